@@ -21,6 +21,12 @@ std::string Settings::ToString() const {
   stream << "Settings: " << std::endl;
   stream << "enable_software_rendering: " << enable_software_rendering
          << std::endl;
+  stream << "raster_cache_on_worker_threads: "
+         << raster_cache_on_worker_threads << std::endl;
+  stream << "enable_trace_buffer: " << enable_trace_buffer << std::endl;
+  stream << "jank_trace_path: " << jank_trace_path << std::endl;
+  stream << "persistent_cache_prefetch_byte_budget: "
+         << persistent_cache_prefetch_byte_budget << std::endl;
   stream << "log_tag: " << log_tag << std::endl;
   stream << "icu_initialization_required: " << icu_initialization_required
          << std::endl;
@@ -38,8 +38,15 @@ class FrameTiming {
     return data_[phase] = value;
   }
 
+  // The vsync the frame was begun for. Frames begun just in time for their
+  // deadline start building after it, so the latency of a frame is measured
+  // from here. It is not one of the reported phases.
+  fml::TimePoint vsync_start() const { return vsync_start_; }
+  void set_vsync_start(fml::TimePoint value) { vsync_start_ = value; }
+
  private:
   fml::TimePoint data_[kCount];
+  fml::TimePoint vsync_start_;
 };
 
 using TaskObserverAdd =
@@ -84,7 +91,21 @@ struct Settings {
   // blocking calls in this callback will cause applications to jank.
   UnhandledExceptionCallback unhandled_exception_callback;
   bool enable_software_rendering = false;
+  // Whether the raster cache rasterizes the pictures of software surfaces on
+  // the VM workers instead of the GPU thread.
+  bool raster_cache_on_worker_threads = false;
   bool skia_deterministic_rendering_on_cpu = false;
+  // Whether the trace events are recorded in the in-process trace buffer. Like
+  // |verbose_logging|, this applies to all the shells in the process.
+  bool enable_trace_buffer = false;
+  // Where the trace buffer is written after a janky frame. Empty to not write
+  // it.
+  std::string jank_trace_path;
+  // The bytes of the persistent cache read into memory on the IO thread when
+  // the first shell is set up, see |PersistentCache::gPrefetchByteBudget|.
+  // Like |enable_trace_buffer|, this applies to the whole process. Zero to not
+  // prefetch the cache.
+  size_t persistent_cache_prefetch_byte_budget = 0;
   bool verbose_logging = false;
   std::string log_tag = "flutter";
 
@@ -15,6 +15,7 @@ CompositorContext::~CompositorContext() = default;
 
 void CompositorContext::BeginFrame(ScopedFrame& frame,
                                    bool enable_instrumentation) {
+  frame_raster_details_ = {};
   if (enable_instrumentation) {
     frame_count_.Increment();
     raster_time_.Start();
@@ -23,12 +24,19 @@ void CompositorContext::BeginFrame(ScopedFrame& frame,
 
 void CompositorContext::EndFrame(ScopedFrame& frame,
                                  bool enable_instrumentation) {
+  frame_raster_details_.raster_cache_miss_count =
+      raster_cache_.frame_stats().miss_count;
   raster_cache_.SweepAfterFrame();
   if (enable_instrumentation) {
     raster_time_.Stop();
   }
 }
 
+void CompositorContext::RecordFrameTiming(const FrameTiming& timing) {
+  frame_timing_stats_.AddFrame(timing, frame_raster_details_);
+  frame_raster_details_ = {};
+}
+
 std::unique_ptr<CompositorContext::ScopedFrame> CompositorContext::AcquireFrame(
     GrContext* gr_context,
     SkCanvas* canvas,
@@ -63,9 +71,22 @@ CompositorContext::ScopedFrame::~ScopedFrame() {
   context_.EndFrame(*this, instrumentation_enabled_);
 }
 
+void CompositorContext::ScopedFrame::EnableDamageTracking(
+    bool surface_retains_contents) {
+  if (!canvas_) {
+    return;
+  }
+  frame_damage_ = std::make_unique<FrameDamage>(
+      canvas_->getBaseLayerSize(), root_surface_transformation_);
+  surface_retains_contents_ = surface_retains_contents;
+}
+
 RasterStatus CompositorContext::ScopedFrame::Raster(
     flutter::LayerTree& layer_tree,
     bool ignore_raster_cache) {
+  if (!frame_damage_) {
+    context_.last_frame_damage_.reset();
+  }
   layer_tree.Preroll(*this, ignore_raster_cache);
   PostPrerollResult post_preroll_result = PostPrerollResult::kSuccess;
   if (view_embedder_ && gpu_thread_merger_) {
@@ -75,6 +96,22 @@ RasterStatus CompositorContext::ScopedFrame::Raster(
   if (post_preroll_result == PostPrerollResult::kResubmitFrame) {
     return RasterStatus::kResubmit;
   }
+  damage_ = std::nullopt;
+  if (frame_damage_ && surface_retains_contents_) {
+    damage_ = frame_damage_->ComputeDamage(context_.last_frame_damage_.get());
+  }
+  if (frame_damage_) {
+    context_.last_frame_damage_ = std::move(frame_damage_);
+  }
+  if (damage_ && damage_->isEmpty()) {
+    // Nothing changed since the last frame, the canvas is already up to date.
+    return RasterStatus::kSuccess;
+  }
+
+  SkAutoCanvasRestore auto_restore(canvas(), damage_.has_value());
+  if (damage_) {
+    canvas()->clipRect(SkRect::Make(*damage_));
+  }
   // Clearing canvas after preroll reduces one render target switch when preroll
   // paints some raster cache.
   if (canvas()) {
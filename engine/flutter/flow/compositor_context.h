@@ -6,9 +6,12 @@
 #define FLUTTER_FLOW_COMPOSITOR_CONTEXT_H_
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "flutter/flow/embedded_views.h"
+#include "flutter/flow/frame_damage.h"
+#include "flutter/flow/frame_timing_stats.h"
 #include "flutter/flow/instrumentation.h"
 #include "flutter/flow/raster_cache.h"
 #include "flutter/flow/texture.h"
@@ -61,6 +64,24 @@ class CompositorContext {
 
     GrContext* gr_context() const { return gr_context_; }
 
+    // Records the layers of this frame so that only the area that changed
+    // since the last frame is repainted. |surface_retains_contents| must
+    // only be set if the canvas still holds the pixels of the last frame
+    // rasterized by this context.
+    void EnableDamageTracking(bool surface_retains_contents);
+
+    FrameDamage* frame_damage() const { return frame_damage_.get(); }
+
+    // The area of the canvas repainted by |Raster|, or std::nullopt if the
+    // whole canvas was repainted.
+    const std::optional<SkIRect>& damage() const { return damage_; }
+
+    // The painting times of the layers of this frame, for the slow frames of
+    // |CompositorContext::frame_timing_stats|.
+    LayerPaintTimes* layer_paint_times() const {
+      return &context_.frame_raster_details_.layer_paint_times;
+    }
+
     virtual RasterStatus Raster(LayerTree& layer_tree,
                                 bool ignore_raster_cache);
 
@@ -72,6 +93,9 @@ class CompositorContext {
     const SkMatrix& root_surface_transformation_;
     const bool instrumentation_enabled_;
     fml::RefPtr<fml::GpuThreadMerger> gpu_thread_merger_;
+    std::unique_ptr<FrameDamage> frame_damage_;
+    bool surface_retains_contents_ = false;
+    std::optional<SkIRect> damage_;
 
     FML_DISALLOW_COPY_AND_ASSIGN(ScopedFrame);
   };
@@ -102,12 +126,24 @@ class CompositorContext {
 
   Stopwatch& ui_time() { return ui_time_; }
 
+  // Adds the timing of the last frame rasterized by this context, along with
+  // the layer painting times and raster cache misses of that frame, to the
+  // frame timing stats.
+  void RecordFrameTiming(const FrameTiming& timing);
+
+  FrameTimingStats& frame_timing_stats() { return frame_timing_stats_; }
+
  private:
   RasterCache raster_cache_;
   TextureRegistry texture_registry_;
   Counter frame_count_;
   Stopwatch raster_time_;
   Stopwatch ui_time_;
+  // The layers of the last frame rasterized with damage tracking enabled.
+  std::unique_ptr<FrameDamage> last_frame_damage_;
+  FrameTimingStats frame_timing_stats_;
+  // What happened during the last frame, until it is recorded.
+  FrameTimingStats::RasterDetails frame_raster_details_;
 
   void BeginFrame(ScopedFrame& frame, bool enable_instrumentation);
 
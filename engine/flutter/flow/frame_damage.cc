@@ -0,0 +1,113 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/frame_damage.h"
+
+#include "flutter/flow/layers/layer.h"
+#include "flutter/fml/trace_event.h"
+
+namespace flutter {
+
+FrameDamage::FrameDamage(const SkISize& frame_size,
+                         const SkMatrix& root_transformation)
+    : frame_size_(frame_size), root_transformation_(root_transformation) {}
+
+FrameDamage::~FrameDamage() = default;
+
+void FrameDamage::AddLayer(const Layer& layer,
+                           const SkMatrix& matrix,
+                           const MutatorsStack& mutators) {
+  switch (layer.damage_kind()) {
+    case Layer::DamageKind::kChildren:
+      break;
+    case Layer::DamageKind::kStatic:
+    case Layer::DamageKind::kVolatile:
+      AddLayer(layer.unique_id(), matrix.mapRect(layer.paint_bounds()),
+               mutators,
+               layer.damage_kind() == Layer::DamageKind::kVolatile);
+      break;
+    case Layer::DamageKind::kBackdrop:
+      SetNeedsFullRepaint();
+      break;
+  }
+}
+
+void FrameDamage::AddLayer(uint64_t unique_id,
+                           const SkRect& device_bounds,
+                           const MutatorsStack& mutators,
+                           bool volatile_content) {
+  if (device_bounds.isEmpty()) {
+    return;
+  }
+  auto inserted = index_.emplace(unique_id, entries_.size());
+  if (!inserted.second) {
+    // The same layer is painted more than once in this frame, the entries
+    // can't be told apart so both are always considered damaged.
+    entries_[inserted.first->second].volatile_content = true;
+    volatile_content = true;
+  }
+  entries_.push_back({unique_id, device_bounds, mutators, volatile_content});
+}
+
+std::optional<SkIRect> FrameDamage::ComputeDamage(
+    const FrameDamage* previous) const {
+  TRACE_EVENT0("flutter", "FrameDamage::ComputeDamage");
+  if (previous == nullptr || needs_full_repaint_ ||
+      previous->needs_full_repaint_ || previous->frame_size_ != frame_size_ ||
+      previous->root_transformation_ != root_transformation_) {
+    return std::nullopt;
+  }
+
+  SkRect damage = SkRect::MakeEmpty();
+  std::vector<bool> matched(previous->entries_.size(), false);
+  // Layers that kept their bounds but are now painted in a different order
+  // relative to each other still have to be repainted where they overlap.
+  size_t max_previous_index = 0;
+  bool has_previous_index = false;
+
+  for (const Entry& entry : entries_) {
+    auto found = previous->index_.find(entry.unique_id);
+    if (found == previous->index_.end()) {
+      damage.join(entry.device_bounds);
+      continue;
+    }
+    const size_t previous_index = found->second;
+    const Entry& previous_entry = previous->entries_[previous_index];
+    matched[previous_index] = true;
+
+    bool out_of_order =
+        has_previous_index && previous_index < max_previous_index;
+    if (!has_previous_index || previous_index > max_previous_index) {
+      max_previous_index = previous_index;
+      has_previous_index = true;
+    }
+
+    if (entry.volatile_content || previous_entry.volatile_content ||
+        out_of_order || entry.device_bounds != previous_entry.device_bounds ||
+        entry.mutators != previous_entry.mutators) {
+      damage.join(entry.device_bounds);
+      damage.join(previous_entry.device_bounds);
+    }
+  }
+
+  for (size_t i = 0; i < matched.size(); i++) {
+    if (!matched[i]) {
+      damage.join(previous->entries_[i].device_bounds);
+    }
+  }
+
+  SkIRect result = SkIRect::MakeEmpty();
+  if (damage.isEmpty()) {
+    return result;
+  }
+  damage.roundOut(&result);
+  // Anti-aliased edges may touch the pixel next to the bounds.
+  result.outset(1, 1);
+  if (!result.intersect(SkIRect::MakeSize(frame_size_))) {
+    result.setEmpty();
+  }
+  return result;
+}
+
+}  // namespace flutter
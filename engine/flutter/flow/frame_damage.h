@@ -0,0 +1,81 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_FRAME_DAMAGE_H_
+#define FLUTTER_FLOW_FRAME_DAMAGE_H_
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/flow/embedded_views.h"
+#include "flutter/fml/macros.h"
+#include "third_party/skia/include/core/SkMatrix.h"
+#include "third_party/skia/include/core/SkRect.h"
+#include "third_party/skia/include/core/SkSize.h"
+
+namespace flutter {
+
+class Layer;
+
+// Records what every painting layer of a frame draws, in paint order, so that
+// two consecutive frames can be diffed into the device space area that has to
+// be repainted.
+//
+// Layers are identified by |Layer::unique_id|, which is stable for layers
+// retained by the framework across frames. A layer that is not found in the
+// previous frame, or whose device bounds or mutators changed, damages both its
+// old and its new bounds.
+class FrameDamage {
+ public:
+  FrameDamage(const SkISize& frame_size, const SkMatrix& root_transformation);
+
+  ~FrameDamage();
+
+  // Records |layer| after it has been prerolled with |matrix| and
+  // |mutators|, according to its |Layer::damage_kind|.
+  void AddLayer(const Layer& layer,
+                const SkMatrix& matrix,
+                const MutatorsStack& mutators);
+
+  // Records a layer that paints |device_bounds|. |volatile_content| must be
+  // set for layers whose output may change without the layer changing, such
+  // as textures, which are always damaged.
+  void AddLayer(uint64_t unique_id,
+                const SkRect& device_bounds,
+                const MutatorsStack& mutators,
+                bool volatile_content = false);
+
+  // Returns the area of the frame, in device pixels, that differs from
+  // |previous|. Returns std::nullopt if the whole frame has to be repainted,
+  // for example because there is no previous frame or its size changed.
+  std::optional<SkIRect> ComputeDamage(const FrameDamage* previous) const;
+
+  // Forces the next diff against this frame, and of this frame against the
+  // previous one, to repaint the whole frame.
+  void SetNeedsFullRepaint() { needs_full_repaint_ = true; }
+
+  size_t layer_count() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t unique_id;
+    SkRect device_bounds;
+    MutatorsStack mutators;
+    bool volatile_content;
+  };
+
+  const SkISize frame_size_;
+  const SkMatrix root_transformation_;
+  std::vector<Entry> entries_;
+  // Index into |entries_| by unique id.
+  std::unordered_map<uint64_t, size_t> index_;
+  bool needs_full_repaint_ = false;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(FrameDamage);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_FLOW_FRAME_DAMAGE_H_
@@ -0,0 +1,116 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/frame_damage.h"
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+namespace {
+
+const SkISize kFrameSize = SkISize::Make(100, 100);
+
+}  // namespace
+
+TEST(FrameDamage, NoPreviousFrameRepaintsEverything) {
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack());
+  ASSERT_FALSE(frame.ComputeDamage(nullptr).has_value());
+}
+
+TEST(FrameDamage, SizeChangeRepaintsEverything) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  FrameDamage frame(SkISize::Make(200, 100), SkMatrix::I());
+  ASSERT_FALSE(frame.ComputeDamage(&previous).has_value());
+}
+
+TEST(FrameDamage, UnchangedFrameHasEmptyDamage) {
+  MutatorsStack mutators;
+  mutators.PushTransform(SkMatrix::MakeTrans(5, 5));
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), mutators);
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), mutators);
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  ASSERT_TRUE(damage->isEmpty());
+}
+
+TEST(FrameDamage, MovedLayerDamagesOldAndNewBounds) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack());
+  previous.AddLayer(2, SkRect::MakeXYWH(60, 60, 10, 10), MutatorsStack());
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(1, SkRect::MakeXYWH(20, 10, 10, 10), MutatorsStack());
+  frame.AddLayer(2, SkRect::MakeXYWH(60, 60, 10, 10), MutatorsStack());
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  // Outset by one pixel for anti-aliasing.
+  ASSERT_EQ(*damage, SkIRect::MakeLTRB(9, 9, 31, 21));
+}
+
+TEST(FrameDamage, AddedAndRemovedLayersAreDamaged) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack());
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(2, SkRect::MakeXYWH(80, 80, 30, 30), MutatorsStack());
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  // Clipped to the frame.
+  ASSERT_EQ(*damage, SkIRect::MakeLTRB(9, 9, 100, 100));
+}
+
+TEST(FrameDamage, MutatorChangeDamagesLayer) {
+  MutatorsStack previous_mutators;
+  previous_mutators.PushOpacity(128);
+  MutatorsStack mutators;
+  mutators.PushOpacity(255);
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), previous_mutators);
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), mutators);
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  ASSERT_EQ(*damage, SkIRect::MakeLTRB(9, 9, 21, 21));
+}
+
+TEST(FrameDamage, VolatileLayerIsAlwaysDamaged) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack(),
+                    true);
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack(), true);
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  ASSERT_EQ(*damage, SkIRect::MakeLTRB(9, 9, 21, 21));
+}
+
+TEST(FrameDamage, ReorderedLayersAreDamaged) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  previous.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack());
+  previous.AddLayer(2, SkRect::MakeXYWH(15, 15, 10, 10), MutatorsStack());
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.AddLayer(2, SkRect::MakeXYWH(15, 15, 10, 10), MutatorsStack());
+  frame.AddLayer(1, SkRect::MakeXYWH(10, 10, 10, 10), MutatorsStack());
+
+  auto damage = frame.ComputeDamage(&previous);
+  ASSERT_TRUE(damage.has_value());
+  ASSERT_EQ(*damage, SkIRect::MakeLTRB(9, 9, 21, 21));
+}
+
+TEST(FrameDamage, FullRepaintIsForced) {
+  FrameDamage previous(kFrameSize, SkMatrix::I());
+  FrameDamage frame(kFrameSize, SkMatrix::I());
+  frame.SetNeedsFullRepaint();
+  ASSERT_FALSE(frame.ComputeDamage(&previous).has_value());
+}
+
+}  // namespace testing
+}  // namespace flutter
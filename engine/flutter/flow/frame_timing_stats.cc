@@ -0,0 +1,182 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/frame_timing_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "flutter/common/settings.h"
+#include "flutter/fml/logging.h"
+
+namespace flutter {
+
+const char* GetLayerPaintKindName(LayerPaintKind kind) {
+  switch (kind) {
+    case LayerPaintKind::kOther:
+      return "other";
+    case LayerPaintKind::kPicture:
+      return "picture";
+    case LayerPaintKind::kPhysicalShape:
+      return "physicalShape";
+    case LayerPaintKind::kBackdropFilter:
+      return "backdropFilter";
+    case LayerPaintKind::kShaderMask:
+      return "shaderMask";
+    case LayerPaintKind::kSaveLayer:
+      return "saveLayer";
+    case LayerPaintKind::kTexture:
+      return "texture";
+    case LayerPaintKind::kPlatformView:
+      return "platformView";
+    case LayerPaintKind::kCount:
+      break;
+  }
+  FML_DCHECK(false);
+  return "";
+}
+
+LayerPaintTimes::ScopedTimer::ScopedTimer(LayerPaintTimes* times,
+                                          LayerPaintKind kind)
+    : times_(times), kind_(kind) {
+  if (!times_) {
+    return;
+  }
+  start_ = fml::TimePoint::Now();
+  enclosing_nested_time_ = times_->nested_time_;
+  times_->nested_time_ = fml::TimeDelta::Zero();
+}
+
+LayerPaintTimes::ScopedTimer::~ScopedTimer() {
+  if (!times_) {
+    return;
+  }
+  fml::TimeDelta elapsed = fml::TimePoint::Now() - start_;
+  times_->Add(kind_, elapsed - times_->nested_time_);
+  times_->nested_time_ = enclosing_nested_time_ + elapsed;
+}
+
+LayerPaintTimes::LayerPaintTimes() {
+  times_.fill(fml::TimeDelta::Zero());
+}
+
+DurationHistogram::DurationHistogram() {
+  Reset();
+}
+
+void DurationHistogram::Add(fml::TimeDelta duration) {
+  int64_t micros = std::max<int64_t>(duration.ToMicroseconds(), 0);
+  buckets_[GetBucketIndex(micros)]++;
+  count_++;
+  max_ = std::max(max_, duration);
+}
+
+void DurationHistogram::Reset() {
+  buckets_.fill(0);
+  count_ = 0;
+  max_ = fml::TimeDelta::Zero();
+}
+
+fml::TimeDelta DurationHistogram::GetPercentile(double percentile) const {
+  if (count_ == 0) {
+    return fml::TimeDelta::Zero();
+  }
+  size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * count_));
+  rank = std::clamp<size_t>(rank, 1, count_);
+  size_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      // The largest duration added may be lower than the bucket's bound.
+      return std::min(fml::TimeDelta::FromMicroseconds(GetBucketUpperBound(i)),
+                      max_);
+    }
+  }
+  return max_;
+}
+
+size_t DurationHistogram::GetBucketIndex(int64_t micros) {
+  micros = std::min(micros, (int64_t{1} << (kMaxExponent + 1)) - 1);
+  if (micros < kSubBucketCount) {
+    return micros;
+  }
+  int exponent = kSubBucketBits;
+  while ((micros >> (exponent + 1)) != 0) {
+    exponent++;
+  }
+  int shift = exponent - kSubBucketBits;
+  int64_t sub_bucket = (micros >> shift) - kSubBucketCount;
+  return kSubBucketCount * (shift + 1) + sub_bucket;
+}
+
+int64_t DurationHistogram::GetBucketUpperBound(size_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  int shift = index / kSubBucketCount - 1;
+  int64_t sub_bucket = index % kSubBucketCount;
+  return ((kSubBucketCount + sub_bucket + 1) << shift) - 1;
+}
+
+FrameTimingStats::FrameTimingStats(fml::TimeDelta frame_budget)
+    : frame_budget_(frame_budget) {}
+
+FrameTimingStats::~FrameTimingStats() = default;
+
+void FrameTimingStats::SetFrameBudget(fml::TimeDelta frame_budget) {
+  FML_DCHECK(frame_budget > fml::TimeDelta::Zero());
+  frame_budget_ = frame_budget;
+}
+
+void FrameTimingStats::AddFrame(const FrameTiming& timing,
+                                const RasterDetails& details) {
+  fml::TimeDelta build_time = timing.Get(FrameTiming::kBuildFinish) -
+                              timing.Get(FrameTiming::kBuildStart);
+  fml::TimeDelta raster_time = timing.Get(FrameTiming::kRasterFinish) -
+                               timing.Get(FrameTiming::kRasterStart);
+  fml::TimeDelta vsync_latency =
+      timing.Get(FrameTiming::kRasterFinish) - timing.vsync_start();
+
+  frame_count_++;
+  build_times_.Add(build_time);
+  raster_times_.Add(raster_time);
+  vsync_latencies_.Add(vsync_latency);
+
+  // A frame ready within one budget of its vsync is displayed at the next
+  // vsync. Every further budget it takes skips one more.
+  if (vsync_latency > frame_budget_) {
+    fml::TimeDelta late = vsync_latency - fml::TimeDelta::FromNanoseconds(1);
+    missed_vsync_count_ += late / frame_budget_;
+  }
+
+  bool slow_build = build_time > frame_budget_;
+  bool slow_raster = raster_time > frame_budget_;
+  if (!slow_build && !slow_raster) {
+    return;
+  }
+  slow_build_count_ += slow_build;
+  slow_raster_count_ += slow_raster;
+  slow_frame_count_++;
+  for (size_t i = 0; i < static_cast<size_t>(LayerPaintKind::kCount); i++) {
+    LayerPaintKind kind = static_cast<LayerPaintKind>(i);
+    slow_frame_layer_paint_times_.Add(kind,
+                                      details.layer_paint_times.Get(kind));
+  }
+  slow_frame_raster_cache_miss_count_ += details.raster_cache_miss_count;
+}
+
+void FrameTimingStats::Reset() {
+  frame_count_ = 0;
+  build_times_.Reset();
+  raster_times_.Reset();
+  vsync_latencies_.Reset();
+  missed_vsync_count_ = 0;
+  slow_build_count_ = 0;
+  slow_raster_count_ = 0;
+  slow_frame_count_ = 0;
+  slow_frame_layer_paint_times_ = LayerPaintTimes();
+  slow_frame_raster_cache_miss_count_ = 0;
+}
+
+}  // namespace flutter
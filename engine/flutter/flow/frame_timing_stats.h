@@ -0,0 +1,195 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_FRAME_TIMING_STATS_H_
+#define FLUTTER_FLOW_FRAME_TIMING_STATS_H_
+
+#include <array>
+#include <cstdint>
+
+#include "flutter/fml/macros.h"
+#include "flutter/fml/time/time_delta.h"
+#include "flutter/fml/time/time_point.h"
+
+namespace flutter {
+
+class FrameTiming;
+
+// The kinds of layers the painting time of slow frames is attributed to by
+// |FrameTimingStats|, see |Layer::paint_kind|.
+enum class LayerPaintKind {
+  // Layers that mostly paint their children, such as transforms and clips.
+  kOther,
+  kPicture,
+  kPhysicalShape,
+  kBackdropFilter,
+  kShaderMask,
+  // Layers that paint their children into an offscreen buffer, such as
+  // opacity and color filters.
+  kSaveLayer,
+  kTexture,
+  kPlatformView,
+  kCount,
+};
+
+// Returns the name of |kind| in the snapshots of |FrameTimingStats|.
+const char* GetLayerPaintKindName(LayerPaintKind kind);
+
+// The time spent painting each kind of layer in a frame. Layers are only
+// charged for their own painting, not for the painting of their children.
+class LayerPaintTimes {
+ public:
+  // Charges the time from its construction to its destruction, minus the time
+  // of the timers nested in it, to |kind|. Does nothing if |times| is null.
+  class ScopedTimer {
+   public:
+    ScopedTimer(LayerPaintTimes* times, LayerPaintKind kind);
+
+    ~ScopedTimer();
+
+   private:
+    LayerPaintTimes* times_;
+    LayerPaintKind kind_;
+    fml::TimePoint start_;
+    // The nested time of the enclosing timer when this one started.
+    fml::TimeDelta enclosing_nested_time_;
+
+    FML_DISALLOW_COPY_AND_ASSIGN(ScopedTimer);
+  };
+
+  LayerPaintTimes();
+
+  fml::TimeDelta Get(LayerPaintKind kind) const {
+    return times_[static_cast<size_t>(kind)];
+  }
+
+  void Add(LayerPaintKind kind, fml::TimeDelta time) {
+    times_[static_cast<size_t>(kind)] = Get(kind) + time;
+  }
+
+ private:
+  std::array<fml::TimeDelta, static_cast<size_t>(LayerPaintKind::kCount)>
+      times_;
+  // The time of the timers nested in the innermost running timer.
+  fml::TimeDelta nested_time_;
+};
+
+// A histogram of durations from a microsecond to about an hour, with a
+// relative precision of about 3%, in constant memory.
+class DurationHistogram {
+ public:
+  DurationHistogram();
+
+  void Add(fml::TimeDelta duration);
+
+  void Reset();
+
+  size_t count() const { return count_; }
+
+  fml::TimeDelta max() const { return max_; }
+
+  // Returns the duration that |percentile| percent of the durations don't
+  // exceed, rounded up to the precision of the histogram. Returns zero if the
+  // histogram is empty.
+  fml::TimeDelta GetPercentile(double percentile) const;
+
+ private:
+  // Durations are counted in buckets of exact microseconds up to
+  // |kSubBucketCount|, and then in |kSubBucketCount| buckets per power of two.
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int64_t kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr int kMaxExponent = 31;
+  static constexpr size_t kBucketCount =
+      kSubBucketCount * (kMaxExponent - kSubBucketBits + 2);
+
+  static size_t GetBucketIndex(int64_t micros);
+
+  // Returns the largest duration in microseconds counted in bucket |index|.
+  static int64_t GetBucketUpperBound(size_t index);
+
+  std::array<uint32_t, kBucketCount> buckets_;
+  size_t count_ = 0;
+  fml::TimeDelta max_;
+};
+
+// Aggregates the timings of the frames rasterized by a compositor context
+// into histograms and counters, to be queried through the service protocol.
+// Slow frames, which miss the frame budget in either the build or the raster
+// phase, are attributed to the kinds of layers that took the time to paint
+// and to the raster cache misses of the frame.
+//
+// Updated and read on the GPU thread.
+class FrameTimingStats {
+ public:
+  // What the compositor context knows about a frame besides its timing.
+  struct RasterDetails {
+    LayerPaintTimes layer_paint_times;
+    size_t raster_cache_miss_count = 0;
+  };
+
+  explicit FrameTimingStats(
+      fml::TimeDelta frame_budget = fml::TimeDelta::FromSecondsF(1.0 / 60.0));
+
+  ~FrameTimingStats();
+
+  // Sets the time between two vsyncs, e.g. from the display refresh rate.
+  void SetFrameBudget(fml::TimeDelta frame_budget);
+
+  fml::TimeDelta frame_budget() const { return frame_budget_; }
+
+  void AddFrame(const FrameTiming& timing, const RasterDetails& details);
+
+  // Forgets all the frames added so far.
+  void Reset();
+
+  size_t frame_count() const { return frame_count_; }
+
+  // The time the UI thread took to build the frames.
+  const DurationHistogram& build_times() const { return build_times_; }
+
+  // The time the GPU thread took to rasterize the frames.
+  const DurationHistogram& raster_times() const { return raster_times_; }
+
+  // The time from the vsync that started each frame to the end of its
+  // rasterization.
+  const DurationHistogram& vsync_latencies() const { return vsync_latencies_; }
+
+  // The number of vsyncs that passed while frames were late, i.e. the
+  // number of frames that could have been displayed but were not.
+  size_t missed_vsync_count() const { return missed_vsync_count_; }
+
+  size_t slow_build_count() const { return slow_build_count_; }
+
+  size_t slow_raster_count() const { return slow_raster_count_; }
+
+  size_t slow_frame_count() const { return slow_frame_count_; }
+
+  // The painting time of slow frames by kind of layer.
+  const LayerPaintTimes& slow_frame_layer_paint_times() const {
+    return slow_frame_layer_paint_times_;
+  }
+
+  size_t slow_frame_raster_cache_miss_count() const {
+    return slow_frame_raster_cache_miss_count_;
+  }
+
+ private:
+  fml::TimeDelta frame_budget_;
+  size_t frame_count_ = 0;
+  DurationHistogram build_times_;
+  DurationHistogram raster_times_;
+  DurationHistogram vsync_latencies_;
+  size_t missed_vsync_count_ = 0;
+  size_t slow_build_count_ = 0;
+  size_t slow_raster_count_ = 0;
+  size_t slow_frame_count_ = 0;
+  LayerPaintTimes slow_frame_layer_paint_times_;
+  size_t slow_frame_raster_cache_miss_count_ = 0;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(FrameTimingStats);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_FLOW_FRAME_TIMING_STATS_H_
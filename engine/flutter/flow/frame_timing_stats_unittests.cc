@@ -0,0 +1,165 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/frame_timing_stats.h"
+
+#include <chrono>
+#include <thread>
+
+#include "flutter/common/settings.h"
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+namespace {
+
+const fml::TimeDelta kFrameBudget = fml::TimeDelta::FromMilliseconds(16);
+
+// Makes the timing of a frame begun |begin_frame_delay| after its vsync.
+FrameTiming MakeFrameTiming(
+    fml::TimeDelta build_time,
+    fml::TimeDelta raster_time,
+    fml::TimeDelta begin_frame_delay = fml::TimeDelta::Zero()) {
+  fml::TimePoint build_start = fml::TimePoint::FromEpochDelta(
+      fml::TimeDelta::FromSeconds(1));
+  FrameTiming timing;
+  timing.set_vsync_start(build_start - begin_frame_delay);
+  timing.Set(FrameTiming::kBuildStart, build_start);
+  timing.Set(FrameTiming::kBuildFinish, build_start + build_time);
+  timing.Set(FrameTiming::kRasterStart, build_start + build_time);
+  timing.Set(FrameTiming::kRasterFinish,
+             build_start + build_time + raster_time);
+  return timing;
+}
+
+}  // namespace
+
+TEST(DurationHistogram, EmptyHistogramHasZeroPercentiles) {
+  DurationHistogram histogram;
+  ASSERT_EQ(histogram.count(), 0u);
+  ASSERT_EQ(histogram.GetPercentile(50), fml::TimeDelta::Zero());
+  ASSERT_EQ(histogram.max(), fml::TimeDelta::Zero());
+}
+
+TEST(DurationHistogram, PercentilesAreWithinPrecision) {
+  DurationHistogram histogram;
+  for (int64_t i = 1; i <= 1000; i++) {
+    histogram.Add(fml::TimeDelta::FromMicroseconds(i * 100));
+  }
+  ASSERT_EQ(histogram.count(), 1000u);
+  ASSERT_EQ(histogram.max(), fml::TimeDelta::FromMicroseconds(100000));
+
+  const double kPercentiles[] = {50, 90, 99};
+  for (double percentile : kPercentiles) {
+    double expected = percentile * 1000;
+    double actual = histogram.GetPercentile(percentile).ToMicroseconds();
+    ASSERT_GE(actual, expected) << percentile;
+    ASSERT_LE(actual, expected * 1.04) << percentile;
+  }
+  ASSERT_EQ(histogram.GetPercentile(100), histogram.max());
+}
+
+TEST(DurationHistogram, SmallDurationsAreExact) {
+  DurationHistogram histogram;
+  histogram.Add(fml::TimeDelta::FromMicroseconds(3));
+  histogram.Add(fml::TimeDelta::FromMicroseconds(7));
+  ASSERT_EQ(histogram.GetPercentile(50), fml::TimeDelta::FromMicroseconds(3));
+  ASSERT_EQ(histogram.GetPercentile(100), fml::TimeDelta::FromMicroseconds(7));
+}
+
+TEST(DurationHistogram, ResetForgetsDurations) {
+  DurationHistogram histogram;
+  histogram.Add(fml::TimeDelta::FromMilliseconds(5));
+  histogram.Reset();
+  ASSERT_EQ(histogram.count(), 0u);
+  ASSERT_EQ(histogram.max(), fml::TimeDelta::Zero());
+}
+
+TEST(FrameTimingStats, CountsMissedVsyncs) {
+  FrameTimingStats stats(kFrameBudget);
+  FrameTimingStats::RasterDetails details;
+  // Ready in time for the next vsync.
+  stats.AddFrame(MakeFrameTiming(fml::TimeDelta::FromMilliseconds(6),
+                                 fml::TimeDelta::FromMilliseconds(10)),
+                 details);
+  ASSERT_EQ(stats.missed_vsync_count(), 0u);
+  // Displayed two vsyncs late.
+  stats.AddFrame(MakeFrameTiming(fml::TimeDelta::FromMilliseconds(10),
+                                 fml::TimeDelta::FromMilliseconds(30)),
+                 details);
+  ASSERT_EQ(stats.missed_vsync_count(), 2u);
+  ASSERT_EQ(stats.frame_count(), 2u);
+  ASSERT_EQ(stats.vsync_latencies().max(),
+            fml::TimeDelta::FromMilliseconds(40));
+}
+
+TEST(FrameTimingStats, MeasuresLatencyFromTheVsync) {
+  FrameTimingStats stats(kFrameBudget);
+  FrameTimingStats::RasterDetails details;
+  // Begun just in time, but its deadline was missed all the same.
+  stats.AddFrame(MakeFrameTiming(fml::TimeDelta::FromMilliseconds(5),
+                                 fml::TimeDelta::FromMilliseconds(5),
+                                 fml::TimeDelta::FromMilliseconds(8)),
+                 details);
+  ASSERT_EQ(stats.vsync_latencies().max(),
+            fml::TimeDelta::FromMilliseconds(18));
+  ASSERT_EQ(stats.missed_vsync_count(), 1u);
+  ASSERT_EQ(stats.build_times().max(), fml::TimeDelta::FromMilliseconds(5));
+  ASSERT_EQ(stats.slow_frame_count(), 0u);
+}
+
+TEST(FrameTimingStats, AttributesOnlySlowFrames) {
+  FrameTimingStats stats(kFrameBudget);
+  FrameTimingStats::RasterDetails details;
+  details.layer_paint_times.Add(LayerPaintKind::kPicture,
+                                fml::TimeDelta::FromMilliseconds(3));
+  details.raster_cache_miss_count = 2;
+
+  stats.AddFrame(MakeFrameTiming(fml::TimeDelta::FromMilliseconds(5),
+                                 fml::TimeDelta::FromMilliseconds(5)),
+                 details);
+  ASSERT_EQ(stats.slow_frame_count(), 0u);
+  ASSERT_EQ(stats.slow_frame_raster_cache_miss_count(), 0u);
+
+  stats.AddFrame(MakeFrameTiming(fml::TimeDelta::FromMilliseconds(5),
+                                 fml::TimeDelta::FromMilliseconds(20)),
+                 details);
+  ASSERT_EQ(stats.slow_frame_count(), 1u);
+  ASSERT_EQ(stats.slow_build_count(), 0u);
+  ASSERT_EQ(stats.slow_raster_count(), 1u);
+  ASSERT_EQ(stats.slow_frame_raster_cache_miss_count(), 2u);
+  ASSERT_EQ(stats.slow_frame_layer_paint_times().Get(LayerPaintKind::kPicture),
+            fml::TimeDelta::FromMilliseconds(3));
+
+  stats.Reset();
+  ASSERT_EQ(stats.frame_count(), 0u);
+  ASSERT_EQ(stats.slow_frame_count(), 0u);
+  ASSERT_EQ(stats.slow_frame_layer_paint_times().Get(LayerPaintKind::kPicture),
+            fml::TimeDelta::Zero());
+}
+
+TEST(LayerPaintTimes, NestedTimersAreNotChargedToTheirParent) {
+  LayerPaintTimes times;
+  fml::TimePoint start = fml::TimePoint::Now();
+  {
+    LayerPaintTimes::ScopedTimer outer(&times, LayerPaintKind::kSaveLayer);
+    LayerPaintTimes::ScopedTimer inner(&times, LayerPaintKind::kPicture);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  fml::TimeDelta elapsed = fml::TimePoint::Now() - start;
+
+  fml::TimeDelta picture_time = times.Get(LayerPaintKind::kPicture);
+  fml::TimeDelta save_layer_time = times.Get(LayerPaintKind::kSaveLayer);
+  ASSERT_GE(picture_time, fml::TimeDelta::FromMilliseconds(2));
+  ASSERT_GE(save_layer_time, fml::TimeDelta::Zero());
+  ASSERT_LE(picture_time + save_layer_time, elapsed);
+}
+
+TEST(LayerPaintTimes, NullTimesAreIgnored) {
+  LayerPaintTimes::ScopedTimer timer(nullptr, LayerPaintKind::kPicture);
+}
+
+}  // namespace testing
+}  // namespace flutter
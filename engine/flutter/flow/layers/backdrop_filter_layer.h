@@ -18,6 +18,12 @@ class BackdropFilterLayer : public ContainerLayer {
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kBackdrop; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kBackdropFilter;
+  }
+
  private:
   sk_sp<SkImageFilter> filter_;
 
@@ -27,6 +27,8 @@ class ChildSceneLayer : public Layer {
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kVolatile; }
+
   void UpdateScene(SceneUpdateContext& context) override;
 
  private:
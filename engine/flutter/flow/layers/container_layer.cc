@@ -28,6 +28,10 @@ void ContainerLayer::PrerollChildren(PrerollContext* context,
                                      SkRect* child_paint_bounds) {
   for (auto& layer : layers_) {
     layer->Preroll(context, child_matrix);
+    if (context->frame_damage) {
+      context->frame_damage->AddLayer(*layer, child_matrix,
+                                      context->mutators_stack);
+    }
 
     if (layer->needs_system_composite()) {
       set_needs_system_composite(true);
@@ -43,6 +47,8 @@ void ContainerLayer::PaintChildren(PaintContext& context) const {
   // and the trace event on this common function has a small overhead.
   for (auto& layer : layers_) {
     if (layer->needs_painting()) {
+      LayerPaintTimes::ScopedTimer timer(context.layer_paint_times,
+                                         layer->paint_kind());
       layer->Paint(context);
     }
   }
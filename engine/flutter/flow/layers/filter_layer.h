@@ -18,6 +18,12 @@ public:
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kStatic; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kSaveLayer;
+  }
+
 private:
   SkPaint filterPaint_;
 
@@ -9,6 +9,8 @@
 #include <vector>
 
 #include "flutter/flow/embedded_views.h"
+#include "flutter/flow/frame_damage.h"
+#include "flutter/flow/frame_timing_stats.h"
 #include "flutter/flow/instrumentation.h"
 #include "flutter/flow/raster_cache.h"
 #include "flutter/flow/texture.h"
@@ -58,6 +60,9 @@ struct PrerollContext {
   TextureRegistry& texture_registry;
   const bool checkerboard_offscreen_layers;
   float total_elevation = 0.0f;
+  // When set, every painting layer is recorded into it so that the frame can
+  // be diffed against the previous one, see |Layer::damage_kind|.
+  FrameDamage* frame_damage = nullptr;
 };
 
 // Represents a single composited layer. Created on the UI thread but then
@@ -69,6 +74,26 @@ class Layer {
 
   virtual void Preroll(PrerollContext* context, const SkMatrix& matrix);
 
+  // How the output of a layer is tracked by |FrameDamage|.
+  enum class DamageKind {
+    // The layer only paints its children and its effect is fully described
+    // by the mutators it pushes, such as transforms and clips.
+    kChildren,
+    // The layer paints the same content for as long as it is retained.
+    kStatic,
+    // The layer may paint different content every frame, e.g. a texture.
+    kVolatile,
+    // The layer filters what has been painted below it, which can't be
+    // repainted partially.
+    kBackdrop,
+  };
+
+  virtual DamageKind damage_kind() const { return DamageKind::kStatic; }
+
+  // The kind the painting time of the layer is attributed to by
+  // |FrameTimingStats|.
+  virtual LayerPaintKind paint_kind() const { return LayerPaintKind::kOther; }
+
   struct PaintContext {
     // When splitting the scene into multiple canvases (e.g when embedding
     // a platform view on iOS) during the paint traversal we apply the non leaf
@@ -89,6 +114,9 @@ class Layer {
     TextureRegistry& texture_registry;
     const RasterCache* raster_cache;
     const bool checkerboard_offscreen_layers;
+    // When set, the time spent painting each layer is charged to its
+    // |Layer::paint_kind|.
+    LayerPaintTimes* layer_paint_times = nullptr;
   };
 
   // Calls SkCanvas::saveLayer and restores the layer upon destruction. Also
@@ -19,8 +19,10 @@ LayerTree::LayerTree()
 
 LayerTree::~LayerTree() = default;
 
-void LayerTree::RecordBuildTime(fml::TimePoint start) {
-  build_start_ = start;
+void LayerTree::RecordBuildTime(fml::TimePoint vsync_start,
+                                fml::TimePoint build_start) {
+  vsync_start_ = vsync_start;
+  build_start_ = build_start;
   build_finish_ = fml::TimePoint::Now();
 }
 
@@ -43,8 +45,13 @@ void LayerTree::Preroll(CompositorContext::ScopedFrame& frame,
       frame.context().ui_time(),
       frame.context().texture_registry(),
       checkerboard_offscreen_layers_};
+  context.frame_damage = frame.frame_damage();
 
   root_layer_->Preroll(&context, frame.root_surface_transformation());
+  if (context.frame_damage) {
+    context.frame_damage->AddLayer(
+        *root_layer_, frame.root_surface_transformation(), stack);
+  }
 }
 
 #if defined(OS_FUCHSIA)
@@ -94,10 +101,14 @@ void LayerTree::Paint(CompositorContext::ScopedFrame& frame,
       frame.context().ui_time(),
       frame.context().texture_registry(),
       ignore_raster_cache ? nullptr : &frame.context().raster_cache(),
-      checkerboard_offscreen_layers_};
+      checkerboard_offscreen_layers_,
+      frame.layer_paint_times()};
 
-  if (root_layer_->needs_painting())
+  if (root_layer_->needs_painting()) {
+    LayerPaintTimes::ScopedTimer timer(context.layer_paint_times,
+                                       root_layer_->paint_kind());
     root_layer_->Paint(context);
+  }
 }
 
 sk_sp<SkPicture> LayerTree::Flatten(const SkRect& bounds) {
@@ -47,7 +47,10 @@ class LayerTree {
 
   void set_frame_size(const SkISize& frame_size) { frame_size_ = frame_size; }
 
-  void RecordBuildTime(fml::TimePoint begin_start);
+  // Records that the tree was built from |build_start| until now, for the
+  // frame begun at |vsync_start|.
+  void RecordBuildTime(fml::TimePoint vsync_start, fml::TimePoint build_start);
+  fml::TimePoint vsync_start() const { return vsync_start_; }
   fml::TimePoint build_start() const { return build_start_; }
   fml::TimePoint build_finish() const { return build_finish_; }
   fml::TimeDelta build_time() const { return build_finish_ - build_start_; }
@@ -74,6 +77,7 @@ class LayerTree {
  private:
   SkISize frame_size_;  // Physical pixels.
   std::shared_ptr<Layer> root_layer_;
+  fml::TimePoint vsync_start_;
   fml::TimePoint build_start_;
   fml::TimePoint build_finish_;
   uint32_t rasterizer_tracing_threshold_;
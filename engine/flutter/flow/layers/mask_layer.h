@@ -25,6 +25,12 @@ class MaskLayer : public ContainerLayer {
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kStatic; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kSaveLayer;
+  }
+
  private:
   bool isSvgMask_ = false;
   bool isGradientMask_ = false;
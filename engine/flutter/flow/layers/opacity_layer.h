@@ -32,6 +32,10 @@ class OpacityLayer : public ContainerLayer {
 
   void Paint(PaintContext& context) const override;
 
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kSaveLayer;
+  }
+
   // TODO(chinmaygarde): Once SCN-139 is addressed, introduce a new node in the
   // session scene hierarchy.
 
@@ -24,6 +24,8 @@ class PerformanceOverlayLayer : public Layer {
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kVolatile; }
+
  private:
   int options_;
   std::string font_path_;
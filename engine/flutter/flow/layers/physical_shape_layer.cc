@@ -9,9 +9,6 @@
 
 namespace flutter {
 
-const SkScalar kLightHeight = 600;
-const SkScalar kLightRadius = 800;
-
 PhysicalShapeLayer::PhysicalShapeLayer(SkColor color,
                                        SkColor shadow_color,
                                        SkScalar device_pixel_ratio,
@@ -107,6 +104,11 @@ void PhysicalShapeLayer::Preroll(PrerollContext* context,
                 kLightHeight;
     bounds.outset(elevation_ * tx, elevation_ * ty);
     set_paint_bounds(bounds);
+
+    if (context->raster_cache &&
+        SkRect::Intersects(context->cull_rect, paint_bounds())) {
+      context->raster_cache->PrepareShadow(context, GetShadow(), matrix);
+    }
 #endif  // defined(OS_FUCHSIA)
   }
 }
@@ -147,8 +149,12 @@ void PhysicalShapeLayer::Paint(PaintContext& context) const {
   FML_DCHECK(needs_painting());
 
   if (elevation_ != 0) {
-    DrawShadow(context.leaf_nodes_canvas, path_, shadow_color_, elevation_,
-               SkColorGetA(color_) != 0xff, device_pixel_ratio_);
+    RasterCacheShadow shadow = GetShadow();
+    if (!context.raster_cache ||
+        !context.raster_cache->DrawShadow(*context.leaf_nodes_canvas, shadow)) {
+      DrawShadow(context.leaf_nodes_canvas, path_, shadow_color_, elevation_,
+                 shadow.transparent_occluder, device_pixel_ratio_);
+    }
   }
 
   // Call drawPath without clip if possible for better performance.
@@ -188,29 +194,50 @@ void PhysicalShapeLayer::Paint(PaintContext& context) const {
   context.internal_nodes_canvas->restoreToCount(saveCount);
 }
 
+RasterCacheShadow PhysicalShapeLayer::GetShadow() const {
+  return {path_,
+          shadow_color_,
+          elevation_,
+          SkColorGetA(color_) != 0xff,
+          device_pixel_ratio_,
+          paint_bounds()};
+}
+
+SkPoint PhysicalShapeLayer::GetLightPosition(const SkPath& path) {
+  const SkRect& bounds = path.getBounds();
+  return SkPoint::Make((bounds.left() + bounds.right()) / 2,
+                       bounds.top() - kLightHeight);
+}
+
 void PhysicalShapeLayer::DrawShadow(SkCanvas* canvas,
                                     const SkPath& path,
                                     SkColor color,
                                     float elevation,
                                     bool transparentOccluder,
-                                    SkScalar dpr) {
+                                    SkScalar dpr,
+                                    ShadowComponents components,
+                                    SkVector light_offset) {
   const SkScalar kAmbientAlpha = 0.039f;
   const SkScalar kSpotAlpha = 0.25f;
 
   SkShadowFlags flags = transparentOccluder
                             ? SkShadowFlags::kTransparentOccluder_ShadowFlag
                             : SkShadowFlags::kNone_ShadowFlag;
-  const SkRect& bounds = path.getBounds();
-  SkScalar shadow_x = (bounds.left() + bounds.right()) / 2;
-  SkScalar shadow_y = bounds.top() - 600.0f;
+  const SkPoint light = GetLightPosition(path) + light_offset;
   SkColor inAmbient = SkColorSetA(color, kAmbientAlpha * SkColorGetA(color));
   SkColor inSpot = SkColorSetA(color, kSpotAlpha * SkColorGetA(color));
   SkColor ambientColor, spotColor;
   SkShadowUtils::ComputeTonalColors(inAmbient, inSpot, &ambientColor,
                                     &spotColor);
+  if (!(components & kAmbientShadow)) {
+    ambientColor = SK_ColorTRANSPARENT;
+  }
+  if (!(components & kSpotShadow)) {
+    spotColor = SK_ColorTRANSPARENT;
+  }
   SkShadowUtils::DrawShadow(
       canvas, path, SkPoint3::Make(0, 0, dpr * elevation),
-      SkPoint3::Make(shadow_x, shadow_y, dpr * kLightHeight),
+      SkPoint3::Make(light.x(), light.y(), dpr * kLightHeight),
       dpr * kLightRadius, ambientColor, spotColor, flags);
 }
 
@@ -20,22 +20,54 @@ class PhysicalShapeLayer : public ContainerLayer {
                      Clip clip_behavior);
   ~PhysicalShapeLayer() override;
 
+  // The light casting the shadows, in logical pixels. It is |kLightHeight|
+  // above the canvas and as far above the top of the shape.
+  static constexpr SkScalar kLightHeight = 600;
+  static constexpr SkScalar kLightRadius = 800;
+
+  // Where |DrawShadow| places the light of the shadow of |path|, above the
+  // center of the top of its bounds. Skia takes it as a device position and
+  // ignores the matrix of the canvas.
+  static SkPoint GetLightPosition(const SkPath& path);
+
+  // The parts of the shadow drawn by |DrawShadow|. The raster cache draws them
+  // separately, see |RasterCache::PrepareShadow|.
+  enum ShadowComponents {
+    kAmbientShadow = 1 << 0,
+    kSpotShadow = 1 << 1,
+    kAllShadows = kAmbientShadow | kSpotShadow,
+  };
+
+  // |light_offset| moves the light, in device pixels. Canvases that render a
+  // part of the frame with their origin moved, like the images of the raster
+  // cache, move the light by as much.
   static void DrawShadow(SkCanvas* canvas,
                          const SkPath& path,
                          SkColor color,
                          float elevation,
                          bool transparentOccluder,
-                         SkScalar dpr);
+                         SkScalar dpr,
+                         ShadowComponents components = kAllShadows,
+                         SkVector light_offset = {0, 0});
 
   void Preroll(PrerollContext* context, const SkMatrix& matrix) override;
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kStatic; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kPhysicalShape;
+  }
+
 #if defined(OS_FUCHSIA)
   void UpdateScene(SceneUpdateContext& context) override;
 #endif  // defined(OS_FUCHSIA)
 
  private:
+  // The shadow drawn by |Paint|, valid after |Preroll|.
+  RasterCacheShadow GetShadow() const;
+
   SkColor color_;
   SkColor shadow_color_;
   SkScalar device_pixel_ratio_;
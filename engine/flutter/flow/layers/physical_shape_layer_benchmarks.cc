@@ -0,0 +1,113 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <cmath>
+#include <memory>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/flow/layers/physical_shape_layer.h"
+#include "flutter/flow/layers/transform_layer.h"
+#include "flutter/flow/raster_cache.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "third_party/skia/include/utils/SkNWayCanvas.h"
+
+namespace flutter {
+
+namespace {
+
+// A phone screen at 3x, filled with two columns of Material cards.
+constexpr SkScalar kDevicePixelRatio = 3;
+constexpr int kScreenWidth = 1080;
+constexpr int kScreenHeight = 2340;
+constexpr SkScalar kCardWidth = 168;
+constexpr SkScalar kCardHeight = 120;
+constexpr SkScalar kCardMargin = 8;
+constexpr SkScalar kCardRadius = 4;
+constexpr float kCardElevation = 4;
+
+std::shared_ptr<ContainerLayer> MakeCardGrid(int rows) {
+  auto root = std::make_shared<TransformLayer>(
+      SkMatrix::MakeScale(kDevicePixelRatio));
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < 2; column++) {
+      SkRect card = SkRect::MakeXYWH(
+          kCardMargin + column * (kCardWidth + kCardMargin),
+          kCardMargin + row * (kCardHeight + kCardMargin), kCardWidth,
+          kCardHeight);
+      SkPath path;
+      path.addRRect(SkRRect::MakeRectXY(card, kCardRadius, kCardRadius));
+      root->Add(std::make_shared<PhysicalShapeLayer>(
+          SK_ColorWHITE, SK_ColorBLACK, kDevicePixelRatio, 1, kCardElevation,
+          path, Clip::none));
+    }
+  }
+  return root;
+}
+
+// Rasterizes frames of a card grid scrolling by fractions of a pixel, like
+// the software backend does, with or without a raster cache.
+void RasterizeCardGrid(benchmark::State& state, RasterCache* raster_cache) {
+  auto root = MakeCardGrid(state.range(0));
+  auto surface = SkSurface::MakeRasterN32Premul(kScreenWidth, kScreenHeight);
+  SkCanvas* canvas = surface->getCanvas();
+  SkNWayCanvas internal_nodes_canvas(kScreenWidth, kScreenHeight);
+  internal_nodes_canvas.addCanvas(canvas);
+
+  const Stopwatch unused_stopwatch;
+  TextureRegistry unused_texture_registry;
+  MutatorsStack unused_stack;
+  PrerollContext preroll_context{
+      raster_cache,             // raster_cache
+      nullptr,                  // gr_context (software backend)
+      nullptr,                  // external view embedder
+      unused_stack,             // mutator stack
+      nullptr,                  // SkColorSpace* dst_color_space
+      kGiantRect,               // SkRect cull_rect
+      unused_stopwatch,         // frame time (dont care)
+      unused_stopwatch,         // engine time (dont care)
+      unused_texture_registry,  // texture registry (not supported)
+      false,                    // checkerboard_offscreen_layers
+  };
+  Layer::PaintContext paint_context{
+      &internal_nodes_canvas,   // internal_nodes_canvas
+      canvas,                   // leaf_nodes_canvas
+      nullptr,                  // gr_context
+      nullptr,                  // view_embedder
+      unused_stopwatch,         // raster_time
+      unused_stopwatch,         // ui_time
+      unused_texture_registry,  // texture_registry
+      raster_cache,             // raster_cache
+      false,                    // checkerboard_offscreen_layers
+  };
+
+  SkScalar scroll_offset = 0;
+  while (state.KeepRunning()) {
+    const SkMatrix matrix =
+        SkMatrix::MakeTrans(0, -scroll_offset * kDevicePixelRatio);
+    root->Preroll(&preroll_context, matrix);
+    canvas->clear(SK_ColorWHITE);
+    canvas->setMatrix(matrix);
+    root->Paint(paint_context);
+    if (raster_cache) {
+      raster_cache->SweepAfterFrame();
+    }
+    scroll_offset = std::fmod(scroll_offset + 0.5f, kCardHeight);
+  }
+}
+
+}  // namespace
+
+static void BM_CardGridShadows(benchmark::State& state) {
+  RasterizeCardGrid(state, nullptr);
+}
+
+static void BM_CardGridShadowsWithRasterCache(benchmark::State& state) {
+  RasterCache raster_cache;
+  RasterizeCardGrid(state, &raster_cache);
+}
+
+BENCHMARK(BM_CardGridShadows)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_CardGridShadowsWithRasterCache)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace flutter
@@ -27,6 +27,8 @@ class PictureLayer : public Layer {
 
   void Paint(PaintContext& context) const override;
 
+  LayerPaintKind paint_kind() const override { return LayerPaintKind::kPicture; }
+
  private:
   SkPoint offset_;
   // Even though pictures themselves are not GPU resources, they may reference
@@ -19,6 +19,12 @@ class PlatformViewLayer : public Layer {
   void Preroll(PrerollContext* context, const SkMatrix& matrix) override;
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kVolatile; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kPlatformView;
+  }
+
  private:
   SkPoint offset_;
   SkSize size_;
@@ -20,6 +20,12 @@ class ShaderMaskLayer : public ContainerLayer {
 
   void Paint(PaintContext& context) const override;
 
+  DamageKind damage_kind() const override { return DamageKind::kStatic; }
+
+  LayerPaintKind paint_kind() const override {
+    return LayerPaintKind::kShaderMask;
+  }
+
  private:
   sk_sp<SkShader> shader_;
   SkRect mask_rect_;
@@ -10,12 +10,30 @@
 #include "third_party/skia/include/core/SkCanvas.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
+void BackdropFilterLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
+{
+    childPaintBounds_ = SkRect::MakeEmpty();
+    PrepareChildren(context, matrix, childPaintBounds_);
+    if (childPaintBounds_.isEmpty() || !imageFilter_) {
+        SetPaintBounds(childPaintBounds_);
+        return;
+    }
+    // The backdrop is filtered behind the children only, but what shows through depends on the
+    // backdrop as far past them as the filter reaches.
+    if (!imageFilter_->canComputeFastBounds()) {
+        SetPaintBounds(GIANT_RECT);
+        return;
+    }
+    SetPaintBounds(imageFilter_->computeFastBounds(childPaintBounds_));
+}
+
 void BackdropFilterLayer::Paint(const PaintContext& paintContext) const
 {
-    paintContext.skCanvas->saveLayer(SkCanvas::SaveLayerRec { &GetPaintBounds(), nullptr, imageFilter_.get(), 0 });
+    paintContext.skCanvas->saveLayer(SkCanvas::SaveLayerRec { &childPaintBounds_, nullptr, imageFilter_.get(), 0 });
     PaintChildren(paintContext);
     paintContext.skCanvas->restore();
 }
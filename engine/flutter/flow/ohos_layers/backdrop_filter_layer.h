@@ -21,10 +21,14 @@ public:
         : imageFilter_(std::move(imageFilter)) {}
     ~BackdropFilterLayer() override = default;
 
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
+
     void Paint(const PaintContext& paintContext) const override;
 
 private:
     sk_sp<SkImageFilter> imageFilter_;
+    // The area the backdrop is filtered in.
+    SkRect childPaintBounds_ = SkRect::MakeEmpty();
 
     FML_DISALLOW_COPY_AND_ASSIGN(BackdropFilterLayer);
 };
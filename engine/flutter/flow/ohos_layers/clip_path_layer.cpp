@@ -8,17 +8,25 @@
 #include "flutter/flow/ohos_layers/clip_path_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
-void ClipPathLayer::Prepare(const SkMatrix& matrix)
+void ClipPathLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkRect clipPathBounds = clipPath_.getBounds();
+    SkRect previousCullRect = context->cullRect;
+    if (!context->cullRect.intersect(clipPathBounds)) {
+        context->cullRect.setEmpty();
+    }
     SkRect childPaintBounds = SkRect::MakeEmpty();
-    PrepareChildren(matrix, childPaintBounds);
+    PrepareChildren(context, matrix, childPaintBounds);
+    context->cullRect = previousCullRect;
 
     if (childPaintBounds.intersect(clipPathBounds)) {
         SetPaintBounds(childPaintBounds);
+    } else {
+        SetPaintBounds(SkRect::MakeEmpty());
     }
 }
 
@@ -36,4 +44,12 @@ void ClipPathLayer::Paint(const PaintContext& paintContext) const
     }
 }
 
+bool ClipPathLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::CLIP_PATH);
+    HashCombine(hash, static_cast<uint64_t>(clipBehavior_));
+    HashCombine(hash, clipPath_.getGenerationID());
+    return true;
+}
+
 } //  namespace flutter::OHOS
\ No newline at end of file
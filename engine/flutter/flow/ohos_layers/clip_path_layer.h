@@ -19,10 +19,12 @@ public:
     ClipPathLayer(const SkPath& clipPath, Clip clipBehavior) : clipPath_(clipPath), clipBehavior_(clipBehavior) {}
     ~ClipPathLayer() override = default;
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
+    bool HashProperties(uint64_t& hash) const override;
+
 private:
     SkPath clipPath_;
     Clip clipBehavior_;
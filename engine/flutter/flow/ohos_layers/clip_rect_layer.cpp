@@ -11,16 +11,24 @@
 #include "third_party/skia/include/core/SkRRect.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
-void ClipRectLayer::Prepare(const SkMatrix& matrix)
+void ClipRectLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
+    SkRect previousCullRect = context->cullRect;
+    if (!context->cullRect.intersect(clipRect_)) {
+        context->cullRect.setEmpty();
+    }
     SkRect childPaintBounds = SkRect::MakeEmpty();
-    PrepareChildren(matrix, childPaintBounds);
+    PrepareChildren(context, matrix, childPaintBounds);
+    context->cullRect = previousCullRect;
 
     if (childPaintBounds.intersect(clipRect_)) {
         SetPaintBounds(childPaintBounds);
+    } else {
+        SetPaintBounds(SkRect::MakeEmpty());
     }
 }
 
@@ -38,4 +46,13 @@ void ClipRectLayer::Paint(const PaintContext& paintContext) const
     }
 }
 
+bool ClipRectLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::CLIP_RECT);
+    HashCombine(hash, static_cast<uint64_t>(clipBehavior_));
+    const SkScalar rect[] = { clipRect_.fLeft, clipRect_.fTop, clipRect_.fRight, clipRect_.fBottom };
+    HashCombine(hash, rect, sizeof(rect) / sizeof(SkScalar));
+    return true;
+}
+
 } // namespace flutter::OHOS
\ No newline at end of file
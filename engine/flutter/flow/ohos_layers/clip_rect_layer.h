@@ -18,10 +18,12 @@ public:
         : clipRect_(clipRect), clipBehavior_(clipBehavior) {}
     ~ClipRectLayer() override = default;
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
+    bool HashProperties(uint64_t& hash) const override;
+
 private:
     SkRect clipRect_;
     Clip clipBehavior_;
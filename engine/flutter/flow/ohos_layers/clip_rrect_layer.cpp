@@ -11,17 +11,25 @@
 #include "third_party/skia/include/core/SkRRect.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
-void ClipRRectLayer::Prepare(const SkMatrix& matrix)
+void ClipRRectLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkRect clipRrectBounds = clipRrect_.getBounds();
+    SkRect previousCullRect = context->cullRect;
+    if (!context->cullRect.intersect(clipRrectBounds)) {
+        context->cullRect.setEmpty();
+    }
     SkRect childPaintBounds = SkRect::MakeEmpty();
-    PrepareChildren(matrix, childPaintBounds);
+    PrepareChildren(context, matrix, childPaintBounds);
+    context->cullRect = previousCullRect;
 
     if (childPaintBounds.intersect(clipRrectBounds)) {
         SetPaintBounds(clipRrectBounds);
+    } else {
+        SetPaintBounds(SkRect::MakeEmpty());
     }
 }
 
@@ -39,4 +47,15 @@ void ClipRRectLayer::Paint(const PaintContext& paintContext) const
     }
 }
 
+bool ClipRRectLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::CLIP_RRECT);
+    HashCombine(hash, static_cast<uint64_t>(clipBehavior_));
+    constexpr size_t scalarCount = SkRRect::kSizeInMemory / sizeof(SkScalar);
+    SkScalar rrect[scalarCount];
+    clipRrect_.writeToMemory(rrect);
+    HashCombine(hash, rrect, scalarCount);
+    return true;
+}
+
 } // namespace flutter::OHOS
\ No newline at end of file
@@ -21,10 +21,12 @@ public:
         : clipRrect_(clipRrect), clipBehavior_(clipBehavior) {}
     ~ClipRRectLayer() override = default;
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
+    bool HashProperties(uint64_t& hash) const override;
+
 private:
     SkRRect clipRrect_;
     Clip clipBehavior_;
@@ -8,6 +8,7 @@
 #include "flutter/flow/ohos_layers/container_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
@@ -17,24 +18,47 @@ void ContainerLayer::Add(const std::shared_ptr<Layer>& layer)
     layers_.push_back(layer);
 }
 
-void ContainerLayer::Prepare(const SkMatrix& matrix)
+void ContainerLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkRect childPaintBounds = SkRect::MakeEmpty();
-    PrepareChildren(matrix, childPaintBounds);
+    PrepareChildren(context, matrix, childPaintBounds);
     SetPaintBounds(childPaintBounds);
 }
 
-void ContainerLayer::PrepareChildren(const SkMatrix& childMatrix, SkRect& childPaintBounds)
+void ContainerLayer::PrepareChildren(PrepareContext* context, const SkMatrix& childMatrix, SkRect& childPaintBounds)
 {
     for (auto& layer : layers_) {
-        layer->Prepare(childMatrix);
+        layer->Prepare(context, childMatrix);
         childPaintBounds.join(layer->GetPaintBounds());
+        if (context->deviceBounds != nullptr) {
+            (*context->deviceBounds)[layer->GetUniqueId()] = childMatrix.mapRect(layer->GetPaintBounds());
+        }
     }
 }
 
+bool ContainerLayer::HashContent(uint64_t& hash) const
+{
+    return HashProperties(hash) && HashChildren(hash);
+}
+
+bool ContainerLayer::HashChildren(uint64_t& hash) const
+{
+    HashCombine(hash, layers_.size());
+    for (auto& layer : layers_) {
+        if (!layer->HashContent(hash)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ContainerLayer::PaintChildren(const PaintContext& paintContext) const
 {
     for (auto& layer : layers_) {
+        // Skip children that are empty or entirely outside of the current clip.
+        if (!layer->NeedsPainting() || paintContext.skCanvas->quickReject(layer->GetPaintBounds())) {
+            continue;
+        }
         layer->Paint(paintContext);
     }
 }
@@ -8,6 +8,7 @@
 #ifndef FLUTTER_FLOW_OHOS_LAYERS_CONTAINER_LAYER_H
 #define FLUTTER_FLOW_OHOS_LAYERS_CONTAINER_LAYER_H
 
+#include <memory>
 #include <vector>
 
 #include "flutter/flow/ohos_layers/layer.h"
@@ -26,12 +27,21 @@ public:
         return layers_;
     }
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
+
+    bool HashContent(uint64_t& hash) const override;
+
+    const ContainerLayer* AsContainerLayer() const override
+    {
+        return this;
+    }
 
 protected:
     void PaintChildren(const PaintContext& paintContext) const;
 
-    void PrepareChildren(const SkMatrix& childMatrix, SkRect& childPaintBounds);
+    void PrepareChildren(PrepareContext* context, const SkMatrix& childMatrix, SkRect& childPaintBounds);
+
+    bool HashChildren(uint64_t& hash) const;
 
     void ClearChildren()
     {
@@ -6,9 +6,28 @@
 #include "flutter/flow/ohos_layers/filter_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
+void FilterLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
+{
+    SkRect childPaintBounds = SkRect::MakeEmpty();
+    PrepareChildren(context, matrix, childPaintBounds);
+    if (childPaintBounds.isEmpty()) {
+        SetPaintBounds(childPaintBounds);
+        return;
+    }
+    // A blur or a drop shadow paints past the children, a filter that paints transparent
+    // pixels paints everywhere.
+    if (!filterPaint_.canComputeFastBounds()) {
+        SetPaintBounds(GIANT_RECT);
+        return;
+    }
+    SkRect storage;
+    SetPaintBounds(filterPaint_.computeFastBounds(childPaintBounds, &storage));
+}
+
 void FilterLayer::Paint(const PaintContext& paintContext) const
 {
     SkAutoCanvasRestore save(paintContext.skCanvas, true);
@@ -18,6 +18,8 @@ public:
 
     ~FilterLayer() override = default;
 
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
+
     void Paint(const PaintContext& paintContext) const override;
 
 private:
@@ -8,6 +8,9 @@
 #ifndef FLUTTER_FLOW_OHOS_LAYERS_LAYER_H
 #define FLUTTER_FLOW_OHOS_LAYERS_LAYER_H
 
+#include <cstring>
+
+#include "third_party/skia/include/core/SkMatrix.h"
 #include "third_party/skia/include/core/SkRRect.h"
 #include "third_party/skia/include/core/SkRect.h"
 
@@ -16,11 +19,36 @@
 namespace flutter::OHOS {
 
 constexpr uint32_t DEAFAULT_UNIQUEID = -1;
+constexpr uint64_t ROOT_LAYER_ID = 0;
 
 enum Clip { NONE, HARDEDGE, ANTIALIAS, ANTIALIAS_WITH_SAVELAYER };
 
 class ContainerLayer;
 struct PaintContext;
+struct PrepareContext;
+
+inline void HashCombine(uint64_t& hash, uint64_t value)
+{
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+}
+
+// Folded first into the properties hash of every layer, so that layers of different types
+// never hash the same.
+enum class LayerHashTag : uint64_t { PICTURE = 1, TRANSFORM, OPACITY, CLIP_RECT, CLIP_RRECT, CLIP_PATH };
+
+inline void HashCombine(uint64_t& hash, LayerHashTag tag)
+{
+    HashCombine(hash, static_cast<uint64_t>(tag));
+}
+
+inline void HashCombine(uint64_t& hash, const SkScalar* values, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        HashCombine(hash, bits);
+    }
+}
 
 class Layer {
 public:
@@ -29,7 +57,27 @@ public:
 
     virtual void Paint(const PaintContext& paintContext) const {};
 
-    virtual void Prepare(const SkMatrix& matrix) {};
+    virtual void Prepare(PrepareContext* context, const SkMatrix& matrix) {};
+
+    // Folds the properties of this layer, excluding its children, into |hash|. Returns false
+    // if the layer paints content that is not described by the layer tree (e.g. textures or
+    // backdrops), in which case what it paints must not be reused across frames.
+    virtual bool HashProperties(uint64_t& hash) const
+    {
+        return false;
+    }
+
+    // Folds everything that affects what this layer and its children paint into |hash|.
+    virtual bool HashContent(uint64_t& hash) const
+    {
+        return HashProperties(hash);
+    }
+
+    // Allows walking the tree without RTTI.
+    virtual const ContainerLayer* AsContainerLayer() const
+    {
+        return nullptr;
+    }
 
     ContainerLayer* parent() const
     {
@@ -65,14 +113,21 @@ public:
         return !paintBounds_.isEmpty();
     }
 
+    // Identifies the layer across frames, assigned by LayerTreeBuilder from the position of
+    // the layer in the tree.
     uint64_t GetUniqueId() const
     {
         return uniqueId_;
     }
 
+    void SetUniqueId(uint64_t uniqueId)
+    {
+        uniqueId_ = uniqueId;
+    }
+
 private:
-    ContainerLayer* parent_;
-    SkRect paintBounds_;
+    ContainerLayer* parent_ = nullptr;
+    SkRect paintBounds_ = SkRect::MakeEmpty();
     bool needsSystemComposite_ = false;
     uint64_t uniqueId_ = DEAFAULT_UNIQUEID;
 
@@ -9,13 +9,155 @@
 
 #include "third_party/skia/include/core/SkMatrix.h"
 
+#include "flutter/flow/ohos_layers/container_layer.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
+
 namespace flutter::OHOS {
 
 void LayerTree::Prepare()
 {
-    SkMatrix skMatrix;
-    skMatrix.setIdentity();
-    rootLayer_->Prepare(skMatrix);
+    // The trees of consecutive frames are prepared on the same thread, but may be painted
+    // on another one. The cache is only touched here: what was not used by the last frame
+    // is swept before this frame is prepared rather than after the last one is painted,
+    // and the layers keep their own references to the rasterized images.
+    RasterCache& rasterCache = RasterCache::GetForCurrentThread();
+    rasterCache.SweepAfterFrame();
+    Prepare(&rasterCache, SkMatrix::I());
+    rasterCache_ = nullptr;
+}
+
+void LayerTree::Prepare(RasterCache* rasterCache, const SkMatrix& rootMatrix, GrContext* grContext)
+{
+    rasterCache_ = rasterCache;
+    PrepareContext context;
+    context.rasterCache = rasterCache;
+    context.grContext = grContext;
+    SkMatrix inverseRootMatrix;
+    if (!treeSize_.isEmpty() && rootMatrix.invert(&inverseRootMatrix)) {
+        inverseRootMatrix.mapRect(&context.cullRect, SkRect::Make(treeSize_));
+    }
+    rootMatrix_ = rootMatrix;
+
+    if (!trackDamage_) {
+        rootLayer_->Prepare(&context, rootMatrix);
+        return;
+    }
+
+    // Reused subtrees are shared with the previous tree and prepared again, so everything
+    // needed for diffing is copied out now rather than read from the layers later.
+    std::unordered_map<uint64_t, SkRect> deviceBounds;
+    context.deviceBounds = &deviceBounds;
+    rootLayer_->Prepare(&context, rootMatrix);
+    deviceBounds[rootLayer_->GetUniqueId()] = rootMatrix.mapRect(rootLayer_->GetPaintBounds());
+    snapshots_.clear();
+    TakeSnapshot(*rootLayer_, deviceBounds);
+}
+
+const LayerTree::LayerSnapshot& LayerTree::TakeSnapshot(const Layer& layer,
+    const std::unordered_map<uint64_t, SkRect>& deviceBounds)
+{
+    LayerSnapshot snapshot;
+    snapshot.propertiesHashable = layer.HashProperties(snapshot.propertiesHash);
+    snapshot.contentHash = snapshot.propertiesHash;
+    snapshot.contentHashable = snapshot.propertiesHashable;
+    auto bounds = deviceBounds.find(layer.GetUniqueId());
+    if (bounds != deviceBounds.end()) {
+        snapshot.deviceBounds = bounds->second;
+    }
+
+    if (const ContainerLayer* container = layer.AsContainerLayer()) {
+        HashCombine(snapshot.contentHash, container->GetLayers().size());
+        for (auto& child : container->GetLayers()) {
+            const LayerSnapshot& childSnapshot = TakeSnapshot(*child, deviceBounds);
+            snapshot.contentHashable = snapshot.contentHashable && childSnapshot.contentHashable;
+            HashCombine(snapshot.contentHash, childSnapshot.contentHash);
+            snapshot.children.push_back(child->GetUniqueId());
+        }
+    }
+
+    LayerSnapshot& result = snapshots_[layer.GetUniqueId()];
+    result = std::move(snapshot);
+    return result;
+}
+
+void LayerTree::DiffLayer(uint64_t uniqueId, const LayerSnapshots& current, const LayerSnapshots& previous,
+    SkRect& damage)
+{
+    const LayerSnapshot& currentSnapshot = current.at(uniqueId);
+    auto it = previous.find(uniqueId);
+    if (it == previous.end()) {
+        damage.join(currentSnapshot.deviceBounds);
+        return;
+    }
+    const LayerSnapshot& previousSnapshot = it->second;
+
+    if (currentSnapshot.contentHashable && previousSnapshot.contentHashable &&
+        currentSnapshot.contentHash == previousSnapshot.contentHash &&
+        currentSnapshot.deviceBounds == previousSnapshot.deviceBounds) {
+        return;
+    }
+
+    bool sameProperties = currentSnapshot.propertiesHashable && previousSnapshot.propertiesHashable &&
+        currentSnapshot.propertiesHash == previousSnapshot.propertiesHash;
+    if (!sameProperties || (currentSnapshot.children.empty() && previousSnapshot.children.empty())) {
+        damage.join(currentSnapshot.deviceBounds);
+        damage.join(previousSnapshot.deviceBounds);
+        return;
+    }
+
+    // Only the children changed. Children that exist in both frames must keep their paint
+    // order, otherwise overlapping children would not be repainted.
+    std::vector<uint64_t> keptChildren;
+    for (uint64_t child : currentSnapshot.children) {
+        if (previous.count(child) != 0) {
+            keptChildren.push_back(child);
+        }
+    }
+    size_t keptIndex = 0;
+    for (uint64_t child : previousSnapshot.children) {
+        if (current.count(child) == 0) {
+            damage.join(previous.at(child).deviceBounds);
+            continue;
+        }
+        if (keptIndex >= keptChildren.size() || keptChildren[keptIndex] != child) {
+            damage.join(currentSnapshot.deviceBounds);
+            damage.join(previousSnapshot.deviceBounds);
+            return;
+        }
+        keptIndex++;
+    }
+    for (uint64_t child : currentSnapshot.children) {
+        DiffLayer(child, current, previous, damage);
+    }
+}
+
+SkRect LayerTree::ComputeDamage(const LayerTree* previous) const
+{
+    SkRect frameRect = SkRect::Make(treeSize_);
+    if (previous == nullptr || !trackDamage_ || !previous->trackDamage_ || previous->treeSize_ != treeSize_ ||
+        previous->rootMatrix_ != rootMatrix_ || snapshots_.empty() || previous->snapshots_.empty() ||
+        previous->rootLayer_->GetUniqueId() != rootLayer_->GetUniqueId()) {
+        return frameRect;
+    }
+
+    SkRect damage = SkRect::MakeEmpty();
+    DiffLayer(rootLayer_->GetUniqueId(), snapshots_, previous->snapshots_, damage);
+    if (!treeSize_.isEmpty() && !damage.intersect(frameRect)) {
+        return SkRect::MakeEmpty();
+    }
+    SkIRect roundedDamage;
+    damage.roundOut(&roundedDamage);
+    return SkRect::Make(roundedDamage);
+}
+
+void LayerTree::Paint(const PaintContext& paintContext) const
+{
+    if (rootLayer_->NeedsPainting()) {
+        rootLayer_->Paint(paintContext);
+    }
+    if (rasterCache_ != nullptr) {
+        rasterCache_->SweepAfterFrame();
+    }
 }
 
 } // namespace flutter::OHOS
@@ -10,11 +10,15 @@
 
 #include <memory>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 #include "third_party/skia/include/core/SkPicture.h"
 #include "third_party/skia/include/core/SkSize.h"
 
 #include "flutter/flow/ohos_layers/layer.h"
+#include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/raster_cache.h"
 
 namespace flutter::OHOS {
 
@@ -38,11 +42,74 @@ public:
         treeSize_ = treeSize;
     }
 
+    // Prepares the tree to be painted into a canvas of identity matrix, with the raster
+    // cache of the current thread.
     void Prepare();
 
+    // Prepares the tree so that static pictures and opacity subtrees are rasterized into
+    // |rasterCache| and blitted on later frames. |rootMatrix| is the total matrix of the
+    // canvas the tree is painted into, entries rasterized for another matrix are not used.
+    void Prepare(RasterCache* rasterCache, const SkMatrix& rootMatrix, GrContext* grContext = nullptr);
+
+    // Paints the root layer, then sweeps the raster cache the tree was prepared with.
+    void Paint(const PaintContext& paintContext) const;
+
+    // When enabled, Prepare records what every layer paints so that ComputeDamage can diff
+    // the tree against the tree of the next frame.
+    void SetTrackDamage(bool trackDamage)
+    {
+        trackDamage_ = trackDamage;
+    }
+
+    bool GetTrackDamage() const
+    {
+        return trackDamage_;
+    }
+
+    // Returns the device space area in which this tree paints differently from |previous|.
+    // Both trees must have been prepared with damage tracking, otherwise the whole frame is
+    // damaged.
+    SkRect ComputeDamage(const LayerTree* previous) const;
+
+    // In retained mode, the tree this one was built from, see
+    // LayerTreeBuilder::SetRetainedMode. It is not painted anymore.
+    void SetPreviousTree(std::shared_ptr<const LayerTree> previousTree)
+    {
+        previousTree_ = std::move(previousTree);
+    }
+
+    // Returns the device space area in which this tree paints differently from the tree it
+    // was built from in retained mode, or the whole frame if there is none.
+    SkRect ComputeDamage() const
+    {
+        return ComputeDamage(previousTree_.get());
+    }
+
 private:
+    struct LayerSnapshot {
+        bool propertiesHashable = false;
+        uint64_t propertiesHash = 0;
+        bool contentHashable = false;
+        uint64_t contentHash = 0;
+        SkRect deviceBounds = SkRect::MakeEmpty();
+        std::vector<uint64_t> children;
+    };
+
+    using LayerSnapshots = std::unordered_map<uint64_t, LayerSnapshot>;
+
+    // Records |layer| and its children into snapshots_, returns the snapshot of |layer|.
+    const LayerSnapshot& TakeSnapshot(const Layer& layer, const std::unordered_map<uint64_t, SkRect>& deviceBounds);
+
+    static void DiffLayer(uint64_t uniqueId, const LayerSnapshots& current, const LayerSnapshots& previous,
+        SkRect& damage);
+
     SkISize treeSize_ { 0, 0 }; // Physical pixels.
     std::shared_ptr<Layer> rootLayer_;
+    RasterCache* rasterCache_ = nullptr;
+    SkMatrix rootMatrix_ = SkMatrix::I();
+    bool trackDamage_ = false;
+    LayerSnapshots snapshots_;
+    std::shared_ptr<const LayerTree> previousTree_;
 
     FML_DISALLOW_COPY_AND_ASSIGN(LayerTree);
 };
@@ -119,7 +119,7 @@ void LayerTreeBuilder::AddPicture(double dx, double dy, sk_sp<SkPicture> picture
     SkRect pictureRect = picture->cullRect();
     pictureRect.offset(offset.x(), offset.y());
     auto layer = std::make_shared<PictureLayer>(offset, picture);
-    currentLayer_->Add(std::move(layer));
+    AddLayer(layer);
 }
 
 void LayerTreeBuilder::AddTexture(double dx, double dy, double width, double height,
@@ -129,12 +129,13 @@ void LayerTreeBuilder::AddTexture(double dx, double dy, double width, double hei
         return;
     }
     auto layer = std::make_shared<TextureLayer>(SkPoint::Make(dx, dy), SkSize::Make(width, height), textureId, opacity);
-    currentLayer_->Add(std::move(layer));
+    AddLayer(layer);
 }
 
 void LayerTreeBuilder::PushLayer(const std::shared_ptr<ContainerLayer>& layer)
 {
     if (!rootLayer_) {
+        layer->SetUniqueId(ROOT_LAYER_ID);
         rootLayer_ = layer;
         currentLayer_ = layer.get();
         return;
@@ -144,10 +145,61 @@ void LayerTreeBuilder::PushLayer(const std::shared_ptr<ContainerLayer>& layer)
         return;
     }
 
-    currentLayer_->Add(layer);
+    AddLayer(layer);
     currentLayer_ = layer.get();
 }
 
+void LayerTreeBuilder::AddLayer(const std::shared_ptr<Layer>& layer)
+{
+    layer->SetUniqueId(GetNextChildId());
+    currentLayer_->Add(layer);
+}
+
+uint64_t LayerTreeBuilder::GetNextChildId() const
+{
+    uint64_t uniqueId = currentLayer_->GetUniqueId();
+    HashCombine(uniqueId, currentLayer_->GetLayers().size());
+    return uniqueId;
+}
+
+void LayerTreeBuilder::SetRetainedMode(std::unique_ptr<LayerTree> previousTree)
+{
+    retainedMode_ = true;
+    retainedLayers_.clear();
+    if (previousTree != nullptr) {
+        // Only the last frame is diffed against, older trees can go.
+        previousTree->SetPreviousTree(nullptr);
+        if (previousTree->GetRootLayer()) {
+            IndexRetainedLayers(previousTree->GetRootLayer());
+        }
+    }
+    previousTree_ = std::move(previousTree);
+}
+
+void LayerTreeBuilder::IndexRetainedLayers(const std::shared_ptr<Layer>& layer)
+{
+    retainedLayers_[layer->GetUniqueId()] = layer;
+    if (const ContainerLayer* container = layer->AsContainerLayer()) {
+        for (auto& child : container->GetLayers()) {
+            IndexRetainedLayers(child);
+        }
+    }
+}
+
+bool LayerTreeBuilder::AddRetained()
+{
+    if (currentLayer_ == nullptr) {
+        return false;
+    }
+    auto it = retainedLayers_.find(GetNextChildId());
+    if (it == retainedLayers_.end()) {
+        return false;
+    }
+    currentLayer_->Add(it->second);
+    retainedLayers_.erase(it);
+    return true;
+}
+
 void LayerTreeBuilder::Pop()
 {
     if (currentLayer_ == nullptr) {
@@ -158,7 +210,10 @@ void LayerTreeBuilder::Pop()
 
 std::unique_ptr<LayerTree> LayerTreeBuilder::GetLayerTree() const
 {
-    return std::make_unique<LayerTree>(rootLayer_);
+    auto layerTree = std::make_unique<LayerTree>(rootLayer_);
+    layerTree->SetTrackDamage(retainedMode_);
+    layerTree->SetPreviousTree(previousTree_);
+    return layerTree;
 }
 
 } // namespace flutter::OHOS
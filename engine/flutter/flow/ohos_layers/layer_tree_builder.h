@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <memory>
 #include <stack>
+#include <unordered_map>
 
 #include "experimental/svg/model/SkSVGDOM.h"
 #include "third_party/skia/include/core/SkImageFilter.h"
@@ -54,11 +55,36 @@ public:
     void Pop();
     std::unique_ptr<LayerTree> GetLayerTree() const;
 
+    // Enables retained mode: the built tree tracks damage against |previousTree|, and the
+    // subtrees of |previousTree| can be reused through AddRetained. |previousTree| may be
+    // null for the first frame. The builder takes |previousTree| over: the layers it hands
+    // to the new tree are prepared again for it, so |previousTree| must not be painted
+    // anymore, and it is only kept to diff the new tree against, see
+    // LayerTree::ComputeDamage.
+    void SetRetainedMode(std::unique_ptr<LayerTree> previousTree);
+
+    // Moves the layer of the previous tree that was at the position of the next child of the
+    // current layer into the new tree, for callers that know that subtree did not change.
+    // Returns false if there is no such layer, in which case the caller must build the
+    // subtree again.
+    bool AddRetained();
+
 private:
     void PushLayer(const std::shared_ptr<ContainerLayer>& layer);
 
+    void AddLayer(const std::shared_ptr<Layer>& layer);
+
+    // Identities are derived from the position of the layer in the tree, so the layers
+    // built for the same position in consecutive frames share the same id.
+    uint64_t GetNextChildId() const;
+
+    void IndexRetainedLayers(const std::shared_ptr<Layer>& layer);
+
     std::shared_ptr<ContainerLayer> rootLayer_;
     ContainerLayer* currentLayer_ = nullptr;
+    bool retainedMode_ = false;
+    std::shared_ptr<const LayerTree> previousTree_;
+    std::unordered_map<uint64_t, std::shared_ptr<Layer>> retainedLayers_;
 
     FML_DISALLOW_COPY_AND_ASSIGN(LayerTreeBuilder);
 };
@@ -0,0 +1,157 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/ohos_layers/layer_tree_builder.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+
+#include "flutter/flow/ohos_layers/clip_path_layer.h"
+#include "flutter/flow/ohos_layers/clip_rect_layer.h"
+#include "flutter/flow/ohos_layers/clip_rrect_layer.h"
+#include "flutter/flow/ohos_layers/opacity_layer.h"
+#include "flutter/flow/ohos_layers/transform_layer.h"
+
+namespace flutter::OHOS {
+namespace {
+
+constexpr int PICTURE_SIZE = 20;
+constexpr int FRAME_SIZE = 100;
+constexpr double SECOND_PICTURE_OFFSET = 50;
+
+sk_sp<SkPicture> MakePicture(SkColor color)
+{
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE));
+    SkPaint paint;
+    paint.setColor(color);
+    canvas->drawRect(SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE), paint);
+    return recorder.finishRecordingAsPicture();
+}
+
+void PrepareTree(LayerTree& layerTree)
+{
+    layerTree.SetFrameSize(SkISize::Make(FRAME_SIZE, FRAME_SIZE));
+    layerTree.Prepare(nullptr, SkMatrix::I());
+}
+
+// Builds a tree with |first| at the origin and |second| in an offset subtree.
+std::unique_ptr<LayerTree> BuildTree(LayerTreeBuilder& builder, sk_sp<SkPicture> first, sk_sp<SkPicture> second)
+{
+    builder.PushOffset(0, 0);
+    builder.AddPicture(0, 0, std::move(first));
+    builder.PushOffset(SECOND_PICTURE_OFFSET, 0);
+    builder.AddPicture(0, 0, std::move(second));
+    builder.Pop();
+    builder.Pop();
+    auto layerTree = builder.GetLayerTree();
+    PrepareTree(*layerTree);
+    return layerTree;
+}
+
+} // namespace
+
+TEST(OHOSLayerTreeBuilderTest, LayersAtTheSamePositionKeepTheirIdAcrossFrames)
+{
+    LayerTreeBuilder firstBuilder;
+    auto firstTree = BuildTree(firstBuilder, MakePicture(SK_ColorRED), MakePicture(SK_ColorBLUE));
+    LayerTreeBuilder secondBuilder;
+    auto secondTree = BuildTree(secondBuilder, MakePicture(SK_ColorGREEN), MakePicture(SK_ColorBLUE));
+
+    const auto& firstChildren = firstTree->GetRootLayer()->AsContainerLayer()->GetLayers();
+    const auto& secondChildren = secondTree->GetRootLayer()->AsContainerLayer()->GetLayers();
+    ASSERT_EQ(firstChildren.size(), 2u);
+    ASSERT_EQ(secondChildren.size(), 2u);
+    for (size_t i = 0; i < firstChildren.size(); i++) {
+        ASSERT_EQ(firstChildren[i]->GetUniqueId(), secondChildren[i]->GetUniqueId());
+    }
+    ASSERT_NE(firstChildren[0]->GetUniqueId(), firstChildren[1]->GetUniqueId());
+}
+
+TEST(OHOSLayerTreeBuilderTest, RetainedLayersAreMovedIntoTheNewTree)
+{
+    auto picture = MakePicture(SK_ColorBLUE);
+    LayerTreeBuilder firstBuilder;
+    firstBuilder.SetRetainedMode(nullptr);
+    auto firstTree = BuildTree(firstBuilder, MakePicture(SK_ColorRED), picture);
+    auto retained = firstTree->GetRootLayer()->AsContainerLayer()->GetLayers()[1];
+
+    LayerTreeBuilder secondBuilder;
+    secondBuilder.SetRetainedMode(std::move(firstTree));
+    secondBuilder.PushOffset(0, 0);
+    secondBuilder.AddPicture(0, 0, MakePicture(SK_ColorGREEN));
+    ASSERT_TRUE(secondBuilder.AddRetained());
+    // The previous tree had nothing at the next position.
+    ASSERT_FALSE(secondBuilder.AddRetained());
+    secondBuilder.Pop();
+    auto secondTree = secondBuilder.GetLayerTree();
+    PrepareTree(*secondTree);
+
+    const auto& children = secondTree->GetRootLayer()->AsContainerLayer()->GetLayers();
+    ASSERT_EQ(children.size(), 2u);
+    ASSERT_EQ(children[1], retained);
+    ASSERT_EQ(retained->parent(), secondTree->GetRootLayer().get());
+    ASSERT_EQ(retained->GetPaintBounds(),
+        SkRect::MakeXYWH(SECOND_PICTURE_OFFSET, 0, PICTURE_SIZE, PICTURE_SIZE));
+}
+
+TEST(OHOSLayerTreeBuilderTest, RetainedTreesOnlyDamageWhatChanged)
+{
+    auto picture = MakePicture(SK_ColorBLUE);
+    LayerTreeBuilder firstBuilder;
+    firstBuilder.SetRetainedMode(nullptr);
+    auto firstTree = BuildTree(firstBuilder, MakePicture(SK_ColorRED), picture);
+    // There is nothing to diff the first frame against.
+    ASSERT_EQ(firstTree->ComputeDamage(), SkRect::MakeWH(FRAME_SIZE, FRAME_SIZE));
+
+    LayerTreeBuilder secondBuilder;
+    secondBuilder.SetRetainedMode(std::move(firstTree));
+    auto secondTree = BuildTree(secondBuilder, MakePicture(SK_ColorGREEN), picture);
+    ASSERT_EQ(secondTree->ComputeDamage(), SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE));
+
+    LayerTreeBuilder thirdBuilder;
+    thirdBuilder.SetRetainedMode(std::move(secondTree));
+    thirdBuilder.PushOffset(0, 0);
+    ASSERT_TRUE(thirdBuilder.AddRetained());
+    ASSERT_TRUE(thirdBuilder.AddRetained());
+    thirdBuilder.Pop();
+    auto thirdTree = thirdBuilder.GetLayerTree();
+    PrepareTree(*thirdTree);
+    ASSERT_TRUE(thirdTree->ComputeDamage().isEmpty());
+}
+
+TEST(OHOSLayerTreeBuilderTest, TreesWithoutDamageTrackingAreFullyDamaged)
+{
+    LayerTreeBuilder firstBuilder;
+    auto firstTree = BuildTree(firstBuilder, MakePicture(SK_ColorRED), MakePicture(SK_ColorBLUE));
+    LayerTreeBuilder secondBuilder;
+    auto secondTree = BuildTree(secondBuilder, MakePicture(SK_ColorRED), MakePicture(SK_ColorBLUE));
+    ASSERT_EQ(secondTree->ComputeDamage(firstTree.get()), SkRect::MakeWH(FRAME_SIZE, FRAME_SIZE));
+}
+
+TEST(OHOSLayerTreeBuilderTest, LayersOfDifferentTypesHashDifferently)
+{
+    const SkRect rect = SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE);
+    SkPath path;
+    path.addRect(rect);
+    const std::shared_ptr<Layer> layers[] = {
+        std::make_shared<TransformLayer>(SkMatrix::I()),
+        std::make_shared<OpacityLayer>(0, SkPoint::Make(0, 0)),
+        std::make_shared<ClipRectLayer>(rect, Clip::NONE),
+        std::make_shared<ClipRRectLayer>(SkRRect::MakeRect(rect), Clip::NONE),
+        std::make_shared<ClipPathLayer>(path, Clip::NONE),
+    };
+    std::vector<uint64_t> hashes;
+    for (const auto& layer : layers) {
+        uint64_t hash = 0;
+        ASSERT_TRUE(layer->HashProperties(hash));
+        ASSERT_EQ(std::count(hashes.begin(), hashes.end(), hash), 0);
+        hashes.push_back(hash);
+    }
+}
+
+} // namespace flutter::OHOS
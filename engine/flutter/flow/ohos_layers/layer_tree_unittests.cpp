@@ -0,0 +1,171 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/ohos_layers/layer_tree.h"
+
+#include "gtest/gtest.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "third_party/skia/include/effects/SkImageFilters.h"
+#include "third_party/skia/include/utils/SkNoDrawCanvas.h"
+
+#include "flutter/flow/ohos_layers/backdrop_filter_layer.h"
+#include "flutter/flow/ohos_layers/clip_rect_layer.h"
+#include "flutter/flow/ohos_layers/filter_layer.h"
+#include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/picture_layer.h"
+#include "flutter/flow/ohos_layers/transform_layer.h"
+
+namespace flutter::OHOS {
+namespace {
+
+constexpr int PICTURE_SIZE = 20;
+constexpr int RECT_COUNT = 10;
+constexpr int FRAME_SIZE = 100;
+constexpr SkScalar BLUR_SIGMA = 5;
+
+sk_sp<SkPicture> MakePicture()
+{
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE));
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    // Enough operations for the picture to be worth rasterizing.
+    for (int i = 0; i < RECT_COUNT; i++) {
+        canvas->drawRect(SkRect::MakeXYWH(0, 0, PICTURE_SIZE, PICTURE_SIZE), paint);
+    }
+    return recorder.finishRecordingAsPicture();
+}
+
+class TestPaintContext : public PaintContext {
+public:
+    explicit TestPaintContext(SkCanvas* canvas) : PaintContext(canvas, nullptr) {}
+    ~TestPaintContext() override = default;
+
+    void Paint(int64_t textureId, const SkPoint& offset, uint8_t opacity) const override {}
+};
+
+// Counts the pictures drawn into a frame.
+class PictureCountingCanvas : public SkNoDrawCanvas {
+public:
+    PictureCountingCanvas() : SkNoDrawCanvas(FRAME_SIZE, FRAME_SIZE) {}
+    ~PictureCountingCanvas() override = default;
+
+    size_t GetPictureCount() const
+    {
+        return pictureCount_;
+    }
+
+protected:
+    void onDrawPicture(const SkPicture* picture, const SkMatrix* matrix, const SkPaint* paint) override
+    {
+        pictureCount_++;
+    }
+
+private:
+    size_t pictureCount_ = 0;
+};
+
+// Returns the number of pictures of |root| rasterized into a raster cache when it is prepared.
+size_t CountCachedPictures(const std::shared_ptr<Layer>& root)
+{
+    RasterCache cache(1);
+    LayerTree layerTree(root);
+    layerTree.SetFrameSize(SkISize::Make(FRAME_SIZE, FRAME_SIZE));
+    layerTree.Prepare(&cache, SkMatrix::I());
+    return cache.GetPictureCacheCount();
+}
+
+// Returns the number of pictures of |root| drawn when it is painted.
+size_t CountPaintedPictures(const std::shared_ptr<Layer>& root)
+{
+    LayerTree layerTree(root);
+    layerTree.SetFrameSize(SkISize::Make(FRAME_SIZE, FRAME_SIZE));
+    layerTree.Prepare(nullptr, SkMatrix::I());
+    PictureCountingCanvas canvas;
+    TestPaintContext paintContext(&canvas);
+    layerTree.Paint(paintContext);
+    return canvas.GetPictureCount();
+}
+
+} // namespace
+
+TEST(OHOSLayerTreeTest, ChildrenOutsideOfTheFrameAreCulled)
+{
+    auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+    root->Add(std::make_shared<PictureLayer>(SkPoint::Make(10, 10), MakePicture()));
+    root->Add(std::make_shared<PictureLayer>(SkPoint::Make(FRAME_SIZE + 10, 10), MakePicture()));
+
+    ASSERT_EQ(CountCachedPictures(root), 1u);
+    ASSERT_EQ(CountPaintedPictures(root), 1u);
+}
+
+TEST(OHOSLayerTreeTest, ChildrenOutsideOfTheirClipAreCulled)
+{
+    auto root = std::make_shared<TransformLayer>(SkMatrix::MakeTrans(10, 10));
+    auto clip = std::make_shared<ClipRectLayer>(SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE), Clip::HARDEDGE);
+    root->Add(clip);
+    clip->Add(std::make_shared<PictureLayer>(SkPoint::Make(0, 0), MakePicture()));
+    // In the frame, but not in the clip.
+    clip->Add(std::make_shared<PictureLayer>(SkPoint::Make(PICTURE_SIZE * 2, 0), MakePicture()));
+
+    ASSERT_EQ(CountCachedPictures(root), 1u);
+    ASSERT_EQ(CountPaintedPictures(root), 1u);
+    ASSERT_EQ(clip->GetPaintBounds(), SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE));
+}
+
+TEST(OHOSLayerTreeTest, CollapsedTransformsPaintNothing)
+{
+    auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+    // Maps the children onto a diagonal line, whose bounds are not empty.
+    auto collapsed = std::make_shared<TransformLayer>(SkMatrix::MakeAll(1, 1, 0, 1, 1, 0, 0, 0, 1));
+    root->Add(collapsed);
+    collapsed->Add(std::make_shared<PictureLayer>(SkPoint::Make(10, 10), MakePicture()));
+
+    ASSERT_EQ(CountCachedPictures(root), 0u);
+    ASSERT_EQ(CountPaintedPictures(root), 0u);
+    ASSERT_TRUE(collapsed->GetPaintBounds().isEmpty());
+}
+
+TEST(OHOSLayerTreeTest, BlurredChildrenArePaintedWhileTheirBlurIsInTheFrame)
+{
+    auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+    SkPaint blurPaint;
+    blurPaint.setImageFilter(SkImageFilters::Blur(BLUR_SIGMA, BLUR_SIGMA, nullptr));
+    auto filter = std::make_shared<FilterLayer>(blurPaint);
+    root->Add(filter);
+    // Just right of the frame.
+    filter->Add(std::make_shared<PictureLayer>(SkPoint::Make(FRAME_SIZE + 1, 10), MakePicture()));
+
+    LayerTree layerTree(root);
+    layerTree.SetFrameSize(SkISize::Make(FRAME_SIZE, FRAME_SIZE));
+    layerTree.Prepare(nullptr, SkMatrix::I());
+    ASSERT_LT(filter->GetPaintBounds().left(), FRAME_SIZE);
+
+    auto surface = SkSurface::MakeRasterN32Premul(FRAME_SIZE, FRAME_SIZE);
+    surface->getCanvas()->clear(SK_ColorTRANSPARENT);
+    TestPaintContext paintContext(surface->getCanvas());
+    layerTree.Paint(paintContext);
+    SkPixmap pixels;
+    ASSERT_TRUE(surface->peekPixels(&pixels));
+    ASSERT_NE(pixels.getColor(FRAME_SIZE - 1, 10 + PICTURE_SIZE / 2), SK_ColorTRANSPARENT);
+}
+
+TEST(OHOSLayerTreeTest, BackdropFiltersPaintPastTheirChildren)
+{
+    auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+    auto backdrop = std::make_shared<BackdropFilterLayer>(SkImageFilters::Blur(BLUR_SIGMA, BLUR_SIGMA, nullptr));
+    root->Add(backdrop);
+    backdrop->Add(std::make_shared<PictureLayer>(SkPoint::Make(10, 10), MakePicture()));
+
+    LayerTree layerTree(root);
+    layerTree.SetFrameSize(SkISize::Make(FRAME_SIZE, FRAME_SIZE));
+    layerTree.Prepare(nullptr, SkMatrix::I());
+    SkRect childBounds = SkRect::MakeXYWH(10, 10, PICTURE_SIZE, PICTURE_SIZE);
+    ASSERT_TRUE(backdrop->GetPaintBounds().contains(childBounds));
+    ASSERT_NE(backdrop->GetPaintBounds(), childBounds);
+}
+
+} // namespace flutter::OHOS
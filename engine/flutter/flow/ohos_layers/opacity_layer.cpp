@@ -8,16 +8,45 @@
 #include "flutter/flow/ohos_layers/opacity_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 #include "flutter/flow/ohos_layers/transform_layer.h"
 
 namespace  flutter::OHOS {
 
-void OpacityLayer::Prepare(const SkMatrix& matrix)
+namespace {
+
+// Paints the children of a cacheable opacity layer into a raster cache entry. Cacheable
+// subtrees never contain textures, so there is nothing to forward to the embedder.
+struct RasterCachePaintContext : public PaintContext {
+    explicit RasterCachePaintContext(SkCanvas* canvas) : PaintContext(canvas, nullptr) {}
+    ~RasterCachePaintContext() override = default;
+    void Paint(int64_t textureId, const SkPoint& offset, uint8_t opacity) const override {}
+};
+
+} // namespace
+
+void OpacityLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkMatrix childMatrix = matrix;
-    childMatrix.postTranslate(offset_.fX, offset_.fY);
-    ContainerLayer::Prepare(childMatrix);
+    childMatrix.preTranslate(offset_.fX, offset_.fY);
+    SkRect previousCullRect = context->cullRect;
+    context->cullRect.offset(-offset_.fX, -offset_.fY);
+    ContainerLayer::Prepare(context, childMatrix);
+    context->cullRect = previousCullRect;
     SetPaintBounds(GetPaintBounds().makeOffset(offset_.fX, offset_.fY));
+
+    // The children are cached without the alpha, so fading animations reuse the same entry.
+    childrenCache_ = RasterCacheResult();
+    uint64_t contentHash = 0;
+    if (context->rasterCache != nullptr && SkRect::Intersects(context->cullRect, GetPaintBounds()) &&
+        HashChildren(contentHash)) {
+        SkRect childBounds = GetPaintBounds().makeOffset(-offset_.fX, -offset_.fY);
+        childrenCache_ = context->rasterCache->Prepare(context->grContext, contentHash, childBounds,
+            RasterCache::GetIntegralTransMatrix(childMatrix), [this](SkCanvas* canvas) {
+                RasterCachePaintContext cachePaintContext(canvas);
+                PaintChildren(cachePaintContext);
+            });
+    }
 }
 
 void OpacityLayer::Paint(const PaintContext& paintContext) const
@@ -26,6 +55,14 @@ void OpacityLayer::Paint(const PaintContext& paintContext) const
     paint.setAlpha(alpha_);
     SkAutoCanvasRestore save(paintContext.skCanvas, true);
     paintContext.skCanvas->translate(offset_.fX, offset_.fY);
+    if (childrenCache_.IsValid()) {
+        SkMatrix ctm = RasterCache::GetIntegralTransMatrix(paintContext.skCanvas->getTotalMatrix());
+        if (childrenCache_.CanDrawWith(ctm)) {
+            paintContext.skCanvas->setMatrix(ctm);
+            childrenCache_.Draw(*paintContext.skCanvas, &paint);
+            return;
+        }
+    }
     SkRect saveLayerBounds;
     GetPaintBounds().makeOffset(-offset_.fX, -offset_.fY).roundOut(&saveLayerBounds);
     paintContext.skCanvas->saveLayer(saveLayerBounds, &paint);
@@ -33,4 +70,13 @@ void OpacityLayer::Paint(const PaintContext& paintContext) const
     paintContext.skCanvas->restore();
 }
 
+bool OpacityLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::OPACITY);
+    HashCombine(hash, static_cast<uint64_t>(alpha_));
+    const SkScalar offset[] = { offset_.fX, offset_.fY };
+    HashCombine(hash, offset, sizeof(offset) / sizeof(SkScalar));
+    return true;
+}
+
 }  // namespace  flutter::OHOS
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "third_party/skia/include/core/SkPoint.h"
 
 #include "flutter/flow/ohos_layers/container_layer.h"
+#include "flutter/flow/ohos_layers/raster_cache.h"
 
 namespace  flutter::OHOS {
 
@@ -22,13 +23,16 @@ public:
         : alpha_(alpha), offset_(offset) {}
     ~OpacityLayer() override = default;
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
+    bool HashProperties(uint64_t& hash) const override;
+
 private:
     int32_t alpha_ = DEAFAULT_ALPHA;
     SkPoint offset_;
+    RasterCacheResult childrenCache_;
 
     FML_DISALLOW_COPY_AND_ASSIGN(OpacityLayer);
 };
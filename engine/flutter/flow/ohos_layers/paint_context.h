@@ -8,13 +8,17 @@
 #ifndef FLUTTER_FLOW_OHOS_LAYERS_PAINT_CONTEXT_H
 #define FLUTTER_FLOW_OHOS_LAYERS_PAINT_CONTEXT_H
 
+#include <memory>
+
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkPoint.h"
 
-#include "flutter/flow/ohos_layers/texture_register.h"
-
 namespace flutter::OHOS {
 
+// Defined in texture_register.h, which is only built for Android as it
+// reaches the textures over JNI.
+class TextureRegistry;
+
 struct PaintContext {
   PaintContext(SkCanvas* skCvs,
                const std::shared_ptr<flutter::OHOS::TextureRegistry>& texReg)
@@ -8,20 +8,46 @@
 #include "flutter/flow/ohos_layers/picture_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
-void PictureLayer::Prepare(const SkMatrix& matrix)
+void PictureLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkRect bounds = GetPicture()->cullRect().makeOffset(offset_.x(), offset_.y());
     SetPaintBounds(bounds);
+
+    cacheResult_ = RasterCacheResult();
+    if (context->rasterCache != nullptr && SkRect::Intersects(context->cullRect, bounds)) {
+        SkMatrix ctm = matrix;
+        ctm.preTranslate(offset_.x(), offset_.y());
+        cacheResult_ = context->rasterCache->Prepare(context->grContext, GetPicture(),
+            RasterCache::GetIntegralTransMatrix(ctm));
+    }
 }
 
 void PictureLayer::Paint(const PaintContext& paintContext) const
 {
     SkAutoCanvasRestore save(paintContext.skCanvas, true);
     paintContext.skCanvas->translate(offset_.x(), offset_.y());
+    if (cacheResult_.IsValid()) {
+        SkMatrix ctm = RasterCache::GetIntegralTransMatrix(paintContext.skCanvas->getTotalMatrix());
+        if (cacheResult_.CanDrawWith(ctm)) {
+            paintContext.skCanvas->setMatrix(ctm);
+            cacheResult_.Draw(*paintContext.skCanvas);
+            return;
+        }
+    }
     paintContext.skCanvas->drawPicture(GetPicture());
 }
 
+bool PictureLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::PICTURE);
+    HashCombine(hash, GetPicture()->uniqueID());
+    const SkScalar offset[] = { offset_.x(), offset_.y() };
+    HashCombine(hash, offset, sizeof(offset) / sizeof(SkScalar));
+    return true;
+}
+
 } // namespace flutter::OHOS
\ No newline at end of file
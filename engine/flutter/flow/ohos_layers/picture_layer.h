@@ -13,6 +13,7 @@
 #include "third_party/skia/include/core/SkPicture.h"
 
 #include "flutter/flow/ohos_layers/layer.h"
+#include "flutter/flow/ohos_layers/raster_cache.h"
 
 namespace flutter::OHOS {
 
@@ -27,13 +28,16 @@ public:
         return picture_.get();
     }
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
+    bool HashProperties(uint64_t& hash) const override;
+
 private:
     SkPoint offset_;
     sk_sp<SkPicture> picture_;
+    RasterCacheResult cacheResult_;
 
     FML_DISALLOW_COPY_AND_ASSIGN(PictureLayer);
 };
@@ -0,0 +1,37 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_OHOS_LAYERS_PREPARE_CONTEXT_H
+#define FLUTTER_FLOW_OHOS_LAYERS_PREPARE_CONTEXT_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "third_party/skia/include/core/SkRect.h"
+
+class GrContext;
+
+namespace flutter::OHOS {
+
+class RasterCache;
+
+constexpr SkRect GIANT_RECT = SkRect::MakeLTRB(-1E9F, -1E9F, 1E9F, 1E9F);
+
+struct PrepareContext {
+    // Visible area in the coordinate space of the layer being prepared. Layers outside of
+    // it are not rasterized into the raster cache.
+    SkRect cullRect = GIANT_RECT;
+    // Optional, when set static pictures and opacity subtrees are rasterized into it.
+    RasterCache* rasterCache = nullptr;
+    // Optional, when null raster cache entries are rasterized into CPU memory.
+    GrContext* grContext = nullptr;
+    // Optional, when set the device space paint bounds of every prepared layer are recorded
+    // into it by unique id so that the tree can be diffed against the next frame.
+    std::unordered_map<uint64_t, SkRect>* deviceBounds = nullptr;
+};
+
+}  // namespace flutter::OHOS
+
+#endif  // FLUTTER_FLOW_OHOS_LAYERS_PREPARE_CONTEXT_H
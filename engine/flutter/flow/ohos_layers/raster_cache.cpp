@@ -0,0 +1,200 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/ohos_layers/raster_cache.h"
+
+#include "third_party/skia/include/core/SkSurface.h"
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/thread_local.h"
+#include "flutter/fml/trace_event.h"
+
+namespace flutter::OHOS {
+
+namespace {
+
+constexpr int MIN_PICTURE_OP_COUNT = 5;
+
+FML_THREAD_LOCAL fml::ThreadLocalUniquePtr<RasterCache> tlsRasterCache;
+
+bool IsPictureWorthRasterizing(SkPicture* picture)
+{
+    if (picture == nullptr) {
+        return false;
+    }
+    const SkRect cullRect = picture->cullRect();
+    if (cullRect.isEmpty() || !cullRect.isFinite()) {
+        return false;
+    }
+    // Trivial pictures are cheaper to replay than to keep in memory.
+    return picture->approximateOpCount() > MIN_PICTURE_OP_COUNT;
+}
+
+RasterCacheResult Rasterize(GrContext* grContext, const SkMatrix& matrix, const SkRect& logicalRect,
+    const std::function<void(SkCanvas*)>& drawFunction)
+{
+    TRACE_EVENT0("flutter", "OHOS::RasterCachePopulate");
+    SkIRect cacheRect = RasterCache::GetDeviceBounds(logicalRect, matrix);
+    if (cacheRect.isEmpty()) {
+        return {};
+    }
+
+    const SkImageInfo imageInfo = SkImageInfo::MakeN32Premul(cacheRect.width(), cacheRect.height());
+    sk_sp<SkSurface> surface = grContext != nullptr
+        ? SkSurface::MakeRenderTarget(grContext, SkBudgeted::kYes, imageInfo)
+        : SkSurface::MakeRaster(imageInfo);
+    if (!surface) {
+        return {};
+    }
+
+    SkCanvas* canvas = surface->getCanvas();
+    canvas->clear(SK_ColorTRANSPARENT);
+    canvas->translate(-cacheRect.left(), -cacheRect.top());
+    canvas->concat(matrix);
+    drawFunction(canvas);
+
+    return { surface->makeImageSnapshot(), logicalRect, matrix };
+}
+
+} // namespace
+
+bool RasterCacheResult::CanDrawWith(const SkMatrix& matrix) const
+{
+    for (int i = 0; i < 9; i++) {
+        if (i == SkMatrix::kMTransX || i == SkMatrix::kMTransY) {
+            continue;
+        }
+        if (matrix_[i] != matrix[i]) {
+            return false;
+        }
+    }
+    return SkScalarFraction(matrix_.getTranslateX()) == SkScalarFraction(matrix.getTranslateX()) &&
+        SkScalarFraction(matrix_.getTranslateY()) == SkScalarFraction(matrix.getTranslateY());
+}
+
+void RasterCacheResult::Draw(SkCanvas& canvas, const SkPaint* paint) const
+{
+    TRACE_EVENT0("flutter", "OHOS::RasterCacheResult::Draw");
+    SkAutoCanvasRestore autoRestore(&canvas, true);
+    SkIRect bounds = RasterCache::GetDeviceBounds(logicalRect_, canvas.getTotalMatrix());
+    FML_DCHECK(bounds.size() == image_->dimensions());
+    canvas.resetMatrix();
+    canvas.drawImage(image_, bounds.fLeft, bounds.fTop, paint);
+}
+
+RasterCache& RasterCache::GetForCurrentThread()
+{
+    if (tlsRasterCache.get() == nullptr) {
+        tlsRasterCache.reset(new RasterCache());
+    }
+    return *tlsRasterCache.get();
+}
+
+SkIRect RasterCache::GetDeviceBounds(const SkRect& rect, const SkMatrix& matrix)
+{
+    SkRect deviceRect;
+    matrix.mapRect(&deviceRect, rect);
+    SkIRect bounds;
+    deviceRect.roundOut(&bounds);
+    return bounds;
+}
+
+SkMatrix RasterCache::GetIntegralTransMatrix(const SkMatrix& matrix)
+{
+    SkMatrix result = matrix;
+    result[SkMatrix::kMTransX] = SkScalarRoundToScalar(matrix.getTranslateX());
+    result[SkMatrix::kMTransY] = SkScalarRoundToScalar(matrix.getTranslateY());
+    return result;
+}
+
+bool RasterCache::Touch(Entry& entry) const
+{
+    entry.usedThisFrame = true;
+    if (entry.accessCount < accessThreshold_) {
+        entry.accessCount++;
+    }
+    return accessThreshold_ != 0 && entry.accessCount >= accessThreshold_;
+}
+
+RasterCacheResult RasterCache::Prepare(GrContext* grContext, SkPicture* picture, const SkMatrix& matrix)
+{
+    if (!IsPictureWorthRasterizing(picture) || !matrix.isFinite() || !matrix.invert(nullptr)) {
+        return {};
+    }
+
+    Entry& entry = pictureCache_[PictureRasterCacheKey(picture->uniqueID(), matrix)];
+    if (!Touch(entry)) {
+        return {};
+    }
+
+    if (!entry.image.IsValid()) {
+        if (pictureCachedThisFrame_ >= pictureCacheLimitPerFrame_) {
+            return {};
+        }
+        entry.image = Rasterize(grContext, matrix, picture->cullRect(),
+            [picture](SkCanvas* canvas) { canvas->drawPicture(picture); });
+        pictureCachedThisFrame_++;
+    }
+    return entry.image;
+}
+
+RasterCacheResult RasterCache::Prepare(GrContext* grContext, uint64_t contentHash, const SkRect& bounds,
+    const SkMatrix& matrix, const std::function<void(SkCanvas*)>& drawFunction)
+{
+    if (bounds.isEmpty() || !bounds.isFinite() || !matrix.isFinite() || !matrix.invert(nullptr)) {
+        return {};
+    }
+
+    Entry& entry = layerCache_[LayerRasterCacheKey(contentHash, matrix)];
+    if (!Touch(entry)) {
+        return {};
+    }
+
+    if (!entry.image.IsValid()) {
+        entry.image = Rasterize(grContext, matrix, bounds, drawFunction);
+    }
+    return entry.image;
+}
+
+void RasterCache::SweepAfterFrame()
+{
+    SweepOneCacheAfterFrame(pictureCache_);
+    SweepOneCacheAfterFrame(layerCache_);
+    pictureCachedThisFrame_ = 0;
+    TraceStatsToTimeline();
+}
+
+void RasterCache::Clear()
+{
+    pictureCache_.clear();
+    layerCache_.clear();
+}
+
+void RasterCache::TraceStatsToTimeline() const
+{
+#if FLUTTER_RUNTIME_MODE != FLUTTER_RUNTIME_MODE_RELEASE
+    constexpr size_t BYTES_PER_PIXEL = 4;
+    size_t layerCacheBytes = 0;
+    size_t pictureCacheBytes = 0;
+
+    for (const auto& item : layerCache_) {
+        const auto dimensions = item.second.image.GetImageDimensions();
+        layerCacheBytes += dimensions.width() * dimensions.height() * BYTES_PER_PIXEL;
+    }
+
+    for (const auto& item : pictureCache_) {
+        const auto dimensions = item.second.image.GetImageDimensions();
+        pictureCacheBytes += dimensions.width() * dimensions.height() * BYTES_PER_PIXEL;
+    }
+
+    FML_TRACE_COUNTER("flutter", "OHOS::RasterCache", reinterpret_cast<int64_t>(this),
+        "LayerCount", layerCache_.size(),
+        "LayerMBytes", layerCacheBytes * 1e-6,
+        "PictureCount", pictureCache_.size(),
+        "PictureMBytes", pictureCacheBytes * 1e-6);
+#endif  // FLUTTER_RUNTIME_MODE != FLUTTER_RUNTIME_MODE_RELEASE
+}
+
+} // namespace flutter::OHOS
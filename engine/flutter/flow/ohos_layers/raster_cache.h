@@ -0,0 +1,141 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_OHOS_LAYERS_RASTER_CACHE_H
+#define FLUTTER_FLOW_OHOS_LAYERS_RASTER_CACHE_H
+
+#include <functional>
+
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkMatrix.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "third_party/skia/include/core/SkRect.h"
+
+#include "flutter/flow/raster_cache_key.h"
+#include "flutter/fml/macros.h"
+
+class GrContext;
+
+namespace flutter::OHOS {
+
+class RasterCacheResult {
+public:
+    RasterCacheResult() = default;
+    RasterCacheResult(sk_sp<SkImage> image, const SkRect& logicalRect, const SkMatrix& matrix)
+        : image_(std::move(image)), logicalRect_(logicalRect), matrix_(matrix) {}
+    ~RasterCacheResult() = default;
+
+    bool IsValid() const
+    {
+        return static_cast<bool>(image_);
+    }
+
+    // Whether the image can be blitted on a canvas whose total matrix is |matrix|, i.e. the
+    // matrices only differ in their integral translation.
+    bool CanDrawWith(const SkMatrix& matrix) const;
+
+    // Draws the image on |canvas|, the total matrix of the canvas must satisfy CanDrawWith.
+    void Draw(SkCanvas& canvas, const SkPaint* paint = nullptr) const;
+
+    SkISize GetImageDimensions() const
+    {
+        return image_ ? image_->dimensions() : SkISize::Make(0, 0);
+    }
+
+private:
+    sk_sp<SkImage> image_;
+    SkRect logicalRect_ = SkRect::MakeEmpty();
+    SkMatrix matrix_ = SkMatrix::I();
+};
+
+// Raster cache of the native_view layer tree, see flutter::RasterCache for the
+// equivalent used by the flow layers.
+//
+// Entries are looked up during LayerTree::Prepare and only rasterized after they have
+// been prepared in |accessThreshold| frames. Entries that are not prepared during a
+// frame are evicted by SweepAfterFrame.
+class RasterCache {
+public:
+    static constexpr size_t DEFAULT_ACCESS_THRESHOLD = 3;
+    // Generating too many caches in one frame may cause jank on that frame, this limit
+    // distributes the work across multiple frames.
+    static constexpr size_t DEFAULT_PICTURE_CACHE_LIMIT_PER_FRAME = 3;
+
+    explicit RasterCache(size_t accessThreshold = DEFAULT_ACCESS_THRESHOLD,
+        size_t pictureCacheLimitPerFrame = DEFAULT_PICTURE_CACHE_LIMIT_PER_FRAME)
+        : accessThreshold_(accessThreshold), pictureCacheLimitPerFrame_(pictureCacheLimitPerFrame) {}
+    ~RasterCache() = default;
+
+    // Returns the cache shared by the trees prepared on the current thread, see
+    // LayerTree::Prepare.
+    static RasterCache& GetForCurrentThread();
+
+    static SkIRect GetDeviceBounds(const SkRect& rect, const SkMatrix& matrix);
+
+    static SkMatrix GetIntegralTransMatrix(const SkMatrix& matrix);
+
+    // Returns the rasterized |picture| for |matrix|, or an invalid result if the picture is
+    // not worth rasterizing, has not been accessed often enough yet or the per frame limit
+    // has been reached.
+    RasterCacheResult Prepare(GrContext* grContext, SkPicture* picture, const SkMatrix& matrix);
+
+    // Returns the rasterization of a layer subtree identified by |contentHash| that paints
+    // into |bounds| through |drawFunction|, or an invalid result if it has not been accessed
+    // often enough yet.
+    RasterCacheResult Prepare(GrContext* grContext, uint64_t contentHash, const SkRect& bounds,
+        const SkMatrix& matrix, const std::function<void(SkCanvas*)>& drawFunction);
+
+    void SweepAfterFrame();
+
+    void Clear();
+
+    size_t GetPictureCacheCount() const
+    {
+        return pictureCache_.size();
+    }
+
+    size_t GetLayerCacheCount() const
+    {
+        return layerCache_.size();
+    }
+
+private:
+    struct Entry {
+        bool usedThisFrame = false;
+        size_t accessCount = 0;
+        RasterCacheResult image;
+    };
+
+    template <class Cache>
+    static void SweepOneCacheAfterFrame(Cache& cache)
+    {
+        for (auto it = cache.begin(); it != cache.end();) {
+            if (!it->second.usedThisFrame) {
+                it = cache.erase(it);
+                continue;
+            }
+            it->second.usedThisFrame = false;
+            ++it;
+        }
+    }
+
+    // Bumps the access count of |entry| and returns whether it reached the threshold.
+    bool Touch(Entry& entry) const;
+
+    void TraceStatsToTimeline() const;
+
+    const size_t accessThreshold_;
+    const size_t pictureCacheLimitPerFrame_;
+    size_t pictureCachedThisFrame_ = 0;
+    PictureRasterCacheKey::Map<Entry> pictureCache_;
+    LayerRasterCacheKey::Map<Entry> layerCache_;
+
+    FML_DISALLOW_COPY_AND_ASSIGN(RasterCache);
+};
+
+}  // namespace flutter::OHOS
+
+#endif  // FLUTTER_FLOW_OHOS_LAYERS_RASTER_CACHE_H
@@ -0,0 +1,131 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Copyright (c) Huawei Technologies Co., Ltd. 2021. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/ohos_layers/raster_cache.h"
+
+#include "gtest/gtest.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+#include "flutter/flow/ohos_layers/layer_tree.h"
+#include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/picture_layer.h"
+#include "flutter/flow/ohos_layers/transform_layer.h"
+
+namespace flutter::OHOS {
+namespace {
+
+constexpr int PICTURE_SIZE = 20;
+constexpr int RECT_COUNT = 10;
+
+sk_sp<SkPicture> MakePicture(SkColor color)
+{
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(PICTURE_SIZE, PICTURE_SIZE));
+    SkPaint paint;
+    paint.setColor(color);
+    // Enough operations for the picture to be worth rasterizing.
+    for (int i = 0; i < RECT_COUNT; i++) {
+        canvas->drawRect(SkRect::MakeXYWH(i, 0, PICTURE_SIZE - i, PICTURE_SIZE), paint);
+    }
+    return recorder.finishRecordingAsPicture();
+}
+
+class TestPaintContext : public PaintContext {
+public:
+    explicit TestPaintContext(SkCanvas* canvas) : PaintContext(canvas, nullptr) {}
+    ~TestPaintContext() override = default;
+
+    void Paint(int64_t textureId, const SkPoint& offset, uint8_t opacity) const override {}
+};
+
+} // namespace
+
+TEST(OHOSRasterCacheTest, PicturesAreRasterizedOnceAccessedEnough)
+{
+    RasterCache cache;
+    auto picture = MakePicture(SK_ColorRED);
+    for (size_t i = 1; i < RasterCache::DEFAULT_ACCESS_THRESHOLD; i++) {
+        ASSERT_FALSE(cache.Prepare(nullptr, picture.get(), SkMatrix::I()).IsValid());
+        cache.SweepAfterFrame();
+    }
+
+    auto result = cache.Prepare(nullptr, picture.get(), SkMatrix::I());
+    ASSERT_TRUE(result.IsValid());
+    ASSERT_EQ(result.GetImageDimensions(), SkISize::Make(PICTURE_SIZE, PICTURE_SIZE));
+    ASSERT_EQ(cache.GetPictureCacheCount(), 1u);
+    cache.SweepAfterFrame();
+
+    // An integral translation hits the same entry, a scale does not.
+    ASSERT_TRUE(cache.Prepare(nullptr, picture.get(), SkMatrix::MakeTrans(7, 3)).IsValid());
+    ASSERT_FALSE(cache.Prepare(nullptr, picture.get(), SkMatrix::MakeScale(2)).IsValid());
+    ASSERT_EQ(cache.GetPictureCacheCount(), 2u);
+}
+
+TEST(OHOSRasterCacheTest, RasterizesALimitedNumberOfPicturesPerFrame)
+{
+    RasterCache cache(1, 1);
+    auto first = MakePicture(SK_ColorRED);
+    auto second = MakePicture(SK_ColorBLUE);
+    ASSERT_TRUE(cache.Prepare(nullptr, first.get(), SkMatrix::I()).IsValid());
+    ASSERT_FALSE(cache.Prepare(nullptr, second.get(), SkMatrix::I()).IsValid());
+    cache.SweepAfterFrame();
+
+    ASSERT_TRUE(cache.Prepare(nullptr, first.get(), SkMatrix::I()).IsValid());
+    ASSERT_TRUE(cache.Prepare(nullptr, second.get(), SkMatrix::I()).IsValid());
+}
+
+TEST(OHOSRasterCacheTest, EntriesNotPreparedDuringAFrameAreEvicted)
+{
+    RasterCache cache(1);
+    auto kept = MakePicture(SK_ColorRED);
+    auto evicted = MakePicture(SK_ColorBLUE);
+    ASSERT_TRUE(cache.Prepare(nullptr, kept.get(), SkMatrix::I()).IsValid());
+    ASSERT_TRUE(cache.Prepare(nullptr, evicted.get(), SkMatrix::I()).IsValid());
+    cache.SweepAfterFrame();
+    ASSERT_EQ(cache.GetPictureCacheCount(), 2u);
+
+    ASSERT_TRUE(cache.Prepare(nullptr, kept.get(), SkMatrix::I()).IsValid());
+    cache.SweepAfterFrame();
+    ASSERT_EQ(cache.GetPictureCacheCount(), 1u);
+
+    cache.SweepAfterFrame();
+    ASSERT_EQ(cache.GetPictureCacheCount(), 0u);
+}
+
+TEST(OHOSRasterCacheTest, LayerTreesShareTheCacheOfTheirThread)
+{
+    RasterCache& cache = RasterCache::GetForCurrentThread();
+    cache.Clear();
+    auto picture = MakePicture(SK_ColorRED);
+    auto surface = SkSurface::MakeRasterN32Premul(PICTURE_SIZE * 2, PICTURE_SIZE * 2);
+    TestPaintContext paintContext(surface->getCanvas());
+
+    for (size_t i = 0; i < RasterCache::DEFAULT_ACCESS_THRESHOLD; i++) {
+        // Every frame builds a new tree, as the framework does.
+        auto root = std::make_shared<TransformLayer>(SkMatrix::I());
+        root->Add(std::make_shared<PictureLayer>(SkPoint::Make(PICTURE_SIZE, 0), picture));
+        LayerTree layerTree(root);
+        layerTree.SetFrameSize(SkISize::Make(PICTURE_SIZE * 2, PICTURE_SIZE * 2));
+        layerTree.Prepare();
+        surface->getCanvas()->clear(SK_ColorTRANSPARENT);
+        layerTree.Paint(paintContext);
+    }
+
+    ASSERT_EQ(cache.GetPictureCacheCount(), 1u);
+    SkPixmap pixels;
+    ASSERT_TRUE(surface->peekPixels(&pixels));
+    ASSERT_EQ(pixels.getColor(PICTURE_SIZE + 1, 1), SK_ColorRED);
+    ASSERT_EQ(pixels.getColor(1, 1), SK_ColorTRANSPARENT);
+
+    // The picture is swept when the frame after the first one without it is prepared.
+    for (int i = 0; i < 2; i++) {
+        LayerTree emptyTree(std::make_shared<TransformLayer>(SkMatrix::I()));
+        emptyTree.Prepare();
+    }
+    ASSERT_EQ(cache.GetPictureCacheCount(), 0u);
+}
+
+} // namespace flutter::OHOS
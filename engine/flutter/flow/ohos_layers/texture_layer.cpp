@@ -11,7 +11,7 @@
 
 namespace flutter::OHOS {
 
-void TextureLayer::Prepare(const SkMatrix& matrix)
+void TextureLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SetPaintBounds(SkRect::MakeXYWH(offset_.x(), offset_.y(), textureSize_.width(), textureSize_.height()));
 }
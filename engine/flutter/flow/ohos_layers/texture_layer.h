@@ -23,7 +23,7 @@ public:
         : offset_(offset), textureSize_(textureSize), textureId_(textureId), opacity_(opacity) {}
     ~TextureLayer() override = default;
 
-    void Prepare(const SkMatrix& matrix) override;
+    void Prepare(PrepareContext* context, const SkMatrix& matrix) override;
 
     void Paint(const PaintContext& paintContext) const override;
 
@@ -8,17 +8,32 @@
 #include "flutter/flow/ohos_layers/transform_layer.h"
 
 #include "flutter/flow/ohos_layers/paint_context.h"
+#include "flutter/flow/ohos_layers/prepare_context.h"
 
 namespace flutter::OHOS {
 
-void TransformLayer::Prepare(const SkMatrix& matrix)
+void TransformLayer::Prepare(PrepareContext* context, const SkMatrix& matrix)
 {
     SkMatrix childMatrix;
     childMatrix.setConcat(matrix, transform_);
+    SkRect previousCullRect = context->cullRect;
+    SkMatrix inverseTransform;
+    bool invertible = transform_.invert(&inverseTransform);
+    if (invertible) {
+        inverseTransform.mapRect(&context->cullRect);
+    } else {
+        // The transform collapses its children, which paint nothing.
+        context->cullRect.setEmpty();
+    }
     SkRect childPaintBounds = SkRect::MakeEmpty();
-    PrepareChildren(childMatrix, childPaintBounds);
-    transform_.mapRect(&childPaintBounds);
-    SetPaintBounds(childPaintBounds);
+    PrepareChildren(context, childMatrix, childPaintBounds);
+    context->cullRect = previousCullRect;
+    if (invertible) {
+        transform_.mapRect(&childPaintBounds);
+        SetPaintBounds(childPaintBounds);
+    } else {
+        SetPaintBounds(SkRect::MakeEmpty());
+    }
 }
 
 void TransformLayer::Paint(const PaintContext& paintContext) const
@@ -28,4 +43,13 @@ void TransformLayer::Paint(const PaintContext& paintContext) const
     PaintChildren(paintContext);
 }
 
+bool TransformLayer::HashProperties(uint64_t& hash) const
+{
+    HashCombine(hash, LayerHashTag::TRANSFORM);
+    SkScalar values[9];
+    transform_.get9(values);
+    HashCombine(hash, values, 9);
+    return true;
+}
+
 }  // namespace flutter::OHOS
\ No newline at end of file
@@ -4,15 +4,19 @@
 
 #include "flutter/flow/raster_cache.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "flutter/flow/layers/layer.h"
+#include "flutter/flow/layers/physical_shape_layer.h"
 #include "flutter/flow/paint_utils.h"
 #include "flutter/fml/logging.h"
 #include "flutter/fml/trace_event.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkImage.h"
 #include "third_party/skia/include/core/SkPicture.h"
+#include "third_party/skia/include/core/SkRRect.h"
 #include "third_party/skia/include/core/SkSurface.h"
 
 namespace flutter {
@@ -38,9 +42,13 @@ void RasterCacheResult::draw(SkCanvas& canvas, const SkPaint* paint) const {
 }
 
 RasterCache::RasterCache(size_t access_threshold,
-                         size_t picture_cache_limit_per_frame)
+                         size_t picture_cache_limit_per_frame,
+                         size_t max_bytes,
+                         size_t eviction_grace_frames)
     : access_threshold_(access_threshold),
       picture_cache_limit_per_frame_(picture_cache_limit_per_frame),
+      max_bytes_(max_bytes),
+      eviction_grace_frames_(eviction_grace_frames),
       checkerboard_images_(false),
       weak_factory_(this) {}
 
@@ -149,36 +157,353 @@ static inline size_t ClampSize(size_t value, size_t min, size_t max) {
   return value;
 }
 
+static size_t ImageBytes(const SkISize& dimensions) {
+  return static_cast<size_t>(dimensions.width()) * dimensions.height() * 4;
+}
+
+static size_t ImageBytes(const SkRect& logical_rect, const SkMatrix& ctm) {
+  return ImageBytes(RasterCache::GetDeviceBounds(logical_rect, ctm).size());
+}
+
+// Pins like SkDrawShadowMetrics, a zero |denom| yields |max|.
+static float DivideAndPin(float numer, float denom, float min, float max) {
+  return std::min(std::max(numer / denom, min), max);
+}
+
+// How far from its outline a shadow blurred by |blur_radius| may reach.
+// Skia tessellates the shadows of convex paths, whose reach is the blur
+// radius, and blurs them otherwise, which reaches further.
+static SkScalar GetShadowReach(SkScalar blur_radius) {
+  return 2 * blur_radius + 2;
+}
+
+// Where the spot shadow of |rect| is drawn before being blurred: scaled about
+// its center and moved away from the light.
+static SkRect GetSpotShadowRect(const SkRect& rect,
+                                const SkPoint& light,
+                                SkScalar z_ratio,
+                                SkScalar scale) {
+  const SkPoint center = SkPoint::Make(rect.centerX(), rect.centerY());
+  SkRect spot = SkRect::MakeXYWH(center.x() - rect.width() * scale / 2,
+                                 center.y() - rect.height() * scale / 2,
+                                 rect.width() * scale, rect.height() * scale);
+  spot.offset(-z_ratio * (light.x() - center.x()),
+              -z_ratio * (light.y() - center.y()));
+  return spot;
+}
+
+namespace {
+
+// A part of the shadow of a rounded rectangle, drawn by stretching the image
+// of the same part rendered for a smaller, canonical rounded rectangle with
+// the same corners.
+struct ShadowNinePatch {
+  ShadowRasterCacheKey key;
+  PhysicalShapeLayer::ShadowComponents component;
+  // The canonical rounded rectangle, in device coordinates.
+  SkRRect canonical;
+  // The device bounds of the image of the part rendered for |canonical|.
+  SkIRect bounds;
+  // The part of the image that is stretched, in the coordinates of the image.
+  SkIRect center;
+  // Where the image is drawn for the shadow, in device coordinates.
+  SkRect dst;
+};
+
+}  // namespace
+
+// The nine patch of the part of a shadow that covers |canonical_rect| for the
+// canonical rounded rectangle and |rect| for the drawn one. The corners of
+// the part span |corners| into it and |reach| around it.
+static ShadowNinePatch MakeShadowNinePatch(
+    ShadowRasterCacheKey key,
+    PhysicalShapeLayer::ShadowComponents component,
+    const SkRRect& canonical,
+    const SkRect& canonical_rect,
+    const SkRect& rect,
+    const SkRect& corners,
+    SkScalar reach) {
+  const SkIRect bounds = canonical_rect.makeOutset(reach, reach).roundOut();
+  const SkRect center =
+      SkRect::MakeLTRB(canonical_rect.left() + corners.left() + reach,
+                       canonical_rect.top() + corners.top() + reach,
+                       canonical_rect.right() - corners.right() - reach,
+                       canonical_rect.bottom() - corners.bottom() - reach)
+          .makeOffset(-bounds.left(), -bounds.top());
+  const SkRect dst = SkRect::MakeLTRB(
+      rect.left() - (canonical_rect.left() - bounds.left()),
+      rect.top() - (canonical_rect.top() - bounds.top()),
+      rect.right() + (bounds.right() - canonical_rect.right()),
+      rect.bottom() + (bounds.bottom() - canonical_rect.bottom()));
+  return {key,
+          component,
+          canonical,
+          bounds,
+          SkIRect::MakeLTRB(std::ceil(center.left()), std::ceil(center.top()),
+                            std::floor(center.right()),
+                            std::floor(center.bottom())),
+          dst};
+}
+
+// Returns the ambient and the spot nine patches of |shadow| drawn with |ctm|,
+// or none if the shadow is not the one of an opaque rounded rectangle at
+// least as large as its canonical rounded rectangle. Skia shades the inside of
+// transparent occluders depending on their size, which a nine patch cannot
+// stretch, while opaque occluders hide it.
+static std::vector<ShadowNinePatch> GetShadowNinePatches(
+    const RasterCacheShadow& shadow,
+    const SkMatrix& ctm) {
+  std::vector<ShadowNinePatch> patches;
+  if (shadow.transparent_occluder || !ctm.isScaleTranslate() ||
+      ctm.getScaleX() <= 0 || ctm.getScaleY() <= 0) {
+    return patches;
+  }
+  SkRect local_rect;
+  SkRRect local_rrect;
+  if (shadow.path.isRect(&local_rect)) {
+    local_rrect.setRect(local_rect);
+  } else if (!shadow.path.isRRect(&local_rrect)) {
+    return patches;
+  }
+  SkRRect rrect;
+  if (!local_rrect.transform(ctm, &rrect)) {
+    return patches;
+  }
+  const SkRect& rect = rrect.rect();
+  SkVector radii[4];
+  for (int i = 0; i < 4; i++) {
+    radii[i] = rrect.radii(static_cast<SkRRect::Corner>(i));
+  }
+  // Skia takes the light as a device position, the ctm does not move it.
+  const SkPoint light = PhysicalShapeLayer::GetLightPosition(shadow.path);
+
+  // The shadow metrics of SkShadowUtils.
+  const SkScalar occluder_z = shadow.dpr * shadow.elevation;
+  const SkScalar light_z = shadow.dpr * PhysicalShapeLayer::kLightHeight;
+  const SkScalar ambient_blur = std::min(occluder_z * 0.5f, 150.0f);
+  const SkScalar z_ratio =
+      DivideAndPin(occluder_z, light_z - occluder_z, 0.0f, 0.95f);
+  const SkScalar spot_scale =
+      DivideAndPin(light_z, light_z - occluder_z, 1.0f, 1.95f);
+  const SkScalar spot_blur =
+      shadow.dpr * PhysicalShapeLayer::kLightRadius * z_ratio;
+  const SkScalar ambient_reach = GetShadowReach(ambient_blur);
+  const SkScalar spot_reach = GetShadowReach(spot_blur);
+
+  // The canonical rounded rectangle leaves a few straight pixels between the
+  // corners of both parts, the shadows of larger ones only stretch them.
+  const SkRect corners = SkRect::MakeLTRB(
+      std::max(radii[SkRRect::kUpperLeft_Corner].x(),
+               radii[SkRRect::kLowerLeft_Corner].x()),
+      std::max(radii[SkRRect::kUpperLeft_Corner].y(),
+               radii[SkRRect::kUpperRight_Corner].y()),
+      std::max(radii[SkRRect::kUpperRight_Corner].x(),
+               radii[SkRRect::kLowerRight_Corner].x()),
+      std::max(radii[SkRRect::kLowerLeft_Corner].y(),
+               radii[SkRRect::kLowerRight_Corner].y()));
+  const SkScalar reach = std::max(ambient_reach, spot_reach);
+  const SkRect canonical_rect = SkRect::MakeWH(
+      std::ceil(corners.left() + corners.right() + 2 * reach) + 2,
+      std::ceil(corners.top() + corners.bottom() + 2 * reach) + 2);
+  if (rect.width() < canonical_rect.width() ||
+      rect.height() < canonical_rect.height()) {
+    return patches;
+  }
+  SkRRect canonical;
+  canonical.setRectRadii(canonical_rect, radii);
+  const SkPoint canonical_light =
+      PhysicalShapeLayer::GetLightPosition(SkPath().addRRect(canonical));
+
+  patches.push_back(MakeShadowNinePatch(
+      ShadowRasterCacheKey::ForNinePatch(
+          ShadowRasterCacheKey::Kind::kAmbientNinePatch, radii,
+          shadow.elevation, shadow.dpr, shadow.color),
+      PhysicalShapeLayer::kAmbientShadow, canonical, canonical_rect, rect,
+      corners, ambient_reach));
+  patches.push_back(MakeShadowNinePatch(
+      ShadowRasterCacheKey::ForNinePatch(
+          ShadowRasterCacheKey::Kind::kSpotNinePatch, radii, shadow.elevation,
+          shadow.dpr, shadow.color),
+      PhysicalShapeLayer::kSpotShadow, canonical,
+      GetSpotShadowRect(canonical_rect, canonical_light, z_ratio, spot_scale),
+      GetSpotShadowRect(rect, light, z_ratio, spot_scale),
+      SkRect::MakeLTRB(corners.left() * spot_scale, corners.top() * spot_scale,
+                       corners.right() * spot_scale,
+                       corners.bottom() * spot_scale),
+      spot_reach));
+  return patches;
+}
+
+// How far the light of the shadow of a path moves in its image, which is
+// rendered with the top left corner of its device bounds at the origin.
+static SkVector GetPathShadowLightOffset(const RasterCacheShadow& shadow,
+                                         const SkMatrix& ctm) {
+  const SkIRect bounds = RasterCache::GetDeviceBounds(shadow.bounds, ctm);
+  return SkVector::Make(-bounds.left(), -bounds.top());
+}
+
+static ShadowRasterCacheKey GetPathShadowKey(const RasterCacheShadow& shadow,
+                                             const SkMatrix& ctm) {
+  return ShadowRasterCacheKey::ForPath(
+      shadow.path.getGenerationID(), ctm,
+      PhysicalShapeLayer::GetLightPosition(shadow.path) +
+          GetPathShadowLightOffset(shadow, ctm),
+      shadow.elevation, shadow.dpr, shadow.color, shadow.transparent_occluder);
+}
+
+void RasterCache::Touch(Entry& entry) {
+  entry.access_count = ClampSize(entry.access_count + 1, 0, access_threshold_);
+  entry.last_used_frame = frame_index_;
+  if (entry.in_lru) {
+    lru_.splice(lru_.begin(), lru_, entry.lru_position);
+  }
+}
+
+const RasterCache::Entry& RasterCache::GetEntry(const EntryKey& key) const {
+  if (key.picture) {
+    return picture_cache_.find(*key.picture)->second;
+  }
+  if (key.layer) {
+    return layer_cache_.find(*key.layer)->second;
+  }
+  return shadow_cache_.find(*key.shadow)->second;
+}
+
+void RasterCache::EraseEntry(const EntryKey& key) {
+  if (key.picture) {
+    auto it = picture_cache_.find(*key.picture);
+    Evict(it->second);
+    picture_cache_.erase(it);
+  } else if (key.layer) {
+    auto it = layer_cache_.find(*key.layer);
+    Evict(it->second);
+    layer_cache_.erase(it);
+  } else {
+    auto it = shadow_cache_.find(*key.shadow);
+    Evict(it->second);
+    shadow_cache_.erase(it);
+  }
+}
+
+bool RasterCache::EnsureCapacity(size_t bytes) {
+  if (bytes > max_bytes_) {
+    return false;
+  }
+  if (cache_bytes_ + pending_bytes_ + bytes <= max_bytes_) {
+    return true;
+  }
+
+  while (!lru_.empty() && cache_bytes_ + pending_bytes_ + bytes > max_bytes_) {
+    const EntryKey key = lru_.back();
+    if (GetEntry(key).last_used_frame == frame_index_) {
+      // The more recently used images are all used in this frame as well.
+      break;
+    }
+    EraseEntry(key);
+  }
+  return cache_bytes_ + pending_bytes_ + bytes <= max_bytes_;
+}
+
+void RasterCache::Evict(const Entry& entry) {
+  if (entry.pending_image) {
+    // The worker still completes the rasterization, its result is dropped.
+    pending_bytes_ -= entry.pending_bytes;
+    pending_count_--;
+  }
+  if (!entry.in_lru) {
+    return;
+  }
+  lru_.erase(entry.lru_position);
+  const size_t bytes = ImageBytes(entry.image.image_dimensions());
+  FML_DCHECK(cache_bytes_ >= bytes);
+  cache_bytes_ -= bytes;
+  frame_stats_.eviction_count++;
+  frame_stats_.evicted_bytes += bytes;
+}
+
+void RasterCache::Insert(Entry& entry, RasterCacheResult image) {
+  FML_DCHECK(!entry.in_lru);
+  if (!image.is_valid()) {
+    // Nothing to account for, the entry is rasterized again next time.
+    return;
+  }
+  entry.image = std::move(image);
+  cache_bytes_ += ImageBytes(entry.image.image_dimensions());
+  entry.lru_position = lru_.insert(lru_.begin(), entry.key);
+  entry.in_lru = true;
+}
+
+void RasterCache::RasterizeAsync(Entry& entry,
+                                 SkPicture* picture,
+                                 const SkMatrix& transformation_matrix,
+                                 SkColorSpace* dst_color_space,
+                                 size_t bytes) {
+  FML_DCHECK(!entry.pending_image);
+  auto pending_image = std::make_shared<PendingImage>();
+  entry.pending_image = pending_image;
+  entry.pending_bytes = bytes;
+  pending_bytes_ += bytes;
+  pending_count_++;
+  concurrent_task_runner_->PostTask(
+      [pending_image, picture = sk_ref_sp(picture), transformation_matrix,
+       dst_color_space = sk_ref_sp(dst_color_space),
+       checkerboard = checkerboard_images_]() {
+        pending_image->image =
+            RasterizePicture(picture.get(), nullptr, transformation_matrix,
+                             dst_color_space.get(), checkerboard);
+        pending_image->ready.store(true, std::memory_order_release);
+      });
+}
+
+void RasterCache::PromotePendingImage(Entry& entry) {
+  if (!entry.pending_image ||
+      !entry.pending_image->ready.load(std::memory_order_acquire)) {
+    return;
+  }
+  RasterCacheResult image = entry.pending_image->image;
+  entry.pending_image.reset();
+  pending_bytes_ -= entry.pending_bytes;
+  pending_count_--;
+  entry.pending_bytes = 0;
+  Insert(entry, std::move(image));
+}
+
 void RasterCache::Prepare(PrerollContext* context,
                           Layer* layer,
                           const SkMatrix& ctm) {
   LayerRasterCacheKey cache_key(layer->unique_id(), ctm);
-  Entry& entry = layer_cache_[cache_key];
-  entry.access_count = ClampSize(entry.access_count + 1, 0, access_threshold_);
-  entry.used_this_frame = true;
-  if (!entry.image.is_valid()) {
-    entry.image = Rasterize(context->gr_context, ctm, context->dst_color_space,
-                            checkerboard_images_, layer->paint_bounds(),
-                            [layer, context](SkCanvas* canvas) {
-                              SkISize canvas_size = canvas->getBaseLayerSize();
-                              SkNWayCanvas internal_nodes_canvas(
-                                  canvas_size.width(), canvas_size.height());
-                              internal_nodes_canvas.addCanvas(canvas);
-                              Layer::PaintContext paintContext = {
-                                  (SkCanvas*)&internal_nodes_canvas,
-                                  canvas,
-                                  context->gr_context,
-                                  nullptr,
-                                  context->raster_time,
-                                  context->ui_time,
-                                  context->texture_registry,
-                                  context->raster_cache,
-                                  context->checkerboard_offscreen_layers};
-                              if (layer->needs_painting()) {
-                                layer->Paint(paintContext);
-                              }
-                            });
+  Entry& entry = FindOrAddEntry(layer_cache_, cache_key);
+  Touch(entry);
+  if (entry.image.is_valid()) {
+    frame_stats_.hit_count++;
+    return;
+  }
+  frame_stats_.miss_count++;
+  if (!EnsureCapacity(ImageBytes(layer->paint_bounds(), ctm))) {
+    return;
   }
+  Insert(entry,
+         Rasterize(context->gr_context, ctm, context->dst_color_space,
+                   checkerboard_images_, layer->paint_bounds(),
+                   [layer, context](SkCanvas* canvas) {
+                     SkISize canvas_size = canvas->getBaseLayerSize();
+                     SkNWayCanvas internal_nodes_canvas(canvas_size.width(),
+                                                        canvas_size.height());
+                     internal_nodes_canvas.addCanvas(canvas);
+                     Layer::PaintContext paintContext = {
+                         (SkCanvas*)&internal_nodes_canvas,
+                         canvas,
+                         context->gr_context,
+                         nullptr,
+                         context->raster_time,
+                         context->ui_time,
+                         context->texture_registry,
+                         context->raster_cache,
+                         context->checkerboard_offscreen_layers};
+                     if (layer->needs_painting()) {
+                       layer->Paint(paintContext);
+                     }
+                   }));
 }
 
 bool RasterCache::Prepare(GrContext* context,
@@ -206,18 +531,36 @@ bool RasterCache::Prepare(GrContext* context,
 
   PictureRasterCacheKey cache_key(picture->uniqueID(), transformation_matrix);
 
-  Entry& entry = picture_cache_[cache_key];
-  entry.access_count = ClampSize(entry.access_count + 1, 0, access_threshold_);
-  entry.used_this_frame = true;
+  Entry& entry = FindOrAddEntry(picture_cache_, cache_key);
+  Touch(entry);
 
   if (entry.access_count < access_threshold_ || access_threshold_ == 0) {
     // Frame threshold has not yet been reached.
     return false;
   }
 
-  if (!entry.image.is_valid()) {
-    entry.image = RasterizePicture(picture, context, transformation_matrix,
-                                   dst_color_space, checkerboard_images_);
+  PromotePendingImage(entry);
+  if (entry.image.is_valid()) {
+    frame_stats_.hit_count++;
+  } else if (entry.pending_image) {
+    // The picture is still being rasterized on a worker thread.
+    return false;
+  } else {
+    frame_stats_.miss_count++;
+    const size_t bytes = ImageBytes(picture->cullRect(), transformation_matrix);
+    if (!EnsureCapacity(bytes)) {
+      // The picture does not fit in the budget next to the images used in
+      // this frame.
+      return false;
+    }
+    if (concurrent_task_runner_ && context == nullptr) {
+      RasterizeAsync(entry, picture, transformation_matrix, dst_color_space,
+                     bytes);
+      picture_cached_this_frame_++;
+      return false;
+    }
+    Insert(entry, RasterizePicture(picture, context, transformation_matrix,
+                                   dst_color_space, checkerboard_images_));
   }
   picture_cached_this_frame_++;
   return true;
@@ -236,18 +579,135 @@ RasterCacheResult RasterCache::Get(Layer* layer, const SkMatrix& ctm) const {
   return it == layer_cache_.end() ? RasterCacheResult() : it->second.image;
 }
 
+void RasterCache::PrepareShadowMask(
+    const ShadowRasterCacheKey& key,
+    size_t bytes,
+    const std::function<RasterCacheResult()>& rasterize) {
+  Entry& entry = FindOrAddEntry(shadow_cache_, key);
+  Touch(entry);
+  if (entry.access_count < access_threshold_ || access_threshold_ == 0) {
+    return;
+  }
+  if (entry.image.is_valid()) {
+    frame_stats_.hit_count++;
+    return;
+  }
+  frame_stats_.miss_count++;
+  if (!EnsureCapacity(bytes)) {
+    return;
+  }
+  Insert(entry, rasterize());
+}
+
+void RasterCache::PrepareShadow(PrerollContext* context,
+                                const RasterCacheShadow& shadow,
+                                const SkMatrix& ctm) {
+  if (context->gr_context) {
+    // Skia draws the shadows analytically on the GPU, and caches their
+    // tessellation already.
+    return;
+  }
+  SkColorSpace* dst_color_space = context->dst_color_space;
+  const bool checkerboard = checkerboard_images_;
+
+  std::vector<ShadowNinePatch> patches = GetShadowNinePatches(shadow, ctm);
+  for (const ShadowNinePatch& patch : patches) {
+    PrepareShadowMask(
+        patch.key, ImageBytes(patch.bounds.size()),
+        [&shadow, &patch, dst_color_space, checkerboard]() {
+          // The canonical rounded rectangle is rendered with the identity
+          // matrix, its nine patch is drawn in device coordinates.
+          return Rasterize(nullptr, SkMatrix::I(), dst_color_space,
+                           checkerboard, SkRect::Make(patch.bounds),
+                           [&shadow, &patch](SkCanvas* canvas) {
+                             SkPath path;
+                             path.addRRect(patch.canonical);
+                             PhysicalShapeLayer::DrawShadow(
+                                 canvas, path, shadow.color, shadow.elevation,
+                                 true, shadow.dpr, patch.component,
+                                 SkVector::Make(-patch.bounds.left(),
+                                                -patch.bounds.top()));
+                           });
+        });
+  }
+  if (!patches.empty() || ctm.hasPerspective() || shadow.bounds.isEmpty()) {
+    return;
+  }
+
+  PrepareShadowMask(
+      GetPathShadowKey(shadow, ctm), ImageBytes(shadow.bounds, ctm),
+      [&shadow, &ctm, dst_color_space, checkerboard]() {
+        const SkVector light_offset = GetPathShadowLightOffset(shadow, ctm);
+        return Rasterize(
+            nullptr, ctm, dst_color_space, checkerboard, shadow.bounds,
+            [&shadow, light_offset](SkCanvas* canvas) {
+              PhysicalShapeLayer::DrawShadow(
+                  canvas, shadow.path, shadow.color, shadow.elevation,
+                  shadow.transparent_occluder, shadow.dpr,
+                  PhysicalShapeLayer::kAllShadows, light_offset);
+            });
+      });
+}
+
+bool RasterCache::DrawShadow(SkCanvas& canvas,
+                             const RasterCacheShadow& shadow) const {
+  const SkMatrix ctm = canvas.getTotalMatrix();
+  std::vector<ShadowNinePatch> patches = GetShadowNinePatches(shadow, ctm);
+  if (patches.empty()) {
+    auto it = shadow_cache_.find(GetPathShadowKey(shadow, ctm));
+    if (it == shadow_cache_.end() || !it->second.image.is_valid()) {
+      return false;
+    }
+    it->second.image.draw(canvas);
+    return true;
+  }
+
+  std::vector<sk_sp<SkImage>> images;
+  for (const ShadowNinePatch& patch : patches) {
+    auto it = shadow_cache_.find(patch.key);
+    if (it == shadow_cache_.end() || !it->second.image.is_valid()) {
+      return false;
+    }
+    images.push_back(it->second.image.image());
+  }
+  TRACE_EVENT0("flutter", "RasterCache::DrawShadow");
+  SkAutoCanvasRestore auto_restore(&canvas, true);
+  canvas.resetMatrix();
+  for (size_t i = 0; i < patches.size(); i++) {
+    FML_DCHECK(images[i]->dimensions() == patches[i].bounds.size());
+    canvas.drawImageNine(images[i], patches[i].center, patches[i].dst);
+  }
+  return true;
+}
+
 void RasterCache::SweepAfterFrame() {
-  using PictureCache = PictureRasterCacheKey::Map<Entry>;
-  using LayerCache = LayerRasterCacheKey::Map<Entry>;
-  SweepOneCacheAfterFrame<PictureCache, PictureCache::iterator>(picture_cache_);
-  SweepOneCacheAfterFrame<LayerCache, LayerCache::iterator>(layer_cache_);
+  SweepOneCacheAfterFrame(picture_cache_);
+  SweepOneCacheAfterFrame(layer_cache_);
+  SweepOneCacheAfterFrame(shadow_cache_);
   picture_cached_this_frame_ = 0;
+  frame_index_++;
   TraceStatsToTimeline();
+
+  stats_.hit_count += frame_stats_.hit_count;
+  stats_.miss_count += frame_stats_.miss_count;
+  stats_.eviction_count += frame_stats_.eviction_count;
+  stats_.evicted_bytes += frame_stats_.evicted_bytes;
+  frame_stats_ = {};
 }
 
 void RasterCache::Clear() {
   picture_cache_.clear();
   layer_cache_.clear();
+  shadow_cache_.clear();
+  lru_.clear();
+  cache_bytes_ = 0;
+  pending_bytes_ = 0;
+  pending_count_ = 0;
+}
+
+void RasterCache::SetConcurrentTaskRunner(
+    std::shared_ptr<fml::ConcurrentTaskRunner> task_runner) {
+  concurrent_task_runner_ = std::move(task_runner);
 }
 
 void RasterCache::SetCheckboardCacheImages(bool checkerboard) {
@@ -269,6 +729,8 @@ void RasterCache::TraceStatsToTimeline() const {
   size_t layer_cache_bytes = 0;
   size_t picture_cache_count = 0;
   size_t picture_cache_bytes = 0;
+  size_t shadow_cache_count = 0;
+  size_t shadow_cache_bytes = 0;
 
   for (const auto& item : layer_cache_) {
     const auto dimensions = item.second.image.image_dimensions();
@@ -282,12 +744,28 @@ void RasterCache::TraceStatsToTimeline() const {
     picture_cache_bytes += dimensions.width() * dimensions.height() * 4;
   }
 
+  for (const auto& item : shadow_cache_) {
+    const auto dimensions = item.second.image.image_dimensions();
+    shadow_cache_count++;
+    shadow_cache_bytes += dimensions.width() * dimensions.height() * 4;
+  }
+
   FML_TRACE_COUNTER("flutter", "RasterCache",
-                    reinterpret_cast<int64_t>(this),             //
-                    "LayerCount", layer_cache_count,             //
-                    "LayerMBytes", layer_cache_bytes * 1e-6,     //
-                    "PictureCount", picture_cache_count,         //
-                    "PictureMBytes", picture_cache_bytes * 1e-6  //
+                    reinterpret_cast<int64_t>(this),              //
+                    "LayerCount", layer_cache_count,              //
+                    "LayerMBytes", layer_cache_bytes * 1e-6,      //
+                    "PictureCount", picture_cache_count,          //
+                    "PictureMBytes", picture_cache_bytes * 1e-6,  //
+                    "ShadowCount", shadow_cache_count,            //
+                    "ShadowMBytes", shadow_cache_bytes * 1e-6     //
+  );
+  FML_TRACE_COUNTER("flutter", "RasterCacheActivity",
+                    reinterpret_cast<int64_t>(this),                     //
+                    "HitCount", frame_stats_.hit_count,                  //
+                    "MissCount", frame_stats_.miss_count,                //
+                    "EvictionCount", frame_stats_.eviction_count,        //
+                    "EvictedMBytes", frame_stats_.evicted_bytes * 1e-6,  //
+                    "BudgetMBytes", max_bytes_ * 1e-6                    //
   );
 
 #endif  // FLUTTER_RUNTIME_MODE != FLUTTER_RUNTIME_MODE_RELEASE
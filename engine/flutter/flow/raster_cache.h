@@ -5,14 +5,19 @@
 #ifndef FLUTTER_FLOW_RASTER_CACHE_H_
 #define FLUTTER_FLOW_RASTER_CACHE_H_
 
+#include <atomic>
+#include <functional>
+#include <list>
 #include <memory>
 #include <unordered_map>
 
 #include "flutter/flow/instrumentation.h"
 #include "flutter/flow/raster_cache_key.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/weak_ptr.h"
 #include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkPath.h"
 #include "third_party/skia/include/core/SkSize.h"
 
 namespace flutter {
@@ -37,6 +42,8 @@ class RasterCacheResult {
     return image_ ? image_->dimensions() : SkISize::Make(0, 0);
   };
 
+  const sk_sp<SkImage>& image() const { return image_; }
+
  private:
   sk_sp<SkImage> image_;
   SkRect logical_rect_;
@@ -44,6 +51,17 @@ class RasterCacheResult {
 
 struct PrerollContext;
 
+// An elevation shadow drawn by |PhysicalShapeLayer::DrawShadow|.
+struct RasterCacheShadow {
+  const SkPath& path;
+  SkColor color;
+  float elevation;
+  bool transparent_occluder;
+  SkScalar dpr;
+  // The area the shadow may cover, in the coordinates of |path|.
+  SkRect bounds;
+};
+
 class RasterCache {
  public:
   // The default max number of picture raster caches to be generated per frame.
@@ -52,9 +70,31 @@ class RasterCache {
   // multiple frames.
   static constexpr int kDefaultPictureCacheLimitPerFrame = 3;
 
+  // The default max number of bytes of rasterized images the cache may hold.
+  // Once the budget is reached, the least recently used images are evicted to
+  // make room for new ones, and new images that don't fit even after evicting
+  // every image unused in the current frame are not rasterized.
+  static constexpr size_t kDefaultMaxBytes = 128 * 1024 * 1024;
+
+  // The default number of consecutive frames an entry may go unused before
+  // being evicted. Keeping entries across a few frames avoids rasterizing
+  // them again when they briefly go off-screen or skip a frame.
+  static constexpr size_t kDefaultEvictionGraceFrames = 3;
+
+  // Counters of the cache activity, the images evicted by the sweep at the end
+  // of a frame and to make room for new images are both counted as evictions.
+  struct Stats {
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+    size_t eviction_count = 0;
+    size_t evicted_bytes = 0;
+  };
+
   explicit RasterCache(
       size_t access_threshold = 3,
-      size_t picture_cache_limit_per_frame = kDefaultPictureCacheLimitPerFrame);
+      size_t picture_cache_limit_per_frame = kDefaultPictureCacheLimitPerFrame,
+      size_t max_bytes = kDefaultMaxBytes,
+      size_t eviction_grace_frames = kDefaultEvictionGraceFrames);
 
   ~RasterCache();
 
@@ -81,6 +121,9 @@ class RasterCache {
   // 3. The picture is accessed too few times
   // 4. There are too many pictures to be cached in the current frame.
   //    (See also kDefaultPictureCacheLimitPerFrame.)
+  // 5. The picture does not fit in the budget.
+  // 6. The picture is being rasterized on a worker thread, see
+  //    |SetConcurrentTaskRunner|.
   bool Prepare(GrContext* context,
                SkPicture* picture,
                const SkMatrix& transformation_matrix,
@@ -94,42 +137,168 @@ class RasterCache {
 
   RasterCacheResult Get(Layer* layer, const SkMatrix& ctm) const;
 
+  // Rasterizes |shadow| into masks that the following frames can draw instead
+  // of computing it again. Only shadows drawn without a GrContext are cached,
+  // the GPU backend draws them analytically.
+  //
+  // The shadow of an opaque rounded rectangle with a scale and translate |ctm|
+  // is cached as an ambient and a spot nine patch, shared by all the rounded
+  // rectangles with the same corners that are at least as large. The other
+  // shadows are cached by the generation ID of their path, their |ctm| and
+  // where their light falls.
+  void PrepareShadow(PrerollContext* context,
+                     const RasterCacheShadow& shadow,
+                     const SkMatrix& ctm);
+
+  // Draws |shadow| from the masks prepared for the matrix of |canvas|.
+  // Returns false if they are not cached.
+  bool DrawShadow(SkCanvas& canvas, const RasterCacheShadow& shadow) const;
+
   void SweepAfterFrame();
 
   void Clear();
 
   void SetCheckboardCacheImages(bool checkerboard);
 
+  // When set, pictures prepared without a GrContext are rasterized on
+  // |task_runner| instead of blocking the frame. Their image is promoted into
+  // the cache when the picture is prepared again after the rasterization
+  // completed. Pass nullptr to rasterize synchronously again.
+  void SetConcurrentTaskRunner(
+      std::shared_ptr<fml::ConcurrentTaskRunner> task_runner);
+
+  // The number of pictures being rasterized on the concurrent task runner.
+  size_t pending_count() const { return pending_count_; }
+
+  // The number of bytes of the rasterized images held by the cache.
+  size_t cache_bytes() const { return cache_bytes_; }
+
+  size_t max_bytes() const { return max_bytes_; }
+
+  // Counters accumulated since the cache was created.
+  const Stats& stats() const { return stats_; }
+
+  // Counters of the current frame, added to |stats| by |SweepAfterFrame|.
+  const Stats& frame_stats() const { return frame_stats_; }
+
  private:
+  // A picture being rasterized on the concurrent task runner. Shared between
+  // the entry and the worker so that the entry can be evicted meanwhile.
+  struct PendingImage {
+    std::atomic<bool> ready{false};
+    RasterCacheResult image;
+  };
+
+  // Identifies an entry by its key in one of the caches. Keys of unordered
+  // maps keep their address until they are erased.
+  struct EntryKey {
+    const PictureRasterCacheKey* picture = nullptr;
+    const LayerRasterCacheKey* layer = nullptr;
+    const ShadowRasterCacheKey* shadow = nullptr;
+  };
+
+  // The entries holding an image, the most recently used first.
+  using LruList = std::list<EntryKey>;
+
   struct Entry {
-    bool used_this_frame = false;
+    EntryKey key;
+    // Whether the entry holds an image, and is linked into |lru_| at
+    // |lru_position|.
+    bool in_lru = false;
+    LruList::iterator lru_position;
+    // The value of |frame_index_| when the entry was last prepared.
+    size_t last_used_frame = 0;
     size_t access_count = 0;
     RasterCacheResult image;
+    std::shared_ptr<PendingImage> pending_image;
+    // The bytes reserved in the budget for |pending_image|.
+    size_t pending_bytes = 0;
   };
 
-  template <class Cache, class Iterator>
-  static void SweepOneCacheAfterFrame(Cache& cache) {
-    std::vector<Iterator> dead;
-
-    for (auto it = cache.begin(); it != cache.end(); ++it) {
-      Entry& entry = it->second;
-      if (!entry.used_this_frame) {
-        dead.push_back(it);
+  template <class Cache>
+  void SweepOneCacheAfterFrame(Cache& cache) {
+    for (auto it = cache.begin(); it != cache.end();) {
+      if (frame_index_ - it->second.last_used_frame >=
+          eviction_grace_frames_) {
+        Evict(it->second);
+        it = cache.erase(it);
+      } else {
+        ++it;
       }
-      entry.used_this_frame = false;
     }
+  }
 
-    for (auto it : dead) {
-      cache.erase(it);
+  static EntryKey MakeEntryKey(const PictureRasterCacheKey& key) {
+    return {&key, nullptr, nullptr};
+  }
+  static EntryKey MakeEntryKey(const LayerRasterCacheKey& key) {
+    return {nullptr, &key, nullptr};
+  }
+  static EntryKey MakeEntryKey(const ShadowRasterCacheKey& key) {
+    return {nullptr, nullptr, &key};
+  }
+
+  // Returns the entry of |key|, adding it to |cache| if needed.
+  template <class Cache, class Key>
+  static Entry& FindOrAddEntry(Cache& cache, const Key& key) {
+    auto result = cache.try_emplace(key);
+    Entry& entry = result.first->second;
+    if (result.second) {
+      entry.key = MakeEntryKey(result.first->first);
     }
+    return entry;
   }
 
+  void Touch(Entry& entry);
+
+  const Entry& GetEntry(const EntryKey& key) const;
+
+  // Evicts and erases the entry of |key|.
+  void EraseEntry(const EntryKey& key);
+
+  // Evicts the least recently used images that were not used in the current
+  // frame until |bytes| more fit in the budget. Returns false if they don't.
+  bool EnsureCapacity(size_t bytes);
+
+  // Accounts for |entry| about to be removed from the cache.
+  void Evict(const Entry& entry);
+
+  // Stores |image| in |entry|, unless the rasterization failed.
+  void Insert(Entry& entry, RasterCacheResult image);
+
+  // Prepares the mask of |key|, which |rasterize| renders in |bytes|.
+  void PrepareShadowMask(const ShadowRasterCacheKey& key,
+                         size_t bytes,
+                         const std::function<RasterCacheResult()>& rasterize);
+
+  void RasterizeAsync(Entry& entry,
+                      SkPicture* picture,
+                      const SkMatrix& transformation_matrix,
+                      SkColorSpace* dst_color_space,
+                      size_t bytes);
+
+  // Moves the image of |entry| into the cache if its rasterization completed.
+  void PromotePendingImage(Entry& entry);
+
   const size_t access_threshold_;
   const size_t picture_cache_limit_per_frame_;
+  const size_t max_bytes_;
+  const size_t eviction_grace_frames_;
   size_t picture_cached_this_frame_ = 0;
+  size_t frame_index_ = 0;
+  size_t cache_bytes_ = 0;
+  // The bytes reserved for the pending images.
+  size_t pending_bytes_ = 0;
+  size_t pending_count_ = 0;
+  std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner_;
   PictureRasterCacheKey::Map<Entry> picture_cache_;
   LayerRasterCacheKey::Map<Entry> layer_cache_;
+  ShadowRasterCacheKey::Map<Entry> shadow_cache_;
+  LruList lru_;
   bool checkerboard_images_;
+  Stats stats_;
+  // The stats of the current frame, reported by |TraceStatsToTimeline|.
+  Stats frame_stats_;
   fml::WeakPtrFactory<RasterCache> weak_factory_;
 
   void TraceStatsToTimeline() const;
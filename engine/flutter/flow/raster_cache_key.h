@@ -5,9 +5,12 @@
 #ifndef FLUTTER_FLOW_RASTER_CACHE_KEY_H_
 #define FLUTTER_FLOW_RASTER_CACHE_KEY_H_
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 #include "flutter/flow/matrix_decomposition.h"
 #include "flutter/fml/logging.h"
+#include "third_party/skia/include/core/SkColor.h"
 
 namespace flutter {
 
@@ -59,6 +62,105 @@ class Layer;
 // The ID is the uint64_t layer unique_id
 using LayerRasterCacheKey = RasterCacheKey<uint64_t>;
 
+// Identifies a rasterized elevation shadow, see |RasterCache::PrepareShadow|.
+class ShadowRasterCacheKey {
+ public:
+  enum class Kind {
+    // The whole shadow of a path, drawn with the matrix of the key.
+    kPath,
+    // The ambient or the spot shadow of a rounded rectangle with the device
+    // corner radii of the key, stretched to any larger rounded rectangle with
+    // the same corners.
+    kAmbientNinePatch,
+    kSpotNinePatch,
+  };
+
+  // The light height and radius derive from the device pixel ratio, see
+  // |PhysicalShapeLayer::DrawShadow|. The light does not follow the ctm, so
+  // its position in the image of the shadow is part of the key.
+  static ShadowRasterCacheKey ForPath(uint32_t path_id,
+                                      const SkMatrix& ctm,
+                                      const SkPoint& light,
+                                      float elevation,
+                                      SkScalar dpr,
+                                      SkColor color,
+                                      bool transparent_occluder) {
+    ShadowRasterCacheKey key(Kind::kPath, elevation, dpr, color);
+    key.path_id_ = path_id;
+    key.transparent_occluder_ = transparent_occluder;
+    key.light_ = light;
+    key.matrix_ = ctm;
+    key.matrix_[SkMatrix::kMTransX] = SkScalarFraction(ctm.getTranslateX());
+    key.matrix_[SkMatrix::kMTransY] = SkScalarFraction(ctm.getTranslateY());
+    return key;
+  }
+
+  // The nine patches are rendered for transparent occluders, the shape drawn
+  // over an opaque occluder hides the difference.
+  static ShadowRasterCacheKey ForNinePatch(Kind kind,
+                                           const SkVector device_radii[4],
+                                           float elevation,
+                                           SkScalar dpr,
+                                           SkColor color) {
+    FML_DCHECK(kind != Kind::kPath);
+    ShadowRasterCacheKey key(kind, elevation, dpr, color);
+    std::memcpy(key.radii_, device_radii, sizeof(key.radii_));
+    return key;
+  }
+
+  Kind kind() const { return kind_; }
+  const SkMatrix& matrix() const { return matrix_; }
+  const SkVector* radii() const { return radii_; }
+  float elevation() const { return elevation_; }
+  SkScalar dpr() const { return dpr_; }
+  SkColor color() const { return color_; }
+
+  struct Hash {
+    uint32_t operator()(ShadowRasterCacheKey const& key) const {
+      size_t hash = std::hash<uint32_t>()(key.path_id_);
+      hash = hash * 31 + std::hash<float>()(key.radii_[0].fX);
+      hash = hash * 31 + std::hash<float>()(key.light_.fX);
+      hash = hash * 31 + std::hash<float>()(key.elevation_);
+      hash = hash * 31 + std::hash<uint32_t>()(key.color_);
+      return hash * 31 + static_cast<size_t>(key.kind_);
+    }
+  };
+
+  struct Equal {
+    bool operator()(const ShadowRasterCacheKey& lhs,
+                    const ShadowRasterCacheKey& rhs) const {
+      return lhs.kind_ == rhs.kind_ && lhs.path_id_ == rhs.path_id_ &&
+             lhs.matrix_ == rhs.matrix_ && lhs.light_ == rhs.light_ &&
+             std::equal(lhs.radii_, lhs.radii_ + 4, rhs.radii_) &&
+             lhs.elevation_ == rhs.elevation_ && lhs.dpr_ == rhs.dpr_ &&
+             lhs.color_ == rhs.color_ &&
+             lhs.transparent_occluder_ == rhs.transparent_occluder_;
+    }
+  };
+
+  template <class Value>
+  using Map = std::unordered_map<ShadowRasterCacheKey, Value, Hash, Equal>;
+
+ private:
+  ShadowRasterCacheKey(Kind kind, float elevation, SkScalar dpr, SkColor color)
+      : kind_(kind), elevation_(elevation), dpr_(dpr), color_(color) {}
+
+  Kind kind_;
+  // The generation ID of the path of a |Kind::kPath| key.
+  uint32_t path_id_ = 0;
+  // The ctm of a |Kind::kPath| key, only its fractional translation is kept.
+  SkMatrix matrix_ = SkMatrix::I();
+  // The light of a |Kind::kPath| key, in the coordinates of its image.
+  SkPoint light_ = SkPoint::Make(0, 0);
+  // The device radii of the corners of a nine patch key, in the order of
+  // |SkRRect::Corner|.
+  SkVector radii_[4] = {};
+  float elevation_;
+  SkScalar dpr_;
+  SkColor color_;
+  bool transparent_occluder_ = true;
+};
+
 }  // namespace flutter
 
 #endif  // FLUTTER_FLOW_RASTER_CACHE_KEY_H_
@@ -3,9 +3,14 @@
 // found in the LICENSE file.
 
 #include "flutter/flow/raster_cache.h"
+#include "flutter/flow/layers/layer.h"
+#include "flutter/flow/layers/physical_shape_layer.h"
+#include "flutter/fml/concurrent_message_loop.h"
+#include "flutter/fml/synchronization/waitable_event.h"
 #include "gtest/gtest.h"
 #include "third_party/skia/include/core/SkPicture.h"
 #include "third_party/skia/include/core/SkPictureRecorder.h"
+#include "third_party/skia/include/core/SkSurface.h"
 
 sk_sp<SkPicture> GetSamplePicture() {
   SkPictureRecorder recorder;
@@ -89,7 +94,400 @@ TEST(RasterCache, SweepsRemoveUnusedFrames) {
   ASSERT_TRUE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
                             false));  // 4
   cache.SweepAfterFrame();
-  cache.SweepAfterFrame();  // Extra frame without a preroll image access.
+  // Extra frames without a preroll image access.
+  for (size_t i = 0; i < flutter::RasterCache::kDefaultEvictionGraceFrames;
+       i++) {
+    cache.SweepAfterFrame();
+  }
   ASSERT_FALSE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
                              false));  // 5
 }
+
+TEST(RasterCache, EntriesSurviveTheGracePeriod) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_TRUE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
+                            false));
+  cache.SweepAfterFrame();
+  for (size_t i = 1; i < flutter::RasterCache::kDefaultEvictionGraceFrames;
+       i++) {
+    cache.SweepAfterFrame();
+  }
+  ASSERT_TRUE(cache.Get(*picture, matrix).is_valid());
+  ASSERT_TRUE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
+                            false));
+  cache.SweepAfterFrame();
+  ASSERT_EQ(cache.stats().miss_count, 1u);
+  ASSERT_EQ(cache.stats().hit_count, 1u);
+  ASSERT_EQ(cache.stats().eviction_count, 0u);
+}
+
+TEST(RasterCache, LeastRecentlyUsedImagesAreEvictedOverBudget) {
+  // The sample picture takes 150 * 100 * 4 bytes, only one fits.
+  const size_t picture_bytes = 150 * 100 * 4;
+  flutter::RasterCache cache(1, 3, picture_bytes * 3 / 2);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto first_picture = GetSamplePicture();
+  auto second_picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_TRUE(cache.Prepare(NULL, first_picture.get(), matrix, srgb.get(),
+                            true, false));
+  ASSERT_EQ(cache.cache_bytes(), picture_bytes);
+  // Both pictures are used in this frame, the second one doesn't fit.
+  ASSERT_FALSE(cache.Prepare(NULL, second_picture.get(), matrix, srgb.get(),
+                             true, false));
+  cache.SweepAfterFrame();
+
+  // The first picture is not used anymore and makes room for the second one.
+  ASSERT_TRUE(cache.Prepare(NULL, second_picture.get(), matrix, srgb.get(),
+                            true, false));
+  ASSERT_FALSE(cache.Get(*first_picture, matrix).is_valid());
+  ASSERT_TRUE(cache.Get(*second_picture, matrix).is_valid());
+  ASSERT_EQ(cache.cache_bytes(), picture_bytes);
+  cache.SweepAfterFrame();
+
+  ASSERT_EQ(cache.stats().eviction_count, 1u);
+  ASSERT_EQ(cache.stats().evicted_bytes, picture_bytes);
+}
+
+TEST(RasterCache, UsingAnImageMakesItTheMostRecentlyUsed) {
+  // Two sample pictures fit.
+  const size_t picture_bytes = 150 * 100 * 4;
+  flutter::RasterCache cache(1, 3, picture_bytes * 2);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto first_picture = GetSamplePicture();
+  auto second_picture = GetSamplePicture();
+  auto third_picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_TRUE(cache.Prepare(NULL, first_picture.get(), matrix, srgb.get(),
+                            true, false));
+  ASSERT_TRUE(cache.Prepare(NULL, second_picture.get(), matrix, srgb.get(),
+                            true, false));
+  cache.SweepAfterFrame();
+
+  // The first picture is used again after the second one was inserted.
+  ASSERT_TRUE(cache.Prepare(NULL, first_picture.get(), matrix, srgb.get(),
+                            true, false));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(cache.Prepare(NULL, third_picture.get(), matrix, srgb.get(),
+                            true, false));
+  ASSERT_TRUE(cache.Get(*first_picture, matrix).is_valid());
+  ASSERT_FALSE(cache.Get(*second_picture, matrix).is_valid());
+  ASSERT_TRUE(cache.Get(*third_picture, matrix).is_valid());
+  ASSERT_EQ(cache.cache_bytes(), picture_bytes * 2);
+}
+
+TEST(RasterCache, FailedRasterizationsAreNotCached) {
+  // Rasterizing the wide picture fails, as Skia limits the width of images.
+  const size_t picture_bytes = 150 * 100 * 4;
+  flutter::RasterCache cache(1, 3, 600000000u * 4u, 1);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  SkPictureRecorder recorder;
+  recorder.beginRecording(SkRect::MakeWH(600000000, 1));
+  recorder.getRecordingCanvas()->drawColor(SK_ColorRED);
+  auto wide_picture = recorder.finishRecordingAsPicture();
+  auto picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  cache.Prepare(NULL, wide_picture.get(), matrix, srgb.get(), true, false);
+  ASSERT_FALSE(cache.Get(*wide_picture, matrix).is_valid());
+  ASSERT_EQ(cache.cache_bytes(), 0u);
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  cache.SweepAfterFrame();
+
+  // The entry of the wide picture goes away without an image to evict.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  cache.SweepAfterFrame();
+  ASSERT_EQ(cache.cache_bytes(), picture_bytes);
+  ASSERT_EQ(cache.stats().eviction_count, 0u);
+
+  cache.SweepAfterFrame();
+  ASSERT_EQ(cache.cache_bytes(), 0u);
+  ASSERT_EQ(cache.stats().eviction_count, 1u);
+}
+
+TEST(RasterCache, PicturesAreRasterizedOnTheConcurrentTaskRunner) {
+  flutter::RasterCache cache(1);
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto task_runner = loop->GetTaskRunner();
+  cache.SetConcurrentTaskRunner(task_runner);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
+                             false));
+  ASSERT_EQ(cache.pending_count(), 1u);
+  ASSERT_EQ(cache.cache_bytes(), 0u);
+  cache.SweepAfterFrame();
+
+  // The single worker runs the tasks in order, so the picture has been
+  // rasterized once this task runs.
+  fml::AutoResetWaitableEvent latch;
+  task_runner->PostTask([&latch]() { latch.Signal(); });
+  latch.Wait();
+
+  ASSERT_TRUE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
+                            false));
+  ASSERT_EQ(cache.pending_count(), 0u);
+  ASSERT_TRUE(cache.Get(*picture, matrix).is_valid());
+  ASSERT_EQ(cache.cache_bytes(), 150u * 100u * 4u);
+  cache.SweepAfterFrame();
+}
+
+TEST(RasterCache, AsyncRasterizationRespectsThePerFrameLimit) {
+  flutter::RasterCache cache(1, 1);
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  cache.SetConcurrentTaskRunner(loop->GetTaskRunner());
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto first_picture = GetSamplePicture();
+  auto second_picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(cache.Prepare(NULL, first_picture.get(), matrix, srgb.get(),
+                             true, false));
+  ASSERT_FALSE(cache.Prepare(NULL, second_picture.get(), matrix, srgb.get(),
+                             true, false));
+  ASSERT_EQ(cache.pending_count(), 1u);
+  cache.SweepAfterFrame();
+
+  ASSERT_FALSE(cache.Prepare(NULL, second_picture.get(), matrix, srgb.get(),
+                             true, false));
+  ASSERT_EQ(cache.pending_count(), 2u);
+}
+
+TEST(RasterCache, EvictingPendingPicturesReleasesTheirBudget) {
+  flutter::RasterCache cache(1, 3, flutter::RasterCache::kDefaultMaxBytes, 1);
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto task_runner = loop->GetTaskRunner();
+  cache.SetConcurrentTaskRunner(task_runner);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true,
+                             false));
+  ASSERT_EQ(cache.pending_count(), 1u);
+  cache.SweepAfterFrame();
+  // Not prepared in this frame, the pending entry is evicted.
+  cache.SweepAfterFrame();
+  ASSERT_EQ(cache.pending_count(), 0u);
+
+  fml::AutoResetWaitableEvent latch;
+  task_runner->PostTask([&latch]() { latch.Signal(); });
+  latch.Wait();
+  ASSERT_EQ(cache.cache_bytes(), 0u);
+  ASSERT_FALSE(cache.Get(*picture, matrix).is_valid());
+}
+
+// Prepares |shadow| in |cache| like a software rasterizer would.
+void PrepareShadow(flutter::RasterCache& cache,
+                   const flutter::RasterCacheShadow& shadow,
+                   const SkMatrix& ctm) {
+  const flutter::Stopwatch unused_stopwatch;
+  flutter::TextureRegistry unused_texture_registry;
+  flutter::MutatorsStack unused_stack;
+  flutter::PrerollContext preroll_context{
+      &cache,                   // raster_cache
+      nullptr,                  // gr_context (software backend)
+      nullptr,                  // external view embedder
+      unused_stack,             // mutator stack
+      nullptr,                  // SkColorSpace* dst_color_space
+      flutter::kGiantRect,      // SkRect cull_rect
+      unused_stopwatch,         // frame time (dont care)
+      unused_stopwatch,         // engine time (dont care)
+      unused_texture_registry,  // texture registry (not supported)
+      false,                    // checkerboard_offscreen_layers
+  };
+  cache.PrepareShadow(&preroll_context, shadow, ctm);
+}
+
+flutter::RasterCacheShadow MakeShadow(const SkPath& path,
+                                      float elevation,
+                                      bool transparent_occluder,
+                                      SkScalar dpr) {
+  return {path, SK_ColorBLACK, elevation, transparent_occluder, dpr,
+          path.getBounds().makeOutset(100, 100)};
+}
+
+TEST(RasterCache, RoundedRectangleShadowsShareNinePatches) {
+  flutter::RasterCache cache(1);
+  SkPath small_card;
+  small_card.addRRect(SkRRect::MakeRectXY(SkRect::MakeWH(200, 120), 8, 8));
+  SkPath large_card;
+  large_card.addRRect(SkRRect::MakeRectXY(SkRect::MakeWH(300, 180), 8, 8));
+  auto small_shadow = MakeShadow(small_card, 4, false, 2);
+  auto large_shadow = MakeShadow(large_card, 4, false, 2);
+  SkMatrix matrix = SkMatrix::MakeScale(2);
+  matrix.postTranslate(10.5, 20);
+
+  // The ambient and the spot nine patches are rendered once.
+  PrepareShadow(cache, small_shadow, matrix);
+  ASSERT_EQ(cache.frame_stats().miss_count, 2u);
+  const size_t cache_bytes = cache.cache_bytes();
+  ASSERT_GT(cache_bytes, 0u);
+  PrepareShadow(cache, large_shadow, matrix);
+  ASSERT_EQ(cache.frame_stats().hit_count, 2u);
+  ASSERT_EQ(cache.cache_bytes(), cache_bytes);
+
+  auto surface = SkSurface::MakeRasterN32Premul(800, 600);
+  SkCanvas* canvas = surface->getCanvas();
+  canvas->setMatrix(matrix);
+  ASSERT_TRUE(cache.DrawShadow(*canvas, small_shadow));
+  ASSERT_TRUE(cache.DrawShadow(*canvas, large_shadow));
+  ASSERT_EQ(canvas->getTotalMatrix(), matrix);
+
+  // Another elevation casts another shadow.
+  ASSERT_FALSE(
+      cache.DrawShadow(*canvas, MakeShadow(small_card, 8, false, 2)));
+}
+
+TEST(RasterCache, OtherShadowsAreCachedByPath) {
+  flutter::RasterCache cache(1);
+  SkPath oval;
+  oval.addOval(SkRect::MakeWH(100, 60));
+  // Too small for the nine patches of its corners.
+  SkPath chip;
+  chip.addRRect(SkRRect::MakeRectXY(SkRect::MakeWH(40, 20), 10, 10));
+  auto oval_shadow = MakeShadow(oval, 4, false, 1);
+  auto chip_shadow = MakeShadow(chip, 4, true, 1);
+  const SkMatrix matrix = SkMatrix::MakeTrans(30, 40);
+
+  PrepareShadow(cache, oval_shadow, matrix);
+  PrepareShadow(cache, chip_shadow, matrix);
+  ASSERT_EQ(cache.frame_stats().miss_count, 2u);
+  ASSERT_EQ(cache.cache_bytes(), (300u * 260u + 240u * 220u) * 4u);
+
+  auto surface = SkSurface::MakeRasterN32Premul(300, 300);
+  SkCanvas* canvas = surface->getCanvas();
+  canvas->setMatrix(matrix);
+  ASSERT_TRUE(cache.DrawShadow(*canvas, oval_shadow));
+  ASSERT_TRUE(cache.DrawShadow(*canvas, chip_shadow));
+  // The light does not follow the canvas, which casts other shadows when it
+  // moves.
+  canvas->translate(20, 20);
+  ASSERT_FALSE(cache.DrawShadow(*canvas, oval_shadow));
+  canvas->setMatrix(matrix);
+  canvas->scale(2, 2);
+  ASSERT_FALSE(cache.DrawShadow(*canvas, oval_shadow));
+  canvas->setMatrix(matrix);
+
+  // A modified path casts another shadow.
+  oval.offset(1, 1);
+  ASSERT_FALSE(cache.DrawShadow(*canvas, oval_shadow));
+}
+
+// Returns the largest difference of a channel between the pixels of |shadow|
+// drawn from |cache| with |ctm| and the ones of |PhysicalShapeLayer|, which
+// calls SkShadowUtils::DrawShadow, once the occluder is painted.
+int GetLargestShadowDifference(const flutter::RasterCache& cache,
+                               const flutter::RasterCacheShadow& shadow,
+                               const SkMatrix& ctm) {
+  const SkImageInfo info = SkImageInfo::MakeN32Premul(800, 800);
+  auto cached = SkSurface::MakeRaster(info);
+  auto expected = SkSurface::MakeRaster(info);
+  cached->getCanvas()->setMatrix(ctm);
+  if (!cache.DrawShadow(*cached->getCanvas(), shadow)) {
+    return 255;
+  }
+  expected->getCanvas()->setMatrix(ctm);
+  flutter::PhysicalShapeLayer::DrawShadow(
+      expected->getCanvas(), shadow.path, shadow.color, shadow.elevation,
+      shadow.transparent_occluder, shadow.dpr);
+  // Like |PhysicalShapeLayer::Paint|, opaque occluders cover their shadow.
+  if (!shadow.transparent_occluder) {
+    SkPaint paint;
+    paint.setColor(SK_ColorWHITE);
+    paint.setAntiAlias(true);
+    cached->getCanvas()->drawPath(shadow.path, paint);
+    expected->getCanvas()->drawPath(shadow.path, paint);
+  }
+
+  SkPixmap cached_pixels;
+  SkPixmap expected_pixels;
+  if (!cached->peekPixels(&cached_pixels) ||
+      !expected->peekPixels(&expected_pixels)) {
+    return 255;
+  }
+  int difference = 0;
+  for (int y = 0; y < info.height(); y++) {
+    const uint8_t* cached_row =
+        static_cast<const uint8_t*>(cached_pixels.addr(0, y));
+    const uint8_t* expected_row =
+        static_cast<const uint8_t*>(expected_pixels.addr(0, y));
+    for (int x = 0; x < info.width() * 4; x++) {
+      difference =
+          std::max(difference, std::abs(cached_row[x] - expected_row[x]));
+    }
+  }
+  return difference;
+}
+
+TEST(RasterCache, NinePatchShadowsMatchSkia) {
+  SkPath card;
+  card.addRRect(SkRRect::MakeRectXY(SkRect::MakeXYWH(40, 30, 200, 120), 8, 8));
+  SkMatrix scaled = SkMatrix::MakeScale(1.5, 2);
+  scaled.postTranslate(-20.5, 60.25);
+  for (const SkMatrix& matrix :
+       {SkMatrix::I(), SkMatrix::MakeTrans(300, 410.5), scaled}) {
+    for (float elevation : {2.0f, 8.0f}) {
+      flutter::RasterCache cache(1);
+      auto shadow = MakeShadow(card, elevation, false, 1.5);
+      PrepareShadow(cache, shadow, matrix);
+      // The nine patches shade the inside of the occluder, which shows
+      // through its antialiased edge.
+      ASSERT_LE(GetLargestShadowDifference(cache, shadow, matrix), 8);
+    }
+  }
+}
+
+TEST(RasterCache, PathShadowsMatchSkia) {
+  SkPath oval;
+  oval.addOval(SkRect::MakeXYWH(60, 50, 100, 60));
+  SkPath chip;
+  chip.addRRect(SkRRect::MakeRectXY(SkRect::MakeXYWH(60, 50, 40, 20), 10, 10));
+  // Transparent occluders are not drawn from nine patches.
+  SkPath card;
+  card.addRRect(SkRRect::MakeRectXY(SkRect::MakeXYWH(40, 30, 200, 120), 8, 8));
+  SkMatrix scaled = SkMatrix::MakeScale(2, 1.5);
+  scaled.postTranslate(20.5, 300.25);
+  for (const SkMatrix& matrix :
+       {SkMatrix::I(), SkMatrix::MakeTrans(300, 410.5), scaled}) {
+    for (bool transparent_occluder : {false, true}) {
+      flutter::RasterCache cache(1);
+      auto oval_shadow = MakeShadow(oval, 4, transparent_occluder, 2);
+      auto chip_shadow = MakeShadow(chip, 4, transparent_occluder, 2);
+      PrepareShadow(cache, oval_shadow, matrix);
+      PrepareShadow(cache, chip_shadow, matrix);
+      ASSERT_LE(GetLargestShadowDifference(cache, oval_shadow, matrix), 1);
+      ASSERT_LE(GetLargestShadowDifference(cache, chip_shadow, matrix), 1);
+    }
+    flutter::RasterCache cache(1);
+    auto card_shadow = MakeShadow(card, 4, true, 2);
+    PrepareShadow(cache, card_shadow, matrix);
+    ASSERT_LE(GetLargestShadowDifference(cache, card_shadow, matrix), 1);
+  }
+}
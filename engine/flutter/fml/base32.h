@@ -12,6 +12,9 @@ namespace fml {
 
 std::pair<bool, std::string> Base32Encode(std::string_view input);
 
+// Reverses |Base32Encode|. Fails if |input| is not the encoding of any string.
+std::pair<bool, std::string> Base32Decode(std::string_view input);
+
 }  // namespace fml
 
 #endif  // FLUTTER_FML_BASE32_H_
@@ -36,3 +36,41 @@ TEST(Base32Test, CanEncode) {
     ASSERT_EQ(result.second, "NBSWYTDP");
   }
 }
+
+TEST(Base32Test, CanDecode) {
+  {
+    auto result = fml::Base32Decode("NBSWY3DP");
+    ASSERT_TRUE(result.first);
+    ASSERT_EQ(result.second, "hello");
+  }
+
+  {
+    auto result = fml::Base32Decode("GE");
+    ASSERT_TRUE(result.first);
+    ASSERT_EQ(result.second, "1");
+  }
+
+  {
+    auto result = fml::Base32Decode("");
+    ASSERT_TRUE(result.first);
+    ASSERT_EQ(result.second, "");
+  }
+
+  {
+    auto encoded = fml::Base32Encode(std::string("\x00\xff\x80\x01", 4));
+    ASSERT_TRUE(encoded.first);
+    auto result = fml::Base32Decode(encoded.second);
+    ASSERT_TRUE(result.first);
+    ASSERT_EQ(result.second, std::string("\x00\xff\x80\x01", 4));
+  }
+}
+
+TEST(Base32Test, RejectsInvalidEncodings) {
+  // Not in the alphabet.
+  ASSERT_FALSE(fml::Base32Decode("nbswy3dp").first);
+  ASSERT_FALSE(fml::Base32Decode("NBSWY3D1").first);
+  // Non-zero padding bits.
+  ASSERT_FALSE(fml::Base32Decode("GF").first);
+  // A dangling character.
+  ASSERT_FALSE(fml::Base32Decode("GEA").first);
+}
@@ -6,11 +6,25 @@
 
 #include <algorithm>
 
+#include "flutter/fml/synchronization/waitable_event.h"
 #include "flutter/fml/thread.h"
+#include "flutter/fml/thread_local.h"
 #include "flutter/fml/trace_event.h"
 
 namespace fml {
 
+namespace {
+
+struct WorkerInfo {
+  const ConcurrentMessageLoop* loop;
+  size_t index;
+};
+
+// The loop and the index of the worker running on the current thread, if any.
+FML_THREAD_LOCAL ThreadLocalUniquePtr<WorkerInfo> tls_worker_info;
+
+}  // namespace
+
 std::shared_ptr<ConcurrentMessageLoop> ConcurrentMessageLoop::Create(
     size_t worker_count) {
   return std::shared_ptr<ConcurrentMessageLoop>{
@@ -19,11 +33,14 @@ std::shared_ptr<ConcurrentMessageLoop> ConcurrentMessageLoop::Create(
 
 ConcurrentMessageLoop::ConcurrentMessageLoop(size_t worker_count)
     : worker_count_(std::max<size_t>(worker_count, 1ul)) {
+  for (size_t i = 0; i < worker_count_; ++i) {
+    worker_queues_.emplace_back(std::make_unique<Worker>());
+  }
   for (size_t i = 0; i < worker_count_; ++i) {
     workers_.emplace_back([i, this]() {
       fml::Thread::SetCurrentThreadName(
           std::string{"io.flutter.worker." + std::to_string(i + 1)});
-      WorkerMain();
+      WorkerMain(i);
     });
   }
 }
@@ -33,6 +50,14 @@ ConcurrentMessageLoop::~ConcurrentMessageLoop() {
   for (auto& worker : workers_) {
     worker.join();
   }
+
+  // A task posted while the loop was being terminated may have been pushed
+  // after the workers found the deques empty. Don't drop it on the floor.
+  for (size_t i = 0; i < worker_count_; ++i) {
+    while (auto task = TakeTask(i)) {
+      task();
+    }
+  }
 }
 
 size_t ConcurrentMessageLoop::GetWorkerCount() const {
@@ -43,62 +68,129 @@ std::shared_ptr<ConcurrentTaskRunner> ConcurrentMessageLoop::GetTaskRunner() {
   return std::make_shared<ConcurrentTaskRunner>(weak_from_this());
 }
 
-void ConcurrentMessageLoop::PostTask(fml::closure task) {
+size_t ConcurrentMessageLoop::GetCurrentWorkerIndex() const {
+  const WorkerInfo* worker_info = tls_worker_info.get();
+  return worker_info != nullptr && worker_info->loop == this
+             ? worker_info->index
+             : worker_count_;
+}
+
+void ConcurrentMessageLoop::PostTask(fml::closure task,
+                                     ConcurrentTaskPriority priority) {
   if (!task) {
     return;
   }
 
-  std::unique_lock lock(tasks_mutex_);
-
   // Don't just drop tasks on the floor in case of shutdown.
   if (shutdown_) {
     FML_DLOG(WARNING)
         << "Tried to post a task to shutdown concurrent message "
            "loop. The task will be executed on the callers thread.";
-    lock.unlock();
     task();
     return;
   }
 
-  tasks_.push(task);
+  size_t worker_index = GetCurrentWorkerIndex();
+  const bool posted_from_worker = worker_index != worker_count_;
+  if (!posted_from_worker) {
+    worker_index = next_worker_.fetch_add(1) % worker_count_;
+  }
 
-  // Unlock the mutex before notifying the condition variable because that mutex
-  // has to be acquired on the other thread anyway. Waiting in this scope till
-  // it is acquired there is a pessimization.
-  lock.unlock();
+  {
+    Worker& worker = *worker_queues_[worker_index];
+    std::scoped_lock lock(worker.tasks_mutex);
+    auto* tasks = posted_from_worker ? worker.tasks : worker.posted_tasks;
+    tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+    ++pending_tasks_;
+  }
 
-  tasks_condition_.notify_one();
+  // A worker going to sleep registers itself before checking for pending
+  // tasks, so either it sees the task pushed above or it is seen here.
+  if (sleeping_workers_ > 0) {
+    // Acquire the mutex so that the notification can't be sent between a
+    // worker checking for pending tasks and starting to wait. Don't hold it
+    // while notifying as it has to be acquired on the woken thread anyway.
+    { std::scoped_lock lock(sleep_mutex_); }
+    sleep_condition_.notify_one();
+  }
 }
 
-void ConcurrentMessageLoop::WorkerMain() {
-  while (true) {
-    std::unique_lock lock(tasks_mutex_);
-    tasks_condition_.wait(lock,
-                          [&]() { return tasks_.size() > 0 || shutdown_; });
+fml::closure ConcurrentMessageLoop::TakeTask(size_t worker_index) {
+  for (size_t priority = 0; priority < kPriorityCount; ++priority) {
+    if (pending_tasks_ == 0) {
+      return nullptr;
+    }
 
-    if (tasks_.size() == 0) {
-      // This can only be caused by shutdown.
-      FML_DCHECK(shutdown_);
-      break;
+    // The most recently pushed task of this worker first, its data is the most
+    // likely to still be in the caches of this thread. Then the oldest task
+    // posted to it from another thread, which nothing keeps warm.
+    {
+      Worker& worker = *worker_queues_[worker_index];
+      std::scoped_lock lock(worker.tasks_mutex);
+      auto& tasks = worker.tasks[priority];
+      if (!tasks.empty()) {
+        fml::closure task = std::move(tasks.back());
+        tasks.pop_back();
+        --pending_tasks_;
+        return task;
+      }
+      auto& posted_tasks = worker.posted_tasks[priority];
+      if (!posted_tasks.empty()) {
+        fml::closure task = std::move(posted_tasks.front());
+        posted_tasks.pop_front();
+        --pending_tasks_;
+        return task;
+      }
     }
 
-    auto task = tasks_.front();
-    tasks_.pop();
+    // Then the oldest task of the other workers.
+    for (size_t i = 1; i < worker_count_; ++i) {
+      Worker& victim = *worker_queues_[(worker_index + i) % worker_count_];
+      std::scoped_lock lock(victim.tasks_mutex);
+      for (auto* tasks : {&victim.posted_tasks[priority],
+                          &victim.tasks[priority]}) {
+        if (!tasks->empty()) {
+          fml::closure task = std::move(tasks->front());
+          tasks->pop_front();
+          --pending_tasks_;
+          return task;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
 
-    // Don't hold onto the mutex while the task is being executed as it could
-    // itself try to post another tasks to this message loop.
-    lock.unlock();
+void ConcurrentMessageLoop::WorkerMain(size_t worker_index) {
+  tls_worker_info.reset(new WorkerInfo{this, worker_index});
 
-    TRACE_EVENT0("flutter", "ConcurrentWorkerWake");
-    // Execute the one tasks we woke up for.
-    task();
+  while (true) {
+    if (auto task = TakeTask(worker_index)) {
+      TRACE_EVENT0("flutter", "ConcurrentWorkerWake");
+      task();
+      continue;
+    }
+
+    std::unique_lock lock(sleep_mutex_);
+    ++sleeping_workers_;
+    sleep_condition_.wait(
+        lock, [&]() { return pending_tasks_ > 0 || shutdown_; });
+    --sleeping_workers_;
+
+    if (pending_tasks_ == 0) {
+      // This can only be caused by shutdown. Pending tasks are drained first.
+      FML_DCHECK(shutdown_);
+      break;
+    }
   }
+
+  tls_worker_info.reset(nullptr);
 }
 
 void ConcurrentMessageLoop::Terminate() {
-  std::scoped_lock lock(tasks_mutex_);
+  std::scoped_lock lock(sleep_mutex_);
   shutdown_ = true;
-  tasks_condition_.notify_all();
+  sleep_condition_.notify_all();
 }
 
 ConcurrentTaskRunner::ConcurrentTaskRunner(
@@ -107,13 +199,14 @@ ConcurrentTaskRunner::ConcurrentTaskRunner(
 
 ConcurrentTaskRunner::~ConcurrentTaskRunner() = default;
 
-void ConcurrentTaskRunner::PostTask(fml::closure task) {
+void ConcurrentTaskRunner::PostTask(fml::closure task,
+                                    ConcurrentTaskPriority priority) {
   if (!task) {
     return;
   }
 
   if (auto loop = weak_loop_.lock()) {
-    loop->PostTask(task);
+    loop->PostTask(std::move(task), priority);
     return;
   }
 
@@ -123,4 +216,47 @@ void ConcurrentTaskRunner::PostTask(fml::closure task) {
   task();
 }
 
+void ConcurrentTaskRunner::ParallelFor(size_t count,
+                                       const std::function<void(size_t)>& body,
+                                       ConcurrentTaskPriority priority) {
+  if (count == 0 || !body) {
+    return;
+  }
+
+  // Shared with the helper tasks, which may only get to run after this call
+  // returned. They don't call |body| then since all the indices are taken.
+  struct State {
+    const std::function<void(size_t)>* body;
+    size_t count;
+    std::atomic_size_t next_index = 0;
+    std::atomic_size_t remaining;
+    AutoResetWaitableEvent done;
+
+    State(const std::function<void(size_t)>* body, size_t count)
+        : body(body), count(count), remaining(count) {}
+
+    void Run() {
+      for (size_t index = next_index++; index < count; index = next_index++) {
+        (*body)(index);
+        if (--remaining == 0) {
+          done.Signal();
+        }
+      }
+    }
+  };
+  auto state = std::make_shared<State>(&body, count);
+
+  if (auto loop = weak_loop_.lock()) {
+    const size_t helper_count = std::min(count - 1, loop->GetWorkerCount());
+    for (size_t i = 0; i < helper_count; ++i) {
+      loop->PostTask([state]() { state->Run(); }, priority);
+    }
+  }
+
+  // The calling thread takes part so that progress is made even if all the
+  // workers are busy, or this is called from one of them.
+  state->Run();
+  state->done.Wait();
+}
+
 }  // namespace fml
@@ -5,9 +5,14 @@
 #ifndef FLUTTER_FML_CONCURRENT_MESSAGE_LOOP_H_
 #define FLUTTER_FML_CONCURRENT_MESSAGE_LOOP_H_
 
+#include <atomic>
 #include <condition_variable>
-#include <queue>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "flutter/fml/closure.h"
 #include "flutter/fml/macros.h"
@@ -17,6 +22,24 @@ namespace fml {
 
 class ConcurrentTaskRunner;
 
+// Tasks of a higher priority are picked up by idle workers before any task
+// of a lower priority, regardless of the worker they were posted to.
+enum class ConcurrentTaskPriority {
+  kHigh,
+  kNormal,
+  kLow,
+};
+
+// A pool of worker threads that run tasks in no particular order.
+//
+// Every worker owns deques of tasks per priority. Tasks posted from a worker
+// are pushed onto that worker's own deque and popped from its back, which
+// keeps the data of nested tasks warm in that worker's caches. Tasks posted
+// from any other thread are spread across the workers, which run them in the
+// order they were posted once their own tasks are done. A worker whose deques
+// are empty steals the oldest task of another worker instead of going to
+// sleep, so that workers only contend with each other when one of them runs
+// out of work.
 class ConcurrentMessageLoop
     : public std::enable_shared_from_this<ConcurrentMessageLoop> {
  public:
@@ -34,18 +57,44 @@ class ConcurrentMessageLoop
  private:
   friend ConcurrentTaskRunner;
 
+  static constexpr size_t kPriorityCount = 3;
+
+  struct Worker {
+    std::mutex tasks_mutex;
+    // The tasks posted from this worker.
+    std::deque<fml::closure> tasks[kPriorityCount] FML_GUARDED_BY(tasks_mutex);
+    // The tasks posted from other threads.
+    std::deque<fml::closure> posted_tasks[kPriorityCount]
+        FML_GUARDED_BY(tasks_mutex);
+  };
+
   size_t worker_count_ = 0;
   std::vector<std::thread> workers_;
-  std::mutex tasks_mutex_;
-  std::condition_variable tasks_condition_;
-  std::queue<fml::closure> tasks_;
-  bool shutdown_ = false;
+  std::vector<std::unique_ptr<Worker>> worker_queues_;
+  // The number of tasks in all the worker deques. Only changed while holding
+  // the mutex of the deque the task is pushed to or popped from.
+  std::atomic_size_t pending_tasks_ = 0;
+  // Used to pick the deque of tasks posted from outside of the workers.
+  std::atomic_size_t next_worker_ = 0;
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_condition_;
+  std::atomic_size_t sleeping_workers_ = 0;
+  std::atomic_bool shutdown_ = false;
 
   ConcurrentMessageLoop(size_t worker_count);
 
-  void WorkerMain();
+  void WorkerMain(size_t worker_index);
+
+  void PostTask(fml::closure task, ConcurrentTaskPriority priority);
+
+  // Pops a task from the back of the deques of |worker_index|, or steals one
+  // from the front of the deques of another worker. Returns a null closure if
+  // all the deques are empty.
+  fml::closure TakeTask(size_t worker_index);
 
-  void PostTask(fml::closure task);
+  // Returns the index of the worker of this loop the calling thread is, or
+  // |worker_count_| if it is not one of them.
+  size_t GetCurrentWorkerIndex() const;
 
   FML_DISALLOW_COPY_AND_ASSIGN(ConcurrentMessageLoop);
 };
@@ -56,7 +105,18 @@ class ConcurrentTaskRunner {
 
   ~ConcurrentTaskRunner();
 
-  void PostTask(fml::closure task);
+  void PostTask(fml::closure task,
+                ConcurrentTaskPriority priority =
+                    ConcurrentTaskPriority::kNormal);
+
+  // Calls |body| once for every index in [0, |count|) on the workers of the
+  // loop and on the calling thread, and returns once all the calls are done.
+  // Indices are handed out in increasing order but may run concurrently and
+  // complete in any order.
+  void ParallelFor(size_t count,
+                   const std::function<void(size_t)>& body,
+                   ConcurrentTaskPriority priority =
+                       ConcurrentTaskPriority::kNormal);
 
  private:
   friend ConcurrentMessageLoop;
@@ -0,0 +1,93 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/concurrent_message_loop.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
+
+namespace fml {
+namespace benchmarking {
+
+namespace {
+
+// Stands in for a small decode or shader compilation task.
+void DoWork(size_t iterations) {
+  std::atomic_size_t sink = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    sink.fetch_add(i, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+
+// Posts many small tasks from the benchmark thread to a loop with
+// |state.range(0)| workers.
+static void BM_ConcurrentMessageLoopPostTasks(benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const size_t kTaskCount = 10000;
+  while (state.KeepRunning()) {
+    CountDownLatch latch(kTaskCount);
+    for (size_t i = 0; i < kTaskCount; i++) {
+      task_runner->PostTask([&latch]() {
+        DoWork(100);
+        latch.CountDown();
+      });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kTaskCount);
+}
+
+// Posts tasks from the workers themselves, which is how nested image decode
+// and Skia tasks fan out.
+static void BM_ConcurrentMessageLoopPostNestedTasks(benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const size_t kFanOut = 100;
+  while (state.KeepRunning()) {
+    CountDownLatch latch(kFanOut * kFanOut);
+    for (size_t i = 0; i < kFanOut; i++) {
+      task_runner->PostTask([&latch, &task_runner]() {
+        for (size_t j = 0; j < kFanOut; j++) {
+          task_runner->PostTask([&latch]() {
+            DoWork(100);
+            latch.CountDown();
+          });
+        }
+      });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kFanOut * kFanOut);
+}
+
+static void BM_ConcurrentTaskRunnerParallelFor(benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const size_t kCount = 10000;
+  while (state.KeepRunning()) {
+    task_runner->ParallelFor(kCount, [](size_t) { DoWork(100); });
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+BENCHMARK(BM_ConcurrentMessageLoopPostTasks)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+BENCHMARK(BM_ConcurrentMessageLoopPostNestedTasks)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+BENCHMARK(BM_ConcurrentTaskRunnerParallelFor)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+}  // namespace benchmarking
+}  // namespace fml
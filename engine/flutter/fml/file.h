@@ -5,6 +5,7 @@
 #ifndef FLUTTER_FML_FILE_H_
 #define FLUTTER_FML_FILE_H_
 
+#include <functional>
 #include <initializer_list>
 #include <string>
 #include <vector>
@@ -55,8 +56,25 @@ bool IsFile(const std::string& path);
 
 bool TruncateFile(const fml::UniqueFD& file, size_t size);
 
+// Writes |data| at |offset| in |file|, growing the file as needed. Returns
+// false unless all of |data| was written, in which case part of it may have
+// been.
+bool WriteFileAt(const fml::UniqueFD& file,
+                 size_t offset,
+                 const Mapping& data);
+
 bool FileExists(const fml::UniqueFD& base_directory, const char* path);
 
+// Called with the directory being visited and the name of one of its entries.
+// Returns false to stop the visit.
+using FileVisitor = std::function<bool(const fml::UniqueFD& directory,
+                                       const std::string& filename)>;
+
+// Calls |visitor| for the entries of |directory|, except for "." and "..".
+// Subdirectories are not visited. Returns false if |directory| could not be
+// read.
+bool VisitFiles(const fml::UniqueFD& directory, const FileVisitor& visitor);
+
 bool UnlinkDirectory(const char* path);
 
 bool UnlinkDirectory(const fml::UniqueFD& base_directory, const char* path);
@@ -81,6 +99,8 @@ class ScopedTemporaryDirectory {
 
   const UniqueFD& fd() { return dir_fd_; }
 
+  const std::string& path() const { return path_; }
+
  private:
   std::string path_;
   UniqueFD dir_fd_;
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -156,6 +157,58 @@ TEST(FileTest, AtomicWriteTest) {
   ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "precious_data"));
 }
 
+TEST(FileTest, WriteAtGrowsTheFile) {
+  fml::ScopedTemporaryDirectory dir;
+
+  auto file = fml::OpenFile(dir.fd(), "my_contents", true,
+                            fml::FilePermission::kReadWrite);
+  ASSERT_TRUE(WriteStringToFile(file, "Hello"));
+
+  const std::string appended = ", World";
+  fml::DataMapping data(std::vector<uint8_t>{appended.begin(), appended.end()});
+  ASSERT_TRUE(fml::WriteFileAt(file, 5, data));
+  ASSERT_EQ(ReadStringFromFile(file), "Hello, World");
+
+  // Overwrite in the middle of the file.
+  ASSERT_TRUE(fml::WriteFileAt(file, 0, data));
+  ASSERT_EQ(ReadStringFromFile(file), ", WorldWorld");
+
+  ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "my_contents"));
+}
+
+TEST(FileTest, VisitsTheFilesOfADirectory) {
+  fml::ScopedTemporaryDirectory dir;
+
+  for (const char* name : {"a", "b"}) {
+    ASSERT_TRUE(fml::OpenFile(dir.fd(), name, true,
+                              fml::FilePermission::kReadWrite)
+                    .is_valid());
+  }
+
+  std::vector<std::string> names;
+  ASSERT_TRUE(fml::VisitFiles(
+      dir.fd(), [&names](const fml::UniqueFD& directory,
+                         const std::string& filename) {
+        names.push_back(filename);
+        return true;
+      }));
+  std::sort(names.begin(), names.end());
+  ASSERT_EQ(names, (std::vector<std::string>{"a", "b"}));
+
+  // The visit stops when the visitor returns false.
+  size_t visit_count = 0;
+  ASSERT_TRUE(fml::VisitFiles(
+      dir.fd(), [&visit_count](const fml::UniqueFD& directory,
+                               const std::string& filename) {
+        visit_count++;
+        return false;
+      }));
+  ASSERT_EQ(visit_count, 1u);
+
+  ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "a"));
+  ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "b"));
+}
+
 TEST(FileTest, EmptyMappingTest) {
   fml::ScopedTemporaryDirectory dir;
 
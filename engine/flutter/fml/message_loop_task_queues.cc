@@ -16,6 +16,18 @@ const size_t TaskQueueId::kUnmerged = ULONG_MAX;
 
 fml::RefPtr<MessageLoopTaskQueues> MessageLoopTaskQueues::instance_;
 
+namespace {
+
+size_t GetEntryChunkIndex(size_t position) {
+  size_t chunk = 0;
+  while ((position >> (chunk + 1)) != 0) {
+    ++chunk;
+  }
+  return chunk;
+}
+
+}  // namespace
+
 TaskQueueEntry::TaskQueueEntry()
     : owner_of(_kUnmerged), subsumed_by(_kUnmerged) {
   wakeable = NULL;
@@ -32,10 +44,10 @@ fml::RefPtr<MessageLoopTaskQueues> MessageLoopTaskQueues::GetInstance() {
 }
 
 TaskQueueId MessageLoopTaskQueues::CreateTaskQueue() {
-  std::lock_guard guard(queue_mutex_);
-  TaskQueueId loop_id = TaskQueueId(task_queue_id_counter_);
-  ++task_queue_id_counter_;
-  queue_entries_[loop_id] = std::make_unique<TaskQueueEntry>();
+  TaskQueueId loop_id = TaskQueueId(task_queue_id_counter_++);
+  EntrySlot* slot = GetEntrySlot(loop_id, true);
+  FML_CHECK(slot) << "Too many task queues.";
+  slot->store(new TaskQueueEntry(), std::memory_order_release);
 
   return loop_id;
 }
@@ -43,16 +55,105 @@ TaskQueueId MessageLoopTaskQueues::CreateTaskQueue() {
 MessageLoopTaskQueues::MessageLoopTaskQueues()
     : task_queue_id_counter_(0), order_(0) {}
 
-MessageLoopTaskQueues::~MessageLoopTaskQueues() = default;
+MessageLoopTaskQueues::~MessageLoopTaskQueues() {
+  for (size_t chunk = 0; chunk < kEntryChunkCount; ++chunk) {
+    EntrySlot* slots = entry_chunks_[chunk].load();
+    if (slots == nullptr) {
+      continue;
+    }
+    for (size_t i = 0; i < (size_t{1} << chunk); ++i) {
+      delete slots[i].load();
+    }
+    delete[] slots;
+  }
+}
+
+MessageLoopTaskQueues::EntrySlot* MessageLoopTaskQueues::GetEntrySlot(
+    TaskQueueId queue_id,
+    bool create) const {
+  // Shift ids by one so that chunk |k| starts at position 2^k.
+  const size_t position = static_cast<size_t>(queue_id) + 1;
+  const size_t chunk = GetEntryChunkIndex(position);
+  if (chunk >= kEntryChunkCount) {
+    return nullptr;
+  }
+
+  EntrySlot* slots = entry_chunks_[chunk].load(std::memory_order_acquire);
+  if (slots == nullptr && create) {
+    // Only reached when creating the first queue of a chunk. Another thread
+    // may be doing the same, only one of the chunks is kept.
+    EntrySlot* new_slots = new EntrySlot[size_t{1} << chunk]();
+    if (entry_chunks_[chunk].compare_exchange_strong(
+            slots, new_slots, std::memory_order_acq_rel)) {
+      slots = new_slots;
+    } else {
+      delete[] new_slots;
+    }
+  }
+  if (slots == nullptr) {
+    return nullptr;
+  }
+  return &slots[position - (size_t{1} << chunk)];
+}
+
+TaskQueueEntry& MessageLoopTaskQueues::GetEntry(TaskQueueId queue_id) const {
+  EntrySlot* slot = GetEntrySlot(queue_id, false);
+  TaskQueueEntry* entry =
+      slot ? slot->load(std::memory_order_acquire) : nullptr;
+  FML_CHECK(entry) << "Unknown task queue: " << static_cast<int>(queue_id);
+  return *entry;
+}
+
+std::unique_ptr<TaskQueueEntry> MessageLoopTaskQueues::RemoveEntry(
+    TaskQueueId queue_id) {
+  EntrySlot* slot = GetEntrySlot(queue_id, false);
+  if (slot == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<TaskQueueEntry>(
+      slot->exchange(nullptr, std::memory_order_acq_rel));
+}
+
+TaskQueueEntry* MessageLoopTaskQueues::LockQueues(
+    TaskQueueEntry& entry,
+    std::unique_lock<std::mutex>& lock,
+    std::unique_lock<std::mutex>& merged_lock) const {
+  while (true) {
+    lock = std::unique_lock(entry.mutex);
+    const TaskQueueId merged_id =
+        entry.owner_of != _kUnmerged ? entry.owner_of : entry.subsumed_by;
+    if (merged_id == _kUnmerged) {
+      return nullptr;
+    }
+
+    // Both mutexes have to be acquired together to avoid lock order
+    // inversions with a call on the merged queue.
+    TaskQueueEntry& merged = GetEntry(merged_id);
+    lock.unlock();
+    std::lock(entry.mutex, merged.mutex);
+    lock = std::unique_lock(entry.mutex, std::adopt_lock);
+    merged_lock = std::unique_lock(merged.mutex, std::adopt_lock);
+
+    // The queues may have been unmerged while no mutex was held.
+    if (entry.owner_of == merged_id || entry.subsumed_by == merged_id) {
+      return &merged;
+    }
+    merged_lock.unlock();
+    lock.unlock();
+  }
+}
 
 void MessageLoopTaskQueues::Dispose(TaskQueueId queue_id) {
-  std::lock_guard guard(queue_mutex_);
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  FML_DCHECK(queue_entry->subsumed_by == _kUnmerged);
-  TaskQueueId subsumed = queue_entry->owner_of;
-  queue_entries_.erase(queue_id);
-  if (subsumed != _kUnmerged) {
-    queue_entries_.erase(subsumed);
+  std::unique_ptr<TaskQueueEntry> queue_entry = RemoveEntry(queue_id);
+  FML_CHECK(queue_entry);
+  std::unique_ptr<TaskQueueEntry> subsumed_entry;
+  {
+    std::scoped_lock lock(queue_entry->mutex);
+    FML_DCHECK(queue_entry->subsumed_by == _kUnmerged);
+    TaskQueueId subsumed = queue_entry->owner_of;
+    if (subsumed != _kUnmerged) {
+      subsumed_entry = RemoveEntry(subsumed);
+    }
   }
 }
 
@@ -60,13 +161,13 @@ void MessageLoopTaskQueues::DisposeTasks(TaskQueueId queue_id) {
   DelayedTaskQueue dispose_tasks;
   DelayedTaskQueue dispose_merged_tasks;
   {
-    std::lock_guard guard(queue_mutex_);
-    const auto& queue_entry = queue_entries_.at(queue_id);
-    FML_DCHECK(queue_entry->subsumed_by == _kUnmerged);
-    TaskQueueId subsumed = queue_entry->owner_of;
-    dispose_tasks = std::move(queue_entry->delayed_tasks);
-    if (subsumed != _kUnmerged) {
-      dispose_merged_tasks = std::move(queue_entries_.at(subsumed)->delayed_tasks);
+    TaskQueueEntry& queue_entry = GetEntry(queue_id);
+    std::unique_lock<std::mutex> lock, merged_lock;
+    TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
+    FML_DCHECK(queue_entry.subsumed_by == _kUnmerged);
+    dispose_tasks = std::move(queue_entry.delayed_tasks);
+    if (queue_entry.owner_of != _kUnmerged) {
+      dispose_merged_tasks = std::move(merged->delayed_tasks);
     }
   }
 }
@@ -74,76 +175,87 @@ void MessageLoopTaskQueues::DisposeTasks(TaskQueueId queue_id) {
 void MessageLoopTaskQueues::RegisterTask(TaskQueueId queue_id,
                                          fml::closure task,
                                          fml::TimePoint target_time) {
-  std::lock_guard guard(queue_mutex_);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
   size_t order = order_++;
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  queue_entry->delayed_tasks.push({order, std::move(task), target_time});
-  TaskQueueId loop_to_wake = queue_id;
-  if (queue_entry->subsumed_by != _kUnmerged) {
-    loop_to_wake = queue_entry->subsumed_by;
-  }
-  WakeUpUnlocked(loop_to_wake,
-                 queue_entry->delayed_tasks.top().GetTargetTime());
+  queue_entry.delayed_tasks.push({order, std::move(task), target_time});
+  if (queue_entry.subsumed_by != _kUnmerged) {
+    WakeUpUnlocked(*merged, GetNextWakeTimeUnlocked(*merged, &queue_entry));
+  } else {
+    WakeUpUnlocked(queue_entry, GetNextWakeTimeUnlocked(queue_entry, merged));
+  }
 }
 
 bool MessageLoopTaskQueues::HasPendingTasks(TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
-  return HasPendingTasksUnlocked(queue_id);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
+  return HasPendingTasksUnlocked(queue_entry, merged);
 }
 
 void MessageLoopTaskQueues::GetTasksToRunNow(
     TaskQueueId queue_id,
     FlushType type,
     std::vector<fml::closure>& invocations) {
-  std::lock_guard guard(queue_mutex_);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
+
+  // The loop is flushed because its wakeable fired, or is about to. The next
+  // wake up must not be skipped.
+  queue_entry.wake_time.reset();
 
-  if (!HasPendingTasksUnlocked(queue_id)) {
+  if (!HasPendingTasksUnlocked(queue_entry, merged)) {
     return;
   }
 
   const auto now = fml::TimePoint::Now();
 
-  while (HasPendingTasksUnlocked(queue_id)) {
-    TaskQueueId top_queue = _kUnmerged;
-    const auto& top = PeekNextTaskUnlocked(queue_id, top_queue);
+  while (HasPendingTasksUnlocked(queue_entry, merged)) {
+    TaskQueueEntry& top_entry = PeekNextTaskUnlocked(queue_entry, merged);
+    const auto& top = top_entry.delayed_tasks.top();
     if (top.GetTargetTime() > now) {
       break;
     }
     invocations.emplace_back(std::move(top.GetTask()));
-    queue_entries_.at(top_queue)->delayed_tasks.pop();
+    top_entry.delayed_tasks.pop();
     if (type == FlushType::kSingle) {
       break;
     }
   }
 
-  if (!HasPendingTasksUnlocked(queue_id)) {
-    WakeUpUnlocked(queue_id, fml::TimePoint::Max());
+  if (!HasPendingTasksUnlocked(queue_entry, merged)) {
+    WakeUpUnlocked(queue_entry, fml::TimePoint::Max());
   } else {
-    WakeUpUnlocked(queue_id, GetNextWakeTimeUnlocked(queue_id));
+    WakeUpUnlocked(queue_entry, GetNextWakeTimeUnlocked(queue_entry, merged));
   }
 }
 
-void MessageLoopTaskQueues::WakeUpUnlocked(TaskQueueId queue_id,
+void MessageLoopTaskQueues::WakeUpUnlocked(TaskQueueEntry& entry,
                                            fml::TimePoint time) const {
-  if (queue_entries_.at(queue_id)->wakeable) {
-    queue_entries_.at(queue_id)->wakeable->WakeUp(time);
+  // Waking the loop up may be a system call. Skip it if the loop is already
+  // going to wake up at that time, such as when a task is posted behind an
+  // earlier one.
+  if (entry.wakeable && entry.wake_time != time) {
+    entry.wake_time = time;
+    entry.wakeable->WakeUp(time);
   }
 }
 
 size_t MessageLoopTaskQueues::GetNumPendingTasks(TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
 
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  if (queue_entry->subsumed_by != _kUnmerged) {
+  if (queue_entry.subsumed_by != _kUnmerged) {
     return 0;
   }
   size_t total_tasks = 0;
-  total_tasks += queue_entry->delayed_tasks.size();
+  total_tasks += queue_entry.delayed_tasks.size();
 
-  TaskQueueId subsumed = queue_entry->owner_of;
-  if (subsumed != _kUnmerged) {
-    const auto& subsumed_entry = queue_entries_.at(subsumed);
-    total_tasks += subsumed_entry->delayed_tasks.size();
+  if (queue_entry.owner_of != _kUnmerged) {
+    total_tasks += merged->delayed_tasks.size();
   }
   return total_tasks;
 }
@@ -151,33 +263,36 @@ size_t MessageLoopTaskQueues::GetNumPendingTasks(TaskQueueId queue_id) const {
 void MessageLoopTaskQueues::AddTaskObserver(TaskQueueId queue_id,
                                             intptr_t key,
                                             fml::closure callback) {
-  std::lock_guard guard(queue_mutex_);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::scoped_lock lock(queue_entry.mutex);
   FML_DCHECK(callback != nullptr) << "Observer callback must be non-null.";
-  queue_entries_.at(queue_id)->task_observers[key] = std::move(callback);
+  queue_entry.task_observers[key] = std::move(callback);
 }
 
 void MessageLoopTaskQueues::RemoveTaskObserver(TaskQueueId queue_id,
                                                intptr_t key) {
-  std::lock_guard guard(queue_mutex_);
-  queue_entries_.at(queue_id)->task_observers.erase(key);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::scoped_lock lock(queue_entry.mutex);
+  queue_entry.task_observers.erase(key);
 }
 
 std::vector<fml::closure> MessageLoopTaskQueues::GetObserversToNotify(
     TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(queue_entry, lock, merged_lock);
   std::vector<fml::closure> observers;
 
-  if (queue_entries_.at(queue_id)->subsumed_by != _kUnmerged) {
+  if (queue_entry.subsumed_by != _kUnmerged) {
     return observers;
   }
 
-  for (const auto& observer : queue_entries_.at(queue_id)->task_observers) {
+  for (const auto& observer : queue_entry.task_observers) {
     observers.push_back(observer.second);
   }
 
-  TaskQueueId subsumed = queue_entries_.at(queue_id)->owner_of;
-  if (subsumed != _kUnmerged) {
-    for (const auto& observer : queue_entries_.at(subsumed)->task_observers) {
+  if (queue_entry.owner_of != _kUnmerged) {
+    for (const auto& observer : merged->task_observers) {
       observers.push_back(observer.second);
     }
   }
@@ -187,10 +302,10 @@ std::vector<fml::closure> MessageLoopTaskQueues::GetObserversToNotify(
 
 void MessageLoopTaskQueues::SetWakeable(TaskQueueId queue_id,
                                         fml::Wakeable* wakeable) {
-  std::lock_guard guard(queue_mutex_);
-  FML_CHECK(!queue_entries_.at(queue_id)->wakeable)
-      << "Wakeable can only be set once.";
-  queue_entries_.at(queue_id)->wakeable = wakeable;
+  TaskQueueEntry& queue_entry = GetEntry(queue_id);
+  std::scoped_lock lock(queue_entry.mutex);
+  FML_CHECK(!queue_entry.wakeable) << "Wakeable can only be set once.";
+  queue_entry.wakeable = wakeable;
 }
 
 bool MessageLoopTaskQueues::Merge(TaskQueueId owner, TaskQueueId subsumed) {
@@ -198,17 +313,17 @@ bool MessageLoopTaskQueues::Merge(TaskQueueId owner, TaskQueueId subsumed) {
     return true;
   }
 
-  std::lock_guard guard(queue_mutex_);
-  auto& owner_entry = queue_entries_.at(owner);
-  auto& subsumed_entry = queue_entries_.at(subsumed);
+  TaskQueueEntry& owner_entry = GetEntry(owner);
+  TaskQueueEntry& subsumed_entry = GetEntry(subsumed);
+  std::scoped_lock lock(owner_entry.mutex, subsumed_entry.mutex);
 
-  if (owner_entry->owner_of == subsumed) {
+  if (owner_entry.owner_of == subsumed) {
     return true;
   }
 
   std::vector<TaskQueueId> owner_subsumed_keys = {
-      owner_entry->owner_of, owner_entry->subsumed_by, subsumed_entry->owner_of,
-      subsumed_entry->subsumed_by};
+      owner_entry.owner_of, owner_entry.subsumed_by, subsumed_entry.owner_of,
+      subsumed_entry.subsumed_by};
 
   for (auto key : owner_subsumed_keys) {
     if (key != _kUnmerged) {
@@ -216,34 +331,37 @@ bool MessageLoopTaskQueues::Merge(TaskQueueId owner, TaskQueueId subsumed) {
     }
   }
 
-  owner_entry->owner_of = subsumed;
-  subsumed_entry->subsumed_by = owner;
+  owner_entry.owner_of = subsumed;
+  subsumed_entry.subsumed_by = owner;
 
-  if (HasPendingTasksUnlocked(owner)) {
-    WakeUpUnlocked(owner, GetNextWakeTimeUnlocked(owner));
+  if (HasPendingTasksUnlocked(owner_entry, &subsumed_entry)) {
+    WakeUpUnlocked(owner_entry,
+                   GetNextWakeTimeUnlocked(owner_entry, &subsumed_entry));
   }
 
   return true;
 }
 
 bool MessageLoopTaskQueues::Unmerge(TaskQueueId owner) {
-  std::lock_guard guard(queue_mutex_);
-  const auto& owner_entry = queue_entries_.at(owner);
+  TaskQueueEntry& owner_entry = GetEntry(owner);
+  std::unique_lock<std::mutex> lock, merged_lock;
+  TaskQueueEntry* merged = LockQueues(owner_entry, lock, merged_lock);
 
-  const TaskQueueId subsumed = owner_entry->owner_of;
-  if (subsumed == _kUnmerged) {
+  if (owner_entry.owner_of == _kUnmerged) {
     return false;
   }
 
-  queue_entries_.at(subsumed)->subsumed_by = _kUnmerged;
-  owner_entry->owner_of = _kUnmerged;
+  TaskQueueEntry& subsumed_entry = *merged;
+  subsumed_entry.subsumed_by = _kUnmerged;
+  owner_entry.owner_of = _kUnmerged;
 
-  if (HasPendingTasksUnlocked(owner)) {
-    WakeUpUnlocked(owner, GetNextWakeTimeUnlocked(owner));
+  if (HasPendingTasksUnlocked(owner_entry, nullptr)) {
+    WakeUpUnlocked(owner_entry, GetNextWakeTimeUnlocked(owner_entry, nullptr));
   }
 
-  if (HasPendingTasksUnlocked(subsumed)) {
-    WakeUpUnlocked(subsumed, GetNextWakeTimeUnlocked(subsumed));
+  if (HasPendingTasksUnlocked(subsumed_entry, nullptr)) {
+    WakeUpUnlocked(subsumed_entry,
+                   GetNextWakeTimeUnlocked(subsumed_entry, nullptr));
   }
 
   return true;
@@ -251,52 +369,49 @@ bool MessageLoopTaskQueues::Unmerge(TaskQueueId owner) {
 
 bool MessageLoopTaskQueues::Owns(TaskQueueId owner,
                                  TaskQueueId subsumed) const {
-  std::lock_guard guard(queue_mutex_);
-  return subsumed == queue_entries_.at(owner)->owner_of || owner == subsumed;
+  TaskQueueEntry& owner_entry = GetEntry(owner);
+  std::scoped_lock lock(owner_entry.mutex);
+  return subsumed == owner_entry.owner_of || owner == subsumed;
 }
 
 // Subsumed queues will never have pending tasks.
 // Owning queues will consider both their and their subsumed tasks.
 bool MessageLoopTaskQueues::HasPendingTasksUnlocked(
-    TaskQueueId queue_id) const {
-  const auto& entry = queue_entries_.at(queue_id);
-  bool is_subsumed = entry->subsumed_by != _kUnmerged;
+    const TaskQueueEntry& entry,
+    const TaskQueueEntry* merged) const {
+  bool is_subsumed = entry.subsumed_by != _kUnmerged;
   if (is_subsumed) {
     return false;
   }
 
-  if (!entry->delayed_tasks.empty()) {
+  if (!entry.delayed_tasks.empty()) {
     return true;
   }
 
-  const TaskQueueId subsumed = entry->owner_of;
-  if (subsumed == _kUnmerged) {
+  if (entry.owner_of == _kUnmerged) {
     // this is not an owner and queue is empty.
     return false;
   } else {
-    return !queue_entries_.at(subsumed)->delayed_tasks.empty();
+    return !merged->delayed_tasks.empty();
   }
 }
 
 fml::TimePoint MessageLoopTaskQueues::GetNextWakeTimeUnlocked(
-    TaskQueueId queue_id) const {
-  TaskQueueId tmp = _kUnmerged;
-  return PeekNextTaskUnlocked(queue_id, tmp).GetTargetTime();
+    TaskQueueEntry& owner,
+    TaskQueueEntry* merged) const {
+  return PeekNextTaskUnlocked(owner, merged).delayed_tasks.top().GetTargetTime();
 }
 
-const DelayedTask& MessageLoopTaskQueues::PeekNextTaskUnlocked(
-    TaskQueueId owner,
-    TaskQueueId& top_queue_id) const {
-  FML_DCHECK(HasPendingTasksUnlocked(owner));
-  const auto& entry = queue_entries_.at(owner);
-  const TaskQueueId subsumed = entry->owner_of;
-  if (subsumed == _kUnmerged) {
-    top_queue_id = owner;
-    return entry->delayed_tasks.top();
+TaskQueueEntry& MessageLoopTaskQueues::PeekNextTaskUnlocked(
+    TaskQueueEntry& owner,
+    TaskQueueEntry* merged) const {
+  FML_DCHECK(HasPendingTasksUnlocked(owner, merged));
+  if (owner.owner_of == _kUnmerged) {
+    return owner;
   }
 
-  const auto& owner_tasks = entry->delayed_tasks;
-  const auto& subsumed_tasks = queue_entries_.at(subsumed)->delayed_tasks;
+  const auto& owner_tasks = owner.delayed_tasks;
+  const auto& subsumed_tasks = merged->delayed_tasks;
 
   // we are owning another task queue
   const bool subsumed_has_task = !subsumed_tasks.empty();
@@ -305,16 +420,15 @@ const DelayedTask& MessageLoopTaskQueues::PeekNextTaskUnlocked(
     const auto owner_task = owner_tasks.top();
     const auto subsumed_task = subsumed_tasks.top();
     if (owner_task > subsumed_task) {
-      top_queue_id = subsumed;
+      return *merged;
     } else {
-      top_queue_id = owner;
+      return owner;
     }
   } else if (owner_has_task) {
-    top_queue_id = owner;
+    return owner;
   } else {
-    top_queue_id = subsumed;
+    return *merged;
   }
-  return queue_entries_.at(top_queue_id)->delayed_tasks.top();
 }
 
 }  // namespace fml
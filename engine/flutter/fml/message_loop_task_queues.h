@@ -5,8 +5,12 @@
 #ifndef FLUTTER_FML_MESSAGE_LOOP_TASK_QUEUES_H_
 #define FLUTTER_FML_MESSAGE_LOOP_TASK_QUEUES_H_
 
+#include <atomic>
+#include <climits>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 #include "flutter/fml/closure.h"
@@ -48,6 +52,14 @@ class TaskQueueEntry {
   TaskQueueId owner_of;
   TaskQueueId subsumed_by;
 
+  // The time |wakeable| was last asked to wake up at. Unset once the loop
+  // flushed its tasks, as its timer may have fired since.
+  std::optional<fml::TimePoint> wake_time;
+
+  // Guards all of the above. The merge state of two queues is only changed
+  // while holding the mutexes of both queues.
+  std::mutex mutex;
+
   TaskQueueEntry();
 
  private:
@@ -125,28 +137,50 @@ class MessageLoopTaskQueues
   bool Owns(TaskQueueId owner, TaskQueueId subsumed) const;
 
  private:
-  class MergedQueuesRunner;
+  using EntrySlot = std::atomic<TaskQueueEntry*>;
+
+  // Entries are stored in chunks of doubling sizes, chunk |k| holds 2^k
+  // entries. Chunks are never reallocated, so entries are looked up by
+  // queue id without taking a lock. Queue ids are never reused.
+  static constexpr size_t kEntryChunkCount = 48;
 
   MessageLoopTaskQueues();
 
   ~MessageLoopTaskQueues();
 
-  void WakeUpUnlocked(TaskQueueId queue_id, fml::TimePoint time) const;
+  // Returns null if the chunk of |queue_id| doesn't exist and |create| is
+  // false.
+  EntrySlot* GetEntrySlot(TaskQueueId queue_id, bool create) const;
+
+  TaskQueueEntry& GetEntry(TaskQueueId queue_id) const;
+
+  std::unique_ptr<TaskQueueEntry> RemoveEntry(TaskQueueId queue_id);
+
+  // Locks |entry| and the entry it is merged with, if any, which is returned.
+  TaskQueueEntry* LockQueues(TaskQueueEntry& entry,
+                             std::unique_lock<std::mutex>& lock,
+                             std::unique_lock<std::mutex>& merged_lock) const;
+
+  // The methods below expect the mutexes of |entry| and of the entry it is
+  // merged with, |merged|, to be held.
+
+  void WakeUpUnlocked(TaskQueueEntry& entry, fml::TimePoint time) const;
 
-  bool HasPendingTasksUnlocked(TaskQueueId queue_id) const;
+  bool HasPendingTasksUnlocked(const TaskQueueEntry& entry,
+                               const TaskQueueEntry* merged) const;
 
-  const DelayedTask& PeekNextTaskUnlocked(TaskQueueId queue_id,
-                                          TaskQueueId& top_queue_id) const;
+  TaskQueueEntry& PeekNextTaskUnlocked(TaskQueueEntry& owner,
+                                       TaskQueueEntry* merged) const;
 
-  fml::TimePoint GetNextWakeTimeUnlocked(TaskQueueId queue_id) const;
+  fml::TimePoint GetNextWakeTimeUnlocked(TaskQueueEntry& owner,
+                                         TaskQueueEntry* merged) const;
 
   static std::mutex creation_mutex_;
   static fml::RefPtr<MessageLoopTaskQueues> instance_
       FML_GUARDED_BY(creation_mutex_);
 
-  mutable std::mutex queue_mutex_;
-  std::map<TaskQueueId, std::unique_ptr<TaskQueueEntry>> queue_entries_;
-  size_t task_queue_id_counter_;
+  mutable std::atomic<EntrySlot*> entry_chunks_[kEntryChunkCount] = {};
+  std::atomic_size_t task_queue_id_counter_;
 
   std::atomic_int order_;
 
@@ -55,7 +55,56 @@ static void BM_RegisterAndGetTasks(benchmark::State& state) {
   }
 }
 
+// Every thread posts to and drains its own queue, like the platform, UI,
+// raster and IO threads do at the same time while a frame is produced.
+static void BM_RegisterAndDrainTasksConcurrently(benchmark::State& state) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  const int num_threads = state.range(0);
+  const int num_tasks_per_thread = 1000;
+  const int num_tasks_per_drain = 10;
+
+  std::vector<TaskQueueId> queue_ids;
+  for (int i = 0; i < num_threads; i++) {
+    queue_ids.push_back(task_queue->CreateTaskQueue());
+  }
+
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    CountDownLatch threads_started(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([queue_id = queue_ids[i], &task_queue,
+                            &threads_started]() {
+        threads_started.CountDown();
+        threads_started.Wait();
+        std::vector<fml::closure> invocations;
+        for (int j = 0; j < num_tasks_per_thread; j++) {
+          task_queue->RegisterTask(
+              queue_id, [] {}, fml::TimePoint::Now());
+          if (j % num_tasks_per_drain == num_tasks_per_drain - 1) {
+            task_queue->GetTasksToRunNow(queue_id, fml::FlushType::kAll,
+                                         invocations);
+            invocations.clear();
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads *
+                          num_tasks_per_thread);
+
+  for (auto queue_id : queue_ids) {
+    task_queue->Dispose(queue_id);
+  }
+}
+
 BENCHMARK(BM_RegisterAndGetTasks);
+BENCHMARK(BM_RegisterAndDrainTasksConcurrently)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
 
 }  // namespace benchmarking
 }  // namespace fml
@@ -4,7 +4,9 @@
 
 #define FML_USED_ON_EMBEDDER
 
+#include <atomic>
 #include <thread>
+#include <vector>
 
 #include "flutter/fml/message_loop_task_queues.h"
 #include "flutter/fml/synchronization/count_down_latch.h"
@@ -116,12 +118,74 @@ TEST(MessageLoopTaskQueue, WakeUpIndependentOfTime) {
       queue_id, new TestWakeable(
                     [&num_wakes](fml::TimePoint wake_time) { ++num_wakes; }));
 
+  task_queue->RegisterTask(
+      queue_id, []() {}, fml::TimePoint::Max());
+  task_queue->RegisterTask(
+      queue_id, []() {}, fml::TimePoint::Now());
+
+  ASSERT_TRUE(num_wakes == 2);
+}
+
+TEST(MessageLoopTaskQueue, NotWokenUpAgainForLaterTasks) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  auto queue_id = task_queue->CreateTaskQueue();
+
+  int num_wakes = 0;
+  task_queue->SetWakeable(
+      queue_id, new TestWakeable(
+                    [&num_wakes](fml::TimePoint wake_time) { ++num_wakes; }));
+
+  task_queue->RegisterTask(
+      queue_id, []() {}, fml::TimePoint::Now());
   task_queue->RegisterTask(
       queue_id, []() {}, fml::TimePoint::Now());
   task_queue->RegisterTask(
       queue_id, []() {}, fml::TimePoint::Max());
+  ASSERT_EQ(num_wakes, 1);
 
-  ASSERT_TRUE(num_wakes == 2);
+  // Flushing the queue may have been caused by the wake up, so the next one
+  // is not skipped even if it is at the same time.
+  std::vector<fml::closure> invocations;
+  task_queue->GetTasksToRunNow(queue_id, fml::FlushType::kSingle,
+                               invocations);
+  ASSERT_EQ(invocations.size(), 1u);
+  ASSERT_EQ(num_wakes, 2);
+}
+
+TEST(MessageLoopTaskQueue, ConcurrentRegisterAndRunOnManyQueues) {
+  auto task_queues = fml::MessageLoopTaskQueues::GetInstance();
+  const int num_queues = 8;
+  const int num_tasks_per_queue = 1000;
+  std::vector<fml::TaskQueueId> queue_ids;
+  for (int i = 0; i < num_queues; i++) {
+    queue_ids.push_back(task_queues->CreateTaskQueue());
+  }
+
+  std::atomic_int num_run = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_queues; i++) {
+    threads.emplace_back([&, queue_id = queue_ids[i]]() {
+      int run = 0;
+      for (int j = 0; j < num_tasks_per_queue; j++) {
+        task_queues->RegisterTask(
+            queue_id, [&num_run]() { num_run++; }, fml::TimePoint::Now());
+        if (j % 10 == 9) {
+          std::vector<fml::closure> invocations;
+          task_queues->GetTasksToRunNow(queue_id, fml::FlushType::kAll,
+                                        invocations);
+          for (auto& invocation : invocations) {
+            invocation();
+            run++;
+          }
+        }
+      }
+      ASSERT_EQ(run, num_tasks_per_queue);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(num_run, num_queues * num_tasks_per_queue);
 }
 
 TEST(MessageLoopTaskQueue, WokenUpWithNewerTime) {
@@ -4,8 +4,10 @@
 
 #define FML_USED_ON_EMBEDDER
 
+#include <atomic>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/message_loop.h"
@@ -308,3 +310,65 @@ TEST(MessageLoop, CanCreateConcurrentMessageLoop) {
   latch.Wait();
   ASSERT_GE(thread_ids.size(), 1u);
 }
+
+TEST(MessageLoop, ConcurrentMessageLoopRunsTasksPostedFromItsWorkers) {
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  auto task_runner = loop->GetTaskRunner();
+  const size_t kCount = 100;
+  fml::CountDownLatch latch(kCount * kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    task_runner->PostTask([&]() {
+      for (size_t j = 0; j < kCount; ++j) {
+        task_runner->PostTask([&]() { latch.CountDown(); },
+                              fml::ConcurrentTaskPriority::kLow);
+      }
+    });
+  }
+  latch.Wait();
+}
+
+TEST(MessageLoop, ConcurrentMessageLoopRunsPostedTasksInOrder) {
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto task_runner = loop->GetTaskRunner();
+  // The worker is held up while the tasks are posted.
+  fml::AutoResetWaitableEvent posted;
+  task_runner->PostTask([&posted]() { posted.Wait(); });
+  const size_t kCount = 10;
+  std::vector<size_t> order;
+  fml::CountDownLatch latch(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    task_runner->PostTask([&order, &latch, i]() {
+      order.push_back(i);
+      latch.CountDown();
+    });
+  }
+  posted.Signal();
+  latch.Wait();
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(order[i], i);
+  }
+}
+
+TEST(MessageLoop, ConcurrentTaskRunnerParallelForVisitsEveryIndexOnce) {
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  auto task_runner = loop->GetTaskRunner();
+  const size_t kCount = 1000;
+  std::vector<std::atomic_int> visits(kCount);
+  task_runner->ParallelFor(kCount, [&](size_t index) { visits[index]++; });
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(visits[i], 1);
+  }
+}
+
+TEST(MessageLoop, ConcurrentTaskRunnerParallelForCanBeCalledFromAWorker) {
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto task_runner = loop->GetTaskRunner();
+  std::atomic_size_t sum = 0;
+  fml::AutoResetWaitableEvent latch;
+  task_runner->PostTask([&]() {
+    task_runner->ParallelFor(10, [&](size_t index) { sum += index; });
+    latch.Signal();
+  });
+  latch.Wait();
+  ASSERT_EQ(sum, 45u);
+}
@@ -4,6 +4,7 @@
 
 #include "flutter/fml/file.h"
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -149,6 +150,28 @@ bool TruncateFile(const fml::UniqueFD& file, size_t size) {
   return ::ftruncate(file.get(), size) == 0;
 }
 
+bool WriteFileAt(const fml::UniqueFD& file,
+                 size_t offset,
+                 const Mapping& data) {
+  if (!file.is_valid()) {
+    return false;
+  }
+
+  const uint8_t* bytes = data.GetMapping();
+  size_t remaining = data.GetSize();
+  while (remaining > 0) {
+    const ssize_t written =
+        FML_HANDLE_EINTR(::pwrite(file.get(), bytes, remaining, offset));
+    if (written <= 0) {
+      return false;
+    }
+    bytes += written;
+    remaining -= written;
+    offset += written;
+  }
+  return true;
+}
+
 bool UnlinkDirectory(const char* path) {
   return UnlinkDirectory(fml::UniqueFD{AT_FDCWD}, path);
 }
@@ -173,6 +196,38 @@ bool FileExists(const fml::UniqueFD& base_directory, const char* path) {
   return ::faccessat(base_directory.get(), path, F_OK, 0) == 0;
 }
 
+bool VisitFiles(const fml::UniqueFD& directory, const FileVisitor& visitor) {
+  if (!directory.is_valid()) {
+    return false;
+  }
+
+  // The stream owns the descriptor it reads, so it gets a duplicate.
+  const int duplicate = FML_HANDLE_EINTR(::dup(directory.get()));
+  if (duplicate < 0) {
+    return false;
+  }
+  DIR* stream = ::fdopendir(duplicate);
+  if (stream == nullptr) {
+    ::close(duplicate);
+    return false;
+  }
+  // The duplicate shares the position of |directory|, which may have been
+  // read before.
+  ::rewinddir(stream);
+
+  while (dirent* entry = ::readdir(stream)) {
+    const std::string filename = entry->d_name;
+    if (filename == "." || filename == "..") {
+      continue;
+    }
+    if (!visitor(directory, filename)) {
+      break;
+    }
+  }
+  ::closedir(stream);
+  return true;
+}
+
 bool WriteAtomically(const fml::UniqueFD& base_directory,
                      const char* file_name,
                      const Mapping& data) {
@@ -323,10 +323,59 @@ bool TruncateFile(const fml::UniqueFD& file, size_t size) {
   return true;
 }
 
+bool WriteFileAt(const fml::UniqueFD& file,
+                 size_t offset,
+                 const Mapping& data) {
+  const uint8_t* bytes = data.GetMapping();
+  size_t remaining = data.GetSize();
+  while (remaining > 0) {
+    OVERLAPPED overlapped = {};
+    LARGE_INTEGER large_offset;
+    large_offset.QuadPart = offset;
+    overlapped.Offset = large_offset.LowPart;
+    overlapped.OffsetHigh = large_offset.HighPart;
+    DWORD written = 0;
+    const DWORD chunk_size =
+        static_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+    if (!::WriteFile(file.get(), bytes, chunk_size, &written, &overlapped) ||
+        written == 0) {
+      FML_DLOG(ERROR) << "Could not write to file. " << GetLastErrorMessage();
+      return false;
+    }
+    bytes += written;
+    remaining -= written;
+    offset += written;
+  }
+  return true;
+}
+
 bool FileExists(const fml::UniqueFD& base_directory, const char* path) {
   return IsFile(GetAbsolutePath(base_directory, path).c_str());
 }
 
+bool VisitFiles(const fml::UniqueFD& directory, const FileVisitor& visitor) {
+  const std::string pattern = GetAbsolutePath(directory, "*");
+  WIN32_FIND_DATA find_data;
+  HANDLE find_handle =
+      ::FindFirstFile(StringToWideString(pattern).c_str(), &find_data);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    FML_DLOG(ERROR) << "Could not list directory. " << GetLastErrorMessage();
+    return false;
+  }
+
+  do {
+    const std::string filename = WideStringToString(find_data.cFileName);
+    if (filename == "." || filename == "..") {
+      continue;
+    }
+    if (!visitor(directory, filename)) {
+      break;
+    }
+  } while (::FindNextFile(find_handle, &find_data));
+  ::FindClose(find_handle);
+  return true;
+}
+
 bool WriteAtomically(const fml::UniqueFD& base_directory,
                      const char* file_name,
                      const Mapping& mapping) {
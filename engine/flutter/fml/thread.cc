@@ -20,6 +20,7 @@
 
 #include "flutter/fml/message_loop.h"
 #include "flutter/fml/synchronization/waitable_event.h"
+#include "flutter/fml/trace_buffer.h"
 
 namespace fml {
 
@@ -71,6 +72,7 @@ void Thread::SetCurrentThreadName(const std::string& name) {
   if (name == "") {
     return;
   }
+  tracing::TraceBuffer::SetCurrentThreadName(name);
 #if OS_MACOSX
   pthread_setname_np(name.c_str());
 #elif OS_LINUX || OS_ANDROID || WINDOWS_PLATFORM
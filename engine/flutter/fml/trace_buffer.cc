@@ -0,0 +1,372 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/trace_buffer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/thread_local.h"
+
+namespace fml {
+namespace tracing {
+
+namespace {
+
+// All the events are attributed to one process, the pid is not needed to tell
+// the threads apart.
+constexpr int kProcessId = 1;
+
+void WriteJsonString(std::ostream& stream, const char* string) {
+  stream << '"';
+  for (const char* c = string ? string : ""; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        stream << "\\\"";
+        break;
+      case '\\':
+        stream << "\\\\";
+        break;
+      case '\n':
+        stream << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x",
+                   static_cast<unsigned char>(*c));
+          stream << escaped;
+        } else {
+          stream << *c;
+        }
+        break;
+    }
+  }
+  stream << '"';
+}
+
+void WriteEvent(std::ostream& stream,
+                int64_t thread_id,
+                const TraceRecord& record) {
+  char timestamp[32];
+  // Microseconds with a nanosecond precision.
+  snprintf(timestamp, sizeof(timestamp), "%" PRId64 ".%03" PRId64,
+           record.timestamp / 1000, record.timestamp % 1000);
+  stream << "{\"ph\":\"" << record.phase << "\",\"name\":";
+  WriteJsonString(stream, record.name);
+  if (record.category) {
+    stream << ",\"cat\":";
+    WriteJsonString(stream, record.category);
+  }
+  stream << ",\"ts\":" << timestamp << ",\"pid\":" << kProcessId
+         << ",\"tid\":" << thread_id;
+  switch (record.phase) {
+    case 'b':
+    case 'e':
+    case 's':
+    case 't':
+    case 'f':
+      stream << ",\"id\":" << record.id;
+      break;
+    case 'i':
+      stream << ",\"s\":\"t\"";
+      break;
+    case 'C':
+      stream << ",\"args\":{";
+      WriteJsonString(stream, record.arg_name);
+      stream << ':' << record.arg_value << '}';
+      break;
+  }
+  stream << '}';
+}
+
+}  // namespace
+
+// A ring of records written by a single thread and read by any thread.
+//
+// The writer announces each record in |start_count_| before writing it, and
+// publishes it in |write_count_|. A reader copies the records below the
+// published count, then drops the ones the writer may have overwritten
+// meanwhile according to the announced count.
+class TraceThreadBuffer {
+ public:
+  TraceThreadBuffer(int64_t thread_id, std::string thread_name)
+      : thread_id_(thread_id),
+        thread_name_(std::move(thread_name)),
+        records_(new TraceRecord[TraceBuffer::kRecordsPerThread]) {}
+
+  int64_t thread_id() const { return thread_id_; }
+
+  // Guarded by the mutex of the trace buffer.
+  std::string& thread_name() { return thread_name_; }
+
+  void Add(const TraceRecord& record) {
+    uint64_t count = write_count_.load(std::memory_order_relaxed);
+    start_count_.store(count + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    records_[count % TraceBuffer::kRecordsPerThread] = record;
+    write_count_.store(count + 1, std::memory_order_release);
+  }
+
+  std::vector<TraceRecord> Copy() const {
+    uint64_t end = write_count_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(GetOldestIndex(end),
+                              clear_count_.load(std::memory_order_relaxed));
+    std::vector<TraceRecord> records;
+    records.reserve(end - std::min(begin, end));
+    for (uint64_t i = begin; i < end; i++) {
+      records.push_back(records_[i % TraceBuffer::kRecordsPerThread]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t overwritten =
+        GetOldestIndex(start_count_.load(std::memory_order_relaxed));
+    if (overwritten > begin) {
+      size_t dropped = std::min<uint64_t>(overwritten - begin, records.size());
+      records.erase(records.begin(), records.begin() + dropped);
+    }
+    return records;
+  }
+
+  void Clear() {
+    clear_count_.store(write_count_.load(std::memory_order_acquire),
+                       std::memory_order_relaxed);
+  }
+
+  // Whether no records were written since the last |Clear|. Called once the
+  // writer is gone.
+  bool IsEmpty() const {
+    return write_count_.load(std::memory_order_acquire) ==
+           clear_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const int64_t thread_id_;
+  std::string thread_name_;
+  std::unique_ptr<TraceRecord[]> records_;
+  std::atomic<uint64_t> start_count_{0};
+  std::atomic<uint64_t> write_count_{0};
+  // The records below this count were cleared.
+  std::atomic<uint64_t> clear_count_{0};
+
+  // Returns the index of the oldest record still in the ring after |count|
+  // records were written.
+  static uint64_t GetOldestIndex(uint64_t count) {
+    constexpr uint64_t kCapacity = TraceBuffer::kRecordsPerThread;
+    return count > kCapacity ? count - kCapacity : 0;
+  }
+
+  FML_DISALLOW_COPY_AND_ASSIGN(TraceThreadBuffer);
+};
+
+// What is known about the current thread. The buffer is shared with the trace
+// buffer so that the events of threads that exited are kept.
+struct ThreadState {
+  std::string name;
+  std::shared_ptr<TraceThreadBuffer> buffer;
+
+  ~ThreadState() {
+    if (buffer) {
+      TraceBuffer::GetInstance().OnThreadExit(buffer.get());
+    }
+  }
+};
+
+namespace {
+
+FML_THREAD_LOCAL ThreadLocalUniquePtr<ThreadState> tls_thread_state;
+
+ThreadState& GetThreadState() {
+  if (!tls_thread_state.get()) {
+    tls_thread_state.reset(new ThreadState());
+  }
+  return *tls_thread_state.get();
+}
+
+}  // namespace
+
+std::atomic_bool TraceBuffer::enabled_{false};
+
+TraceSnapshot::TraceSnapshot(std::vector<ThreadTrace> threads)
+    : threads_(std::move(threads)) {}
+
+void TraceSnapshot::WriteChromeTrace(std::ostream& stream) const {
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  for (const ThreadTrace& thread : threads_) {
+    if (!thread.thread_name.empty()) {
+      stream << (first ? "" : ",")
+             << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << kProcessId
+             << ",\"tid\":" << thread.thread_id << ",\"args\":{\"name\":";
+      WriteJsonString(stream, thread.thread_name.c_str());
+      stream << "}}";
+      first = false;
+    }
+    for (const TraceRecord& record : thread.records) {
+      stream << (first ? "" : ",");
+      WriteEvent(stream, thread.thread_id, record);
+      first = false;
+    }
+  }
+  stream << "],\"displayTimeUnit\":\"ms\"}";
+}
+
+bool TraceSnapshot::WriteChromeTraceToFile(const std::string& path) const {
+  std::ofstream stream(path, std::ios::out | std::ios::trunc);
+  if (!stream) {
+    FML_LOG(ERROR) << "Could not open the trace file " << path;
+    return false;
+  }
+  WriteChromeTrace(stream);
+  stream.close();
+  return !stream.fail();
+}
+
+TraceBuffer& TraceBuffer::GetInstance() {
+  static TraceBuffer* instance = new TraceBuffer();
+  return *instance;
+}
+
+TraceBuffer::TraceBuffer() = default;
+
+TraceBuffer::~TraceBuffer() = default;
+
+void TraceBuffer::SetEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_.store(enabled, std::memory_order_relaxed);
+  if (enabled_callback_) {
+    enabled_callback_(enabled);
+  }
+}
+
+void TraceBuffer::SetEnabledCallback(EnabledCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_callback_ = std::move(callback);
+  if (enabled_callback_) {
+    enabled_callback_(IsEnabled());
+  }
+}
+
+void TraceBuffer::Record(char phase,
+                         const char* category,
+                         const char* name,
+                         int64_t id) {
+  RecordAt(TimePoint::Now(), phase, category, name, id);
+}
+
+void TraceBuffer::RecordAt(TimePoint time,
+                           char phase,
+                           const char* category,
+                           const char* name,
+                           int64_t id) {
+  AddRecord({time.ToEpochDelta().ToNanoseconds(), category, name, id, nullptr,
+             0, phase});
+}
+
+void TraceBuffer::RecordCounter(const char* category,
+                                const char* name,
+                                const char* arg_name,
+                                double arg_value) {
+  AddRecord({TimePoint::Now().ToEpochDelta().ToNanoseconds(), category, name,
+             0, arg_name, arg_value, 'C'});
+}
+
+void TraceBuffer::AddRecord(const TraceRecord& record) {
+  GetCurrentThreadBuffer()->Add(record);
+}
+
+TraceThreadBuffer* TraceBuffer::GetCurrentThreadBuffer() {
+  ThreadState& state = GetThreadState();
+  if (!state.buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto buffer =
+        std::make_shared<TraceThreadBuffer>(next_thread_id_++, state.name);
+    thread_buffers_.push_back(buffer);
+    state.buffer = std::move(buffer);
+  }
+  return state.buffer.get();
+}
+
+void TraceBuffer::OnThreadExit(TraceThreadBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!buffer->IsEmpty()) {
+    exited_thread_buffers_.push_back(buffer);
+    if (exited_thread_buffers_.size() <= kMaxExitedThreadBuffers) {
+      return;
+    }
+    buffer = exited_thread_buffers_.front();
+    exited_thread_buffers_.pop_front();
+  }
+  thread_buffers_.erase(
+      std::find_if(thread_buffers_.begin(), thread_buffers_.end(),
+                   [buffer](const std::shared_ptr<TraceThreadBuffer>& item) {
+                     return item.get() == buffer;
+                   }));
+}
+
+size_t TraceBuffer::GetThreadCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return thread_buffers_.size();
+}
+
+void TraceBuffer::SetCurrentThreadName(const std::string& name) {
+  ThreadState& state = GetThreadState();
+  state.name = name;
+  if (state.buffer) {
+    TraceBuffer& instance = GetInstance();
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+    state.buffer->thread_name() = name;
+  }
+}
+
+std::unique_ptr<TraceSnapshot> TraceBuffer::TakeSnapshot() const {
+  std::vector<ThreadTrace> threads;
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads.reserve(thread_buffers_.size());
+  for (const auto& buffer : thread_buffers_) {
+    threads.push_back(
+        {buffer->thread_id(), buffer->thread_name(), buffer->Copy()});
+  }
+  return std::make_unique<TraceSnapshot>(std::move(threads));
+}
+
+void TraceBuffer::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& buffer : thread_buffers_) {
+    buffer->Clear();
+  }
+}
+
+void TraceBuffer::SetJankTracePath(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  jank_trace_path_ = path;
+}
+
+std::string TraceBuffer::GetJankTracePath() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jank_trace_path_;
+}
+
+std::unique_ptr<TraceSnapshot> TraceBuffer::TakeJankSnapshot() {
+  if (!IsEnabled()) {
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TimePoint now = TimePoint::Now();
+    if (jank_trace_path_.empty() ||
+        (last_jank_snapshot_time_ != TimePoint() &&
+         now - last_jank_snapshot_time_ <
+             TimeDelta::FromSeconds(kMinJankSnapshotIntervalSeconds))) {
+      return nullptr;
+    }
+    last_jank_snapshot_time_ = now;
+  }
+  return TakeSnapshot();
+}
+
+}  // namespace tracing
+}  // namespace fml
@@ -0,0 +1,182 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FML_TRACE_BUFFER_H_
+#define FLUTTER_FML_TRACE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "flutter/fml/time/time_point.h"
+
+namespace fml {
+namespace tracing {
+
+// A trace event as stored by |TraceBuffer|. The strings are not copied, they
+// must outlive the buffer like the string literals passed to the trace
+// macros.
+struct TraceRecord {
+  // Nanoseconds on the clock of |fml::TimePoint|.
+  int64_t timestamp;
+  const char* category;
+  const char* name;
+  // The id of async events and flows.
+  int64_t id;
+  // The value of counters.
+  const char* arg_name;
+  double arg_value;
+  // The phase of the event in the Chrome trace event format, e.g. 'B' for the
+  // beginning of a duration.
+  char phase;
+};
+
+// The events of a thread copied out of a |TraceBuffer|.
+struct ThreadTrace {
+  int64_t thread_id;
+  std::string thread_name;
+  std::vector<TraceRecord> records;
+};
+
+// The events of all the threads copied out of a |TraceBuffer|.
+class TraceSnapshot {
+ public:
+  explicit TraceSnapshot(std::vector<ThreadTrace> threads);
+
+  const std::vector<ThreadTrace>& threads() const { return threads_; }
+
+  // Writes the events in the JSON trace event format, which is read by
+  // chrome://tracing and Perfetto.
+  void WriteChromeTrace(std::ostream& stream) const;
+
+  bool WriteChromeTraceToFile(const std::string& path) const;
+
+ private:
+  std::vector<ThreadTrace> threads_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(TraceSnapshot);
+};
+
+class TraceThreadBuffer;
+
+// A backend of the trace macros of "flutter/fml/trace_event.h" that is cheap
+// enough to leave on in production. While enabled, every event is written as a
+// fixed size |TraceRecord| into a ring buffer owned by the thread that traced
+// it, so recording takes no lock and only keeps the most recent events of
+// each thread. The buffers can be dumped at any time, e.g. after a janky
+// frame.
+//
+// The ring of a thread is kept after the thread exits, but only for the
+// |kMaxExitedThreadBuffers| threads that exited last.
+//
+// Event arguments other than the values of counters are not recorded.
+class TraceBuffer {
+ public:
+  // The number of events kept per thread.
+  static constexpr size_t kRecordsPerThread = 8192;
+
+  // The number of exited threads whose events are kept.
+  static constexpr size_t kMaxExitedThreadBuffers = 4;
+
+  // The minimum time between two snapshots taken by |TakeJankSnapshot|.
+  static constexpr int64_t kMinJankSnapshotIntervalSeconds = 10;
+
+  static TraceBuffer& GetInstance();
+
+  // Whether events are being recorded. Checked by the trace macros before
+  // every event.
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Starts or stops recording events. The events recorded so far are kept.
+  void SetEnabled(bool enabled);
+
+  // Sets a callback invoked with the new state whenever recording is started
+  // or stopped, and right away with the current state. This lets tracers that
+  // cache whether they are enabled, like Skia's, follow the trace buffer. The
+  // callback must not call into the trace buffer.
+  using EnabledCallback = std::function<void(bool enabled)>;
+  void SetEnabledCallback(EnabledCallback callback);
+
+  // Records an event of the current thread, timestamped now.
+  void Record(char phase,
+              const char* category,
+              const char* name,
+              int64_t id = 0);
+
+  void RecordAt(TimePoint time,
+                char phase,
+                const char* category,
+                const char* name,
+                int64_t id = 0);
+
+  void RecordCounter(const char* category,
+                     const char* name,
+                     const char* arg_name,
+                     double arg_value);
+
+  // Names the current thread in the snapshots. Called by |fml::Thread|.
+  static void SetCurrentThreadName(const std::string& name);
+
+  // Returns the number of threads whose events are kept.
+  size_t GetThreadCount() const;
+
+  // Copies the events of all the threads that recorded events. Events
+  // overwritten while they are being copied are left out.
+  std::unique_ptr<TraceSnapshot> TakeSnapshot() const;
+
+  // Forgets the events recorded so far.
+  void Clear();
+
+  // Sets where the trace of janky frames should be written. An empty path
+  // disables jank snapshots.
+  void SetJankTracePath(const std::string& path);
+
+  std::string GetJankTracePath() const;
+
+  // Returns a snapshot to be written to the jank trace path, away from the
+  // thread that janked, or null if recording is disabled, no jank trace path
+  // is set or a jank snapshot was taken recently.
+  std::unique_ptr<TraceSnapshot> TakeJankSnapshot();
+
+ private:
+  static std::atomic_bool enabled_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<TraceThreadBuffer>> thread_buffers_;
+  // The buffers of |thread_buffers_| whose thread exited, oldest first.
+  std::deque<TraceThreadBuffer*> exited_thread_buffers_;
+  EnabledCallback enabled_callback_;
+  int64_t next_thread_id_ = 1;
+  std::string jank_trace_path_;
+  TimePoint last_jank_snapshot_time_;
+
+  TraceBuffer();
+
+  ~TraceBuffer();
+
+  friend struct ThreadState;
+
+  // Returns the buffer of the current thread, creating it on first use.
+  TraceThreadBuffer* GetCurrentThreadBuffer();
+
+  // Called when the thread that owns |buffer| exits. Releases the buffer if it
+  // holds no events, or if too many exited threads are kept.
+  void OnThreadExit(TraceThreadBuffer* buffer);
+
+  void AddRecord(const TraceRecord& record);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(TraceBuffer);
+};
+
+}  // namespace tracing
+}  // namespace fml
+
+#endif  // FLUTTER_FML_TRACE_BUFFER_H_
@@ -0,0 +1,256 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/trace_buffer.h"
+
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include "flutter/fml/synchronization/waitable_event.h"
+#include "flutter/fml/thread.h"
+#include "flutter/fml/trace_event.h"
+#include "gtest/gtest.h"
+
+namespace fml {
+namespace tracing {
+namespace {
+
+// Enables the trace buffer for the duration of a test, starting empty.
+class ScopedTraceBuffer {
+ public:
+  ScopedTraceBuffer() {
+    TraceBuffer::GetInstance().Clear();
+    TraceBuffer::GetInstance().SetEnabled(true);
+  }
+
+  ~ScopedTraceBuffer() {
+    TraceBuffer::GetInstance().SetEnabled(false);
+    TraceBuffer::GetInstance().SetJankTracePath("");
+    TraceBuffer::GetInstance().Clear();
+  }
+};
+
+// Returns the events named |name| in |snapshot|, in the order they were
+// recorded by their thread.
+std::vector<TraceRecord> FindRecords(const TraceSnapshot& snapshot,
+                                     const char* name) {
+  std::vector<TraceRecord> found;
+  for (const ThreadTrace& thread : snapshot.threads()) {
+    for (const TraceRecord& record : thread.records) {
+      if (strcmp(record.name, name) == 0) {
+        found.push_back(record);
+      }
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
+TEST(TraceBuffer, RecordsTraceMacrosOnlyWhileEnabled) {
+  { TRACE_EVENT0("flutter", "TraceBufferDisabledEvent"); }
+  ScopedTraceBuffer scoped_trace_buffer;
+  { TRACE_EVENT0("flutter", "TraceBufferEvent"); }
+  TRACE_EVENT_ASYNC_BEGIN0("flutter", "TraceBufferAsyncEvent", 42);
+
+  auto snapshot = TraceBuffer::GetInstance().TakeSnapshot();
+  ASSERT_TRUE(FindRecords(*snapshot, "TraceBufferDisabledEvent").empty());
+
+  auto records = FindRecords(*snapshot, "TraceBufferEvent");
+  ASSERT_EQ(records.size(), 2u);
+  ASSERT_EQ(records[0].phase, 'B');
+  ASSERT_STREQ(records[0].category, "flutter");
+  ASSERT_EQ(records[1].phase, 'E');
+  ASSERT_LE(records[0].timestamp, records[1].timestamp);
+
+  records = FindRecords(*snapshot, "TraceBufferAsyncEvent");
+  ASSERT_EQ(records.size(), 1u);
+  ASSERT_EQ(records[0].phase, 'b');
+  ASSERT_EQ(records[0].id, 42);
+}
+
+TEST(TraceBuffer, RecordsCounterValues) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  FML_TRACE_COUNTER("flutter", "TraceBufferCounter", 0, "Hits", 3, "Rate",
+                    0.5);
+
+  auto records = FindRecords(*TraceBuffer::GetInstance().TakeSnapshot(),
+                             "TraceBufferCounter");
+  ASSERT_EQ(records.size(), 2u);
+  ASSERT_EQ(records[0].phase, 'C');
+  ASSERT_STREQ(records[0].arg_name, "Hits");
+  ASSERT_EQ(records[0].arg_value, 3);
+  ASSERT_STREQ(records[1].arg_name, "Rate");
+  ASSERT_EQ(records[1].arg_value, 0.5);
+}
+
+TEST(TraceBuffer, KeepsTheMostRecentEventsOfEachThread) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  TraceBuffer& buffer = TraceBuffer::GetInstance();
+  for (size_t i = 0; i < TraceBuffer::kRecordsPerThread; i++) {
+    buffer.Record('i', "flutter", "TraceBufferOldEvent");
+  }
+  for (size_t i = 0; i < TraceBuffer::kRecordsPerThread / 2; i++) {
+    buffer.Record('i', "flutter", "TraceBufferNewEvent");
+  }
+
+  auto snapshot = buffer.TakeSnapshot();
+  ASSERT_EQ(FindRecords(*snapshot, "TraceBufferOldEvent").size(),
+            TraceBuffer::kRecordsPerThread / 2);
+  ASSERT_EQ(FindRecords(*snapshot, "TraceBufferNewEvent").size(),
+            TraceBuffer::kRecordsPerThread / 2);
+}
+
+TEST(TraceBuffer, ClearForgetsRecordedEvents) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  TraceBuffer& buffer = TraceBuffer::GetInstance();
+  buffer.Record('i', "flutter", "TraceBufferClearedEvent");
+  buffer.Clear();
+  buffer.Record('i', "flutter", "TraceBufferKeptEvent");
+
+  auto snapshot = buffer.TakeSnapshot();
+  ASSERT_TRUE(FindRecords(*snapshot, "TraceBufferClearedEvent").empty());
+  ASSERT_EQ(FindRecords(*snapshot, "TraceBufferKeptEvent").size(), 1u);
+}
+
+TEST(TraceBuffer, KeepsEventsOfThreadsThatExited) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  {
+    fml::Thread thread("trace_buffer_thread");
+    fml::AutoResetWaitableEvent latch;
+    thread.GetTaskRunner()->PostTask([&latch]() {
+      TRACE_EVENT_INSTANT0("flutter", "TraceBufferThreadEvent");
+      latch.Signal();
+    });
+    latch.Wait();
+  }
+
+  auto snapshot = TraceBuffer::GetInstance().TakeSnapshot();
+  int64_t thread_id = 0;
+  for (const ThreadTrace& thread : snapshot->threads()) {
+    for (const TraceRecord& record : thread.records) {
+      if (strcmp(record.name, "TraceBufferThreadEvent") == 0) {
+        ASSERT_EQ(thread.thread_name, "trace_buffer_thread");
+        thread_id = thread.thread_id;
+      }
+    }
+  }
+  ASSERT_NE(thread_id, 0);
+}
+
+TEST(TraceBuffer, ReleasesTheEventsOfTheThreadsThatExitedFirst) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  // Names that outlive the buffer, one per thread.
+  static const char* kNames[] = {
+      "TraceBufferExitedThread0", "TraceBufferExitedThread1",
+      "TraceBufferExitedThread2", "TraceBufferExitedThread3",
+      "TraceBufferExitedThread4", "TraceBufferExitedThread5",
+  };
+  static_assert(std::size(kNames) > TraceBuffer::kMaxExitedThreadBuffers,
+                "Not enough threads exit to release one.");
+  for (const char* name : kNames) {
+    std::thread([name]() {
+      TraceBuffer::GetInstance().Record('i', "flutter", name);
+    }).join();
+  }
+
+  auto snapshot = TraceBuffer::GetInstance().TakeSnapshot();
+  size_t kept_count = std::size(kNames) - TraceBuffer::kMaxExitedThreadBuffers;
+  for (size_t i = 0; i < std::size(kNames); i++) {
+    ASSERT_EQ(FindRecords(*snapshot, kNames[i]).size(),
+              i < kept_count ? 0u : 1u);
+  }
+
+  // Threads that exit without recording anything are released right away.
+  size_t thread_count = TraceBuffer::GetInstance().GetThreadCount();
+  std::thread([]() {
+    TraceBuffer::GetInstance().Record('i', "flutter", "TraceBufferEmptyThread");
+    TraceBuffer::GetInstance().Clear();
+  }).join();
+  ASSERT_EQ(TraceBuffer::GetInstance().GetThreadCount(), thread_count);
+}
+
+TEST(TraceBuffer, SnapshotsRacingTheWriterOnlyHoldWholeEvents) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  std::atomic_bool done = false;
+  std::atomic<int64_t> written = 0;
+  // Each event is stamped with its id so that a torn copy shows.
+  std::thread writer([&done, &written]() {
+    TraceBuffer& buffer = TraceBuffer::GetInstance();
+    for (int64_t id = 0; !done.load(std::memory_order_relaxed); id++) {
+      buffer.RecordAt(TimePoint::FromEpochDelta(TimeDelta::FromNanoseconds(id)),
+                      'i', "flutter", "TraceBufferRacingEvent", id);
+      written.store(id + 1, std::memory_order_relaxed);
+    }
+  });
+
+  // Snapshots race the writer once it overwrites its oldest events.
+  while (written.load(std::memory_order_relaxed) <
+         static_cast<int64_t>(TraceBuffer::kRecordsPerThread)) {
+    std::this_thread::yield();
+  }
+  size_t copied_count = 0;
+  bool consistent = true;
+  for (size_t i = 0; i < 200 && consistent; i++) {
+    auto records = FindRecords(*TraceBuffer::GetInstance().TakeSnapshot(),
+                               "TraceBufferRacingEvent");
+    // The last event may be published before it is counted.
+    int64_t written_count = written.load(std::memory_order_relaxed);
+    copied_count += records.size();
+    consistent = records.size() <= TraceBuffer::kRecordsPerThread;
+    // The events kept follow each other, none of them overwritten while they
+    // were copied.
+    for (size_t j = 0; j < records.size() && consistent; j++) {
+      consistent = records[j].timestamp == records[j].id &&
+                   records[j].phase == 'i' &&
+                   records[j].id <= written_count &&
+                   (j == 0 || records[j].id == records[j - 1].id + 1);
+    }
+  }
+
+  done = true;
+  writer.join();
+  ASSERT_TRUE(consistent);
+  ASSERT_GT(copied_count, 0u);
+}
+
+TEST(TraceBuffer, CallsTheEnabledCallbackOnChanges) {
+  std::vector<bool> states;
+  TraceBuffer::GetInstance().SetEnabledCallback(
+      [&states](bool enabled) { states.push_back(enabled); });
+  { ScopedTraceBuffer scoped_trace_buffer; }
+  TraceBuffer::GetInstance().SetEnabledCallback(nullptr);
+  ASSERT_EQ(states, std::vector<bool>({false, true, false}));
+}
+
+TEST(TraceBuffer, WritesChromeTraceEvents) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  TraceBuffer::GetInstance().RecordAt(
+      TimePoint::FromEpochDelta(TimeDelta::FromNanoseconds(1234567)), 'i',
+      "flutter", "TraceBuffer\"Quoted\"Event");
+
+  std::stringstream stream;
+  TraceBuffer::GetInstance().TakeSnapshot()->WriteChromeTrace(stream);
+  std::string trace = stream.str();
+  ASSERT_EQ(trace.find("{\"traceEvents\":["), 0u);
+  ASSERT_NE(trace.find("{\"ph\":\"i\",\"name\":\"TraceBuffer\\\"Quoted\\\""
+                       "Event\",\"cat\":\"flutter\",\"ts\":1234.567"),
+            std::string::npos);
+}
+
+TEST(TraceBuffer, JankSnapshotsAreRateLimited) {
+  ScopedTraceBuffer scoped_trace_buffer;
+  TraceBuffer& buffer = TraceBuffer::GetInstance();
+  ASSERT_EQ(buffer.TakeJankSnapshot(), nullptr);
+
+  buffer.SetJankTracePath("jank_trace.json");
+  ASSERT_NE(buffer.TakeJankSnapshot(), nullptr);
+  ASSERT_EQ(buffer.TakeJankSnapshot(), nullptr);
+}
+
+}  // namespace tracing
+}  // namespace fml
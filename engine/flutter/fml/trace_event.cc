@@ -6,14 +6,29 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstdlib>
 #include <utility>
 
 #include "flutter/fml/build_config.h"
 #include "flutter/fml/logging.h"
+#include "flutter/fml/trace_buffer.h"
 
 namespace fml {
 namespace tracing {
 
+namespace {
+
+void RecordToTraceBuffer(char phase,
+                         TraceArg category_group,
+                         TraceArg name,
+                         TraceIDArg id = 0) {
+  if (TraceBuffer::IsEnabled()) {
+    TraceBuffer::GetInstance().Record(phase, category_group, name, id);
+  }
+}
+
+}  // namespace
+
 size_t TraceNonce() {
   static std::atomic_size_t gLastItem;
   return ++gLastItem;
@@ -45,6 +60,19 @@ void TraceTimelineEvent(TraceArg category_group,
                         const std::vector<std::string>& values) {
   const auto argument_count = std::min(c_names.size(), values.size());
 
+  if (TraceBuffer::IsEnabled()) {
+    TraceBuffer& buffer = TraceBuffer::GetInstance();
+    if (type == Event_Begin) {
+      buffer.Record('B', category_group, name, identifier);
+    } else {
+      // Only counters are traced with any other type.
+      for (size_t i = 0; i < argument_count; i++) {
+        buffer.RecordCounter(category_group, name, c_names[i],
+                             std::strtod(values[i].c_str(), nullptr));
+      }
+    }
+  }
+
   std::vector<const char*> c_values;
   c_values.resize(argument_count, nullptr);
 
@@ -63,6 +91,7 @@ void TraceTimelineEvent(TraceArg category_group,
 }
 
 void TraceEvent0(TraceArg category_group, TraceArg name) {
+  RecordToTraceBuffer('B', category_group, name);
   TimelineEvent(name,         // label
                 0,            // timestamp0
                 0,            // timestamp1_or_async_id
@@ -77,6 +106,7 @@ void TraceEvent1(TraceArg category_group,
                  TraceArg name,
                  TraceArg arg1_name,
                  TraceArg arg1_val) {
+  RecordToTraceBuffer('B', category_group, name);
   const char* arg_names[] = {arg1_name};
   const char* arg_values[] = {arg1_val};
   TimelineEvent(name,         // label
@@ -95,6 +125,7 @@ void TraceEvent2(TraceArg category_group,
                  TraceArg arg1_val,
                  TraceArg arg2_name,
                  TraceArg arg2_val) {
+  RecordToTraceBuffer('B', category_group, name);
   const char* arg_names[] = {arg1_name, arg2_name};
   const char* arg_values[] = {arg1_val, arg2_val};
   TimelineEvent(name,         // label
@@ -108,6 +139,7 @@ void TraceEvent2(TraceArg category_group,
 }
 
 void TraceEventEnd(TraceArg name) {
+  RecordToTraceBuffer('E', nullptr, name);
   TimelineEvent(name,       // label
                 0,          // timestamp0
                 0,          // timestamp1_or_async_id
@@ -128,6 +160,12 @@ void TraceEventAsyncComplete(TraceArg category_group,
     std::swap(begin, end);
   }
 
+  if (TraceBuffer::IsEnabled()) {
+    TraceBuffer& buffer = TraceBuffer::GetInstance();
+    buffer.RecordAt(begin, 'b', category_group, name, identifier);
+    buffer.RecordAt(end, 'e', category_group, name, identifier);
+  }
+
   TimelineEvent(name,                                   // label
                 begin.ToEpochDelta().ToMicroseconds(),  // timestamp0
                 identifier,    // timestamp1_or_async_id
@@ -149,6 +187,7 @@ void TraceEventAsyncComplete(TraceArg category_group,
 void TraceEventAsyncBegin0(TraceArg category_group,
                            TraceArg name,
                            TraceIDArg id) {
+  RecordToTraceBuffer('b', category_group, name, id);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 id,            // timestamp1_or_async_id
@@ -162,6 +201,7 @@ void TraceEventAsyncBegin0(TraceArg category_group,
 void TraceEventAsyncEnd0(TraceArg category_group,
                          TraceArg name,
                          TraceIDArg id) {
+  RecordToTraceBuffer('e', category_group, name, id);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 id,            // timestamp1_or_async_id
@@ -177,6 +217,7 @@ void TraceEventAsyncBegin1(TraceArg category_group,
                            TraceIDArg id,
                            TraceArg arg1_name,
                            TraceArg arg1_val) {
+  RecordToTraceBuffer('b', category_group, name, id);
   const char* arg_names[] = {arg1_name};
   const char* arg_values[] = {arg1_val};
   TimelineEvent(name,          // label
@@ -194,6 +235,7 @@ void TraceEventAsyncEnd1(TraceArg category_group,
                          TraceIDArg id,
                          TraceArg arg1_name,
                          TraceArg arg1_val) {
+  RecordToTraceBuffer('e', category_group, name, id);
   const char* arg_names[] = {arg1_name};
   const char* arg_values[] = {arg1_val};
   TimelineEvent(name,          // label
@@ -207,6 +249,7 @@ void TraceEventAsyncEnd1(TraceArg category_group,
 }
 
 void TraceEventInstant0(TraceArg category_group, TraceArg name) {
+  RecordToTraceBuffer('i', category_group, name);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 0,             // timestamp1_or_async_id
@@ -220,6 +263,7 @@ void TraceEventInstant0(TraceArg category_group, TraceArg name) {
 void TraceEventFlowBegin0(TraceArg category_group,
                           TraceArg name,
                           TraceIDArg id) {
+  RecordToTraceBuffer('s', category_group, name, id);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 id,            // timestamp1_or_async_id
@@ -233,6 +277,7 @@ void TraceEventFlowBegin0(TraceArg category_group,
 void TraceEventFlowStep0(TraceArg category_group,
                          TraceArg name,
                          TraceIDArg id) {
+  RecordToTraceBuffer('t', category_group, name, id);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 id,            // timestamp1_or_async_id
@@ -244,6 +289,7 @@ void TraceEventFlowStep0(TraceArg category_group,
 }
 
 void TraceEventFlowEnd0(TraceArg category_group, TraceArg name, TraceIDArg id) {
+  RecordToTraceBuffer('f', category_group, name, id);
   TimelineEvent(name,          // label
                 0,             // timestamp0
                 id,            // timestamp1_or_async_id
@@ -11,8 +11,10 @@
 #include "flutter/fml/make_copyable.h"
 #include "flutter/fml/trace_event.h"
 #include "flutter/lib/ui/painting/frame_info.h"
+#include "flutter/lib/ui/painting/image_decoder.h"
 #include "flutter/lib/ui/painting/multi_frame_codec.h"
 #include "flutter/lib/ui/painting/single_frame_codec.h"
+#include "flutter/lib/ui/ui_dart_state.h"
 #include "third_party/skia/include/codec/SkCodec.h"
 #include "third_party/skia/include/core/SkPixelRef.h"
 
@@ -222,7 +224,14 @@ static void InstantiateImageCodec(Dart_NativeArguments args) {
 
     ui_codec = fml::MakeRefCounted<SingleFrameCodec>(std::move(descriptor));
   } else {
-    ui_codec = fml::MakeRefCounted<MultiFrameCodec>(std::move(codec));
+    // Frames are decoded ahead of time on the workers that decode the single
+    // frame images, if there are any.
+    std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner;
+    if (auto decoder = UIDartState::Current()->GetImageDecoder()) {
+      concurrent_task_runner = decoder->GetConcurrentTaskRunner();
+    }
+    ui_codec = fml::MakeRefCounted<MultiFrameCodec>(
+        std::move(codec), std::move(concurrent_task_runner));
   }
 
   tonic::DartInvoke(callback_handle, {ToDart(ui_codec)});
@@ -4,9 +4,15 @@
 
 #include "flutter/lib/ui/painting/image_decoder.h"
 
+#include <algorithm>
+
 #include "flutter/fml/make_copyable.h"
 #include "flutter/fml/trace_event.h"
+#include "flutter/lib/ui/painting/image_decoder_cache.h"
+#include "third_party/skia/include/codec/SkAndroidCodec.h"
 #include "third_party/skia/include/codec/SkCodec.h"
+#include "third_party/skia/include/codec/SkEncodedOrigin.h"
+#include "third_party/skia/include/core/SkCanvas.h"
 
 namespace flutter {
 
@@ -56,10 +62,17 @@ static SkISize GetResizedDimensions(SkISize current_size,
   return current_size;
 }
 
+static void RecordBitmapBytes(ImageDecodeStats* stats, size_t bytes) {
+  if (stats) {
+    stats->peak_bitmap_bytes = std::max(stats->peak_bitmap_bytes, bytes);
+  }
+}
+
 static sk_sp<SkImage> ResizeRasterImage(sk_sp<SkImage> image,
                                         std::optional<uint32_t> target_width,
                                         std::optional<uint32_t> target_height,
-                                        const fml::tracing::TraceFlow& flow) {
+                                        const fml::tracing::TraceFlow& flow,
+                                        ImageDecodeStats* stats = nullptr) {
   FML_DCHECK(!image->isTextureBacked());
 
   const auto resized_dimensions =
@@ -87,6 +100,7 @@ static sk_sp<SkImage> ResizeRasterImage(sk_sp<SkImage> image,
     FML_LOG(ERROR) << "Could not allocate bitmap when attempting to scale.";
     return nullptr;
   }
+  RecordBitmapBytes(stats, scaled_bitmap.computeByteSize());
 
   if (!image->scalePixels(scaled_bitmap.pixmap(), kLow_SkFilterQuality,
                           SkImage::kDisallow_CachingHint)) {
@@ -125,14 +139,168 @@ static sk_sp<SkImage> ImageFromDecompressedData(
   return ResizeRasterImage(std::move(image), target_width, target_height, flow);
 }
 
-static sk_sp<SkImage> ImageFromCompressedData(
-    sk_sp<SkData> data,
+// Get the dimensions of an image decoded in |dimensions| once |origin| is
+// applied.
+static SkISize GetOrientedDimensions(SkISize dimensions,
+                                     SkEncodedOrigin origin) {
+  if (origin >= kLeftTop_SkEncodedOrigin) {
+    return SkISize::Make(dimensions.height(), dimensions.width());
+  }
+  return dimensions;
+}
+
+// Get the smallest dimensions |codec| can decode at without the oriented image
+// getting smaller than |resized_dimensions|. These are the full dimensions of
+// the image if the codec can't decode at a reduced size.
+static SkISize GetSampledDecodeDimensions(const SkAndroidCodec& codec,
+                                          SkISize resized_dimensions,
+                                          int* sample_size) {
+  // The codec works in the orientation the image is encoded in.
+  SkISize decode_dimensions =
+      GetOrientedDimensions(resized_dimensions, codec.codec()->getOrigin());
+  *sample_size = codec.computeSampleSize(&decode_dimensions);
+  return decode_dimensions;
+}
+
+static sk_sp<SkImage> OrientRasterImage(sk_sp<SkImage> image,
+                                        SkEncodedOrigin origin,
+                                        ImageDecodeStats* stats) {
+  const auto oriented_dimensions =
+      GetOrientedDimensions(image->dimensions(), origin);
+
+  SkBitmap oriented_bitmap;
+  if (!oriented_bitmap.tryAllocPixels(image->imageInfo().makeWH(
+          oriented_dimensions.width(), oriented_dimensions.height()))) {
+    FML_LOG(ERROR) << "Could not allocate bitmap when attempting to orient.";
+    return nullptr;
+  }
+  RecordBitmapBytes(stats, oriented_bitmap.computeByteSize());
+
+  SkCanvas canvas(oriented_bitmap);
+  canvas.concat(
+      SkEncodedOriginToMatrix(origin, image->width(), image->height()));
+  SkPaint paint;
+  paint.setBlendMode(SkBlendMode::kSrc);
+  canvas.drawImage(image, 0, 0, &paint);
+
+  oriented_bitmap.setImmutable();
+  return SkImage::MakeFromBitmap(oriented_bitmap);
+}
+
+// Decodes the image at a reduced size when the codec supports it, so that a
+// large image shown small never gets decoded at full size. JPEGs are scaled
+// while decoding, other formats are sampled. Returns nullptr if the codec can't
+// decode at a smaller size than the full one.
+static sk_sp<SkImage> ImageFromSampledDecode(
+    const sk_sp<SkData>& data,
     std::optional<uint32_t> target_width,
     std::optional<uint32_t> target_height,
-    const fml::tracing::TraceFlow& flow) {
+    const fml::tracing::TraceFlow& flow,
+    ImageDecodeStats* stats) {
+  auto codec = SkAndroidCodec::MakeFromData(data);
+  if (!codec) {
+    return nullptr;
+  }
+
+  const auto origin = codec->codec()->getOrigin();
+  const auto resized_dimensions = GetResizedDimensions(
+      GetOrientedDimensions(codec->getInfo().dimensions(), origin),
+      target_width, target_height);
+  if (resized_dimensions.isEmpty()) {
+    return nullptr;
+  }
+
+  int sample_size = 1;
+  const auto decode_dimensions =
+      GetSampledDecodeDimensions(*codec, resized_dimensions, &sample_size);
+  if (decode_dimensions == codec->getInfo().dimensions()) {
+    return nullptr;
+  }
+
   TRACE_EVENT0("flutter", __FUNCTION__);
   flow.Step(__FUNCTION__);
 
+  auto decode_info = codec->getInfo().makeWH(decode_dimensions.width(),
+                                             decode_dimensions.height());
+  if (decode_info.alphaType() == kUnpremul_SkAlphaType) {
+    decode_info = decode_info.makeAlphaType(kPremul_SkAlphaType);
+  }
+
+  SkBitmap decoded_bitmap;
+  if (!decoded_bitmap.tryAllocPixels(decode_info)) {
+    FML_LOG(ERROR) << "Could not allocate bitmap when attempting to decode.";
+    return nullptr;
+  }
+  RecordBitmapBytes(stats, decoded_bitmap.computeByteSize());
+
+  SkAndroidCodec::AndroidOptions options;
+  options.fSampleSize = sample_size;
+  switch (codec->getAndroidPixels(decode_info, decoded_bitmap.getPixels(),
+                                  decoded_bitmap.rowBytes(), &options)) {
+    case SkCodec::kSuccess:
+    case SkCodec::kIncompleteInput:
+    case SkCodec::kErrorInInput:
+      break;
+    default:
+      FML_LOG(ERROR) << "Could not decode image at a reduced size.";
+      return nullptr;
+  }
+  decoded_bitmap.setImmutable();
+
+  auto decoded_image = SkImage::MakeFromBitmap(decoded_bitmap);
+  if (decoded_image && origin != kTopLeft_SkEncodedOrigin) {
+    decoded_image = OrientRasterImage(std::move(decoded_image), origin, stats);
+  }
+  if (!decoded_image) {
+    return nullptr;
+  }
+
+  // Resize to the dimensions computed from the full size of the image, the
+  // aspect ratio of the decoded image may be slightly off due to rounding.
+  return ResizeRasterImage(std::move(decoded_image),
+                           resized_dimensions.width(),
+                           resized_dimensions.height(), flow, stats);
+}
+
+SkISize GetDecodeDimensions(sk_sp<SkData> data,
+                            std::optional<uint32_t> target_width,
+                            std::optional<uint32_t> target_height) {
+  auto codec = SkAndroidCodec::MakeFromData(std::move(data));
+  if (!codec) {
+    return SkISize::MakeEmpty();
+  }
+  if (!target_width && !target_height) {
+    return codec->getInfo().dimensions();
+  }
+
+  const auto resized_dimensions = GetResizedDimensions(
+      GetOrientedDimensions(codec->getInfo().dimensions(),
+                            codec->codec()->getOrigin()),
+      target_width, target_height);
+  if (resized_dimensions.isEmpty()) {
+    return codec->getInfo().dimensions();
+  }
+
+  int sample_size = 1;
+  return GetSampledDecodeDimensions(*codec, resized_dimensions, &sample_size);
+}
+
+sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
+                                       std::optional<uint32_t> target_width,
+                                       std::optional<uint32_t> target_height,
+                                       const fml::tracing::TraceFlow& flow,
+                                       ImageDecodeStats* stats) {
+  TRACE_EVENT0("flutter", __FUNCTION__);
+  flow.Step(__FUNCTION__);
+
+  if (target_width || target_height) {
+    auto sampled_image =
+        ImageFromSampledDecode(data, target_width, target_height, flow, stats);
+    if (sampled_image) {
+      return sampled_image;
+    }
+  }
+
   auto decoded_image = SkImage::MakeFromEncoded(data);
 
   if (!decoded_image) {
@@ -145,8 +313,13 @@ static sk_sp<SkImage> ImageFromCompressedData(
   if (!decoded_image) {
     return nullptr;
   }
+  SkPixmap decoded_pixels;
+  if (decoded_image->peekPixels(&decoded_pixels)) {
+    RecordBitmapBytes(stats, decoded_pixels.computeByteSize());
+  }
 
-  return ResizeRasterImage(decoded_image, target_width, target_height, flow);
+  return ResizeRasterImage(decoded_image, target_width, target_height, flow,
+                           stats);
 }
 
 static SkiaGPUObject<SkImage> UploadRasterImage(
@@ -188,6 +361,167 @@ static SkiaGPUObject<SkImage> UploadRasterImage(
   return {texture_image, queue};
 }
 
+namespace {
+
+// The state of a call to |ImageDecoder::Decode|, handed from thread to thread.
+struct DecodeRequest {
+  using Result =
+      std::function<void(SkiaGPUObject<SkImage>, fml::tracing::TraceFlow)>;
+
+  ImageDecoder::ImageDescriptor descriptor;
+  fml::WeakPtr<IOManager> io_manager;
+  fml::RefPtr<fml::TaskRunner> io_runner;
+  std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_runner;
+  Result result;
+  fml::tracing::TraceFlow flow;
+
+  // Set once the data is hashed on a worker.
+  std::optional<ImageDecoderCache::Key> key;
+  // Set on the IO thread. The image is stored in the cache for them.
+  fml::RefPtr<SkiaUnrefQueue> unref_queue;
+  const GrContext* resource_context = nullptr;
+  // Whether the image missed the cache, which waits for |Finish| to complete
+  // it.
+  bool missed = false;
+
+  DecodeRequest(ImageDecoder::ImageDescriptor p_descriptor,
+                fml::WeakPtr<IOManager> p_io_manager,
+                fml::RefPtr<fml::TaskRunner> p_io_runner,
+                std::shared_ptr<fml::ConcurrentTaskRunner> p_concurrent_runner,
+                Result p_result,
+                fml::tracing::TraceFlow p_flow)
+      : descriptor(std::move(p_descriptor)),
+        io_manager(std::move(p_io_manager)),
+        io_runner(std::move(p_io_runner)),
+        concurrent_runner(std::move(p_concurrent_runner)),
+        result(std::move(p_result)),
+        flow(std::move(p_flow)) {}
+
+  ~DecodeRequest() {
+    // The task holding the request last was dropped without running, as the
+    // tasks of a task runner being shut down are. Fails the decode rather than
+    // leaving the caller and the requests waiting for the image hanging.
+    if (result) {
+      Finish({});
+    }
+  }
+
+  // Ends the decode of the image in the cache if it missed it, and returns
+  // |image| to the caller.
+  void Finish(SkiaGPUObject<SkImage> image) {
+    if (missed) {
+      missed = false;
+      ImageDecoderCache::GetInstance().Complete(*key, unref_queue,
+                                                resource_context, image.get());
+    }
+    auto callback = std::move(result);
+    result = nullptr;
+    callback(std::move(image), std::move(flow));
+  }
+};
+
+}  // namespace
+
+static void DecompressAndUpload(std::shared_ptr<DecodeRequest> request);
+
+// Step 2: Look for an image decoded from the same data, which the IO manager
+// has already uploaded.
+// On IO Thread.
+static void LookUpDecodedImage(std::shared_ptr<DecodeRequest> request) {
+  TRACE_EVENT0("flutter", __FUNCTION__);
+  request->flow.Step(__FUNCTION__);
+
+  if (!request->io_manager) {
+    FML_LOG(ERROR) << "Could not acquire IO manager.";
+    request->Finish({});
+    return;
+  }
+
+  request->unref_queue = request->io_manager->GetSkiaUnrefQueue();
+  request->resource_context = request->io_manager->GetResourceContext().get();
+
+  sk_sp<SkImage> image;
+  auto lookup = ImageDecoderCache::GetInstance().Lookup(
+      *request->key, request->unref_queue, request->resource_context, &image,
+      // Looks again once the image being decoded by another request is done.
+      [request]() {
+        request->io_runner->PostTask(
+            [request]() { LookUpDecodedImage(request); });
+      });
+
+  switch (lookup) {
+    case ImageDecoderCache::LookupResult::kHit:
+      request->Finish({std::move(image), request->unref_queue});
+      return;
+    case ImageDecoderCache::LookupResult::kPending:
+      return;
+    case ImageDecoderCache::LookupResult::kMiss:
+      request->missed = true;
+      request->concurrent_runner->PostTask(
+          [request]() { DecompressAndUpload(request); });
+      return;
+  }
+}
+
+// Step 3: Decompress the image.
+// On Worker.
+static void DecompressAndUpload(std::shared_ptr<DecodeRequest> request) {
+  auto& descriptor = request->descriptor;
+  auto decompressed =
+      descriptor.decompressed_image_info
+          ? ImageFromDecompressedData(
+                std::move(descriptor.data),                  //
+                descriptor.decompressed_image_info.value(),  //
+                descriptor.target_width,                     //
+                descriptor.target_height,                    //
+                request->flow                                //
+                )
+          : ImageFromCompressedData(std::move(descriptor.data),  //
+                                    descriptor.target_width,     //
+                                    descriptor.target_height,    //
+                                    request->flow);
+
+  if (!decompressed) {
+    FML_LOG(ERROR) << "Could not decompress image.";
+    request->Finish({});
+    return;
+  }
+
+  // Step 4: Update the image to the GPU.
+  // On IO Thread.
+
+  request->io_runner->PostTask([request, decompressed]() mutable {
+    auto& io_manager = request->io_manager;
+    if (!io_manager) {
+      FML_LOG(ERROR) << "Could not acquire IO manager.";
+      request->Finish({});
+      return;
+    }
+
+    // If the IO manager does not have a resource context, the caller
+    // might not have set one or a software backend could be in use.
+    // Either way, just return the image as-is.
+    if (!io_manager->GetResourceContext()) {
+      request->Finish(
+          {std::move(decompressed), io_manager->GetSkiaUnrefQueue()});
+      return;
+    }
+
+    auto uploaded = UploadRasterImage(
+        std::move(decompressed), io_manager->GetResourceContext(),
+        io_manager->GetSkiaUnrefQueue(), request->flow);
+
+    if (!uploaded.get()) {
+      FML_LOG(ERROR) << "Could not upload image to the GPU.";
+      request->Finish({});
+      return;
+    }
+
+    // Finally, all done.
+    request->Finish(std::move(uploaded));
+  });
+}
+
 void ImageDecoder::Decode(ImageDescriptor descriptor, ImageResult callback) {
   TRACE_EVENT0("flutter", __FUNCTION__);
   fml::tracing::TraceFlow flow(__FUNCTION__);
@@ -214,74 +548,25 @@ void ImageDecoder::Decode(ImageDescriptor descriptor, ImageResult callback) {
     return;
   }
 
-  concurrent_task_runner_->PostTask(
-      fml::MakeCopyable([descriptor,                              //
-                         io_manager = io_manager_,                //
-                         io_runner = runners_.GetIOTaskRunner(),  //
-                         result,                                  //
-                         flow = std::move(flow)                   //
-  ]() mutable {
-        // Step 1: Decompress the image.
-        // On Worker.
-
-        auto decompressed =
-            descriptor.decompressed_image_info
-                ? ImageFromDecompressedData(
-                      std::move(descriptor.data),                  //
-                      descriptor.decompressed_image_info.value(),  //
-                      descriptor.target_width,                     //
-                      descriptor.target_height,                    //
-                      flow                                         //
-                      )
-                : ImageFromCompressedData(std::move(descriptor.data),  //
-                                          descriptor.target_width,     //
-                                          descriptor.target_height,    //
-                                          flow);
-
-        if (!decompressed) {
-          FML_LOG(ERROR) << "Could not decompress image.";
-          result({}, std::move(flow));
-          return;
-        }
-
-        // Step 2: Update the image to the GPU.
-        // On IO Thread.
-
-        io_runner->PostTask(fml::MakeCopyable([io_manager, decompressed, result,
-                                               flow =
-                                                   std::move(flow)]() mutable {
-          if (!io_manager) {
-            FML_LOG(ERROR) << "Could not acquire IO manager.";
-            return result({}, std::move(flow));
-          }
-
-          // If the IO manager does not have a resource context, the caller
-          // might not have set one or a software backend could be in use.
-          // Either way, just return the image as-is.
-          if (!io_manager->GetResourceContext()) {
-            result({std::move(decompressed), io_manager->GetSkiaUnrefQueue()},
-                   std::move(flow));
-            return;
-          }
-
-          auto uploaded = UploadRasterImage(
-              std::move(decompressed), io_manager->GetResourceContext(),
-              io_manager->GetSkiaUnrefQueue(), flow);
-
-          if (!uploaded.get()) {
-            FML_LOG(ERROR) << "Could not upload image to the GPU.";
-            result({}, std::move(flow));
-            return;
-          }
-
-          // Finally, all done.
-          result(std::move(uploaded), std::move(flow));
-        }));
-      }));
+  auto request = std::make_shared<DecodeRequest>(
+      std::move(descriptor), io_manager_, runners_.GetIOTaskRunner(),
+      concurrent_task_runner_, std::move(result), std::move(flow));
+
+  concurrent_task_runner_->PostTask([request]() {
+    // Step 1: Hash the data to find the image in the cache.
+    // On Worker.
+    request->key.emplace(request->descriptor);
+    request->io_runner->PostTask([request]() { LookUpDecodedImage(request); });
+  });
 }
 
 fml::WeakPtr<ImageDecoder> ImageDecoder::GetWeakPtr() const {
   return weak_factory_.GetWeakPtr();
 }
 
+const std::shared_ptr<fml::ConcurrentTaskRunner>&
+ImageDecoder::GetConcurrentTaskRunner() const {
+  return concurrent_task_runner_;
+}
+
 }  // namespace flutter
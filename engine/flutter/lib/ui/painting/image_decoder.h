@@ -13,6 +13,7 @@
 #include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/mapping.h"
+#include "flutter/fml/trace_event.h"
 #include "flutter/lib/ui/io_manager.h"
 #include "third_party/skia/include/core/SkData.h"
 #include "third_party/skia/include/core/SkImage.h"
@@ -59,6 +60,11 @@ class ImageDecoder {
 
   fml::WeakPtr<ImageDecoder> GetWeakPtr() const;
 
+  // The runner the decompression and resizes are done on, which other image
+  // codecs can share.
+  const std::shared_ptr<fml::ConcurrentTaskRunner>& GetConcurrentTaskRunner()
+      const;
+
  private:
   TaskRunners runners_;
   std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner_;
@@ -68,6 +74,28 @@ class ImageDecoder {
   FML_DISALLOW_COPY_AND_ASSIGN(ImageDecoder);
 };
 
+// The pixel memory allocated by |ImageFromCompressedData|.
+struct ImageDecodeStats {
+  // The size of the largest bitmap allocated while decoding and resizing.
+  size_t peak_bitmap_bytes = 0;
+};
+
+// Decodes |data| and resizes it to the target dimensions. If the codec can
+// decode at a reduced size, the image is decoded at the smallest size that is
+// not smaller than the target dimensions and only the remainder is resized.
+// Exposed for testing, along with |stats|.
+sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
+                                       std::optional<uint32_t> target_width,
+                                       std::optional<uint32_t> target_height,
+                                       const fml::tracing::TraceFlow& flow,
+                                       ImageDecodeStats* stats = nullptr);
+
+// The dimensions |ImageFromCompressedData| decodes |data| at, before the image
+// is oriented and resized. Exposed for testing.
+SkISize GetDecodeDimensions(sk_sp<SkData> data,
+                            std::optional<uint32_t> target_width,
+                            std::optional<uint32_t> target_height);
+
 }  // namespace flutter
 
 #endif  // FLUTTER_LIB_UI_PAINTING_IMAGE_DECODER_H_
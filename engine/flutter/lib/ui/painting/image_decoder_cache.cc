@@ -0,0 +1,182 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/lib/ui/painting/image_decoder_cache.h"
+
+#include <functional>
+#include <string_view>
+
+namespace flutter {
+
+static size_t HashCombine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+ImageDecoderCache::Key::Key(const ImageDecoder::ImageDescriptor& descriptor)
+    : data_(descriptor.data),
+      decompressed_image_info_(descriptor.decompressed_image_info),
+      target_width_(descriptor.target_width),
+      target_height_(descriptor.target_height) {
+  if (data_) {
+    hash_ = std::hash<std::string_view>{}(std::string_view(
+        static_cast<const char*>(data_->data()), data_->size()));
+  }
+  hash_ = HashCombine(hash_, target_width_.value_or(0));
+  hash_ = HashCombine(hash_, target_height_.value_or(0));
+}
+
+bool ImageDecoderCache::Key::operator==(const Key& other) const {
+  if (hash_ != other.hash_ || target_width_ != other.target_width_ ||
+      target_height_ != other.target_height_ ||
+      decompressed_image_info_.has_value() !=
+          other.decompressed_image_info_.has_value()) {
+    return false;
+  }
+  if (decompressed_image_info_ &&
+      (decompressed_image_info_->sk_info !=
+           other.decompressed_image_info_->sk_info ||
+       decompressed_image_info_->row_bytes !=
+           other.decompressed_image_info_->row_bytes)) {
+    return false;
+  }
+  // Two different images can share a hash, only equal data decodes to the
+  // same image.
+  if (!data_ || !other.data_) {
+    return data_ == other.data_;
+  }
+  return data_ == other.data_ || data_->equals(other.data_.get());
+}
+
+bool ImageDecoderCache::EntryKey::operator==(const EntryKey& other) const {
+  return unref_queue == other.unref_queue &&
+         resource_context == other.resource_context && key == other.key;
+}
+
+size_t ImageDecoderCache::EntryKeyHash::operator()(const EntryKey& key) const {
+  size_t hash = key.key.GetHash();
+  hash = HashCombine(hash, std::hash<const void*>{}(key.unref_queue));
+  hash = HashCombine(hash, std::hash<const void*>{}(key.resource_context));
+  return hash;
+}
+
+ImageDecoderCache& ImageDecoderCache::GetInstance() {
+  // Never destroyed, the IO managers release their images before they go away.
+  static ImageDecoderCache* instance = new ImageDecoderCache();
+  return *instance;
+}
+
+ImageDecoderCache::ImageDecoderCache(size_t byte_budget)
+    : byte_budget_(byte_budget) {}
+
+ImageDecoderCache::~ImageDecoderCache() {
+  std::scoped_lock lock(mutex_);
+  while (!entries_.empty()) {
+    EvictLocked(std::prev(entries_.end()));
+  }
+}
+
+ImageDecoderCache::LookupResult ImageDecoderCache::Lookup(
+    const Key& key,
+    const fml::RefPtr<SkiaUnrefQueue>& unref_queue,
+    const GrContext* resource_context,
+    sk_sp<SkImage>* image,
+    fml::closure waiter) {
+  EntryKey entry_key{key, unref_queue.get(), resource_context};
+
+  std::scoped_lock lock(mutex_);
+  auto found = index_.find(entry_key);
+  if (found != index_.end()) {
+    // Make it the most recently used entry.
+    entries_.splice(entries_.begin(), entries_, found->second);
+    *image = found->second->image;
+    stats_.hit_count++;
+    return LookupResult::kHit;
+  }
+
+  auto pending = pending_.find(entry_key);
+  if (pending != pending_.end()) {
+    if (waiter) {
+      pending->second.push_back(std::move(waiter));
+    }
+    stats_.deduplicated_count++;
+    return LookupResult::kPending;
+  }
+
+  pending_.emplace(std::move(entry_key), std::vector<fml::closure>{});
+  stats_.miss_count++;
+  return LookupResult::kMiss;
+}
+
+void ImageDecoderCache::Complete(const Key& key,
+                                 const fml::RefPtr<SkiaUnrefQueue>& unref_queue,
+                                 const GrContext* resource_context,
+                                 sk_sp<SkImage> image) {
+  EntryKey entry_key{key, unref_queue.get(), resource_context};
+  std::vector<fml::closure> waiters;
+  {
+    std::scoped_lock lock(mutex_);
+    auto pending = pending_.find(entry_key);
+    if (pending != pending_.end()) {
+      waiters = std::move(pending->second);
+      pending_.erase(pending);
+    }
+
+    if (image && index_.find(entry_key) == index_.end()) {
+      const size_t byte_size = image->imageInfo().computeMinByteSize() +
+                               (key.data_ ? key.data_->size() : 0);
+      if (byte_size <= byte_budget_) {
+        entries_.push_front(
+            {entry_key, unref_queue, std::move(image), byte_size});
+        index_.emplace(std::move(entry_key), entries_.begin());
+        stats_.entry_count++;
+        stats_.byte_size += byte_size;
+        EvictToBudgetLocked();
+      }
+    }
+  }
+
+  for (auto& waiter : waiters) {
+    waiter();
+  }
+}
+
+void ImageDecoderCache::Purge(const SkiaUnrefQueue* unref_queue) {
+  std::scoped_lock lock(mutex_);
+  for (auto entry = entries_.begin(); entry != entries_.end();) {
+    auto next = std::next(entry);
+    if (entry->key.unref_queue == unref_queue) {
+      EvictLocked(entry);
+    }
+    entry = next;
+  }
+}
+
+void ImageDecoderCache::SetByteBudget(size_t byte_budget) {
+  std::scoped_lock lock(mutex_);
+  byte_budget_ = byte_budget;
+  EvictToBudgetLocked();
+}
+
+ImageDecoderCache::Stats ImageDecoderCache::GetStats() const {
+  std::scoped_lock lock(mutex_);
+  return stats_;
+}
+
+void ImageDecoderCache::EvictLocked(std::list<Entry>::iterator entry) {
+  // Images uploaded to a resource context must be released on its thread.
+  entry->unref_queue->Unref(entry->image.release());
+  stats_.entry_count--;
+  stats_.byte_size -= entry->byte_size;
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+void ImageDecoderCache::EvictToBudgetLocked() {
+  while (stats_.byte_size > byte_budget_) {
+    EvictLocked(std::prev(entries_.end()));
+    stats_.eviction_count++;
+  }
+}
+
+}  // namespace flutter
@@ -0,0 +1,158 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_LIB_UI_PAINTING_IMAGE_DECODER_CACHE_H_
+#define FLUTTER_LIB_UI_PAINTING_IMAGE_DECODER_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/flow/skia_gpu_object.h"
+#include "flutter/fml/closure.h"
+#include "flutter/fml/macros.h"
+#include "flutter/fml/synchronization/thread_annotations.h"
+#include "flutter/lib/ui/painting/image_decoder.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/gpu/GrContext.h"
+
+namespace flutter {
+
+// The images returned by |ImageDecoder| kept across decoders, so that decoding
+// the same data again to the same size skips both the decode and the upload.
+//
+// Images uploaded to a resource context can only be used with that context,
+// so entries are only found by the IO manager that stored them, identified by
+// its unref queue and resource context. They are released through that queue.
+// The IO manager must |Purge| its entries before draining the queue for the
+// last time.
+//
+// The least recently used entries are evicted to keep the images and the data
+// they were decoded from within a byte budget.
+//
+// Thread-safe.
+class ImageDecoderCache {
+ public:
+  static constexpr size_t kDefaultByteBudget = 32 * 1024 * 1024;
+
+  // Identifies the image decoded from a descriptor by the contents of its data
+  // and the size it is resized to.
+  class Key {
+   public:
+    // Hashes the data of |descriptor|, which should be done on a worker.
+    explicit Key(const ImageDecoder::ImageDescriptor& descriptor);
+
+    size_t GetHash() const { return hash_; }
+
+    bool operator==(const Key& other) const;
+
+   private:
+    friend class ImageDecoderCache;
+
+    sk_sp<SkData> data_;
+    std::optional<ImageDecoder::ImageInfo> decompressed_image_info_;
+    std::optional<uint32_t> target_width_;
+    std::optional<uint32_t> target_height_;
+    size_t hash_ = 0;
+  };
+
+  struct Stats {
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+    // The lookups that waited for the same image to be decoded by another.
+    size_t deduplicated_count = 0;
+    size_t eviction_count = 0;
+    size_t entry_count = 0;
+    size_t byte_size = 0;
+  };
+
+  enum class LookupResult {
+    // The image was found.
+    kHit,
+    // The image is being decoded by an earlier lookup. The waiter is called
+    // once it is done.
+    kPending,
+    // The caller has to decode the image and call |Complete|. Later lookups of
+    // the same image are pending until then.
+    kMiss,
+  };
+
+  // The instance used by all the image decoders of the process.
+  static ImageDecoderCache& GetInstance();
+
+  explicit ImageDecoderCache(size_t byte_budget = kDefaultByteBudget);
+
+  ~ImageDecoderCache();
+
+  // Looks for the image decoded from the data of |key| and uploaded to
+  // |resource_context|, which may be null, by the IO manager owning
+  // |unref_queue|. On a hit, |image| is set to it. If the image is pending,
+  // |waiter| is called on the thread completing it.
+  LookupResult Lookup(const Key& key,
+                      const fml::RefPtr<SkiaUnrefQueue>& unref_queue,
+                      const GrContext* resource_context,
+                      sk_sp<SkImage>* image,
+                      fml::closure waiter);
+
+  // Ends the decode of an image that missed, storing |image| unless it is
+  // null because the decode failed or was abandoned. Calls the waiters of the
+  // image. Every miss must be completed, later lookups of the image are
+  // pending until then.
+  void Complete(const Key& key,
+                const fml::RefPtr<SkiaUnrefQueue>& unref_queue,
+                const GrContext* resource_context,
+                sk_sp<SkImage> image);
+
+  // Releases all the images stored by the IO manager owning |unref_queue|.
+  void Purge(const SkiaUnrefQueue* unref_queue);
+
+  // Evicts entries until the cache fits in |byte_budget|. Images larger than
+  // it are not stored at all.
+  void SetByteBudget(size_t byte_budget);
+
+  Stats GetStats() const;
+
+ private:
+  struct EntryKey {
+    Key key;
+    const SkiaUnrefQueue* unref_queue;
+    const GrContext* resource_context;
+
+    bool operator==(const EntryKey& other) const;
+  };
+
+  struct EntryKeyHash {
+    size_t operator()(const EntryKey& key) const;
+  };
+
+  struct Entry {
+    EntryKey key;
+    fml::RefPtr<SkiaUnrefQueue> unref_queue;
+    sk_sp<SkImage> image;
+    size_t byte_size;
+  };
+
+  mutable std::mutex mutex_;
+  size_t byte_budget_ FML_GUARDED_BY(mutex_);
+  // Most recently used first.
+  std::list<Entry> entries_ FML_GUARDED_BY(mutex_);
+  std::unordered_map<EntryKey, std::list<Entry>::iterator, EntryKeyHash>
+      index_ FML_GUARDED_BY(mutex_);
+  std::unordered_map<EntryKey, std::vector<fml::closure>, EntryKeyHash>
+      pending_ FML_GUARDED_BY(mutex_);
+  Stats stats_ FML_GUARDED_BY(mutex_);
+
+  void EvictLocked(std::list<Entry>::iterator entry)
+      FML_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void EvictToBudgetLocked() FML_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ImageDecoderCache);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_LIB_UI_PAINTING_IMAGE_DECODER_CACHE_H_
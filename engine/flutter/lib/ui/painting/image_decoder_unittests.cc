@@ -4,8 +4,10 @@
 
 #include "flutter/common/task_runners.h"
 #include "flutter/fml/mapping.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
 #include "flutter/fml/synchronization/waitable_event.h"
 #include "flutter/lib/ui/painting/image_decoder.h"
+#include "flutter/lib/ui/painting/image_decoder_cache.h"
 #include "flutter/testing/test_gl_surface.h"
 #include "flutter/testing/testing.h"
 #include "flutter/testing/thread_test.h"
@@ -39,6 +41,8 @@ class TestIOManager final : public IOManager {
     fml::AutoResetWaitableEvent latch;
     fml::TaskRunner::RunNowOrPostTask(runner_,
                                       [&latch, queue = unref_queue_]() {
+                                        ImageDecoderCache::GetInstance().Purge(
+                                            queue.get());
                                         queue->Drain();
                                         latch.Signal();
                                       });
@@ -73,6 +77,52 @@ class TestIOManager final : public IOManager {
   FML_DISALLOW_COPY_AND_ASSIGN(TestIOManager);
 };
 
+// An IO manager without a GPU context, which calls |on_look_up| the first time
+// a decode looks up its image in the cache. Its task runner may be terminated
+// before it is destroyed.
+class LookUpObservingIOManager final : public IOManager {
+ public:
+  LookUpObservingIOManager(fml::RefPtr<fml::TaskRunner> task_runner,
+                           fml::closure on_look_up)
+      : unref_queue_(fml::MakeRefCounted<SkiaUnrefQueue>(
+            std::move(task_runner),
+            fml::TimeDelta::FromNanoseconds(0))),
+        on_look_up_(std::move(on_look_up)),
+        weak_factory_(this) {
+    weak_prototype_ = weak_factory_.GetWeakPtr();
+  }
+
+  ~LookUpObservingIOManager() override {
+    ImageDecoderCache::GetInstance().Purge(unref_queue_.get());
+  }
+
+  // |IOManager|
+  fml::WeakPtr<IOManager> GetWeakIOManager() const override {
+    return weak_prototype_;
+  }
+
+  // |IOManager|
+  fml::WeakPtr<GrContext> GetResourceContext() const override { return {}; }
+
+  // |IOManager|
+  fml::RefPtr<flutter::SkiaUnrefQueue> GetSkiaUnrefQueue() const override {
+    if (on_look_up_) {
+      auto on_look_up = std::move(on_look_up_);
+      on_look_up_ = nullptr;
+      on_look_up();
+    }
+    return unref_queue_;
+  }
+
+ private:
+  fml::RefPtr<SkiaUnrefQueue> unref_queue_;
+  mutable fml::closure on_look_up_;
+  fml::WeakPtr<LookUpObservingIOManager> weak_prototype_;
+  fml::WeakPtrFactory<LookUpObservingIOManager> weak_factory_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(LookUpObservingIOManager);
+};
+
 static sk_sp<SkData> OpenFixtureAsSkData(const char* name) {
   auto fixtures_directory =
       fml::OpenDirectory(GetFixturesPath(), false, fml::FilePermission::kRead);
@@ -440,5 +490,268 @@ TEST_F(ImageDecoderFixtureTest, CanResizeWithoutDecode) {
   ASSERT_EQ(decoded_size(100, 100), SkISize::Make(100, 100));
 }
 
+TEST_F(ImageDecoderFixtureTest, DecodesAtReducedSizeForSmallTargets) {
+  auto data = OpenFixtureAsSkData("DashInNooglerHat.jpg");
+  ASSERT_TRUE(data);
+  fml::tracing::TraceFlow flow(__FUNCTION__);
+
+  // The largest bitmap allocated is what the decode peaks at.
+  auto decode_bytes = [&](std::optional<uint32_t> target_width,
+                          std::optional<uint32_t> target_height) {
+    ImageDecodeStats stats;
+    auto image = ImageFromCompressedData(data, target_width, target_height,
+                                         flow, &stats);
+    EXPECT_TRUE(image);
+    return stats.peak_bitmap_bytes;
+  };
+
+  // 48MB at full size.
+  const size_t full_bytes = decode_bytes({}, {});
+  ASSERT_EQ(full_bytes, 3024u * 4032u * 4u);
+
+  ASSERT_LE(decode_bytes(100, {}), full_bytes / 64);
+  ASSERT_LE(decode_bytes({}, 100), full_bytes / 64);
+  ASSERT_LE(decode_bytes(100, 100), full_bytes / 64);
+  ASSERT_LE(decode_bytes(1000, {}), full_bytes / 4);
+  ASSERT_EQ(decode_bytes(3024, {}), full_bytes);
+}
+
+TEST_F(ImageDecoderFixtureTest, ReducedSizeDecodeOnlyAllocatesTheReducedSize) {
+  auto data = OpenFixtureAsSkData("DashInNooglerHat.jpg");
+  ASSERT_TRUE(data);
+  fml::tracing::TraceFlow flow(__FUNCTION__);
+
+  const auto decode_dimensions = GetDecodeDimensions(data, 100, {});
+  ASSERT_GE(decode_dimensions.width(), 100);
+  ASSERT_LT(decode_dimensions.width(), 3024);
+
+  ImageDecodeStats stats;
+  auto image = ImageFromCompressedData(data, 100, {}, flow, &stats);
+  ASSERT_TRUE(image);
+  ASSERT_EQ(image->dimensions(), SkISize::Make(100, 133));
+  // The decoded bitmap is the largest one, resizing it allocates less.
+  ASSERT_EQ(stats.peak_bitmap_bytes,
+            static_cast<size_t>(decode_dimensions.width()) *
+                decode_dimensions.height() * 4u);
+}
+
+TEST_F(ImageDecoderFixtureTest, ReducedSizeDecodeRespectsExifData) {
+  auto data = OpenFixtureAsSkData("Horizontal.jpg");
+  ASSERT_TRUE(data);
+  fml::tracing::TraceFlow flow(__FUNCTION__);
+
+  // Encoded as 200x600 and rotated to 600x200.
+  ASSERT_EQ(GetDecodeDimensions(data, 300, {}), SkISize::Make(100, 300));
+
+  auto image = ImageFromCompressedData(data, 300, {}, flow);
+  ASSERT_TRUE(image);
+  ASSERT_EQ(image->dimensions(), SkISize::Make(300, 100));
+
+  image = ImageFromCompressedData(data, {}, 50, flow);
+  ASSERT_TRUE(image);
+  ASSERT_EQ(image->dimensions(), SkISize::Make(150, 50));
+}
+
+TEST_F(ImageDecoderFixtureTest, CacheReturnsImagesDecodedEarlier) {
+  auto loop = fml::ConcurrentMessageLoop::Create();
+  TaskRunners runners(GetCurrentTestName(),    // label
+                      GetThreadTaskRunner(),   // platform
+                      CreateNewThread("gpu"),  // gpu
+                      CreateNewThread("ui"),   // ui
+                      CreateNewThread("io")    // io
+  );
+
+  fml::AutoResetWaitableEvent latch;
+  std::unique_ptr<IOManager> io_manager;
+  std::unique_ptr<ImageDecoder> image_decoder;
+
+  runners.GetIOTaskRunner()->PostTask([&]() {
+    io_manager = std::make_unique<TestIOManager>(runners.GetIOTaskRunner());
+    latch.Signal();
+  });
+  latch.Wait();
+
+  runners.GetUITaskRunner()->PostTask([&]() {
+    image_decoder = std::make_unique<ImageDecoder>(
+        runners, loop->GetTaskRunner(), io_manager->GetWeakIOManager());
+    latch.Signal();
+  });
+  latch.Wait();
+
+  // Decodes the fixture |count| times at once, as a list showing the same
+  // image in several places would.
+  auto decode_images = [&](size_t count) {
+    std::vector<sk_sp<SkImage>> images;
+    fml::CountDownLatch decoded(count);
+    runners.GetUITaskRunner()->PostTask([&]() {
+      for (size_t i = 0; i < count; i++) {
+        ImageDecoder::ImageDescriptor image_descriptor;
+        image_descriptor.target_width = 100;
+        image_descriptor.data = OpenFixtureAsSkData("DashInNooglerHat.jpg");
+        image_decoder->Decode(std::move(image_descriptor),
+                              [&](SkiaGPUObject<SkImage> image) {
+                                images.push_back(image.get());
+                                decoded.CountDown();
+                              });
+      }
+    });
+    decoded.Wait();
+    return images;
+  };
+
+  auto& cache = ImageDecoderCache::GetInstance();
+  const auto stats_before = cache.GetStats();
+
+  // The second image waits for the first one to be decoded.
+  auto images = decode_images(2);
+  ASSERT_EQ(images.size(), 2u);
+  ASSERT_TRUE(images[0]);
+  ASSERT_EQ(images[0]->dimensions(), SkISize::Make(100, 133));
+  ASSERT_EQ(images[0], images[1]);
+
+  auto stats = cache.GetStats();
+  ASSERT_EQ(stats.miss_count - stats_before.miss_count, 1u);
+  ASSERT_EQ(stats.deduplicated_count - stats_before.deduplicated_count, 1u);
+  ASSERT_EQ(stats.hit_count - stats_before.hit_count, 1u);
+
+  // Later decodes are served from the cache.
+  auto later_images = decode_images(1);
+  ASSERT_EQ(later_images[0], images[0]);
+  ASSERT_EQ(cache.GetStats().hit_count - stats.hit_count, 1u);
+
+  runners.GetUITaskRunner()->PostTask([&]() {
+    image_decoder.reset();
+    latch.Signal();
+  });
+  latch.Wait();
+}
+
+TEST_F(ImageDecoderFixtureTest, AbandonedDecodesFailTheirWaiters) {
+  // A single worker runs the tasks posted from the IO thread in order.
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  TaskRunners runners(GetCurrentTestName(),    // label
+                      GetThreadTaskRunner(),   // platform
+                      CreateNewThread("gpu"),  // gpu
+                      CreateNewThread("ui"),   // ui
+                      CreateNewThread("io")    // io
+  );
+
+  fml::AutoResetWaitableEvent latch;
+  fml::AutoResetWaitableEvent worker_blocked;
+  fml::AutoResetWaitableEvent io_terminated;
+  std::unique_ptr<IOManager> io_manager;
+  std::unique_ptr<ImageDecoder> image_decoder;
+
+  runners.GetIOTaskRunner()->PostTask([&]() {
+    // Holds the decompression of the image back until the IO thread, which
+    // uploads it, is gone.
+    io_manager = std::make_unique<LookUpObservingIOManager>(
+        runners.GetIOTaskRunner(), [&]() {
+          loop->GetTaskRunner()->PostTask([&]() {
+            worker_blocked.Signal();
+            io_terminated.Wait();
+          });
+        });
+    latch.Signal();
+  });
+  latch.Wait();
+
+  const auto data = OpenFixtureAsSkData("DashInNooglerHat.jpg");
+  ASSERT_TRUE(data);
+  bool decoded = true;
+  runners.GetUITaskRunner()->PostTask([&]() {
+    image_decoder = std::make_unique<ImageDecoder>(
+        runners, loop->GetTaskRunner(), io_manager->GetWeakIOManager());
+    ImageDecoder::ImageDescriptor image_descriptor;
+    image_descriptor.data = data;
+    image_decoder->Decode(std::move(image_descriptor),
+                          [&](SkiaGPUObject<SkImage> image) {
+                            decoded = static_cast<bool>(image.get());
+                            latch.Signal();
+                          });
+  });
+  worker_blocked.Wait();
+
+  ImageDecoder::ImageDescriptor image_descriptor;
+  image_descriptor.data = data;
+  const ImageDecoderCache::Key key(image_descriptor);
+  auto& cache = ImageDecoderCache::GetInstance();
+  auto unref_queue = io_manager->GetSkiaUnrefQueue();
+  fml::AutoResetWaitableEvent waiter_called;
+  runners.GetIOTaskRunner()->PostTask([&]() {
+    sk_sp<SkImage> image;
+    EXPECT_EQ(cache.Lookup(key, unref_queue, nullptr, &image,
+                           [&]() { waiter_called.Signal(); }),
+              ImageDecoderCache::LookupResult::kPending);
+    fml::MessageLoop::GetCurrent().Terminate();
+    io_terminated.Signal();
+  });
+
+  // The upload of the image is dropped along with the decode.
+  waiter_called.Wait();
+  latch.Wait();
+  ASSERT_FALSE(decoded);
+
+  // The image can be decoded again.
+  sk_sp<SkImage> image;
+  ASSERT_EQ(cache.Lookup(key, unref_queue, nullptr, &image, {}),
+            ImageDecoderCache::LookupResult::kMiss);
+  cache.Complete(key, unref_queue, nullptr, nullptr);
+
+  runners.GetUITaskRunner()->PostTask([&]() {
+    image_decoder.reset();
+    latch.Signal();
+  });
+  latch.Wait();
+  io_manager.reset();
+}
+
+TEST_F(ImageDecoderFixtureTest, CacheEvictsLeastRecentlyUsedImages) {
+  auto unref_queue = fml::MakeRefCounted<SkiaUnrefQueue>(
+      GetThreadTaskRunner(), fml::TimeDelta::FromNanoseconds(0));
+
+  auto make_key = [](const char* name) {
+    ImageDecoder::ImageDescriptor descriptor;
+    descriptor.data = SkData::MakeWithCString(name);
+    return ImageDecoderCache::Key(descriptor);
+  };
+  // 10x10 pixels take 400 bytes.
+  auto image = SkImage::MakeRasterData(
+      SkImageInfo::MakeN32Premul(10, 10), SkData::MakeUninitialized(400),
+      40);
+  ASSERT_TRUE(image);
+  auto lookup = [&](ImageDecoderCache& cache, const char* name) {
+    sk_sp<SkImage> found;
+    return cache.Lookup(make_key(name), unref_queue, nullptr, &found, {});
+  };
+
+  ImageDecoderCache cache(1000);
+  ASSERT_EQ(lookup(cache, "a"), ImageDecoderCache::LookupResult::kMiss);
+  ASSERT_EQ(lookup(cache, "a"), ImageDecoderCache::LookupResult::kPending);
+  cache.Complete(make_key("a"), unref_queue, nullptr, image);
+  ASSERT_EQ(lookup(cache, "b"), ImageDecoderCache::LookupResult::kMiss);
+  cache.Complete(make_key("b"), unref_queue, nullptr, image);
+
+  // Using "a" makes "b" the least recently used image.
+  ASSERT_EQ(lookup(cache, "a"), ImageDecoderCache::LookupResult::kHit);
+  ASSERT_EQ(lookup(cache, "c"), ImageDecoderCache::LookupResult::kMiss);
+  cache.Complete(make_key("c"), unref_queue, nullptr, image);
+
+  auto stats = cache.GetStats();
+  ASSERT_EQ(stats.entry_count, 2u);
+  ASSERT_EQ(stats.eviction_count, 1u);
+  ASSERT_LE(stats.byte_size, 1000u);
+  ASSERT_EQ(lookup(cache, "a"), ImageDecoderCache::LookupResult::kHit);
+  ASSERT_EQ(lookup(cache, "b"), ImageDecoderCache::LookupResult::kMiss);
+
+  // A failed decode is not stored.
+  cache.Complete(make_key("b"), unref_queue, nullptr, nullptr);
+  ASSERT_EQ(lookup(cache, "b"), ImageDecoderCache::LookupResult::kMiss);
+
+  cache.Purge(unref_queue.get());
+  ASSERT_EQ(cache.GetStats().entry_count, 0u);
+  unref_queue->Drain();
+}
+
 }  // namespace testing
 }  // namespace flutter
@@ -4,146 +4,424 @@
 
 #include "flutter/lib/ui/painting/multi_frame_codec.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 #include "flutter/fml/make_copyable.h"
+#include "flutter/fml/synchronization/thread_annotations.h"
+#include "flutter/fml/trace_event.h"
 #include "third_party/dart/runtime/include/dart_api.h"
 #include "third_party/skia/include/core/SkPixelRef.h"
 
 namespace flutter {
 
-MultiFrameCodec::MultiFrameCodec(std::unique_ptr<SkCodec> codec)
-    : codec_(std::move(codec)),
-      frameCount_(codec_->getFrameCount()),
-      repetitionCount_(codec_->getRepetitionCount()),
-      nextFrameIndex_(0) {}
+namespace {
 
-MultiFrameCodec::~MultiFrameCodec() = default;
+// The memory taken by the frames decoded ahead of time and by the pixels kept
+// for later decodes, summed over all the codecs.
+std::atomic<size_t> gPrefetchByteLimit{
+    MultiFrameCodec::kDefaultPrefetchByteLimit};
+std::atomic<size_t> gPrefetchedBytes{0};
 
-static void InvokeNextFrameCallback(
-    fml::RefPtr<FrameInfo> frameInfo,
-    std::unique_ptr<DartPersistentValue> callback,
-    size_t trace_id) {
-  std::shared_ptr<tonic::DartState> dart_state = callback->dart_state().lock();
-  if (!dart_state) {
-    FML_DLOG(ERROR) << "Could not acquire Dart state while attempting to fire "
-                       "next frame callback.";
-    return;
+bool ReservePrefetchBytes(size_t bytes) {
+  size_t used = gPrefetchedBytes.load(std::memory_order_relaxed);
+  do {
+    if (used + bytes > gPrefetchByteLimit.load(std::memory_order_relaxed)) {
+      return false;
+    }
+  } while (!gPrefetchedBytes.compare_exchange_weak(used, used + bytes,
+                                                    std::memory_order_relaxed));
+  return true;
+}
+
+void ReleasePrefetchBytes(size_t bytes) {
+  gPrefetchedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+struct DecodedFrame {
+  int duration = 0;
+  // Empty if the frame could not be decoded.
+  SkBitmap bitmap;
+};
+
+}  // namespace
+
+// Frames are always decoded in order, one at a time since the codec and the
+// frame a frame depends on are shared by all the decodes. The decodes made
+// ahead of time run in a single task on the concurrent runner that stops once
+// enough frames are waiting, and is posted again when one of them is taken.
+//
+// The pixels of a frame are decoded into the pixels of an earlier one if
+// nothing else refers to them once it's uploaded, which saves allocating and
+// zeroing a frame for each decode.
+//
+// The frames waiting in |decoded_frames_| and the pixels in |free_bitmaps_| are
+// counted against the limit shared by all the codecs.
+class MultiFrameCodec::State : public std::enable_shared_from_this<State> {
+ public:
+  State(std::unique_ptr<SkCodec> codec,
+        std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner);
+
+  ~State();
+
+  int frame_count() const { return frame_count_; }
+
+  int repetition_count() const { return repetition_count_; }
+
+  // Returns the next frame, decoding it now if it wasn't decoded ahead of
+  // time, and sets |duration| to its duration. Called on the IO thread.
+  sk_sp<SkImage> GetNextFrameImage(fml::WeakPtr<GrContext> resourceContext,
+                                   int* duration);
+
+ private:
+  const std::unique_ptr<SkCodec> codec_;
+  const std::vector<SkCodec::FrameInfo> frame_infos_;
+  const int frame_count_;
+  const int repetition_count_;
+  const SkImageInfo info_;
+  const size_t frame_bytes_;
+  const std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner_;
+  const size_t prefetch_frame_count_;
+
+  // Held for the whole decode of a frame, and while it is queued so that the
+  // frames are queued in order.
+  std::mutex decode_mutex_;
+  int next_decode_index_ FML_GUARDED_BY(decode_mutex_) = 0;
+  // The last decoded frame that's required to decode any subsequent frames.
+  std::unique_ptr<SkBitmap> last_required_frame_ FML_GUARDED_BY(decode_mutex_);
+  // The index of the last decoded required frame.
+  int last_required_frame_index_ FML_GUARDED_BY(decode_mutex_) = -1;
+
+  std::mutex frames_mutex_;
+  std::deque<DecodedFrame> decoded_frames_ FML_GUARDED_BY(frames_mutex_);
+  std::vector<SkBitmap> free_bitmaps_ FML_GUARDED_BY(frames_mutex_);
+  // Whether the task decoding frames ahead of time is posted or running.
+  bool prefetching_ FML_GUARDED_BY(frames_mutex_) = false;
+
+  // Takes the oldest frame decoded ahead of time, if any.
+  bool TakeDecodedFrame(DecodedFrame* frame)
+      FML_EXCLUSIVE_LOCKS_REQUIRED(frames_mutex_);
+
+  void PostPrefetchTask();
+
+  // Decodes frames until |prefetch_frame_count_| of them are waiting or the
+  // shared limit is reached. Runs on the concurrent runner.
+  void Prefetch();
+
+  // Decodes and queues the frame after the last one queued, unless enough of
+  // them are waiting. Returns whether it did.
+  bool PrefetchNextFrame();
+
+  DecodedFrame DecodeNextFrame() FML_EXCLUSIVE_LOCKS_REQUIRED(decode_mutex_);
+
+  // Keeps the pixels of a frame that was uploaded for a later decode, unless
+  // they are still referred to or enough pixels are kept already.
+  void RecycleBitmap(SkBitmap bitmap);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(State);
+};
+
+static SkImageInfo GetDecodeInfo(const SkCodec& codec) {
+  SkImageInfo info = codec.getInfo().makeColorType(kN32_SkColorType);
+  if (info.alphaType() == kUnpremul_SkAlphaType) {
+    info = info.makeAlphaType(kPremul_SkAlphaType);
   }
-  tonic::DartState::Scope scope(dart_state);
-  if (!frameInfo) {
-    tonic::DartInvoke(callback->value(), {Dart_Null()});
-  } else {
-    tonic::DartInvoke(callback->value(), {ToDart(frameInfo)});
+  return info;
+}
+
+MultiFrameCodec::State::State(
+    std::unique_ptr<SkCodec> codec,
+    std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner)
+    : codec_(std::move(codec)),
+      frame_infos_(codec_->getFrameInfo()),
+      frame_count_(codec_->getFrameCount()),
+      repetition_count_(codec_->getRepetitionCount()),
+      info_(GetDecodeInfo(*codec_)),
+      frame_bytes_(info_.computeMinByteSize()),
+      concurrent_task_runner_(std::move(concurrent_task_runner)),
+      prefetch_frame_count_(
+          concurrent_task_runner_ && frame_bytes_ > 0
+              ? std::min(kMaxPrefetchedFrameCount,
+                         gPrefetchByteLimit.load(std::memory_order_relaxed) /
+                             frame_bytes_)
+              : 0) {}
+
+MultiFrameCodec::State::~State() {
+  std::scoped_lock lock(frames_mutex_);
+  for (const auto& frame : decoded_frames_) {
+    if (!frame.bitmap.isNull()) {
+      ReleasePrefetchBytes(frame_bytes_);
+    }
   }
+  ReleasePrefetchBytes(free_bitmaps_.size() * frame_bytes_);
 }
 
-// Copied the source bitmap to the destination. If this cannot occur due to
-// running out of memory or the image info not being compatible, returns false.
-static bool CopyToBitmap(SkBitmap* dst,
-                         SkColorType dstColorType,
-                         const SkBitmap& src) {
-  SkPixmap srcPM;
-  if (!src.peekPixels(&srcPM)) {
+bool MultiFrameCodec::State::TakeDecodedFrame(DecodedFrame* frame) {
+  if (decoded_frames_.empty()) {
     return false;
   }
+  *frame = std::move(decoded_frames_.front());
+  decoded_frames_.pop_front();
+  if (!frame->bitmap.isNull()) {
+    ReleasePrefetchBytes(frame_bytes_);
+  }
+  return true;
+}
 
-  SkBitmap tmpDst;
-  SkImageInfo dstInfo = srcPM.info().makeColorType(dstColorType);
-  if (!tmpDst.setInfo(dstInfo)) {
-    return false;
+void MultiFrameCodec::State::PostPrefetchTask() {
+  // The runner runs the task right away once it is shut down, so this must
+  // not be called while holding any of the locks.
+  concurrent_task_runner_->PostTask([weak_state = weak_from_this()]() {
+    if (auto state = weak_state.lock()) {
+      state->Prefetch();
+    }
+  });
+}
+
+void MultiFrameCodec::State::Prefetch() {
+  TRACE_EVENT0("flutter", "MultiFrameCodec::Prefetch");
+  while (PrefetchNextFrame()) {
   }
+}
 
-  if (!tmpDst.tryAllocPixels()) {
-    return false;
+bool MultiFrameCodec::State::PrefetchNextFrame() {
+  // Only held for one frame, so that a request that finds no frame waiting
+  // doesn't wait for the others.
+  std::scoped_lock decode_lock(decode_mutex_);
+  {
+    std::scoped_lock lock(frames_mutex_);
+    if (decoded_frames_.size() >= prefetch_frame_count_ ||
+        !ReservePrefetchBytes(frame_bytes_)) {
+      prefetching_ = false;
+      return false;
+    }
+  }
+  DecodedFrame frame = DecodeNextFrame();
+  if (frame.bitmap.isNull()) {
+    ReleasePrefetchBytes(frame_bytes_);
   }
+  std::scoped_lock lock(frames_mutex_);
+  decoded_frames_.push_back(std::move(frame));
+  return true;
+}
 
-  SkPixmap dstPM;
-  if (!tmpDst.peekPixels(&dstPM)) {
+// Copies the pixels of |src| into those of |dst|. If the image infos are not
+// compatible, returns false.
+static bool CopyToBitmap(SkBitmap* dst, const SkBitmap& src) {
+  SkPixmap srcPM;
+  if (!src.peekPixels(&srcPM)) {
     return false;
   }
 
-  if (!srcPM.readPixels(dstPM)) {
+  SkPixmap dstPM;
+  if (!dst->peekPixels(&dstPM)) {
     return false;
   }
 
-  dst->swap(tmpDst);
-  return true;
+  return srcPM.readPixels(dstPM);
 }
 
-sk_sp<SkImage> MultiFrameCodec::GetNextFrameImage(
-    fml::WeakPtr<GrContext> resourceContext) {
-  SkBitmap bitmap = SkBitmap();
-  SkImageInfo info = codec_->getInfo().makeColorType(kN32_SkColorType);
-  if (info.alphaType() == kUnpremul_SkAlphaType) {
-    info = info.makeAlphaType(kPremul_SkAlphaType);
+DecodedFrame MultiFrameCodec::State::DecodeNextFrame() {
+  TRACE_EVENT0("flutter", "MultiFrameCodec::DecodeNextFrame");
+  const int index = next_decode_index_;
+  next_decode_index_ = (next_decode_index_ + 1) % frame_count_;
+
+  DecodedFrame result;
+
+  SkCodec::FrameInfo frameInfo = {};
+  if (static_cast<size_t>(index) < frame_infos_.size()) {
+    frameInfo = frame_infos_[index];
+  } else {
+    frameInfo.fRequiredFrame = SkCodec::kNoFrame;
+  }
+  result.duration = frameInfo.fDuration;
+
+  SkBitmap bitmap;
+  {
+    std::scoped_lock lock(frames_mutex_);
+    if (!free_bitmaps_.empty()) {
+      bitmap = std::move(free_bitmaps_.back());
+      free_bitmaps_.pop_back();
+      ReleasePrefetchBytes(frame_bytes_);
+    }
+  }
+  if (!bitmap.getPixels() && !bitmap.tryAllocPixels(info_)) {
+    FML_LOG(ERROR) << "Could not allocate the pixels of frame " << index;
+    return result;
   }
-  bitmap.allocPixels(info);
 
   SkCodec::Options options;
-  options.fFrameIndex = nextFrameIndex_;
-  SkCodec::FrameInfo frameInfo;
-  codec_->getFrameInfo(nextFrameIndex_, &frameInfo);
+  options.fFrameIndex = index;
   const int requiredFrameIndex = frameInfo.fRequiredFrame;
   if (requiredFrameIndex != SkCodec::kNoFrame) {
-    if (lastRequiredFrame_ == nullptr) {
-      FML_LOG(ERROR) << "Frame " << nextFrameIndex_ << " depends on frame "
+    if (last_required_frame_ == nullptr) {
+      FML_LOG(ERROR) << "Frame " << index << " depends on frame "
                      << requiredFrameIndex
                      << " and no required frames are cached.";
-      return nullptr;
-    } else if (lastRequiredFrameIndex_ != requiredFrameIndex) {
+      return result;
+    } else if (last_required_frame_index_ != requiredFrameIndex) {
       FML_DLOG(INFO) << "Required frame " << requiredFrameIndex
-                     << " is not cached. Using " << lastRequiredFrameIndex_
+                     << " is not cached. Using " << last_required_frame_index_
                      << " instead";
     }
 
-    if (lastRequiredFrame_->getPixels() &&
-        CopyToBitmap(&bitmap, lastRequiredFrame_->colorType(),
-                     *lastRequiredFrame_)) {
+    if (last_required_frame_->getPixels() &&
+        CopyToBitmap(&bitmap, *last_required_frame_)) {
       options.fPriorFrame = requiredFrameIndex;
     }
   }
 
-  if (SkCodec::kSuccess != codec_->getPixels(info, bitmap.getPixels(),
+  if (SkCodec::kSuccess != codec_->getPixels(info_, bitmap.getPixels(),
                                              bitmap.rowBytes(), &options)) {
-    FML_LOG(ERROR) << "Could not getPixels for frame " << nextFrameIndex_;
-    return nullptr;
+    FML_LOG(ERROR) << "Could not getPixels for frame " << index;
+    return result;
   }
 
-  // Hold onto this if we need it to decode future frames.
+  // Hold onto this if we need it to decode future frames. This shares the
+  // pixels, which keeps them from being recycled while they are needed.
   if (frameInfo.fDisposalMethod == SkCodecAnimation::DisposalMethod::kKeep) {
-    lastRequiredFrame_ = std::make_unique<SkBitmap>(bitmap);
-    lastRequiredFrameIndex_ = nextFrameIndex_;
+    last_required_frame_ = std::make_unique<SkBitmap>(bitmap);
+    last_required_frame_index_ = index;
+  }
+
+  result.bitmap = std::move(bitmap);
+  return result;
+}
+
+void MultiFrameCodec::State::RecycleBitmap(SkBitmap bitmap) {
+  // Only frames decoded by the IO thread and the prefetch task refer to the
+  // pixels, and they never take a new reference to a frame that was handed
+  // out. A reference that is dropped concurrently only keeps the pixels from
+  // being recycled this time.
+  if (!bitmap.pixelRef() || !bitmap.pixelRef()->unique()) {
+    return;
+  }
+  std::scoped_lock lock(frames_mutex_);
+  // Keep one frame around when decoding on demand, and no more than the frames
+  // allowed ahead of time otherwise.
+  if (decoded_frames_.size() + free_bitmaps_.size() <
+          std::max<size_t>(prefetch_frame_count_, 1) &&
+      ReservePrefetchBytes(frame_bytes_)) {
+    free_bitmaps_.push_back(std::move(bitmap));
+  }
+}
+
+sk_sp<SkImage> MultiFrameCodec::State::GetNextFrameImage(
+    fml::WeakPtr<GrContext> resourceContext,
+    int* duration) {
+  DecodedFrame frame;
+  bool decoded = false;
+  {
+    std::scoped_lock lock(frames_mutex_);
+    decoded = TakeDecodedFrame(&frame);
+  }
+
+  if (!decoded) {
+    std::scoped_lock decode_lock(decode_mutex_);
+    {
+      // The prefetch task may have decoded the frame while this waited for it.
+      std::scoped_lock lock(frames_mutex_);
+      decoded = TakeDecodedFrame(&frame);
+    }
+    if (!decoded) {
+      frame = DecodeNextFrame();
+    }
+  }
+
+  // Start decoding the frames after this one while it is uploaded.
+  bool post_prefetch = false;
+  {
+    std::scoped_lock lock(frames_mutex_);
+    if (!prefetching_ && prefetch_frame_count_ > 0) {
+      prefetching_ = true;
+      post_prefetch = true;
+    }
+  }
+  if (post_prefetch) {
+    PostPrefetchTask();
   }
 
+  *duration = frame.duration;
+  if (frame.bitmap.isNull()) {
+    return nullptr;
+  }
+
+  sk_sp<SkImage> image;
   if (resourceContext) {
-    SkPixmap pixmap(bitmap.info(), bitmap.pixelRef()->pixels(),
-                    bitmap.pixelRef()->rowBytes());
-    return SkImage::MakeCrossContextFromPixmap(resourceContext.get(), pixmap,
-                                               true);
+    SkPixmap pixmap(frame.bitmap.info(), frame.bitmap.pixelRef()->pixels(),
+                    frame.bitmap.pixelRef()->rowBytes());
+    image = SkImage::MakeCrossContextFromPixmap(resourceContext.get(), pixmap,
+                                                true);
   } else {
     // Defer decoding until time of draw later on the GPU thread. Can happen
     // when GL operations are currently forbidden such as in the background
     // on iOS.
-    return SkImage::MakeFromBitmap(bitmap);
+    image = SkImage::MakeFromBitmap(frame.bitmap);
+  }
+  RecycleBitmap(std::move(frame.bitmap));
+  return image;
+}
+
+void MultiFrameCodec::SetPrefetchByteLimit(size_t limit) {
+  gPrefetchByteLimit.store(limit, std::memory_order_relaxed);
+}
+
+size_t MultiFrameCodec::GetPrefetchedByteCount() {
+  return gPrefetchedBytes.load(std::memory_order_relaxed);
+}
+
+MultiFrameCodec::MultiFrameCodec(
+    std::unique_ptr<SkCodec> codec,
+    std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner)
+    : state_(std::make_shared<State>(std::move(codec),
+                                     std::move(concurrent_task_runner))),
+      frameCount_(state_->frame_count()),
+      repetitionCount_(state_->repetition_count()) {}
+
+MultiFrameCodec::~MultiFrameCodec() = default;
+
+sk_sp<SkImage> MultiFrameCodec::GetNextFrameImage(
+    fml::WeakPtr<GrContext> resourceContext,
+    int* duration) {
+  return state_->GetNextFrameImage(std::move(resourceContext), duration);
+}
+
+static void InvokeNextFrameCallback(
+    fml::RefPtr<FrameInfo> frameInfo,
+    std::unique_ptr<DartPersistentValue> callback,
+    size_t trace_id) {
+  std::shared_ptr<tonic::DartState> dart_state = callback->dart_state().lock();
+  if (!dart_state) {
+    FML_DLOG(ERROR) << "Could not acquire Dart state while attempting to fire "
+                       "next frame callback.";
+    return;
+  }
+  tonic::DartState::Scope scope(dart_state);
+  if (!frameInfo) {
+    tonic::DartInvoke(callback->value(), {Dart_Null()});
+  } else {
+    tonic::DartInvoke(callback->value(), {ToDart(frameInfo)});
   }
 }
 
 void MultiFrameCodec::GetNextFrameAndInvokeCallback(
+    State& state,
     std::unique_ptr<DartPersistentValue> callback,
     fml::RefPtr<fml::TaskRunner> ui_task_runner,
     fml::WeakPtr<GrContext> resourceContext,
     fml::RefPtr<flutter::SkiaUnrefQueue> unref_queue,
     size_t trace_id) {
   fml::RefPtr<FrameInfo> frameInfo = NULL;
-  sk_sp<SkImage> skImage = GetNextFrameImage(resourceContext);
+  int duration = 0;
+  sk_sp<SkImage> skImage = state.GetNextFrameImage(resourceContext, &duration);
   if (skImage) {
     fml::RefPtr<CanvasImage> image = CanvasImage::Create();
     image->set_image({skImage, std::move(unref_queue)});
-    SkCodec::FrameInfo skFrameInfo;
-    codec_->getFrameInfo(nextFrameIndex_, &skFrameInfo);
-    frameInfo =
-        fml::MakeRefCounted<FrameInfo>(std::move(image), skFrameInfo.fDuration);
+    frameInfo = fml::MakeRefCounted<FrameInfo>(std::move(image), duration);
   }
-  nextFrameIndex_ = (nextFrameIndex_ + 1) % frameCount_;
 
   ui_task_runner->PostTask(fml::MakeCopyable(
       [callback = std::move(callback), frameInfo, trace_id]() mutable {
@@ -166,10 +444,11 @@ Dart_Handle MultiFrameCodec::getNextFrame(Dart_Handle callback_handle) {
   task_runners.GetIOTaskRunner()->PostTask(fml::MakeCopyable(
       [callback = std::make_unique<DartPersistentValue>(
            tonic::DartState::Current(), callback_handle),
-       this, trace_id, ui_task_runner = task_runners.GetUITaskRunner(),
+       state = state_, trace_id,
+       ui_task_runner = task_runners.GetUITaskRunner(),
        queue = UIDartState::Current()->GetSkiaUnrefQueue(),
        context = dart_state->GetResourceContext()]() mutable {
-        GetNextFrameAndInvokeCallback(std::move(callback),
+        GetNextFrameAndInvokeCallback(*state, std::move(callback),
                                       std::move(ui_task_runner), context,
                                       std::move(queue), trace_id);
       }));
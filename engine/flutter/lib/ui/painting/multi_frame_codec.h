@@ -5,6 +5,9 @@
 #ifndef FLUTTER_LIB_UI_PAINTING_MUTLI_FRAME_CODEC_H_
 #define FLUTTER_LIB_UI_PAINTING_MUTLI_FRAME_CODEC_H_
 
+#include <memory>
+
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/lib/ui/painting/codec.h"
 
@@ -12,7 +15,28 @@ namespace flutter {
 
 class MultiFrameCodec : public Codec {
  public:
-  MultiFrameCodec(std::unique_ptr<SkCodec> codec);
+  // The most frames decoded ahead of the one requested last.
+  static constexpr size_t kMaxPrefetchedFrameCount = 3;
+
+  // The default limit on the memory taken by the frames that all the codecs
+  // of the process decoded ahead of time or keep for later decodes.
+  static constexpr size_t kDefaultPrefetchByteLimit = 16 * 1024 * 1024;
+
+  // Sets the limit shared by all the codecs. Codecs created afterwards whose
+  // frames don't fit decode on demand. Frames already held are kept.
+  static void SetPrefetchByteLimit(size_t limit);
+
+  // The memory currently taken by the frames counted against the limit.
+  static size_t GetPrefetchedByteCount();
+
+  // The frames following the one requested last are decoded ahead of time on
+  // |concurrent_task_runner| while they fit in the limit shared by all the
+  // codecs. Without a runner, or if a single frame doesn't fit, frames are
+  // decoded when they are requested, on the IO thread.
+  explicit MultiFrameCodec(
+      std::unique_ptr<SkCodec> codec,
+      std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner =
+          nullptr);
 
   ~MultiFrameCodec() override;
 
@@ -25,20 +49,23 @@ class MultiFrameCodec : public Codec {
   // |Codec|
   Dart_Handle getNextFrame(Dart_Handle args) override;
 
+  // Returns the next frame and sets |duration| to its duration, as
+  // |getNextFrame| does on the IO thread. Exposed for testing.
+  sk_sp<SkImage> GetNextFrameImage(fml::WeakPtr<GrContext> resourceContext,
+                                   int* duration);
+
  private:
-  const std::unique_ptr<SkCodec> codec_;
+  // The decoder and the frames decoded ahead of time. Shared with the tasks
+  // decoding the frames, which may outlive the codec.
+  class State;
+
+  const std::shared_ptr<State> state_;
   const int frameCount_;
   const int repetitionCount_;
-  int nextFrameIndex_;
-
-  // The last decoded frame that's required to decode any subsequent frames.
-  std::unique_ptr<SkBitmap> lastRequiredFrame_;
-  // The index of the last decoded required frame.
-  int lastRequiredFrameIndex_ = -1;
-
-  sk_sp<SkImage> GetNextFrameImage(fml::WeakPtr<GrContext> resourceContext);
 
-  void GetNextFrameAndInvokeCallback(
+  // Runs on the IO thread.
+  static void GetNextFrameAndInvokeCallback(
+      State& state,
       std::unique_ptr<DartPersistentValue> callback,
       fml::RefPtr<fml::TaskRunner> ui_task_runner,
       fml::WeakPtr<GrContext> resourceContext,
@@ -0,0 +1,122 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/lib/ui/painting/multi_frame_codec.h"
+
+#include "flutter/fml/concurrent_message_loop.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/synchronization/waitable_event.h"
+#include "flutter/testing/testing.h"
+#include "third_party/skia/include/codec/SkCodec.h"
+
+namespace flutter {
+namespace testing {
+
+// FourFrames.gif is an 8x8 image looping over red, green, blue and white
+// frames, which last 20, 30, 40 and 50 milliseconds.
+static constexpr size_t kFixtureFrameCount = 4;
+static constexpr SkColor kFixtureColors[kFixtureFrameCount] = {
+    SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE, SK_ColorWHITE};
+static constexpr int kFixtureDurations[kFixtureFrameCount] = {20, 30, 40, 50};
+static constexpr size_t kFixtureFrameBytes = 8 * 8 * 4;
+
+static std::unique_ptr<SkCodec> OpenFixtureAsCodec(const char* name) {
+  auto fixtures_directory =
+      fml::OpenDirectory(GetFixturesPath(), false, fml::FilePermission::kRead);
+  auto mapping = fml::FileMapping::CreateReadOnly(fixtures_directory, name);
+  if (!mapping) {
+    return nullptr;
+  }
+  return SkCodec::MakeFromData(
+      SkData::MakeWithCopy(mapping->GetMapping(), mapping->GetSize()));
+}
+
+// Checks that the next frame of |codec| is frame |index| of the fixture.
+static void ExpectNextFrame(MultiFrameCodec& codec, size_t index) {
+  int duration = 0;
+  auto image = codec.GetNextFrameImage({}, &duration);
+  ASSERT_TRUE(image);
+  ASSERT_EQ(duration, kFixtureDurations[index % kFixtureFrameCount]);
+  SkPixmap pixels;
+  ASSERT_TRUE(image->peekPixels(&pixels));
+  ASSERT_EQ(pixels.getColor(4, 4), kFixtureColors[index % kFixtureFrameCount]);
+}
+
+// Waits for the tasks posted to the single worker of |loop| so far.
+static void WaitForWorker(fml::ConcurrentMessageLoop& loop) {
+  fml::AutoResetWaitableEvent latch;
+  loop.GetTaskRunner()->PostTask([&latch]() { latch.Signal(); });
+  latch.Wait();
+}
+
+TEST(MultiFrameCodecTest, FramesDecodedAheadOfTimeAreReturnedInOrder) {
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto codec = fml::MakeRefCounted<MultiFrameCodec>(
+      OpenFixtureAsCodec("FourFrames.gif"), loop->GetTaskRunner());
+  ASSERT_EQ(codec->frameCount(), static_cast<int>(kFixtureFrameCount));
+
+  // The first frame is decoded on demand, the following ones ahead of time.
+  ExpectNextFrame(*codec, 0);
+  WaitForWorker(*loop);
+  ASSERT_EQ(MultiFrameCodec::GetPrefetchedByteCount(),
+            MultiFrameCodec::kMaxPrefetchedFrameCount * kFixtureFrameBytes);
+
+  for (size_t i = 1; i < kFixtureFrameCount * 3; i++) {
+    ExpectNextFrame(*codec, i);
+    WaitForWorker(*loop);
+  }
+
+  codec = nullptr;
+  ASSERT_EQ(MultiFrameCodec::GetPrefetchedByteCount(), 0u);
+}
+
+TEST(MultiFrameCodecTest, RequestsRacingThePrefetchGetFramesInOrder) {
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  auto codec = fml::MakeRefCounted<MultiFrameCodec>(
+      OpenFixtureAsCodec("FourFrames.gif"), loop->GetTaskRunner());
+
+  // Requests find frames waiting, being decoded, or not decoded yet.
+  for (size_t i = 0; i < kFixtureFrameCount * 50; i++) {
+    ExpectNextFrame(*codec, i);
+  }
+
+  codec = nullptr;
+  // Joins the workers, which may still be running a prefetch task.
+  loop.reset();
+  ASSERT_EQ(MultiFrameCodec::GetPrefetchedByteCount(), 0u);
+}
+
+TEST(MultiFrameCodecTest, CodecsShareThePrefetchByteLimit) {
+  MultiFrameCodec::SetPrefetchByteLimit(2 * kFixtureFrameBytes);
+  auto loop = fml::ConcurrentMessageLoop::Create(1);
+  auto first_codec = fml::MakeRefCounted<MultiFrameCodec>(
+      OpenFixtureAsCodec("FourFrames.gif"), loop->GetTaskRunner());
+  auto second_codec = fml::MakeRefCounted<MultiFrameCodec>(
+      OpenFixtureAsCodec("FourFrames.gif"), loop->GetTaskRunner());
+
+  ExpectNextFrame(*first_codec, 0);
+  WaitForWorker(*loop);
+  ASSERT_EQ(MultiFrameCodec::GetPrefetchedByteCount(), 2 * kFixtureFrameBytes);
+
+  // The second codec decodes on demand while the first one holds the budget.
+  for (size_t i = 0; i < kFixtureFrameCount; i++) {
+    ExpectNextFrame(*second_codec, i);
+    WaitForWorker(*loop);
+    ASSERT_LE(MultiFrameCodec::GetPrefetchedByteCount(),
+              2 * kFixtureFrameBytes);
+  }
+  ExpectNextFrame(*first_codec, 1);
+
+  first_codec = nullptr;
+  second_codec = nullptr;
+  MultiFrameCodec::SetPrefetchByteLimit(
+      MultiFrameCodec::kDefaultPrefetchByteLimit);
+  // Joins the workers, which may still be running a prefetch task.
+  loop.reset();
+  ASSERT_EQ(MultiFrameCodec::GetPrefetchedByteCount(), 0u);
+}
+
+}  // namespace testing
+}  // namespace flutter
@@ -5,9 +5,11 @@
 #ifndef FLUTTER_LIB_UI_PLATFORM_PLATFORM_MESSAGE_H_
 #define FLUTTER_LIB_UI_PLATFORM_PLATFORM_MESSAGE_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "flutter/fml/mapping.h"
 #include "flutter/fml/memory/ref_counted.h"
 #include "flutter/fml/memory/ref_ptr.h"
 #include "flutter/lib/ui/window/platform_message_response.h"
@@ -20,7 +22,8 @@ class PlatformMessage : public fml::RefCountedThreadSafe<PlatformMessage> {
 
  public:
   const std::string& channel() const { return channel_; }
-  const std::vector<uint8_t>& data() const { return data_; }
+  // The payload of the message, which is empty if |hasData| is false.
+  const fml::Mapping& data() const { return *data_; }
   bool hasData() { return hasData_; }
 
   const fml::RefPtr<PlatformMessageResponse>& response() const {
@@ -28,6 +31,12 @@ class PlatformMessage : public fml::RefCountedThreadSafe<PlatformMessage> {
   }
 
  private:
+  // The payload is passed along without being copied, whether it is owned,
+  // mapped from a file or released through a callback of a
+  // |fml::NonOwnedMapping|.
+  PlatformMessage(std::string channel,
+                  std::unique_ptr<fml::Mapping> data,
+                  fml::RefPtr<PlatformMessageResponse> response);
   PlatformMessage(std::string channel,
                   std::vector<uint8_t> data,
                   fml::RefPtr<PlatformMessageResponse> response);
@@ -36,7 +45,7 @@ class PlatformMessage : public fml::RefCountedThreadSafe<PlatformMessage> {
   ~PlatformMessage();
 
   std::string channel_;
-  std::vector<uint8_t> data_;
+  std::unique_ptr<fml::Mapping> data_;
   bool hasData_;
   fml::RefPtr<PlatformMessageResponse> response_;
 };
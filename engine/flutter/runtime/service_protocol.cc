@@ -31,6 +31,8 @@ const std::string_view ServiceProtocol::kSetAssetBundlePathExtensionName =
     "_flutter.setAssetBundlePath";
 const std::string_view ServiceProtocol::kGetDisplayRefreshRateExtensionName =
     "_flutter.getDisplayRefreshRate";
+const std::string_view ServiceProtocol::kGetFrameTimingStatsExtensionName =
+    "_flutter.getFrameTimingStats";
 
 static constexpr std::string_view kViewIdPrefx = "_flutterView/";
 static constexpr std::string_view kListViewsExtensionName =
@@ -48,6 +50,7 @@ ServiceProtocol::ServiceProtocol()
           kFlushUIThreadTasksExtensionName,
           kSetAssetBundlePathExtensionName,
           kGetDisplayRefreshRateExtensionName,
+          kGetFrameTimingStatsExtensionName,
       }),
       handlers_mutex_(fml::SharedMutex::Create()) {}
 
@@ -126,6 +126,10 @@ void Engine::ReportTimings(std::vector<int64_t> timings) {
   runtime_controller_->ReportTimings(std::move(timings));
 }
 
+void Engine::OnFrameRasterized(const FrameTiming& timing) {
+  animator_->OnFrameRasterized(timing);
+}
+
 void Engine::NotifyIdle(int64_t deadline) {
   TRACE_EVENT1("flutter", "Engine::NotifyIdle", "deadline_now_delta",
                std::to_string(deadline).c_str());
@@ -181,7 +185,8 @@ void Engine::DispatchPlatformMessage(fml::RefPtr<PlatformMessage> message) {
 
 bool Engine::HandleLifecyclePlatformMessage(PlatformMessage* message) {
   const auto& data = message->data();
-  std::string state(reinterpret_cast<const char*>(data.data()), data.size());
+  std::string state(reinterpret_cast<const char*>(data.GetMapping()),
+                    data.GetSize());
   if (state == "AppLifecycleState.paused" ||
       state == "AppLifecycleState.suspending") {
     activity_running_ = false;
@@ -214,7 +219,8 @@ bool Engine::HandleLocalizationPlatformMessage(PlatformMessage* message) {
 
 void Engine::HandleSettingsPlatformMessage(PlatformMessage* message) {
   const auto& data = message->data();
-  std::string jsonData(reinterpret_cast<const char*>(data.data()), data.size());
+  std::string jsonData(reinterpret_cast<const char*>(data.GetMapping()),
+                       data.GetSize());
   if (runtime_controller_->SetUserSettingsData(std::move(jsonData)) &&
       have_surface_) {
     ScheduleFrame();
@@ -323,7 +323,13 @@ void Shell::NotifyLowMemoryWarning() const {
         }
       });
   // The IO Manager uses resource cache limits of 0, so it is not necessary
-  // to purge them.
+  // to purge them. The decoded images it keeps are released though.
+  task_runners_.GetIOTaskRunner()->PostTask(
+      [io_manager = io_manager_->GetWeakPtr()]() {
+        if (io_manager) {
+          io_manager->NotifyLowMemoryWarning();
+        }
+      });
 }
 
 void Shell::RunEngine(RunConfiguration run_configuration) {
@@ -844,6 +850,14 @@ void Shell::OnFrameRasterized(const FrameTiming& timing) {
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetGPUTaskRunner()->RunsTasksOnCurrentThread());
 
+  // The animator schedules the next frames from the timing of every frame.
+  task_runners_.GetUITaskRunner()->PostTask(
+      [timing, engine = weak_engine_]() {
+        if (engine) {
+          engine->OnFrameRasterized(timing);
+        }
+      });
+
   // The C++ callback defined in settings.h and set by Flutter runner. This is
   // independent of the timings report to the Dart side.
   if (settings_.frame_rasterized_callback) {
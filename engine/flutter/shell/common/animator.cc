@@ -25,6 +25,7 @@ Animator::Animator(Delegate& delegate,
       task_runners_(std::move(task_runners)),
       waiter_(std::move(waiter)),
       last_begin_frame_time_(),
+      last_build_start_time_(),
       dart_frame_deadline_(0),
       // TODO(dnfield): We should remove this logic and set the pipeline depth
       // back to 2 in this case. See https://github.com/flutter/engine/pull/9132
@@ -41,7 +42,10 @@ Animator::Animator(Delegate& delegate,
       frame_scheduled_(false),
       notify_idle_task_id_(0),
       dimension_change_pending_(false),
-      weak_factory_(this) {}
+      weak_factory_(this) {
+  frame_deadline_predictor_.SetReportedRefreshRate(
+      waiter_->GetDisplayRefreshRate());
+}
 
 Animator::~Animator() = default;
 
@@ -79,6 +83,10 @@ void Animator::EnqueueTraceFlowId(uint64_t trace_flow_id) {
       });
 }
 
+void Animator::OnFrameRasterized(const FrameTiming& timing) {
+  frame_deadline_predictor_.AddFrameTiming(timing);
+}
+
 // This Parity is used by the timeline component to correctly align
 // GPU Workloads events with their respective Framework Workload.
 const char* Animator::FrameParity() {
@@ -93,6 +101,8 @@ static int64_t FxlToDartOrEarlier(fml::TimePoint time) {
 
 void Animator::BeginFrame(fml::TimePoint frame_start_time,
                           fml::TimePoint frame_target_time) {
+  // The build starts now, which may be well after the vsync of the frame.
+  fml::TimePoint build_start_time = fml::TimePoint::Now();
   TRACE_EVENT_ASYNC_END0("flutter", "Frame Request Pending", frame_number_++);
 
   TRACE_EVENT0("flutter", "Animator::BeginFrame");
@@ -127,6 +137,7 @@ void Animator::BeginFrame(fml::TimePoint frame_start_time,
   FML_DCHECK(producer_continuation_);
 
   last_begin_frame_time_ = frame_start_time;
+  last_build_start_time_ = build_start_time;
   dart_frame_deadline_ = FxlToDartOrEarlier(frame_target_time);
   {
     TRACE_EVENT2("flutter", "Framework Workload", "mode", "basic", "frame",
@@ -162,6 +173,31 @@ void Animator::BeginFrame(fml::TimePoint frame_start_time,
   }
 }
 
+void Animator::ScheduleBeginFrame(fml::TimePoint frame_start_time,
+                                  fml::TimePoint frame_target_time) {
+  frame_deadline_predictor_.AddVsync(frame_start_time);
+  fml::TimeDelta delay = frame_deadline_predictor_.GetBeginFrameDelay(
+      frame_start_time, frame_target_time);
+  fml::TimePoint begin_time = frame_start_time + delay;
+  if (delay == fml::TimeDelta::Zero() || begin_time <= fml::TimePoint::Now()) {
+    BeginFrame(frame_start_time, frame_target_time);
+    return;
+  }
+
+  // The frame keeps the time of its vsync, only its work starts later. Its
+  // pending frame semaphore is held until then, so frame requests made in the
+  // meantime are satisfied by this frame.
+  TRACE_EVENT_INSTANT0("flutter", "BeginFrameDelayedToDeadline");
+  task_runners_.GetUITaskRunner()->PostTaskForTime(
+      [self = weak_factory_.GetWeakPtr(), frame_start_time,
+       frame_target_time]() {
+        if (self) {
+          self->BeginFrame(frame_start_time, frame_target_time);
+        }
+      },
+      begin_time);
+}
+
 void Animator::Render(std::unique_ptr<flutter::LayerTree> layer_tree) {
   if (dimension_change_pending_ &&
       layer_tree->frame_size() != last_layer_tree_size_) {
@@ -171,7 +207,7 @@ void Animator::Render(std::unique_ptr<flutter::LayerTree> layer_tree) {
 
   if (layer_tree) {
     // Note the frame time for instrumentation.
-    layer_tree->RecordBuildTime(last_begin_frame_time_);
+    layer_tree->RecordBuildTime(last_begin_frame_time_, last_build_start_time_);
   }
 
   // Commit the pending continuation.
@@ -229,7 +265,7 @@ void Animator::AwaitVSync() {
           if (self->CanReuseLastLayerTree()) {
             self->DrawLastLayerTree();
           } else {
-            self->BeginFrame(frame_start_time, frame_target_time);
+            self->ScheduleBeginFrame(frame_start_time, frame_target_time);
           }
         }
       });
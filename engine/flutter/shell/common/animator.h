@@ -12,6 +12,7 @@
 #include "flutter/fml/memory/weak_ptr.h"
 #include "flutter/fml/synchronization/semaphore.h"
 #include "flutter/fml/time/time_point.h"
+#include "flutter/shell/common/frame_deadline_predictor.h"
 #include "flutter/shell/common/pipeline.h"
 #include "flutter/shell/common/rasterizer.h"
 #include "flutter/shell/common/vsync_waiter.h"
@@ -62,12 +63,21 @@ class Animator final {
   // will be ended during the next |BeginFrame|.
   void EnqueueTraceFlowId(uint64_t trace_flow_id);
 
+  // Learns how long frames take from the timing of a rasterized frame, to
+  // begin the next frames just in time for their vsync.
+  void OnFrameRasterized(const FrameTiming& timing);
+
  private:
   using LayerTreePipeline = Pipeline<flutter::LayerTree>;
 
   void BeginFrame(fml::TimePoint frame_start_time,
                   fml::TimePoint frame_target_time);
 
+  // Begins the frame of a vsync, later than the vsync if the frame is
+  // predicted to be done before its target time anyway.
+  void ScheduleBeginFrame(fml::TimePoint frame_start_time,
+                          fml::TimePoint frame_target_time);
+
   bool CanReuseLastLayerTree();
   void DrawLastLayerTree();
 
@@ -79,7 +89,9 @@ class Animator final {
   TaskRunners task_runners_;
   std::shared_ptr<VsyncWaiter> waiter_;
 
+  // The vsync time of the last frame begun, and when it was begun.
   fml::TimePoint last_begin_frame_time_;
+  fml::TimePoint last_build_start_time_;
   int64_t dart_frame_deadline_;
   fml::RefPtr<LayerTreePipeline> layer_tree_pipeline_;
   fml::Semaphore pending_frame_semaphore_;
@@ -92,6 +104,7 @@ class Animator final {
   bool dimension_change_pending_;
   SkISize last_layer_tree_size_;
   std::deque<uint64_t> trace_flow_ids_;
+  FrameDeadlinePredictor frame_deadline_predictor_;
 
   fml::WeakPtrFactory<Animator> weak_factory_;
 
@@ -373,6 +373,17 @@ class Engine final : public RuntimeDelegate {
   void BeginFrame(fml::TimePoint frame_time);
 
   void ReportTimings(std::vector<int64_t> timings);
+
+  //----------------------------------------------------------------------------
+  /// @brief      Notifies the engine that a frame was rasterized. Unlike
+  ///             `Engine::ReportTimings`, this is done for every frame, even
+  ///             when the Dart code is not interested in the timings, so that
+  ///             the animator can begin the next frames just in time for
+  ///             their vsync.
+  ///
+  /// @param[in]  timing  The timing of the rasterized frame.
+  ///
+  void OnFrameRasterized(const FrameTiming& timing);
   //----------------------------------------------------------------------------
   /// @brief      Notifies the engine that the UI task runner is not expected to
   ///             undertake a new frame workload till a specified timepoint. The
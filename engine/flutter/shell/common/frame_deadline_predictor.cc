@@ -0,0 +1,142 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/frame_deadline_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#include "flutter/shell/common/vsync_waiter.h"
+
+namespace flutter {
+
+namespace {
+
+// The refresh rate reported by the display is trusted until this many
+// successive vsyncs were seen.
+constexpr size_t kMinVsyncIntervalCount = 3;
+
+void AddSample(std::deque<fml::TimeDelta>& samples, fml::TimeDelta sample) {
+  samples.push_back(sample);
+  if (samples.size() > FrameDeadlinePredictor::kWindowSize) {
+    samples.pop_front();
+  }
+}
+
+fml::TimeDelta GetPercentile(const std::deque<fml::TimeDelta>& samples,
+                             double percentile) {
+  if (samples.empty()) {
+    return fml::TimeDelta::Zero();
+  }
+  std::vector<fml::TimeDelta> sorted(samples.begin(), samples.end());
+  size_t rank =
+      static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+  size_t index = std::clamp<size_t>(rank, 1, sorted.size()) - 1;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+}  // namespace
+
+FrameDeadlinePredictor::FrameDeadlinePredictor()
+    : reported_refresh_rate_(VsyncWaiter::kUnknownRefreshRateFPS) {
+  Reset();
+}
+
+FrameDeadlinePredictor::~FrameDeadlinePredictor() = default;
+
+void FrameDeadlinePredictor::SetReportedRefreshRate(float refresh_rate) {
+  reported_refresh_rate_ = refresh_rate;
+  UpdateRefreshInterval();
+}
+
+void FrameDeadlinePredictor::AddVsync(fml::TimePoint frame_start_time) {
+  fml::TimePoint last_vsync_time = last_vsync_time_;
+  last_vsync_time_ = frame_start_time;
+  if (last_vsync_time == fml::TimePoint()) {
+    return;
+  }
+  fml::TimeDelta interval = frame_start_time - last_vsync_time;
+  if (interval <= fml::TimeDelta::Zero() || interval > kMaxRefreshInterval) {
+    return;
+  }
+  AddSample(vsync_intervals_, interval);
+  UpdateRefreshInterval();
+}
+
+void FrameDeadlinePredictor::AddFrameTiming(const FrameTiming& timing) {
+  fml::TimeDelta build_duration = timing.Get(FrameTiming::kBuildFinish) -
+                                  timing.Get(FrameTiming::kBuildStart);
+  fml::TimeDelta raster_duration = timing.Get(FrameTiming::kRasterFinish) -
+                                   timing.Get(FrameTiming::kBuildFinish);
+
+  AddSample(build_durations_, std::max(build_duration, fml::TimeDelta()));
+  AddSample(raster_durations_, std::max(raster_duration, fml::TimeDelta()));
+  UpdatePredictedFrameDuration();
+}
+
+fml::TimeDelta FrameDeadlinePredictor::GetRefreshInterval() const {
+  return refresh_interval_;
+}
+
+fml::TimeDelta FrameDeadlinePredictor::GetPredictedFrameDuration() const {
+  return predicted_frame_duration_;
+}
+
+fml::TimeDelta FrameDeadlinePredictor::GetBeginFrameDelay(
+    fml::TimePoint frame_start_time,
+    fml::TimePoint frame_target_time) const {
+  if (build_durations_.size() < kMinFrameCount) {
+    return fml::TimeDelta::Zero();
+  }
+  fml::TimePoint deadline = frame_target_time > frame_start_time
+                                ? frame_target_time
+                                : frame_start_time + refresh_interval_;
+  fml::TimeDelta slack = deadline - frame_start_time -
+                         predicted_frame_duration_ - kSafetyMargin;
+  return std::max(slack, fml::TimeDelta::Zero());
+}
+
+void FrameDeadlinePredictor::Reset() {
+  last_vsync_time_ = fml::TimePoint();
+  vsync_intervals_.clear();
+  build_durations_.clear();
+  raster_durations_.clear();
+  predicted_frame_duration_ = fml::TimeDelta::Zero();
+  UpdateRefreshInterval();
+}
+
+void FrameDeadlinePredictor::UpdateRefreshInterval() {
+  if (vsync_intervals_.size() >= kMinVsyncIntervalCount) {
+    // Half a refresh interval of tolerance tells a skipped vsync from jitter.
+    fml::TimeDelta shortest =
+        *std::min_element(vsync_intervals_.begin(), vsync_intervals_.end());
+    std::deque<fml::TimeDelta> intervals;
+    std::copy_if(vsync_intervals_.begin(), vsync_intervals_.end(),
+                 std::back_inserter(intervals),
+                 [limit = shortest * 3 / 2](fml::TimeDelta interval) {
+                   return interval <= limit;
+                 });
+    refresh_interval_ = GetPercentile(intervals, 50);
+  } else if (reported_refresh_rate_ > VsyncWaiter::kUnknownRefreshRateFPS) {
+    refresh_interval_ =
+        fml::TimeDelta::FromSecondsF(1.0 / reported_refresh_rate_);
+  } else {
+    refresh_interval_ = kDefaultRefreshInterval;
+  }
+}
+
+void FrameDeadlinePredictor::UpdatePredictedFrameDuration() {
+  if (build_durations_.size() < kMinFrameCount) {
+    predicted_frame_duration_ = fml::TimeDelta::Zero();
+    return;
+  }
+  predicted_frame_duration_ =
+      GetPercentile(build_durations_, kDurationPercentile) +
+      GetPercentile(raster_durations_, kDurationPercentile);
+}
+
+}  // namespace flutter
@@ -0,0 +1,109 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_COMMON_FRAME_DEADLINE_PREDICTOR_H_
+#define FLUTTER_SHELL_COMMON_FRAME_DEADLINE_PREDICTOR_H_
+
+#include <deque>
+
+#include "flutter/common/settings.h"
+#include "flutter/fml/macros.h"
+#include "flutter/fml/time/time_delta.h"
+#include "flutter/fml/time/time_point.h"
+
+namespace flutter {
+
+/// Predicts how long the next frame will take from the timings of the recent
+/// frames, so that the |Animator| can begin it as late as possible while still
+/// finishing its rasterization before the vsync it targets. Beginning later
+/// lets the frame pick up more recent input, which lowers the latency between
+/// an input event and the frame that shows it.
+///
+/// The refresh interval is learned from the time between successive vsyncs,
+/// and only falls back to the refresh rate reported by the display when too
+/// few vsyncs followed each other.
+///
+/// Not thread safe, the |Animator| uses it on the UI thread.
+class FrameDeadlinePredictor {
+ public:
+  // The number of recent frames and vsyncs the predictions are made from.
+  static constexpr size_t kWindowSize = 60;
+
+  // No frame is delayed before this many frames were timed.
+  static constexpr size_t kMinFrameCount = 10;
+
+  // The percentile of the recent build and raster durations that the next
+  // frame is expected to fit in.
+  static constexpr double kDurationPercentile = 90;
+
+  // How long before its deadline a frame is predicted to finish.
+  static constexpr fml::TimeDelta kSafetyMargin =
+      fml::TimeDelta::FromMilliseconds(2);
+
+  // The interval assumed when neither the vsyncs nor the display told it.
+  static constexpr fml::TimeDelta kDefaultRefreshInterval =
+      fml::TimeDelta::FromMicroseconds(16667);
+
+  // Vsyncs further apart than this did not follow each other, no frame was
+  // requested in between.
+  static constexpr fml::TimeDelta kMaxRefreshInterval =
+      fml::TimeDelta::FromMilliseconds(100);
+
+  FrameDeadlinePredictor();
+
+  ~FrameDeadlinePredictor();
+
+  // Sets the refresh rate reported by the display, or
+  // |VsyncWaiter::kUnknownRefreshRateFPS|.
+  void SetReportedRefreshRate(float refresh_rate);
+
+  // Records the start time of a vsync.
+  void AddVsync(fml::TimePoint frame_start_time);
+
+  // Records the timing of a rasterized frame. Its build starts when its frame
+  // was begun, not at its vsync.
+  void AddFrameTiming(const FrameTiming& timing);
+
+  // The median interval between the recent vsyncs that followed each other.
+  // The vsyncs skipped while a frame was late make some intervals a multiple
+  // of the refresh interval, only the intervals close to the shortest one
+  // count.
+  fml::TimeDelta GetRefreshInterval() const;
+
+  // The time from the beginning of a frame to the end of its rasterization
+  // that the next frame is expected to need, including the time it waits for
+  // the GPU thread. Zero until |kMinFrameCount| frames were timed.
+  fml::TimeDelta GetPredictedFrameDuration() const;
+
+  // How long after |frame_start_time| the frame should begin to finish
+  // |kSafetyMargin| before |frame_target_time|. Zero when the frame is not
+  // expected to fit in the time left or too few frames were timed.
+  fml::TimeDelta GetBeginFrameDelay(fml::TimePoint frame_start_time,
+                                    fml::TimePoint frame_target_time) const;
+
+  // Forgets the recent frames and vsyncs, e.g. when the frames become
+  // different.
+  void Reset();
+
+ private:
+  float reported_refresh_rate_;
+  fml::TimePoint last_vsync_time_;
+  // The intervals between successive vsyncs.
+  std::deque<fml::TimeDelta> vsync_intervals_;
+  std::deque<fml::TimeDelta> build_durations_;
+  // From the end of the build to the end of the rasterization.
+  std::deque<fml::TimeDelta> raster_durations_;
+  fml::TimeDelta refresh_interval_;
+  fml::TimeDelta predicted_frame_duration_;
+
+  void UpdateRefreshInterval();
+
+  void UpdatePredictedFrameDuration();
+
+  FML_DISALLOW_COPY_AND_ASSIGN(FrameDeadlinePredictor);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_COMMON_FRAME_DEADLINE_PREDICTOR_H_
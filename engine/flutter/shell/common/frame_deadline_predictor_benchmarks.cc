@@ -0,0 +1,119 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/shell/common/frame_deadline_predictor.h"
+
+namespace flutter {
+
+namespace {
+
+constexpr size_t kSimulatedFrameCount = 600;
+
+// The refresh rate the simulated display reports, whatever its actual rate.
+constexpr float kReportedRefreshRate = 60;
+
+struct FrameSchedulingStats {
+  fml::TimeDelta total_latency;
+  size_t missed_frame_count = 0;
+  fml::TimeDelta refresh_interval;
+};
+
+// Simulates |kSimulatedFrameCount| frames on a display refreshing every
+// |refresh_interval|, on a simulated clock so that the results do not depend
+// on the load of the machine. The frames take 2 to 4 ms to build and 2 to 5 ms
+// to rasterize, with a spike every 30 frames. The latency of a frame runs from
+// when it is begun, and reads its input, to the vsync that displays it.
+FrameSchedulingStats SimulateFrames(fml::TimeDelta refresh_interval,
+                                    bool delay_begin_frame) {
+  FrameDeadlinePredictor predictor;
+  predictor.SetReportedRefreshRate(kReportedRefreshRate);
+  std::mt19937 random(0);
+  std::uniform_int_distribution<int64_t> build_us(2000, 4000);
+  std::uniform_int_distribution<int64_t> raster_us(2000, 5000);
+
+  FrameSchedulingStats stats;
+  fml::TimePoint vsync_time =
+      fml::TimePoint::FromEpochDelta(fml::TimeDelta::FromSeconds(1));
+  fml::TimePoint ui_idle_time = vsync_time;
+  fml::TimePoint gpu_idle_time = vsync_time;
+  for (size_t i = 0; i < kSimulatedFrameCount; i++) {
+    // A frame is only requested once the previous one was built.
+    while (vsync_time < ui_idle_time) {
+      vsync_time = vsync_time + refresh_interval;
+    }
+    fml::TimePoint target_time = vsync_time + refresh_interval;
+    predictor.AddVsync(vsync_time);
+    fml::TimeDelta delay = delay_begin_frame ? predictor.GetBeginFrameDelay(
+                                                   vsync_time, target_time)
+                                             : fml::TimeDelta::Zero();
+
+    FrameTiming timing;
+    fml::TimePoint build_start = vsync_time + delay;
+    fml::TimeDelta spike = fml::TimeDelta::FromMilliseconds(i % 30 ? 0 : 6);
+    timing.Set(FrameTiming::kBuildStart, build_start);
+    timing.Set(FrameTiming::kBuildFinish,
+               build_start + fml::TimeDelta::FromMicroseconds(
+                                 build_us(random)));
+    timing.Set(FrameTiming::kRasterStart,
+               std::max(timing.Get(FrameTiming::kBuildFinish), gpu_idle_time));
+    timing.Set(FrameTiming::kRasterFinish,
+               timing.Get(FrameTiming::kRasterStart) +
+                   fml::TimeDelta::FromMicroseconds(raster_us(random)) +
+                   spike);
+    predictor.AddFrameTiming(timing);
+    ui_idle_time = timing.Get(FrameTiming::kBuildFinish);
+    gpu_idle_time = timing.Get(FrameTiming::kRasterFinish);
+
+    fml::TimePoint display_time = target_time;
+    while (display_time < gpu_idle_time) {
+      display_time = display_time + refresh_interval;
+    }
+    if (display_time > target_time) {
+      stats.missed_frame_count++;
+    }
+    stats.total_latency = stats.total_latency + (display_time - build_start);
+    vsync_time = vsync_time + refresh_interval;
+  }
+  stats.refresh_interval = predictor.GetRefreshInterval();
+  return stats;
+}
+
+}  // namespace
+
+// Schedules frames on a display refreshing |state.range(0)| times a second,
+// beginning them at their vsync if |state.range(1)| is 0 or just in time for
+// their deadline otherwise. The time measured is the cost of the predictions,
+// the label tells the latency and the frames that missed their vsync.
+static void BM_FrameDeadlinePredictorScheduling(benchmark::State& state) {
+  fml::TimeDelta refresh_interval =
+      fml::TimeDelta::FromSecondsF(1.0 / state.range(0));
+  bool delay_begin_frame = state.range(1) != 0;
+  FrameSchedulingStats stats;
+  while (state.KeepRunning()) {
+    stats = SimulateFrames(refresh_interval, delay_begin_frame);
+  }
+  state.SetItemsProcessed(state.iterations() * kSimulatedFrameCount);
+
+  std::stringstream label;
+  label << "latency_ms="
+        << stats.total_latency.ToMillisecondsF() / kSimulatedFrameCount
+        << " missed_frames=" << stats.missed_frame_count
+        << " learned_hz=" << 1.0 / stats.refresh_interval.ToSecondsF();
+  state.SetLabel(label.str());
+}
+
+BENCHMARK(BM_FrameDeadlinePredictorScheduling)
+    ->Args({60, 0})
+    ->Args({60, 1})
+    ->Args({90, 0})
+    ->Args({90, 1})
+    ->Args({120, 0})
+    ->Args({120, 1});
+
+}  // namespace flutter
@@ -0,0 +1,146 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/frame_deadline_predictor.h"
+
+#include "flutter/shell/common/vsync_waiter.h"
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+namespace {
+
+const fml::TimePoint kVsyncTime =
+    fml::TimePoint::FromEpochDelta(fml::TimeDelta::FromSeconds(1));
+
+FrameTiming MakeFrameTiming(fml::TimePoint build_start,
+                            fml::TimeDelta build_time,
+                            fml::TimeDelta raster_time) {
+  FrameTiming timing;
+  timing.Set(FrameTiming::kBuildStart, build_start);
+  timing.Set(FrameTiming::kBuildFinish, build_start + build_time);
+  timing.Set(FrameTiming::kRasterStart, build_start + build_time);
+  timing.Set(FrameTiming::kRasterFinish,
+             build_start + build_time + raster_time);
+  return timing;
+}
+
+void AddFrames(FrameDeadlinePredictor& predictor,
+               size_t count,
+               fml::TimeDelta build_time,
+               fml::TimeDelta raster_time) {
+  for (size_t i = 0; i < count; i++) {
+    predictor.AddFrameTiming(
+        MakeFrameTiming(kVsyncTime, build_time, raster_time));
+  }
+}
+
+// Adds |count| vsyncs |interval| apart starting at |start|, and returns the
+// time of the last one.
+fml::TimePoint AddVsyncs(FrameDeadlinePredictor& predictor,
+                         fml::TimePoint start,
+                         size_t count,
+                         fml::TimeDelta interval) {
+  fml::TimePoint time = start;
+  for (size_t i = 0; i < count; i++) {
+    time = start + interval * i;
+    predictor.AddVsync(time);
+  }
+  return time;
+}
+
+}  // namespace
+
+TEST(FrameDeadlinePredictor, LearnsTheRefreshIntervalFromTheVsyncs) {
+  FrameDeadlinePredictor predictor;
+  ASSERT_EQ(predictor.GetRefreshInterval(),
+            FrameDeadlinePredictor::kDefaultRefreshInterval);
+
+  predictor.SetReportedRefreshRate(120);
+  ASSERT_EQ(predictor.GetRefreshInterval(),
+            fml::TimeDelta::FromSecondsF(1.0 / 120));
+
+  // The display reports its maximum refresh rate, the vsyncs tell the actual
+  // one.
+  AddVsyncs(predictor, kVsyncTime, 4, fml::TimeDelta::FromMilliseconds(11));
+  ASSERT_EQ(predictor.GetRefreshInterval(),
+            fml::TimeDelta::FromMilliseconds(11));
+}
+
+TEST(FrameDeadlinePredictor, IgnoresSkippedVsyncsAndIdleTime) {
+  FrameDeadlinePredictor predictor;
+  fml::TimeDelta refresh_interval = fml::TimeDelta::FromMilliseconds(8);
+  fml::TimePoint time = AddVsyncs(predictor, kVsyncTime, 3, refresh_interval);
+
+  // Late frames skip vsyncs.
+  for (size_t i = 0; i < FrameDeadlinePredictor::kWindowSize / 2; i++) {
+    time = time + refresh_interval * 2;
+    predictor.AddVsync(time);
+  }
+  time = AddVsyncs(predictor, time + refresh_interval, 3, refresh_interval);
+  ASSERT_EQ(predictor.GetRefreshInterval(), refresh_interval);
+
+  // No frame is requested for a while.
+  AddVsyncs(predictor, time + fml::TimeDelta::FromSeconds(1), 2,
+            refresh_interval);
+  ASSERT_EQ(predictor.GetRefreshInterval(), refresh_interval);
+}
+
+TEST(FrameDeadlinePredictor, DoesNotDelayFramesUntilEnoughWereTimed) {
+  FrameDeadlinePredictor predictor;
+  fml::TimePoint target = kVsyncTime + fml::TimeDelta::FromMilliseconds(16);
+  AddFrames(predictor, FrameDeadlinePredictor::kMinFrameCount - 1,
+            fml::TimeDelta::FromMilliseconds(2),
+            fml::TimeDelta::FromMilliseconds(2));
+  ASSERT_EQ(predictor.GetPredictedFrameDuration(), fml::TimeDelta::Zero());
+  ASSERT_EQ(predictor.GetBeginFrameDelay(kVsyncTime, target),
+            fml::TimeDelta::Zero());
+
+  AddFrames(predictor, 1, fml::TimeDelta::FromMilliseconds(2),
+            fml::TimeDelta::FromMilliseconds(2));
+  ASSERT_EQ(predictor.GetPredictedFrameDuration(),
+            fml::TimeDelta::FromMilliseconds(4));
+  ASSERT_EQ(predictor.GetBeginFrameDelay(kVsyncTime, target),
+            fml::TimeDelta::FromMilliseconds(12) -
+                FrameDeadlinePredictor::kSafetyMargin);
+}
+
+TEST(FrameDeadlinePredictor, PredictsAHighPercentileOfTheRecentFrames) {
+  FrameDeadlinePredictor predictor;
+  AddFrames(predictor, FrameDeadlinePredictor::kWindowSize,
+            fml::TimeDelta::FromMilliseconds(20),
+            fml::TimeDelta::FromMilliseconds(20));
+  // The slow frames are out of the window once as many fast frames followed.
+  AddFrames(predictor, FrameDeadlinePredictor::kWindowSize * 95 / 100,
+            fml::TimeDelta::FromMilliseconds(3),
+            fml::TimeDelta::FromMilliseconds(5));
+  ASSERT_EQ(predictor.GetPredictedFrameDuration(),
+            fml::TimeDelta::FromMilliseconds(8));
+
+  // A frame that does not fit before its deadline is begun right away.
+  AddFrames(predictor, FrameDeadlinePredictor::kWindowSize,
+            fml::TimeDelta::FromMilliseconds(10),
+            fml::TimeDelta::FromMilliseconds(10));
+  ASSERT_EQ(predictor.GetBeginFrameDelay(
+                kVsyncTime, kVsyncTime + fml::TimeDelta::FromMilliseconds(16)),
+            fml::TimeDelta::Zero());
+}
+
+TEST(FrameDeadlinePredictor, UsesTheRefreshIntervalWithoutATargetTime) {
+  FrameDeadlinePredictor predictor;
+  predictor.SetReportedRefreshRate(50);
+  AddFrames(predictor, FrameDeadlinePredictor::kMinFrameCount,
+            fml::TimeDelta::FromMilliseconds(5),
+            fml::TimeDelta::FromMilliseconds(5));
+  ASSERT_EQ(predictor.GetBeginFrameDelay(kVsyncTime, kVsyncTime),
+            fml::TimeDelta::FromMilliseconds(10) -
+                FrameDeadlinePredictor::kSafetyMargin);
+
+  predictor.Reset();
+  ASSERT_EQ(predictor.GetPredictedFrameDuration(), fml::TimeDelta::Zero());
+}
+
+}  // namespace testing
+}  // namespace flutter
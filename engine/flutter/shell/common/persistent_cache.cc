@@ -39,14 +39,25 @@ static std::string SkKeyToFilePath(const SkData& data) {
 
 bool PersistentCache::gIsReadOnly = false;
 
+size_t PersistentCache::gPrefetchByteBudget = 0;
+
+std::mutex PersistentCache::instance_mutex_;
+
+std::unique_ptr<PersistentCache> PersistentCache::gPersistentCache;
+
 PersistentCache* PersistentCache::GetCacheForProcess() {
-  static std::unique_ptr<PersistentCache> gPersistentCache;
-  static std::once_flag once = {};
-  std::call_once(
-      once, []() { gPersistentCache.reset(new PersistentCache(gIsReadOnly)); });
+  std::scoped_lock lock(instance_mutex_);
+  if (gPersistentCache == nullptr) {
+    gPersistentCache.reset(new PersistentCache(gIsReadOnly));
+  }
   return gPersistentCache.get();
 }
 
+void PersistentCache::ResetCacheForProcess() {
+  std::scoped_lock lock(instance_mutex_);
+  gPersistentCache.reset(new PersistentCache(gIsReadOnly));
+}
+
 void PersistentCache::SetCacheDirectoryPath(std::string path) {
   cache_base_path_ = path;
 }
@@ -73,11 +84,27 @@ std::shared_ptr<fml::UniqueFD> MakeCacheDirectory(
     return std::make_shared<fml::UniqueFD>();
   }
 }
+
+std::shared_ptr<PersistentCachePack> OpenCachePack(
+    const std::shared_ptr<fml::UniqueFD>& cache_directory,
+    bool read_only) {
+  if (!cache_directory->is_valid()) {
+    return nullptr;
+  }
+  auto pack = PersistentCachePack::Open(*cache_directory, read_only);
+  if (pack && !read_only) {
+    // Only finds files the first time the cache is opened after the pack was
+    // introduced, or after the pack could not be opened.
+    pack->ImportLegacyFiles(*cache_directory);
+  }
+  return pack;
+}
 }  // namespace
 
 PersistentCache::PersistentCache(bool read_only)
     : is_read_only_(read_only),
-      cache_directory_(MakeCacheDirectory(cache_base_path_, read_only)) {
+      cache_directory_(MakeCacheDirectory(cache_base_path_, read_only)),
+      pack_(OpenCachePack(cache_directory_, read_only)) {
   if (!IsValid()) {
     FML_LOG(WARNING) << "Could not acquire the persistent cache directory. "
                         "Caching of GPU resources on disk is disabled.";
@@ -93,9 +120,27 @@ bool PersistentCache::IsValid() const {
 // |GrContextOptions::PersistentCache|
 sk_sp<SkData> PersistentCache::load(const SkData& key) {
   TRACE_EVENT0("flutter", "PersistentCacheLoad");
+  auto data = LoadData(key);
+  if (data) {
+    hit_count_++;
+    hit_bytes_ += data->size();
+  } else {
+    miss_count_++;
+  }
+  return data;
+}
+
+sk_sp<SkData> PersistentCache::LoadData(const SkData& key) const {
   if (!IsValid()) {
     return nullptr;
   }
+  if (pack_) {
+    auto data = pack_->Find(key);
+    if (data) {
+      TRACE_EVENT0("flutter", "PersistentCacheLoadHit");
+    }
+    return data;
+  }
   auto file_name = SkKeyToFilePath(key);
   if (file_name.size() == 0) {
     return nullptr;
@@ -114,6 +159,28 @@ sk_sp<SkData> PersistentCache::load(const SkData& key) {
   return SkData::MakeWithCopy(mapping->GetMapping(), mapping->GetSize());
 }
 
+PersistentCache::Stats PersistentCache::GetStats() const {
+  Stats stats;
+  stats.hit_count = hit_count_;
+  stats.hit_bytes = hit_bytes_;
+  stats.miss_count = miss_count_;
+  stats.prefetched_bytes = pack_ ? pack_->GetPrefetchedByteCount() : 0;
+  return stats;
+}
+
+static void PersistentCacheRunTask(fml::RefPtr<fml::TaskRunner> worker,
+                                   fml::closure task) {
+  if (!worker) {
+    FML_LOG(WARNING)
+        << "The persistent cache has no available workers. Performing the task "
+           "on the current thread. This slow operation is going to occur on a "
+           "frame workload.";
+    task();
+  } else {
+    worker->PostTask(std::move(task));
+  }
+}
+
 static void PersistentCacheStore(fml::RefPtr<fml::TaskRunner> worker,
                                  std::shared_ptr<fml::UniqueFD> cache_directory,
                                  std::string key,
@@ -133,15 +200,7 @@ static void PersistentCacheStore(fml::RefPtr<fml::TaskRunner> worker,
         }
       });
 
-  if (!worker) {
-    FML_LOG(WARNING)
-        << "The persistent cache has no available workers. Performing the task "
-           "on the current thread. This slow operation is going to occur on a "
-           "frame workload.";
-    task();
-  } else {
-    worker->PostTask(std::move(task));
-  }
+  PersistentCacheRunTask(std::move(worker), std::move(task));
 }
 
 // |GrContextOptions::PersistentCache|
@@ -156,6 +215,20 @@ void PersistentCache::store(const SkData& key, const SkData& data) {
     return;
   }
 
+  if (pack_) {
+    // Visible to |load| right away, written to the pack with the other entries
+    // stored before the worker gets to it.
+    pack_->Insert(key, SkData::MakeWithCopy(data.data(), data.size()));
+    PersistentCacheRunTask(GetWorkerTaskRunner(), [pack = pack_]() {
+      TRACE_EVENT0("flutter", "PersistentCacheStore");
+      if (!pack->Flush()) {
+        FML_DLOG(WARNING)
+            << "Could not write cache contents to persistent store.";
+      }
+    });
+    return;
+  }
+
   auto file_name = SkKeyToFilePath(key);
 
   if (file_name.size() == 0) {
@@ -195,6 +268,13 @@ void PersistentCache::AddWorkerTaskRunner(
     fml::RefPtr<fml::TaskRunner> task_runner) {
   std::scoped_lock lock(worker_task_runners_mutex_);
   worker_task_runners_.insert(task_runner);
+
+  if (pack_ && gPrefetchByteBudget > 0 && !prefetch_started_) {
+    prefetch_started_ = true;
+    task_runner->PostTask([pack = pack_, budget = gPrefetchByteBudget]() {
+      pack->Prefetch(budget);
+    });
+  }
 }
 
 void PersistentCache::RemoveWorkerTaskRunner(
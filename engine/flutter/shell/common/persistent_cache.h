@@ -5,6 +5,7 @@
 #ifndef FLUTTER_SHELL_COMMON_PERSISTENT_CACHE_H_
 #define FLUTTER_SHELL_COMMON_PERSISTENT_CACHE_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -13,6 +14,7 @@
 #include "flutter/fml/synchronization/thread_annotations.h"
 #include "flutter/fml/task_runner.h"
 #include "flutter/fml/unique_fd.h"
+#include "flutter/shell/common/persistent_cache_pack.h"
 #include "third_party/skia/include/gpu/GrContextOptions.h"
 
 namespace flutter {
@@ -21,6 +23,10 @@ namespace flutter {
 ///
 /// This is mainly used for Shaders but is also written to by Dart.  It is
 /// thread-safe for reading and writing from multiple threads.
+///
+/// The entries are stored in a single |PersistentCachePack| file. Caches
+/// generated beforehand as one file per entry are still read when |gIsReadOnly|
+/// is set and there is no pack.
 class PersistentCache : public GrContextOptions::PersistentCache {
  public:
   // Mutable static switch that can be set before GetCacheForProcess. If true,
@@ -30,8 +36,31 @@ class PersistentCache : public GrContextOptions::PersistentCache {
   // packages.
   static bool gIsReadOnly;
 
+  // Mutable static switch that can be set before the first worker task runner
+  // is added. If not zero, the entries of the cache are read into memory on
+  // that worker, up to this many bytes, so that the shaders of the first
+  // frames are loaded without waiting on the disk. Caches stored as one file
+  // per entry are not prefetched. Shells set it from
+  // |Settings::persistent_cache_prefetch_byte_budget|.
+  static size_t gPrefetchByteBudget;
+
+  struct Stats {
+    // The number of |load| calls that found an entry, and their total size.
+    size_t hit_count = 0;
+    size_t hit_bytes = 0;
+    // The number of |load| calls that didn't find an entry.
+    size_t miss_count = 0;
+    // The number of bytes read into memory ahead of |load| calls.
+    size_t prefetched_bytes = 0;
+  };
+
   static PersistentCache* GetCacheForProcess();
 
+  // Replaces the cache of the process with one opened again from the disk,
+  // with no stats and nothing prefetched. For tests and benchmarks only, no
+  // shell may be using the cache.
+  static void ResetCacheForProcess();
+
   static void SetCacheDirectoryPath(std::string path);
 
   ~PersistentCache() override;
@@ -45,6 +74,8 @@ class PersistentCache : public GrContextOptions::PersistentCache {
   // frame so we can know if Skia tries to compile new shaders in that frame.
   bool StoredNewShaders() const { return stored_new_shaders_; }
   void ResetStoredNewShaders() { stored_new_shaders_ = false; }
+  Stats GetStats() const;
+
   void DumpSkp(const SkData& data);
   bool IsDumpingSkp() const { return is_dumping_skp_; }
   void SetIsDumpingSkp(bool value) { is_dumping_skp_ = value; }
@@ -52,12 +83,22 @@ class PersistentCache : public GrContextOptions::PersistentCache {
  private:
   static std::string cache_base_path_;
 
+  static std::mutex instance_mutex_;
+  static std::unique_ptr<PersistentCache> gPersistentCache
+      FML_GUARDED_BY(instance_mutex_);
+
   const bool is_read_only_;
   const std::shared_ptr<fml::UniqueFD> cache_directory_;
+  const std::shared_ptr<PersistentCachePack> pack_;
   mutable std::mutex worker_task_runners_mutex_;
   std::multiset<fml::RefPtr<fml::TaskRunner>> worker_task_runners_
       FML_GUARDED_BY(worker_task_runners_mutex_);
 
+  bool prefetch_started_ FML_GUARDED_BY(worker_task_runners_mutex_) = false;
+  std::atomic_size_t hit_count_ = 0;
+  std::atomic_size_t hit_bytes_ = 0;
+  std::atomic_size_t miss_count_ = 0;
+
   bool stored_new_shaders_ = false;
   bool is_dumping_skp_ = false;
 
@@ -68,6 +109,8 @@ class PersistentCache : public GrContextOptions::PersistentCache {
   // |GrContextOptions::PersistentCache|
   sk_sp<SkData> load(const SkData& key) override;
 
+  sk_sp<SkData> LoadData(const SkData& key) const;
+
   // |GrContextOptions::PersistentCache|
   void store(const SkData& key, const SkData& data) override;
 
@@ -0,0 +1,138 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/base32.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/shell/common/persistent_cache_pack.h"
+
+namespace flutter {
+
+namespace {
+
+// About the size of the programs Skia stores for a simple shader.
+constexpr size_t kValueSize = 4096;
+
+std::vector<sk_sp<SkData>> MakeKeys(size_t count) {
+  std::vector<sk_sp<SkData>> keys;
+  for (size_t i = 0; i < count; i++) {
+    std::string key = "shader_key_" + std::to_string(i);
+    key.resize(64, '#');
+    keys.push_back(SkData::MakeWithCopy(key.data(), key.size()));
+  }
+  return keys;
+}
+
+std::string GetEntryFileName(const SkData& key) {
+  std::string_view view(static_cast<const char*>(key.data()), key.size());
+  return fml::Base32Encode(view).second;
+}
+
+// The layout used by |PersistentCache| before the pack: one file per entry,
+// named after the key.
+sk_sp<SkData> LoadEntryFile(const fml::UniqueFD& directory,
+                            const SkData& key) {
+  auto file = fml::OpenFile(directory, GetEntryFileName(key).c_str(), false,
+                            fml::FilePermission::kRead);
+  if (!file.is_valid()) {
+    return nullptr;
+  }
+  fml::FileMapping mapping(file);
+  if (mapping.GetSize() == 0) {
+    return nullptr;
+  }
+  return SkData::MakeWithCopy(mapping.GetMapping(), mapping.GetSize());
+}
+
+}  // namespace
+
+// Loads every entry of a cache stored as one file per entry, like a cold start
+// that finds the programs of all of its shaders in the cache.
+static void BM_PersistentCacheStartupPerFile(benchmark::State& state) {
+  fml::ScopedTemporaryDirectory dir;
+  const auto keys = MakeKeys(state.range(0));
+  for (const auto& key : keys) {
+    fml::WriteAtomically(dir.fd(), GetEntryFileName(*key).c_str(),
+                         fml::DataMapping(std::vector<uint8_t>(kValueSize)));
+  }
+
+  while (state.KeepRunning()) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(LoadEntryFile(dir.fd(), *key));
+    }
+  }
+
+  for (const auto& key : keys) {
+    fml::UnlinkFile(dir.fd(), GetEntryFileName(*key).c_str());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Opens a pack and loads every entry in it.
+static void BM_PersistentCacheStartupPack(benchmark::State& state) {
+  fml::ScopedTemporaryDirectory dir;
+  const auto keys = MakeKeys(state.range(0));
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    const std::vector<uint8_t> value(kValueSize);
+    for (const auto& key : keys) {
+      pack->Insert(*key, SkData::MakeWithCopy(value.data(), value.size()));
+    }
+    pack->Flush();
+  }
+
+  while (state.KeepRunning()) {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(pack->Find(*key));
+    }
+  }
+
+  fml::UnlinkFile(dir.fd(), PersistentCachePack::kFileName);
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Loads every entry of an open pack, after prefetching up to |state.range(1)|
+// bytes of it. This is the part of the startup that runs on the raster thread.
+static void BM_PersistentCacheLoadsAfterPrefetch(benchmark::State& state) {
+  fml::ScopedTemporaryDirectory dir;
+  const auto keys = MakeKeys(state.range(0));
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    const std::vector<uint8_t> value(kValueSize);
+    for (const auto& key : keys) {
+      pack->Insert(*key, SkData::MakeWithCopy(value.data(), value.size()));
+    }
+    pack->Flush();
+  }
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Prefetch(state.range(1));
+    state.ResumeTiming();
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(pack->Find(*key));
+    }
+  }
+
+  fml::UnlinkFile(dir.fd(), PersistentCachePack::kFileName);
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+BENCHMARK(BM_PersistentCacheStartupPerFile)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024);
+BENCHMARK(BM_PersistentCacheStartupPack)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_PersistentCacheLoadsAfterPrefetch)
+    ->Args({256, 0})
+    ->Args({256, 128 * kValueSize})
+    ->Args({256, 256 * kValueSize});
+
+}  // namespace flutter
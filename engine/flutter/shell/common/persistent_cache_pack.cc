@@ -0,0 +1,462 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/persistent_cache_pack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "flutter/fml/base32.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/trace_event.h"
+
+namespace flutter {
+
+constexpr char PersistentCachePack::kFileName[];
+
+namespace {
+
+constexpr char kPackMagic[8] = {'F', 'L', 'T', 'P', 'A', 'C', 'K', '\0'};
+constexpr uint32_t kPackVersion = 1;
+
+struct PackHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct RecordHeader {
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t checksum;
+  uint32_t reserved;
+};
+
+// Keys and values start on this alignment within the file, and so within its
+// mapping. Skia expects the serialized programs to be 4 byte aligned.
+constexpr uint64_t kRecordAlignment = 8;
+
+// Below this, compacting the file isn't worth rewriting it.
+constexpr size_t kMinimumDeadBytesToCompact = 16 * 1024;
+
+// The file is opened again after it is recreated or compacted. It is not
+// compacted on the last attempt.
+constexpr size_t kMaxOpenAttempts = 3;
+
+uint64_t AlignRecordSize(uint64_t size) {
+  return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+uint64_t GetRecordSize(uint64_t key_size, uint64_t value_size) {
+  return sizeof(RecordHeader) + AlignRecordSize(key_size) +
+         AlignRecordSize(value_size);
+}
+
+// FNV-1a over 64 bit words. This only has to catch records that were not
+// completely written, and runs over every value that is loaded.
+uint64_t UpdateChecksum(uint64_t checksum, const void* data, size_t size) {
+  constexpr uint64_t kPrime = 1099511628211u;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    ::memcpy(&word, bytes + i, sizeof(word));
+    checksum = (checksum ^ word) * kPrime;
+  }
+  for (; i < size; i++) {
+    checksum = (checksum ^ bytes[i]) * kPrime;
+  }
+  return checksum;
+}
+
+uint32_t GetRecordChecksum(uint32_t key_size,
+                           uint32_t value_size,
+                           const uint8_t* key,
+                           const uint8_t* value) {
+  uint64_t checksum = 14695981039346656037u;
+  checksum = UpdateChecksum(checksum, &key_size, sizeof(key_size));
+  checksum = UpdateChecksum(checksum, &value_size, sizeof(value_size));
+  checksum = UpdateChecksum(checksum, key, key_size);
+  checksum = UpdateChecksum(checksum, value, value_size);
+  return static_cast<uint32_t>(checksum ^ (checksum >> 32));
+}
+
+void AppendHeader(std::vector<uint8_t>* buffer) {
+  PackHeader header = {};
+  ::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+  header.version = kPackVersion;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(header));
+}
+
+void AppendRecord(std::vector<uint8_t>* buffer,
+                  const uint8_t* key,
+                  uint32_t key_size,
+                  const uint8_t* value,
+                  uint32_t value_size) {
+  RecordHeader header = {};
+  header.key_size = key_size;
+  header.value_size = value_size;
+  header.checksum = GetRecordChecksum(key_size, value_size, key, value);
+
+  const size_t offset = buffer->size();
+  buffer->resize(offset + GetRecordSize(key_size, value_size), 0);
+  uint8_t* record = buffer->data() + offset;
+  ::memcpy(record, &header, sizeof(header));
+  ::memcpy(record + sizeof(header), key, key_size);
+  ::memcpy(record + sizeof(header) + AlignRecordSize(key_size), value,
+           value_size);
+}
+
+bool CreatePackFile(const fml::UniqueFD& directory) {
+  std::vector<uint8_t> header;
+  AppendHeader(&header);
+  return fml::WriteAtomically(directory, PersistentCachePack::kFileName,
+                              fml::DataMapping(std::move(header)));
+}
+
+void ReleaseMapping(const void* ptr, void* context) {
+  delete static_cast<std::shared_ptr<fml::FileMapping>*>(context);
+}
+
+}  // namespace
+
+std::shared_ptr<PersistentCachePack> PersistentCachePack::Open(
+    const fml::UniqueFD& directory,
+    bool read_only) {
+  TRACE_EVENT0("flutter", "PersistentCachePack::Open");
+  const auto permission =
+      read_only ? fml::FilePermission::kRead : fml::FilePermission::kReadWrite;
+
+  for (size_t attempt = 1; attempt <= kMaxOpenAttempts; attempt++) {
+    auto file = fml::OpenFile(directory, kFileName, false, permission);
+    if (!file.is_valid()) {
+      if (read_only || !CreatePackFile(directory)) {
+        return nullptr;
+      }
+      file = fml::OpenFile(directory, kFileName, false, permission);
+      if (!file.is_valid()) {
+        return nullptr;
+      }
+    }
+
+    std::shared_ptr<PersistentCachePack> pack(
+        new PersistentCachePack(read_only, std::move(file)));
+    size_t dead_bytes = 0;
+    const size_t valid_size = pack->ReadIndex(&dead_bytes);
+
+    if (read_only) {
+      return valid_size > 0 ? pack : nullptr;
+    }
+
+    if (valid_size == 0) {
+      // Not a pack, or one written in another version of the format.
+      FML_LOG(WARNING) << "Discarding unreadable persistent cache pack.";
+      pack.reset();
+      if (!CreatePackFile(directory)) {
+        return nullptr;
+      }
+      continue;
+    }
+
+    if (attempt < kMaxOpenAttempts &&
+        dead_bytes >= kMinimumDeadBytesToCompact &&
+        dead_bytes * 2 > valid_size) {
+      TRACE_EVENT0("flutter", "PersistentCachePack::Compact");
+      fml::DataMapping live_records(pack->SerializeLiveRecords());
+      if (fml::WriteAtomically(directory, kFileName, live_records)) {
+        continue;
+      }
+      FML_DLOG(WARNING) << "Could not compact the persistent cache pack.";
+    }
+
+    if (valid_size < pack->mapping_->GetSize()) {
+      // The tail of the file is a record that was not completely written. The
+      // mapping stays valid for the records before it.
+      if (!fml::TruncateFile(pack->file_, valid_size)) {
+        FML_DLOG(WARNING) << "Could not truncate the persistent cache pack.";
+        return nullptr;
+      }
+    }
+
+    {
+      std::scoped_lock lock(pack->file_mutex_);
+      pack->file_size_ = valid_size;
+    }
+    return pack;
+  }
+
+  // The file written by the previous attempt could not be read back.
+  FML_LOG(WARNING) << "Could not open the persistent cache pack.";
+  return nullptr;
+}
+
+PersistentCachePack::PersistentCachePack(bool read_only, fml::UniqueFD file)
+    : read_only_(read_only), file_(std::move(file)) {}
+
+PersistentCachePack::~PersistentCachePack() = default;
+
+size_t PersistentCachePack::ReadIndex(size_t* dead_bytes) {
+  *dead_bytes = 0;
+  mapping_ = std::make_shared<fml::FileMapping>(file_);
+  if (!mapping_->IsValid() || mapping_->GetSize() < sizeof(PackHeader)) {
+    return 0;
+  }
+
+  const uint8_t* base = mapping_->GetMapping();
+  const size_t size = mapping_->GetSize();
+
+  PackHeader pack_header;
+  ::memcpy(&pack_header, base, sizeof(pack_header));
+  if (::memcmp(pack_header.magic, kPackMagic, sizeof(kPackMagic)) != 0 ||
+      pack_header.version != kPackVersion) {
+    return 0;
+  }
+
+  std::scoped_lock lock(index_mutex_);
+  size_t offset = sizeof(PackHeader);
+  while (size - offset >= sizeof(RecordHeader)) {
+    RecordHeader header;
+    ::memcpy(&header, base + offset, sizeof(header));
+    if (header.key_size == 0) {
+      // Space the file was grown by for records that were never written.
+      break;
+    }
+    const uint64_t record_size =
+        GetRecordSize(header.key_size, header.value_size);
+    if (record_size > size - offset) {
+      break;
+    }
+    const uint8_t* key = base + offset + sizeof(RecordHeader);
+    const size_t value_offset =
+        offset + sizeof(RecordHeader) + AlignRecordSize(header.key_size);
+
+    auto inserted = index_.emplace(
+        std::string{reinterpret_cast<const char*>(key), header.key_size},
+        Entry{});
+    if (!inserted.second) {
+      *dead_bytes +=
+          GetRecordSize(header.key_size, inserted.first->second.size);
+    }
+    inserted.first->second.offset = value_offset;
+    inserted.first->second.size = header.value_size;
+    inserted.first->second.checksum = header.checksum;
+    offset += record_size;
+  }
+  return offset;
+}
+
+std::vector<uint8_t> PersistentCachePack::SerializeLiveRecords() const {
+  std::scoped_lock lock(index_mutex_);
+
+  // Keep the records in the order they were stored in.
+  std::vector<const std::pair<const std::string, Entry>*> records;
+  records.reserve(index_.size());
+  for (const auto& record : index_) {
+    records.push_back(&record);
+  }
+  std::sort(records.begin(), records.end(), [](auto* a, auto* b) {
+    return a->second.offset < b->second.offset;
+  });
+
+  std::vector<uint8_t> buffer;
+  AppendHeader(&buffer);
+  for (const auto* record : records) {
+    const uint8_t* key = reinterpret_cast<const uint8_t*>(record->first.data());
+    const uint8_t* value = mapping_->GetMapping() + record->second.offset;
+    // Copied as is, a corrupted value would get a checksum that matches it.
+    if (GetRecordChecksum(record->first.size(), record->second.size, key,
+                          value) != record->second.checksum) {
+      FML_DLOG(WARNING) << "Dropping corrupted persistent cache pack record.";
+      continue;
+    }
+    AppendRecord(&buffer, key, record->first.size(), value,
+                 record->second.size);
+  }
+  return buffer;
+}
+
+size_t PersistentCachePack::GetEntryCount() const {
+  std::scoped_lock lock(index_mutex_);
+  return index_.size();
+}
+
+sk_sp<SkData> PersistentCachePack::Find(const SkData& key) const {
+  std::string key_string{static_cast<const char*>(key.data()), key.size()};
+
+  Entry entry;
+  {
+    std::scoped_lock lock(index_mutex_);
+    auto found = index_.find(key_string);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    entry = found->second;
+  }
+  if (entry.data) {
+    return entry.data;
+  }
+  return GetMappedValue(key_string, entry);
+}
+
+sk_sp<SkData> PersistentCachePack::GetMappedValue(const std::string& key,
+                                                  const Entry& entry) const {
+  const uint8_t* value = mapping_->GetMapping() + entry.offset;
+  if (GetRecordChecksum(key.size(), entry.size,
+                        reinterpret_cast<const uint8_t*>(key.data()),
+                        value) != entry.checksum) {
+    // Only the tail of the file can be left incomplete, and only when the
+    // process died while appending to it. Storing the value again supersedes
+    // the record.
+    FML_DLOG(WARNING) << "Ignoring incomplete persistent cache pack record.";
+    return nullptr;
+  }
+  return SkData::MakeWithProc(value, entry.size, &ReleaseMapping,
+                              new std::shared_ptr<fml::FileMapping>(mapping_));
+}
+
+size_t PersistentCachePack::Prefetch(size_t byte_budget) {
+  TRACE_EVENT0("flutter", "PersistentCachePack::Prefetch");
+  std::vector<std::pair<std::string, Entry>> records;
+  {
+    std::scoped_lock lock(index_mutex_);
+    for (const auto& record : index_) {
+      if (!record.second.data) {
+        records.emplace_back(record.first, record.second);
+      }
+    }
+  }
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+    return a.second.offset < b.second.offset;
+  });
+
+  size_t prefetched_bytes = 0;
+  for (const auto& record : records) {
+    const Entry& entry = record.second;
+    if (entry.size > byte_budget - prefetched_bytes) {
+      continue;
+    }
+    auto mapped_value = GetMappedValue(record.first, entry);
+    if (!mapped_value) {
+      continue;
+    }
+    auto value = SkData::MakeWithCopy(mapped_value->data(), entry.size);
+
+    std::scoped_lock lock(index_mutex_);
+    auto found = index_.find(record.first);
+    // The value may have been replaced while it was being copied.
+    if (found != index_.end() && !found->second.data &&
+        found->second.offset == entry.offset) {
+      found->second.data = std::move(value);
+      prefetched_bytes += entry.size;
+      prefetched_bytes_ += entry.size;
+    }
+  }
+  return prefetched_bytes;
+}
+
+size_t PersistentCachePack::GetPrefetchedByteCount() const {
+  std::scoped_lock lock(index_mutex_);
+  return prefetched_bytes_;
+}
+
+void PersistentCachePack::Insert(const SkData& key, sk_sp<SkData> value) {
+  if (key.size() == 0 || key.size() > UINT32_MAX || !value ||
+      value->size() == 0 || value->size() > UINT32_MAX) {
+    return;
+  }
+  std::string key_string{static_cast<const char*>(key.data()), key.size()};
+
+  std::scoped_lock lock(index_mutex_);
+  Entry& entry = index_[key_string];
+  entry.size = value->size();
+  entry.data = value;
+  if (!read_only_) {
+    pending_records_.push_back({std::move(key_string), std::move(value)});
+  }
+}
+
+bool PersistentCachePack::Flush() {
+  std::vector<PendingRecord> records;
+  {
+    std::scoped_lock lock(index_mutex_);
+    records.swap(pending_records_);
+  }
+  if (read_only_) {
+    return false;
+  }
+  if (records.empty()) {
+    return true;
+  }
+
+  TRACE_EVENT0("flutter", "PersistentCachePack::Flush");
+  std::vector<uint8_t> bytes;
+  for (const auto& record : records) {
+    AppendRecord(&bytes, reinterpret_cast<const uint8_t*>(record.key.data()),
+                 record.key.size(), record.value->bytes(),
+                 record.value->size());
+  }
+
+  // The records are written rather than copied into a mapping of the grown
+  // file, which would fault when the disk is full.
+  std::scoped_lock lock(file_mutex_);
+  const size_t new_size = file_size_ + bytes.size();
+  if (fml::WriteFileAt(file_, file_size_, fml::DataMapping(std::move(bytes)))) {
+    file_size_ = new_size;
+    return true;
+  }
+
+  // Drop the records written in part, the records appended next would come
+  // after them and not be found when opening the pack.
+  fml::TruncateFile(file_, file_size_);
+  FML_DLOG(WARNING) << "Could not append to the persistent cache pack.";
+  return false;
+}
+
+size_t PersistentCachePack::ImportLegacyFiles(const fml::UniqueFD& directory) {
+  if (read_only_) {
+    return 0;
+  }
+
+  // The pack file and the other files of the directory aren't named by a
+  // base32 encoding, their names have lower case letters or dots.
+  std::vector<std::string> file_names;
+  fml::VisitFiles(directory, [&file_names](const fml::UniqueFD& directory,
+                                           const std::string& file_name) {
+    auto key = fml::Base32Decode(file_name);
+    if (key.first && !key.second.empty()) {
+      file_names.push_back(file_name);
+    }
+    return true;
+  });
+  if (file_names.empty()) {
+    return 0;
+  }
+
+  TRACE_EVENT0("flutter", "PersistentCachePack::ImportLegacyFiles");
+  size_t imported_count = 0;
+  for (const auto& file_name : file_names) {
+    auto mapping =
+        fml::FileMapping::CreateReadOnly(directory, file_name.c_str());
+    if (!mapping || mapping->GetSize() == 0) {
+      continue;
+    }
+    const std::string key = fml::Base32Decode(file_name).second;
+    Insert(*SkData::MakeWithoutCopy(key.data(), key.size()),
+           SkData::MakeWithCopy(mapping->GetMapping(), mapping->GetSize()));
+    imported_count++;
+  }
+  if (!Flush()) {
+    // Keep the files for the next time the cache is opened.
+    return 0;
+  }
+
+  for (const auto& file_name : file_names) {
+    fml::UnlinkFile(directory, file_name.c_str());
+  }
+  return imported_count;
+}
+
+}  // namespace flutter
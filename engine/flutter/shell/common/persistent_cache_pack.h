@@ -0,0 +1,138 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_COMMON_PERSISTENT_CACHE_PACK_H_
+#define FLUTTER_SHELL_COMMON_PERSISTENT_CACHE_PACK_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/synchronization/thread_annotations.h"
+#include "flutter/fml/unique_fd.h"
+#include "third_party/skia/include/core/SkData.h"
+
+namespace flutter {
+
+/// All the entries of a |PersistentCache| stored in a single append-only file.
+///
+/// The file starts with a fixed header followed by records of a key and its
+/// value. Opening a pack maps the file once and indexes its records, so that
+/// a lookup neither touches the file system nor copies the value. Values
+/// stored afterwards are kept in memory and appended to the file by |Flush|.
+///
+/// Every record carries a checksum, which is checked when its value is first
+/// looked up rather than when indexing the file. A record that was only
+/// partially written when the process died fails it and is never served. The
+/// file is truncated back to the last record that fits in it the next time the
+/// pack is opened. The header is only ever written with
+/// |fml::WriteAtomically|, along with the records it describes.
+///
+/// When a key is stored more than once, the last record wins. The space taken
+/// by the superseded records is reclaimed when opening the pack if they make
+/// up more than half of the file.
+///
+/// Thread-safe.
+class PersistentCachePack {
+ public:
+  static constexpr char kFileName[] = "persistent_cache.pack";
+
+  /// Opens the pack stored in |directory|. Unless |read_only| is set, the pack
+  /// is created if it doesn't exist yet, and its file is repaired and
+  /// compacted as needed. Returns nullptr if there is no usable pack.
+  static std::shared_ptr<PersistentCachePack> Open(
+      const fml::UniqueFD& directory,
+      bool read_only);
+
+  ~PersistentCachePack();
+
+  /// The number of distinct keys in the pack.
+  size_t GetEntryCount() const;
+
+  /// Returns the value last stored for |key|, or nullptr. Values read from
+  /// the file point into its mapping, which they keep alive.
+  sk_sp<SkData> Find(const SkData& key) const;
+
+  /// Makes |value| the value of |key| for |Find|. It is only written to the
+  /// file by the next call to |Flush|.
+  void Insert(const SkData& key, sk_sp<SkData> value);
+
+  /// Copies the values read from the file into memory, in the order they were
+  /// stored in, until |byte_budget| bytes are copied. This takes the page
+  /// faults and checksums off the threads that later find these values, and
+  /// should be called on a worker thread. Returns the number of bytes copied.
+  size_t Prefetch(size_t byte_budget);
+
+  /// The number of bytes copied into memory by |Prefetch| so far.
+  size_t GetPrefetchedByteCount() const;
+
+  /// Appends the values inserted since the last call to the file. This does
+  /// file IO and should be called on a worker thread. Returns false if the
+  /// pack is read-only or the values could not be written, in which case they
+  /// are only kept in memory.
+  bool Flush();
+
+  /// Moves the entries that earlier versions of |PersistentCache| stored in
+  /// |directory|, one file per key named by the base32 encoding of the key,
+  /// into the pack. Their files are deleted once the pack holds the entries.
+  /// This does file IO and should be done once, when opening the cache.
+  /// Returns the number of entries imported.
+  size_t ImportLegacyFiles(const fml::UniqueFD& directory);
+
+ private:
+  struct Entry {
+    // The value as found in |mapping_|, if |data| is null.
+    size_t offset = 0;
+    size_t size = 0;
+    uint32_t checksum = 0;
+    // The value inserted since the pack was opened, or prefetched.
+    sk_sp<SkData> data;
+  };
+
+  struct PendingRecord {
+    std::string key;
+    sk_sp<SkData> value;
+  };
+
+  const bool read_only_;
+  const fml::UniqueFD file_;
+  // The whole file as it was when it was opened. Only ever replaced during
+  // |Open|, so it can be read without holding |index_mutex_|.
+  std::shared_ptr<fml::FileMapping> mapping_;
+
+  mutable std::mutex index_mutex_;
+  std::unordered_map<std::string, Entry> index_ FML_GUARDED_BY(index_mutex_);
+  std::vector<PendingRecord> pending_records_ FML_GUARDED_BY(index_mutex_);
+  size_t prefetched_bytes_ FML_GUARDED_BY(index_mutex_) = 0;
+
+  std::mutex file_mutex_;
+  size_t file_size_ FML_GUARDED_BY(file_mutex_) = 0;
+
+  PersistentCachePack(bool read_only, fml::UniqueFD file);
+
+  // Maps |file_| and indexes its records. Returns the number of bytes taken by
+  // the header and the records that fit in the file, or zero if the file isn't
+  // a pack.
+  // |dead_bytes| is set to the size of the records superseded by a later one.
+  size_t ReadIndex(size_t* dead_bytes);
+
+  // Returns the value of a record read from the file, or nullptr if the
+  // record is incomplete.
+  sk_sp<SkData> GetMappedValue(const std::string& key,
+                               const Entry& entry) const;
+
+  // The header and the most recent record of every key, except the records
+  // that fail their checksum.
+  std::vector<uint8_t> SerializeLiveRecords() const;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(PersistentCachePack);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_COMMON_PERSISTENT_CACHE_PACK_H_
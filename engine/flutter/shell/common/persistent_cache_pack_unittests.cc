@@ -0,0 +1,275 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "flutter/fml/base32.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/shell/common/persistent_cache_pack.h"
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+// Removes the pack, which |fml::ScopedTemporaryDirectory| doesn't do.
+class PackDirectory {
+ public:
+  ~PackDirectory() {
+    fml::UnlinkFile(dir_.fd(), PersistentCachePack::kFileName);
+  }
+
+  const fml::UniqueFD& fd() { return dir_.fd(); }
+
+ private:
+  fml::ScopedTemporaryDirectory dir_;
+};
+
+static sk_sp<SkData> MakeData(const std::string& string) {
+  return SkData::MakeWithCopy(string.data(), string.size());
+}
+
+static fml::DataMapping MakeMapping(const std::string& string) {
+  return fml::DataMapping(std::vector<uint8_t>(string.begin(), string.end()));
+}
+
+static std::string ToString(const sk_sp<SkData>& data) {
+  if (!data) {
+    return "<null>";
+  }
+  return std::string{static_cast<const char*>(data->data()), data->size()};
+}
+
+static size_t GetPackFileSize(const fml::UniqueFD& directory) {
+  auto mapping = fml::FileMapping::CreateReadOnly(
+      directory, PersistentCachePack::kFileName);
+  return mapping ? mapping->GetSize() : 0;
+}
+
+TEST(PersistentCachePackTest, FindsValuesAfterReopening) {
+  PackDirectory dir;
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    ASSERT_TRUE(pack);
+    pack->Insert(*MakeData("key1"), MakeData("value1"));
+    pack->Insert(*MakeData("key2"), MakeData("value2"));
+    ASSERT_EQ(ToString(pack->Find(*MakeData("key1"))), "value1");
+    ASSERT_TRUE(pack->Flush());
+  }
+
+  auto pack = PersistentCachePack::Open(dir.fd(), true);
+  ASSERT_TRUE(pack);
+  ASSERT_EQ(pack->GetEntryCount(), 2u);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key1"))), "value1");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key2"))), "value2");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key3"))), "<null>");
+  ASSERT_EQ(
+      reinterpret_cast<uintptr_t>(pack->Find(*MakeData("key2"))->data()) % 4,
+      0u);
+}
+
+TEST(PersistentCachePackTest, PrefetchesValuesWithinBudget) {
+  PackDirectory dir;
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("key1"), MakeData("value1"));
+    pack->Insert(*MakeData("key2"), MakeData("longer value2"));
+    pack->Insert(*MakeData("key3"), MakeData("value3"));
+    ASSERT_TRUE(pack->Flush());
+  }
+
+  auto pack = PersistentCachePack::Open(dir.fd(), true);
+  // The second value doesn't fit in what is left after the first one, the
+  // third one still does.
+  ASSERT_EQ(pack->Prefetch(15), 12u);
+  ASSERT_EQ(pack->GetPrefetchedByteCount(), 12u);
+  // Values already in memory are not prefetched again.
+  ASSERT_EQ(pack->Prefetch(100), 13u);
+  ASSERT_EQ(pack->GetPrefetchedByteCount(), 25u);
+
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key1"))), "value1");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key2"))), "longer value2");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key3"))), "value3");
+}
+
+TEST(PersistentCachePackTest, ReadOnlyPackIsNotCreated) {
+  PackDirectory dir;
+  ASSERT_FALSE(PersistentCachePack::Open(dir.fd(), true));
+  ASSERT_FALSE(fml::FileExists(dir.fd(), PersistentCachePack::kFileName));
+}
+
+TEST(PersistentCachePackTest, LastStoredValueWins) {
+  PackDirectory dir;
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("key"), MakeData("old"));
+    ASSERT_TRUE(pack->Flush());
+    pack->Insert(*MakeData("key"), MakeData("new"));
+    ASSERT_TRUE(pack->Flush());
+  }
+  auto pack = PersistentCachePack::Open(dir.fd(), false);
+  ASSERT_EQ(pack->GetEntryCount(), 1u);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key"))), "new");
+}
+
+TEST(PersistentCachePackTest, DiscardsIncompleteRecord) {
+  PackDirectory dir;
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("complete"), MakeData("value"));
+    ASSERT_TRUE(pack->Flush());
+    pack->Insert(*MakeData("torn"), MakeData("value"));
+    ASSERT_TRUE(pack->Flush());
+  }
+
+  // Cut the last record as if the process died while writing it.
+  {
+    auto file = fml::OpenFile(dir.fd(), PersistentCachePack::kFileName, false,
+                              fml::FilePermission::kReadWrite);
+    ASSERT_TRUE(fml::TruncateFile(file, GetPackFileSize(dir.fd()) - 3));
+  }
+
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    ASSERT_TRUE(pack);
+    ASSERT_EQ(pack->GetEntryCount(), 1u);
+    ASSERT_EQ(ToString(pack->Find(*MakeData("complete"))), "value");
+    ASSERT_EQ(ToString(pack->Find(*MakeData("torn"))), "<null>");
+
+    // Records appended after the repair are found again.
+    pack->Insert(*MakeData("after"), MakeData("value"));
+    ASSERT_TRUE(pack->Flush());
+  }
+
+  auto pack = PersistentCachePack::Open(dir.fd(), true);
+  ASSERT_EQ(pack->GetEntryCount(), 2u);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("after"))), "value");
+}
+
+TEST(PersistentCachePackTest, IgnoresCorruptedValue) {
+  PackDirectory dir;
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("intact"), MakeData("value"));
+    pack->Insert(*MakeData("corrupted"), MakeData("value"));
+    ASSERT_TRUE(pack->Flush());
+  }
+
+  // Overwrite the last byte of the last value, which is followed by padding.
+  {
+    auto file = fml::OpenFile(dir.fd(), PersistentCachePack::kFileName, false,
+                              fml::FilePermission::kReadWrite);
+    fml::FileMapping mapping(file, {fml::FileMapping::Protection::kRead,
+                                    fml::FileMapping::Protection::kWrite});
+    uint8_t* bytes = mapping.GetMutableMapping();
+    ASSERT_NE(bytes, nullptr);
+    size_t last = mapping.GetSize() - 1;
+    while (bytes[last] != 'e') {
+      last--;
+    }
+    bytes[last] = 'E';
+  }
+
+  auto pack = PersistentCachePack::Open(dir.fd(), false);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("intact"))), "value");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("corrupted"))), "<null>");
+}
+
+TEST(PersistentCachePackTest, DiscardsUnreadableFile) {
+  PackDirectory dir;
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), PersistentCachePack::kFileName,
+                                   fml::DataMapping(std::vector<uint8_t>(
+                                       64, 0xff))));
+  ASSERT_FALSE(PersistentCachePack::Open(dir.fd(), true));
+
+  auto pack = PersistentCachePack::Open(dir.fd(), false);
+  ASSERT_TRUE(pack);
+  ASSERT_EQ(pack->GetEntryCount(), 0u);
+}
+
+TEST(PersistentCachePackTest, CompactsSupersededRecords) {
+  PackDirectory dir;
+  const std::string large_value(4096, 'x');
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("other"), MakeData("value"));
+    for (int i = 0; i < 16; i++) {
+      pack->Insert(*MakeData("key"), MakeData(large_value + std::to_string(i)));
+      ASSERT_TRUE(pack->Flush());
+    }
+  }
+  const size_t size_before = GetPackFileSize(dir.fd());
+
+  auto pack = PersistentCachePack::Open(dir.fd(), false);
+  ASSERT_TRUE(pack);
+  ASSERT_LT(GetPackFileSize(dir.fd()), size_before / 8);
+  ASSERT_EQ(pack->GetEntryCount(), 2u);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key"))), large_value + "15");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("other"))), "value");
+}
+
+TEST(PersistentCachePackTest, CompactionDropsCorruptedValues) {
+  PackDirectory dir;
+  const std::string large_value(4096, 'x');
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    pack->Insert(*MakeData("corrupted"), MakeData("value"));
+    for (int i = 0; i < 16; i++) {
+      pack->Insert(*MakeData("key"), MakeData(large_value + std::to_string(i)));
+      ASSERT_TRUE(pack->Flush());
+    }
+  }
+
+  {
+    auto file = fml::OpenFile(dir.fd(), PersistentCachePack::kFileName, false,
+                              fml::FilePermission::kReadWrite);
+    fml::FileMapping mapping(file, {fml::FileMapping::Protection::kRead,
+                                    fml::FileMapping::Protection::kWrite});
+    uint8_t* bytes = mapping.GetMutableMapping();
+    ASSERT_NE(bytes, nullptr);
+    const std::string value = "value";
+    auto found = std::search(bytes, bytes + mapping.GetSize(), value.begin(),
+                             value.end());
+    ASSERT_NE(found, bytes + mapping.GetSize());
+    *found = 'V';
+  }
+
+  // Compacts the pack, then reads back what the compaction wrote.
+  PersistentCachePack::Open(dir.fd(), false);
+  auto pack = PersistentCachePack::Open(dir.fd(), true);
+  ASSERT_TRUE(pack);
+  ASSERT_EQ(pack->GetEntryCount(), 1u);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("corrupted"))), "<null>");
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key"))), large_value + "15");
+}
+
+TEST(PersistentCachePackTest, ImportsLegacyFiles) {
+  PackDirectory dir;
+  const std::string legacy_name = fml::Base32Encode("key1").second;
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), legacy_name.c_str(),
+                                   MakeMapping("value1")));
+  // Not named by a key.
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), "shader_dump_1.skp",
+                                   MakeMapping("skp")));
+
+  {
+    auto pack = PersistentCachePack::Open(dir.fd(), false);
+    ASSERT_TRUE(pack);
+    ASSERT_EQ(pack->ImportLegacyFiles(dir.fd()), 1u);
+    ASSERT_EQ(ToString(pack->Find(*MakeData("key1"))), "value1");
+    ASSERT_FALSE(fml::FileExists(dir.fd(), legacy_name.c_str()));
+    ASSERT_TRUE(fml::FileExists(dir.fd(), "shader_dump_1.skp"));
+    // The files are only imported once.
+    ASSERT_EQ(pack->ImportLegacyFiles(dir.fd()), 0u);
+  }
+
+  auto pack = PersistentCachePack::Open(dir.fd(), true);
+  ASSERT_TRUE(pack);
+  ASSERT_EQ(ToString(pack->Find(*MakeData("key1"))), "value1");
+  ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "shader_dump_1.skp"));
+}
+
+}  // namespace testing
+}  // namespace flutter
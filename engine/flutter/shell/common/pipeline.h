@@ -5,14 +5,18 @@
 #ifndef FLUTTER_SHELL_COMMON_PIPELINE_H_
 #define FLUTTER_SHELL_COMMON_PIPELINE_H_
 
+#include "flutter/fml/compiler_specific.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/ref_counted.h"
-#include "flutter/fml/synchronization/semaphore.h"
 #include "flutter/fml/trace_event.h"
 
-#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <memory>
-#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace flutter {
 
@@ -26,6 +30,12 @@ size_t GetNextPipelineTraceID();
 
 /// A thread-safe queue of resources for a single consumer and a single
 /// producer.
+///
+/// The resources are stored in a ring buffer of |depth| slots allocated
+/// upfront. A slot is reserved by |Produce| and handed to the consumer once
+/// the continuation is completed, the producer and the consumer only
+/// synchronize through atomics and never block each other. Resources are
+/// consumed in the order their slots were reserved.
 template <class R>
 class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
  public:
@@ -36,23 +46,27 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
   /// preparing a completed pipeline resource.
   class ProducerContinuation {
    public:
-    ProducerContinuation() : trace_id_(0) {}
+    ProducerContinuation() : pipeline_(nullptr), slot_(0), trace_id_(0) {}
 
     ProducerContinuation(ProducerContinuation&& other)
-        : continuation_(other.continuation_), trace_id_(other.trace_id_) {
-      other.continuation_ = nullptr;
+        : pipeline_(other.pipeline_),
+          slot_(other.slot_),
+          trace_id_(other.trace_id_) {
+      other.pipeline_ = nullptr;
+      other.slot_ = 0;
       other.trace_id_ = 0;
     }
 
     ProducerContinuation& operator=(ProducerContinuation&& other) {
-      std::swap(continuation_, other.continuation_);
+      std::swap(pipeline_, other.pipeline_);
+      std::swap(slot_, other.slot_);
       std::swap(trace_id_, other.trace_id_);
       return *this;
     }
 
     ~ProducerContinuation() {
-      if (continuation_) {
-        continuation_(nullptr, trace_id_);
+      if (pipeline_) {
+        pipeline_->ProducerCommit(slot_, nullptr, trace_id_);
         TRACE_EVENT_ASYNC_END0("flutter", "PipelineProduce", trace_id_);
         // The continuation is being dropped on the floor. End the flow.
         TRACE_FLOW_END("flutter", "PipelineItem", trace_id_);
@@ -61,25 +75,28 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
     }
 
     void Complete(ResourcePtr resource) {
-      if (continuation_) {
-        continuation_(std::move(resource), trace_id_);
-        continuation_ = nullptr;
+      if (pipeline_) {
+        pipeline_->ProducerCommit(slot_, std::move(resource), trace_id_);
+        pipeline_ = nullptr;
         TRACE_EVENT_ASYNC_END0("flutter", "PipelineProduce", trace_id_);
         TRACE_FLOW_STEP("flutter", "PipelineItem", trace_id_);
       }
     }
 
-    operator bool() const { return continuation_ != nullptr; }
+    operator bool() const { return pipeline_ != nullptr; }
 
    private:
     friend class Pipeline;
-    using Continuation = std::function<void(ResourcePtr, size_t)>;
 
-    Continuation continuation_;
+    // Slot reserved by |ProduceToFront| rather than |Produce|.
+    static constexpr size_t kFrontSlot = std::numeric_limits<size_t>::max();
+
+    Pipeline* pipeline_;
+    size_t slot_;
     size_t trace_id_;
 
-    ProducerContinuation(Continuation continuation, size_t trace_id)
-        : continuation_(continuation), trace_id_(trace_id) {
+    ProducerContinuation(Pipeline* pipeline, size_t slot, size_t trace_id)
+        : pipeline_(pipeline), slot_(slot), trace_id_(trace_id) {
       TRACE_FLOW_BEGIN("flutter", "PipelineItem", trace_id_);
       TRACE_EVENT_ASYNC_BEGIN0("flutter", "PipelineItem", trace_id_);
       TRACE_EVENT_ASYNC_BEGIN0("flutter", "PipelineProduce", trace_id_);
@@ -88,22 +105,29 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
     FML_DISALLOW_COPY_AND_ASSIGN(ProducerContinuation);
   };
 
+  // A |depth| of zero is clamped to one slot.
   explicit Pipeline(uint32_t depth)
-      : depth_(depth), empty_(depth), available_(0) {}
+      : depth_(std::max<uint32_t>(depth, 1)),
+        slots_(new Slot[depth_]),
+        head_(0),
+        tail_(0) {
+    front_.reserve(depth_ + 1);
+  }
 
   ~Pipeline() = default;
 
-  bool IsValid() const { return empty_.IsValid() && available_.IsValid(); }
+  bool IsValid() const { return depth_ > 0; }
 
   ProducerContinuation Produce() {
-    if (!empty_.TryWait()) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= depth_) {
       return {};
     }
+    tail_.store(tail + 1, std::memory_order_release);
 
-    return ProducerContinuation{
-        std::bind(&Pipeline::ProducerCommit, this, std::placeholders::_1,
-                  std::placeholders::_2),  // continuation
-        GetNextPipelineTraceID()};         // trace id
+    return ProducerContinuation{this,                       // pipeline
+                                tail,                       // slot
+                                GetNextPipelineTraceID()};  // trace id
   }
 
   // Pushes task to the front of the pipeline.
@@ -112,12 +136,12 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
   // last frame to preserve the depth of the pipeline.
   //
   // Note: Use |Pipeline::Produce| where possible. This should only be
-  // used to en-queue high-priority resources.
+  // used to en-queue high-priority resources. The continuation must be
+  // completed on the consumer thread.
   ProducerContinuation ProduceToFront() {
-    return ProducerContinuation{
-        std::bind(&Pipeline::ProducerCommitFront, this, std::placeholders::_1,
-                  std::placeholders::_2),  // continuation
-        GetNextPipelineTraceID()};         // trace id
+    return ProducerContinuation{this,                              // pipeline
+                                ProducerContinuation::kFrontSlot,  // slot
+                                GetNextPipelineTraceID()};         // trace id
   }
 
   using Consumer = std::function<void(ResourcePtr)>;
@@ -128,19 +152,23 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
       return PipelineConsumeResult::NoneAvailable;
     }
 
-    if (!available_.TryWait()) {
-      return PipelineConsumeResult::NoneAvailable;
-    }
-
     ResourcePtr resource;
     size_t trace_id = 0;
-    size_t items_count = 0;
-
-    {
-      std::scoped_lock lock(queue_mutex_);
-      std::tie(resource, trace_id) = std::move(queue_.front());
-      queue_.pop_front();
-      items_count = queue_.size();
+    size_t head = SkipDroppedSlots();
+
+    if (!front_.empty()) {
+      std::tie(resource, trace_id) = std::move(front_.back());
+      front_.pop_back();
+      head = head_.load(std::memory_order_relaxed);
+    } else {
+      Slot& slot = slots_[head % depth_];
+      if (!slot.ready.load(std::memory_order_acquire)) {
+        return PipelineConsumeResult::NoneAvailable;
+      }
+      resource = std::move(slot.resource);
+      trace_id = slot.trace_id;
+      slot.ready.store(false, std::memory_order_relaxed);
+      head++;
     }
 
     {
@@ -148,43 +176,96 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
       consumer(std::move(resource));
     }
 
-    empty_.Signal();
+    // Only hand the slot back to the producer once the resource has been
+    // consumed so that at most |depth_| resources are alive at once.
+    head_.store(head, std::memory_order_release);
+    head = SkipDroppedSlots();
 
     TRACE_FLOW_END("flutter", "PipelineItem", trace_id);
     TRACE_EVENT_ASYNC_END0("flutter", "PipelineItem", trace_id);
 
-    return items_count > 0 ? PipelineConsumeResult::MoreAvailable
-                           : PipelineConsumeResult::Done;
+    const bool more_available =
+        !front_.empty() ||
+        slots_[head % depth_].ready.load(std::memory_order_acquire);
+    return more_available ? PipelineConsumeResult::MoreAvailable
+                          : PipelineConsumeResult::Done;
   }
 
  private:
-  uint32_t depth_;
-  fml::Semaphore empty_;
-  fml::Semaphore available_;
-  std::mutex queue_mutex_;
-  std::deque<std::pair<ResourcePtr, size_t>> queue_;
+  struct Slot {
+    // Written by the producer while false, by the consumer while true.
+    std::atomic_bool ready = {false};
+    ResourcePtr resource;
+    size_t trace_id = 0;
+    // Only accessed by the consumer. Set on ready slots that were dropped to
+    // make room for a resource pushed to the front.
+    bool dropped = false;
+  };
 
-  void ProducerCommit(ResourcePtr resource, size_t trace_id) {
-    {
-      std::scoped_lock lock(queue_mutex_);
-      queue_.emplace_back(std::move(resource), trace_id);
+  const uint32_t depth_;
+  std::unique_ptr<Slot[]> slots_;
+  // The next slot to consume, only written by the consumer.
+  std::atomic_size_t head_;
+  // The next slot to reserve, only written by the producer.
+  std::atomic_size_t tail_;
+  // Resources pushed to the front, the last one is consumed first. Only
+  // accessed by the consumer.
+  std::vector<std::pair<ResourcePtr, size_t>> front_;
+
+  void ProducerCommit(size_t slot_index,
+                      ResourcePtr resource,
+                      size_t trace_id) {
+    if (slot_index == ProducerContinuation::kFrontSlot) {
+      ProducerCommitFront(std::move(resource), trace_id);
+      return;
     }
-
-    // Ensure the queue mutex is not held as that would be a pessimization.
-    available_.Signal();
+    Slot& slot = slots_[slot_index % depth_];
+    slot.resource = std::move(resource);
+    slot.trace_id = trace_id;
+    slot.ready.store(true, std::memory_order_release);
   }
 
   void ProducerCommitFront(ResourcePtr resource, size_t trace_id) {
-    {
-      std::scoped_lock lock(queue_mutex_);
-      queue_.emplace_front(std::move(resource), trace_id);
-      while (queue_.size() > depth_) {
-        queue_.pop_back();
+    front_.emplace_back(std::move(resource), trace_id);
+
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    size_t count = front_.size();
+    for (size_t i = head; i < tail; i++) {
+      const Slot& slot = slots_[i % depth_];
+      if (!slot.dropped && slot.ready.load(std::memory_order_acquire)) {
+        count++;
+      }
+    }
+
+    // Drop the last completed resources, the slots being written by the
+    // producer are left alone.
+    for (size_t i = tail; i > head && count > depth_; i--) {
+      Slot& slot = slots_[(i - 1) % depth_];
+      if (!slot.dropped && slot.ready.load(std::memory_order_acquire)) {
+        slot.resource.reset();
+        slot.dropped = true;
+        count--;
       }
     }
+    while (count > depth_) {
+      front_.erase(front_.begin());
+      count--;
+    }
+  }
 
-    // Ensure the queue mutex is not held as that would be a pessimization.
-    available_.Signal();
+  // Hands the dropped slots at the head of the pipeline back to the producer
+  // and returns the new head.
+  size_t SkipDroppedSlots() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (slots_[head % depth_].dropped) {
+      Slot& slot = slots_[head % depth_];
+      slot.dropped = false;
+      slot.ready.store(false, std::memory_order_relaxed);
+      head++;
+    }
+    head_.store(head, std::memory_order_release);
+    return head;
   }
 
   FML_DISALLOW_COPY_AND_ASSIGN(Pipeline);
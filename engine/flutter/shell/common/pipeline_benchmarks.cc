@@ -0,0 +1,149 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#define FML_USED_ON_EMBEDDER
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/synchronization/semaphore.h"
+#include "flutter/shell/common/pipeline.h"
+
+namespace flutter {
+
+namespace {
+
+constexpr uint32_t kPipelineDepth = 2;
+
+// The handoff used by |Pipeline| before it was backed by a ring buffer: two
+// semaphores guarding a mutex protected deque, with a std::function bound for
+// every produced resource. Kept as the baseline of the benchmarks below.
+class SemaphorePipeline
+    : public fml::RefCountedThreadSafe<SemaphorePipeline> {
+ public:
+  using ResourcePtr = std::unique_ptr<int>;
+  using Continuation = std::function<void(ResourcePtr, size_t)>;
+
+  explicit SemaphorePipeline(uint32_t depth) : empty_(depth), available_(0) {}
+
+  Continuation Produce() {
+    if (!empty_.TryWait()) {
+      return nullptr;
+    }
+    return std::bind(&SemaphorePipeline::ProducerCommit, this,
+                     std::placeholders::_1, std::placeholders::_2);
+  }
+
+  bool Consume(const std::function<void(ResourcePtr)>& consumer) {
+    if (!available_.TryWait()) {
+      return false;
+    }
+    ResourcePtr resource;
+    {
+      std::scoped_lock lock(queue_mutex_);
+      resource = std::move(queue_.front().first);
+      queue_.pop_front();
+    }
+    consumer(std::move(resource));
+    empty_.Signal();
+    return true;
+  }
+
+ private:
+  fml::Semaphore empty_;
+  fml::Semaphore available_;
+  std::mutex queue_mutex_;
+  std::deque<std::pair<ResourcePtr, size_t>> queue_;
+
+  void ProducerCommit(ResourcePtr resource, size_t trace_id) {
+    {
+      std::scoped_lock lock(queue_mutex_);
+      queue_.emplace_back(std::move(resource), trace_id);
+    }
+    available_.Signal();
+  }
+};
+
+bool Produce(SemaphorePipeline& pipeline, int value) {
+  auto continuation = pipeline.Produce();
+  if (!continuation) {
+    return false;
+  }
+  continuation(std::make_unique<int>(value), 0);
+  return true;
+}
+
+bool Consume(SemaphorePipeline& pipeline, int& sum) {
+  return pipeline.Consume(
+      [&sum](std::unique_ptr<int> value) { sum += *value; });
+}
+
+bool Produce(Pipeline<int>& pipeline, int value) {
+  auto continuation = pipeline.Produce();
+  if (!continuation) {
+    return false;
+  }
+  continuation.Complete(std::make_unique<int>(value));
+  return true;
+}
+
+bool Consume(Pipeline<int>& pipeline, int& sum) {
+  return pipeline.Consume([&sum](std::unique_ptr<int> value) {
+           sum += *value;
+         }) != PipelineConsumeResult::NoneAvailable;
+}
+
+}  // namespace
+
+// Produces and consumes a resource on the same thread, which measures the
+// cost of the handoff itself.
+template <class P>
+static void BM_PipelineProduceAndConsume(benchmark::State& state) {
+  fml::RefPtr<P> pipeline = fml::MakeRefCounted<P>(kPipelineDepth);
+  int sum = 0;
+  while (state.KeepRunning()) {
+    Produce(*pipeline, 1);
+    Consume(*pipeline, sum);
+  }
+  benchmark::DoNotOptimize(sum);
+}
+
+// Hands |state.range(0)| resources from a producer thread to the benchmark
+// thread, like the animator and the rasterizer do for every frame.
+template <class P>
+static void BM_PipelineCrossThreadHandoff(benchmark::State& state) {
+  const int count = state.range(0);
+  fml::RefPtr<P> pipeline = fml::MakeRefCounted<P>(kPipelineDepth);
+  while (state.KeepRunning()) {
+    std::thread producer([&pipeline, count]() {
+      for (int i = 0; i < count;) {
+        if (Produce(*pipeline, 1)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    int sum = 0;
+    while (sum < count) {
+      if (!Consume(*pipeline, sum)) {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK_TEMPLATE(BM_PipelineProduceAndConsume, SemaphorePipeline);
+BENCHMARK_TEMPLATE(BM_PipelineProduceAndConsume, Pipeline<int>);
+BENCHMARK_TEMPLATE(BM_PipelineCrossThreadHandoff, SemaphorePipeline)
+    ->Arg(1000);
+BENCHMARK_TEMPLATE(BM_PipelineCrossThreadHandoff, Pipeline<int>)->Arg(1000);
+
+}  // namespace flutter
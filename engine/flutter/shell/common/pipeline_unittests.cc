@@ -131,5 +131,21 @@ TEST(PipelineTest, PushingToFrontDropsLastResource) {
   ASSERT_EQ(consume_result_2, PipelineConsumeResult::Done);
 }
 
+TEST(PipelineTest, ZeroDepthHoldsOneResource) {
+  fml::RefPtr<IntPipeline> pipeline = fml::MakeRefCounted<IntPipeline>(0);
+  ASSERT_TRUE(pipeline->IsValid());
+
+  Continuation continuation_1 = pipeline->Produce();
+  ASSERT_TRUE(continuation_1);
+  Continuation continuation_2 = pipeline->Produce();
+  ASSERT_FALSE(continuation_2);
+
+  const int test_val = 1;
+  continuation_1.Complete(std::make_unique<int>(test_val));
+  PipelineConsumeResult consume_result = pipeline->Consume(
+      [&test_val](std::unique_ptr<int> v) { ASSERT_EQ(*v, test_val); });
+  ASSERT_EQ(consume_result, PipelineConsumeResult::Done);
+}
+
 }  // namespace testing
 }  // namespace flutter
@@ -0,0 +1,62 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/lib/ui/window/platform_message.h"
+
+namespace flutter {
+
+// The hops a message goes through from the embedder to its handler: the
+// platform view, the shell and the engine only pass the reference along.
+static size_t DeliverMessage(fml::RefPtr<PlatformMessage> message) {
+  fml::RefPtr<PlatformMessage> platform_view_message = std::move(message);
+  fml::RefPtr<PlatformMessage> shell_message = std::move(platform_view_message);
+  fml::RefPtr<PlatformMessage> engine_message = std::move(shell_message);
+  const auto& data = engine_message->data();
+  return data.GetSize() > 0 ? data.GetMapping()[data.GetSize() - 1] : 0;
+}
+
+// Sends a message whose payload is copied out of the buffer of the embedder.
+static void BM_PlatformMessageCopiedPayload(benchmark::State& state) {
+  const std::vector<uint8_t> payload(state.range(0), 0x2a);
+  while (state.KeepRunning()) {
+    auto message = fml::MakeRefCounted<PlatformMessage>(
+        "test_channel", std::vector<uint8_t>(payload.begin(), payload.end()),
+        nullptr);
+    benchmark::DoNotOptimize(DeliverMessage(std::move(message)));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// Sends a message referring to the buffer of the embedder, which is released
+// through a callback once the message is collected.
+static void BM_PlatformMessageMappedPayload(benchmark::State& state) {
+  const std::vector<uint8_t> payload(state.range(0), 0x2a);
+  size_t release_count = 0;
+  while (state.KeepRunning()) {
+    auto message = fml::MakeRefCounted<PlatformMessage>(
+        "test_channel",
+        std::make_unique<fml::NonOwnedMapping>(
+            payload.data(), payload.size(),
+            [&release_count](const uint8_t* data, size_t size) {
+              release_count++;
+            }),
+        nullptr);
+    benchmark::DoNotOptimize(DeliverMessage(std::move(message)));
+  }
+  benchmark::DoNotOptimize(release_count);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PlatformMessageCopiedPayload)
+    ->RangeMultiplier(16)
+    ->Range(4 << 10, 4 << 20);
+BENCHMARK(BM_PlatformMessageMappedPayload)
+    ->RangeMultiplier(16)
+    ->Range(4 << 10, 4 << 20);
+
+}  // namespace flutter
@@ -8,6 +8,7 @@
 
 #include <utility>
 
+#include "flutter/fml/trace_buffer.h"
 #include "third_party/skia/include/core/SkEncodedImageFormat.h"
 #include "third_party/skia/include/core/SkImageEncoder.h"
 #include "third_party/skia/include/core/SkPictureRecorder.h"
@@ -148,6 +149,32 @@ void Rasterizer::Draw(fml::RefPtr<Pipeline<flutter::LayerTree>> pipeline) {
   }
 }
 
+// Writes the trace buffer to its jank trace path if |timing| missed its
+// vsync, i.e. was not rasterized within |frame_budget| of it. The file is
+// written on the IO thread.
+static void WriteJankTrace(const FrameTiming& timing,
+                           fml::TimeDelta frame_budget,
+                           const TaskRunners& task_runners) {
+  if (!fml::tracing::TraceBuffer::IsEnabled()) {
+    return;
+  }
+  fml::TimeDelta vsync_latency =
+      timing.Get(FrameTiming::kRasterFinish) - timing.vsync_start();
+  if (vsync_latency <= frame_budget) {
+    return;
+  }
+  auto& trace_buffer = fml::tracing::TraceBuffer::GetInstance();
+  std::shared_ptr<fml::tracing::TraceSnapshot> snapshot =
+      trace_buffer.TakeJankSnapshot();
+  if (!snapshot) {
+    return;
+  }
+  task_runners.GetIOTaskRunner()->PostTask(
+      [snapshot, path = trace_buffer.GetJankTracePath()]() {
+        snapshot->WriteChromeTraceToFile(path);
+      });
+}
+
 RasterStatus Rasterizer::DoDraw(
     std::unique_ptr<flutter::LayerTree> layer_tree) {
   FML_DCHECK(task_runners_.GetGPUTaskRunner()->RunsTasksOnCurrentThread());
@@ -157,6 +184,7 @@ RasterStatus Rasterizer::DoDraw(
   }
 
   FrameTiming timing;
+  timing.set_vsync_start(layer_tree->vsync_start());
   timing.Set(FrameTiming::kBuildStart, layer_tree->build_start());
   timing.Set(FrameTiming::kBuildFinish, layer_tree->build_finish());
   timing.Set(FrameTiming::kRasterStart, fml::TimePoint::Now());
@@ -183,6 +211,10 @@ RasterStatus Rasterizer::DoDraw(
   // Rasterizer::DoDraw finishes. Future work is needed to adapt the timestamp
   // for Fuchsia to capture SceneUpdateContext::ExecutePaintTasks.
   timing.Set(FrameTiming::kRasterFinish, fml::TimePoint::Now());
+  compositor_context_->RecordFrameTiming(timing);
+  WriteJankTrace(timing,
+                 compositor_context_->frame_timing_stats().frame_budget(),
+                 task_runners_);
   delegate_.OnFrameRasterized(timing);
 
   // Pipeline pressure is applied from a couple of places:
@@ -255,10 +287,21 @@ RasterStatus Rasterizer::DrawToSurface(flutter::LayerTree& layer_tree) {
   );
 
   if (compositor_frame) {
+    // Embedded platform views are composited by the embedder, the damage of
+    // the root surface alone does not describe what changed on screen.
+    const bool track_damage =
+        surface_->SupportsPartialRepaint() && !embedder_root_surface &&
+        external_view_embedder == nullptr;
+    if (track_damage) {
+      compositor_frame->EnableDamageTracking(frame->retains_contents());
+    }
     RasterStatus raster_status = compositor_frame->Raster(layer_tree, false);
     if (raster_status == RasterStatus::kFailed) {
       return raster_status;
     }
+    if (track_damage) {
+      frame->set_damage(compositor_frame->damage());
+    }
     frame->Submit();
     if (external_view_embedder != nullptr) {
       external_view_embedder->SubmitFrame(surface_->GetContext());
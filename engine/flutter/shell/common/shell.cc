@@ -17,6 +17,7 @@
 #include "flutter/fml/make_copyable.h"
 #include "flutter/fml/message_loop.h"
 #include "flutter/fml/paths.h"
+#include "flutter/fml/trace_buffer.h"
 #include "flutter/fml/trace_event.h"
 #include "flutter/fml/unique_fd.h"
 #include "flutter/runtime/dart_vm.h"
@@ -86,13 +87,30 @@ std::unique_ptr<Shell> Shell::CreateShellOnPlatformThread(
   fml::AutoResetWaitableEvent gpu_latch;
   std::unique_ptr<Rasterizer> rasterizer;
   fml::TaskRunner::RunNowOrPostTask(
-      task_runners.GetGPUTaskRunner(), [&gpu_latch,            //
-                                        &rasterizer,           //
-                                        on_create_rasterizer,  //
-                                        shell = shell.get()    //
+      task_runners.GetGPUTaskRunner(),
+      [&gpu_latch,            //
+       &rasterizer,           //
+       on_create_rasterizer,  //
+       shell = shell.get(),   //
+       worker_task_runner = shell->vm_->GetConcurrentWorkerTaskRunner(),  //
+       refresh_rate = vsync_waiter->GetDisplayRefreshRate()               //
   ]() {
         TRACE_EVENT0("flutter", "ShellSetupGPUSubsystem");
         if (auto new_rasterizer = on_create_rasterizer(*shell)) {
+          if (shell->GetSettings().raster_cache_on_worker_threads) {
+            // Raster cache entries of software surfaces don't need the GPU
+            // thread and are rasterized on the VM workers instead.
+            new_rasterizer->compositor_context()
+                ->raster_cache()
+                .SetConcurrentTaskRunner(worker_task_runner);
+          }
+          if (refresh_rate > VsyncWaiter::kUnknownRefreshRateFPS) {
+            fml::TimeDelta frame_budget =
+                fml::TimeDelta::FromSecondsF(1.0 / refresh_rate);
+            new_rasterizer->compositor_context()
+                ->frame_timing_stats()
+                .SetFrameBudget(frame_budget);
+          }
           rasterizer = std::move(new_rasterizer);
         }
         gpu_latch.Signal();
@@ -175,9 +193,14 @@ static void PerformInitializationTasks(const Settings& settings) {
     tonic::SetLogHandler(
         [](const char* message) { FML_LOG(ERROR) << message; });
 
-    if (settings.trace_skia) {
-      InitSkiaEventTracer(settings.trace_skia);
-    }
+    // Installed even when Skia isn't traced to the timeline so that Skia
+    // events land in the trace buffer while it is enabled. The tracer keeps
+    // the flag Skia checks up to date with both.
+    InitSkiaEventTracer(settings.trace_skia);
+
+    auto& trace_buffer = fml::tracing::TraceBuffer::GetInstance();
+    trace_buffer.SetJankTracePath(settings.jank_trace_path);
+    trace_buffer.SetEnabled(settings.enable_trace_buffer);
 
     if (!settings.skia_deterministic_rendering_on_cpu) {
       SkGraphics::Init();
@@ -304,6 +327,11 @@ Shell::Shell(DartVMRef vm, TaskRunners task_runners, Settings settings)
           task_runners_.GetUITaskRunner(),
           std::bind(&Shell::OnServiceProtocolGetDisplayRefreshRate, this,
                     std::placeholders::_1, std::placeholders::_2)};
+  service_protocol_handlers_
+      [ServiceProtocol::kGetFrameTimingStatsExtensionName] = {
+          task_runners_.GetGPUTaskRunner(),
+          std::bind(&Shell::OnServiceProtocolGetFrameTimingStats, this,
+                    std::placeholders::_1, std::placeholders::_2)};
 }
 
 Shell::~Shell() {
@@ -366,7 +394,13 @@ void Shell::NotifyLowMemoryWarning() const {
         }
       });
   // The IO Manager uses resource cache limits of 0, so it is not necessary
-  // to purge them.
+  // to purge them. The decoded images it keeps are released though.
+  task_runners_.GetIOTaskRunner()->PostTask(
+      [io_manager = io_manager_->GetWeakPtr()]() {
+        if (io_manager) {
+          io_manager->NotifyLowMemoryWarning();
+        }
+      });
 }
 
 void Shell::RunEngine(RunConfiguration run_configuration) {
@@ -473,6 +507,12 @@ bool Shell::Setup(std::unique_ptr<PlatformView> platform_view,
 
   vm_->GetServiceProtocol()->AddHandler(this, GetServiceProtocolDescription());
 
+  // The prefetch starts on the first worker task runner added to the cache.
+  if (settings_.persistent_cache_prefetch_byte_budget > 0) {
+    PersistentCache::gPrefetchByteBudget =
+        settings_.persistent_cache_prefetch_byte_budget;
+  }
+
   PersistentCache::GetCacheForProcess()->AddWorkerTaskRunner(
       task_runners_.GetIOTaskRunner());
 
@@ -935,7 +975,8 @@ void Shell::HandleEngineSkiaMessage(fml::RefPtr<PlatformMessage> message) {
   const auto& data = message->data();
 
   rapidjson::Document document;
-  document.Parse(reinterpret_cast<const char*>(data.data()), data.size());
+  document.Parse(reinterpret_cast<const char*>(data.GetMapping()),
+                 data.GetSize());
   if (document.HasParseError() || !document.IsObject())
     return;
   auto root = document.GetObject();
@@ -1013,6 +1054,14 @@ void Shell::OnFrameRasterized(const FrameTiming& timing) {
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetGPUTaskRunner()->RunsTasksOnCurrentThread());
 
+  // The animator schedules the next frames from the timing of every frame.
+  task_runners_.GetUITaskRunner()->PostTask(
+      [timing, engine = weak_engine_]() {
+        if (engine) {
+          engine->OnFrameRasterized(timing);
+        }
+      });
+
   // The C++ callback defined in settings.h and set by Flutter runner. This is
   // independent of the timings report to the Dart side.
   if (settings_.frame_rasterized_callback) {
@@ -1259,6 +1308,85 @@ bool Shell::OnServiceProtocolGetDisplayRefreshRate(
   return true;
 }
 
+static rapidjson::Value FrameTimingHistogramToJson(
+    const DurationHistogram& histogram,
+    rapidjson::Document::AllocatorType& allocator) {
+  rapidjson::Value json(rapidjson::kObjectType);
+  json.AddMember("p50", histogram.GetPercentile(50).ToMicroseconds(),
+                 allocator);
+  json.AddMember("p90", histogram.GetPercentile(90).ToMicroseconds(),
+                 allocator);
+  json.AddMember("p99", histogram.GetPercentile(99).ToMicroseconds(),
+                 allocator);
+  json.AddMember("max", histogram.max().ToMicroseconds(), allocator);
+  return json;
+}
+
+// Service protocol handler
+bool Shell::OnServiceProtocolGetFrameTimingStats(
+    const ServiceProtocol::Handler::ServiceProtocolMap& params,
+    rapidjson::Document& response) {
+  FML_DCHECK(task_runners_.GetGPUTaskRunner()->RunsTasksOnCurrentThread());
+  if (!rasterizer_) {
+    ServiceProtocolFailureError(response, "Rasterizer is not available.");
+    return false;
+  }
+  FrameTimingStats& stats =
+      rasterizer_->compositor_context()->frame_timing_stats();
+
+  response.SetObject();
+  auto& allocator = response.GetAllocator();
+  response.AddMember("type", "FrameTimingStats", allocator);
+  response.AddMember("frameBudgetMicros",
+                     stats.frame_budget().ToMicroseconds(), allocator);
+  response.AddMember("frameCount", static_cast<uint64_t>(stats.frame_count()),
+                     allocator);
+  response.AddMember(
+      "buildTimeMicros",
+      FrameTimingHistogramToJson(stats.build_times(), allocator), allocator);
+  response.AddMember(
+      "rasterTimeMicros",
+      FrameTimingHistogramToJson(stats.raster_times(), allocator), allocator);
+  response.AddMember(
+      "vsyncLatencyMicros",
+      FrameTimingHistogramToJson(stats.vsync_latencies(), allocator),
+      allocator);
+  response.AddMember("missedVsyncCount",
+                     static_cast<uint64_t>(stats.missed_vsync_count()),
+                     allocator);
+  response.AddMember("slowFrameCount",
+                     static_cast<uint64_t>(stats.slow_frame_count()),
+                     allocator);
+  response.AddMember("slowBuildCount",
+                     static_cast<uint64_t>(stats.slow_build_count()),
+                     allocator);
+  response.AddMember("slowRasterCount",
+                     static_cast<uint64_t>(stats.slow_raster_count()),
+                     allocator);
+
+  rapidjson::Value layer_paint_micros(rapidjson::kObjectType);
+  for (size_t i = 0; i < static_cast<size_t>(LayerPaintKind::kCount); i++) {
+    LayerPaintKind kind = static_cast<LayerPaintKind>(i);
+    layer_paint_micros.AddMember(
+        rapidjson::StringRef(GetLayerPaintKindName(kind)),
+        stats.slow_frame_layer_paint_times().Get(kind).ToMicroseconds(),
+        allocator);
+  }
+  response.AddMember("slowFrameLayerPaintMicros", layer_paint_micros,
+                     allocator);
+  response.AddMember(
+      "slowFrameRasterCacheMissCount",
+      static_cast<uint64_t>(stats.slow_frame_raster_cache_miss_count()),
+      allocator);
+
+  // Lets tools measure an interaction by resetting the stats before it.
+  auto reset = params.find("reset");
+  if (reset != params.end() && reset->second == "true") {
+    stats.Reset();
+  }
+  return true;
+}
+
 // Service protocol handler
 bool Shell::OnServiceProtocolSetAssetBundlePath(
     const ServiceProtocol::Handler::ServiceProtocolMap& params,
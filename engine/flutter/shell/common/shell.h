@@ -122,8 +122,9 @@ class Shell final : public PlatformView::Delegate,
 
   //----------------------------------------------------------------------------
   /// @brief      Used by embedders to notify that there is a low memory
-  ///             warning. The shell will attempt to purge caches. Current, only
-  ///             the rasterizer cache is purged.
+  ///             warning. The shell will attempt to purge caches. Currently,
+  ///             the rasterizer caches and the decoded images kept for the IO
+  ///             manager are purged.
   void NotifyLowMemoryWarning() const;
 
   //----------------------------------------------------------------------------
@@ -2,15 +2,62 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <sstream>
+
 #include "flutter/benchmarking/benchmarking.h"
+#include "flutter/flow/layers/picture_layer.h"
+#include "flutter/fml/file.h"
 #include "flutter/fml/logging.h"
+#include "flutter/fml/synchronization/waitable_event.h"
 #include "flutter/runtime/dart_vm.h"
+#include "flutter/shell/common/persistent_cache.h"
 #include "flutter/shell/common/shell.h"
+#include "flutter/shell/common/shell_test.h"
 #include "flutter/shell/common/thread_host.h"
 #include "flutter/testing/testing.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+#include "third_party/skia/include/effects/SkGradientShader.h"
 
 namespace flutter {
 
+// The settings of shells running the fixtures in |assets_dir|, which must
+// outlive them.
+static Settings CreateSettings(const fml::UniqueFD& assets_dir) {
+  Settings settings = {};
+  settings.task_observer_add = [](intptr_t, fml::closure) {};
+  settings.task_observer_remove = [](intptr_t) {};
+
+  if (DartVM::IsRunningPrecompiledCode()) {
+    settings.vm_snapshot_data = [&assets_dir]() {
+      return fml::FileMapping::CreateReadOnly(assets_dir, "vm_snapshot_data");
+    };
+
+    settings.isolate_snapshot_data = [&assets_dir]() {
+      return fml::FileMapping::CreateReadOnly(assets_dir,
+                                              "isolate_snapshot_data");
+    };
+
+    settings.vm_snapshot_instr = [&assets_dir]() {
+      return fml::FileMapping::CreateReadExecute(assets_dir,
+                                                 "vm_snapshot_instr");
+    };
+
+    settings.isolate_snapshot_instr = [&assets_dir]() {
+      return fml::FileMapping::CreateReadExecute(assets_dir,
+                                                 "isolate_snapshot_instr");
+    };
+
+  } else {
+    settings.application_kernels = [&assets_dir]() {
+      std::vector<std::unique_ptr<const fml::Mapping>> kernel_mappings;
+      kernel_mappings.emplace_back(
+          fml::FileMapping::CreateReadOnly(assets_dir, "kernel_blob.bin"));
+      return kernel_mappings;
+    };
+  }
+  return settings;
+}
+
 static void StartupAndShutdownShell(benchmark::State& state,
                                     bool measure_startup,
                                     bool measure_shutdown) {
@@ -20,38 +67,7 @@ static void StartupAndShutdownShell(benchmark::State& state,
   std::unique_ptr<ThreadHost> thread_host;
   {
     benchmarking::ScopedPauseTiming pause(state, !measure_startup);
-    Settings settings = {};
-    settings.task_observer_add = [](intptr_t, fml::closure) {};
-    settings.task_observer_remove = [](intptr_t) {};
-
-    if (DartVM::IsRunningPrecompiledCode()) {
-      settings.vm_snapshot_data = [&]() {
-        return fml::FileMapping::CreateReadOnly(assets_dir, "vm_snapshot_data");
-      };
-
-      settings.isolate_snapshot_data = [&]() {
-        return fml::FileMapping::CreateReadOnly(assets_dir,
-                                                "isolate_snapshot_data");
-      };
-
-      settings.vm_snapshot_instr = [&]() {
-        return fml::FileMapping::CreateReadExecute(assets_dir,
-                                                   "vm_snapshot_instr");
-      };
-
-      settings.isolate_snapshot_instr = [&]() {
-        return fml::FileMapping::CreateReadExecute(assets_dir,
-                                                   "isolate_snapshot_instr");
-      };
-
-    } else {
-      settings.application_kernels = [&]() {
-        std::vector<std::unique_ptr<const fml::Mapping>> kernel_mappings;
-        kernel_mappings.emplace_back(
-            fml::FileMapping::CreateReadOnly(assets_dir, "kernel_blob.bin"));
-        return kernel_mappings;
-      };
-    }
+    Settings settings = CreateSettings(assets_dir);
 
     thread_host = std::make_unique<ThreadHost>(
         "io.flutter.bench.", ThreadHost::Type::Platform |
@@ -109,4 +125,141 @@ static void BM_ShellInitializationAndShutdown(benchmark::State& state) {
 
 BENCHMARK(BM_ShellInitializationAndShutdown);
 
+namespace {
+
+constexpr double kFrameSize = 256;
+
+// Draws with enough different paints for Skia to compile and cache a few
+// programs, like the first frame of an application.
+sk_sp<SkPicture> MakeFirstFramePicture() {
+  SkPictureRecorder recorder;
+  SkCanvas* canvas =
+      recorder.beginRecording(SkRect::MakeWH(kFrameSize, kFrameSize));
+  const SkPoint points[] = {SkPoint::Make(0, 0),
+                            SkPoint::Make(kFrameSize, kFrameSize)};
+  const SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+  SkPaint paint;
+  paint.setAntiAlias(true);
+  paint.setShader(SkGradientShader::MakeLinear(points, colors, nullptr, 2,
+                                               SkTileMode::kClamp));
+  canvas->drawRRect(SkRRect::MakeRectXY(SkRect::MakeWH(kFrameSize, kFrameSize),
+                                        kFrameSize / 8, kFrameSize / 8),
+                    paint);
+  paint.setShader(SkGradientShader::MakeRadial(
+      SkPoint::Make(kFrameSize / 2, kFrameSize / 2), kFrameSize / 4, colors,
+      nullptr, 2, SkTileMode::kMirror));
+  canvas->drawCircle(kFrameSize / 2, kFrameSize / 2, kFrameSize / 4, paint);
+  paint.setShader(nullptr);
+  paint.setStyle(SkPaint::kStroke_Style);
+  paint.setStrokeWidth(3);
+  canvas->drawOval(SkRect::MakeWH(kFrameSize, kFrameSize / 2), paint);
+  return recorder.finishRecordingAsPicture();
+}
+
+// Starts a shell rendering on a GL surface, so that its GrContext loads its
+// programs from the persistent cache, and renders the first frame. When
+// |timed|, the timing is paused while the shell shuts down.
+void StartupShellAndRenderFirstFrame(benchmark::State& state, bool timed) {
+  auto assets_dir = fml::OpenDirectory(testing::GetFixturesPath(), false,
+                                       fml::FilePermission::kRead);
+  fml::AutoResetWaitableEvent frame_rasterized;
+  std::unique_ptr<Shell> shell;
+  std::unique_ptr<ThreadHost> thread_host;
+  {
+    Settings settings = CreateSettings(assets_dir);
+    settings.frame_rasterized_callback =
+        [&frame_rasterized](const FrameTiming&) { frame_rasterized.Signal(); };
+
+    thread_host = std::make_unique<ThreadHost>(
+        "io.flutter.bench.", ThreadHost::Type::Platform |
+                                 ThreadHost::Type::GPU | ThreadHost::Type::IO |
+                                 ThreadHost::Type::UI);
+
+    TaskRunners task_runners("test",
+                             thread_host->platform_thread->GetTaskRunner(),
+                             thread_host->gpu_thread->GetTaskRunner(),
+                             thread_host->ui_thread->GetTaskRunner(),
+                             thread_host->io_thread->GetTaskRunner());
+
+    shell = Shell::Create(
+        task_runners, settings,
+        [](Shell& shell) {
+          return std::make_unique<testing::ShellTestPlatformView>(
+              shell, shell.GetTaskRunners());
+        },
+        [](Shell& shell) {
+          return std::make_unique<Rasterizer>(shell, shell.GetTaskRunners());
+        });
+    FML_CHECK(shell);
+
+    testing::ShellTest::PlatformViewNotifyCreated(shell.get());
+    testing::ShellTest::PumpOneFrame(
+        shell.get(), kFrameSize, kFrameSize,
+        [ui_task_runner = task_runners.GetUITaskRunner()](
+            std::shared_ptr<ContainerLayer> root) {
+          auto unref_queue = fml::MakeRefCounted<SkiaUnrefQueue>(
+              ui_task_runner, fml::TimeDelta::Zero());
+          root->Add(std::make_shared<PictureLayer>(
+              SkPoint::Make(0, 0),
+              SkiaGPUObject<SkPicture>(MakeFirstFramePicture(),
+                                       std::move(unref_queue)),
+              false, false));
+        });
+    frame_rasterized.Wait();
+  }
+
+  {
+    benchmarking::ScopedPauseTiming pause(state, timed);
+    // Lets the IO thread write the programs compiled for the frame to the
+    // cache before it is joined.
+    fml::AutoResetWaitableEvent stored;
+    thread_host->io_thread->GetTaskRunner()->PostTask(
+        [&stored]() { stored.Signal(); });
+    stored.Wait();
+    shell.reset();
+    thread_host.reset();
+  }
+}
+
+}  // namespace
+
+// Starts a shell and renders its first frame with up to |state.range(0)| bytes
+// of the persistent cache read into memory as soon as the IO thread is
+// available. The cache is filled by rendering the frame once beforehand, and
+// opened again before every iteration, so that each of them prefetches it and
+// loads the programs of the frame. The label shows what the cache served in the
+// last iteration. The file of the cache stays in the page cache of the OS
+// across iterations.
+static void BM_ShellInitializationWithPersistentCachePrefetch(
+    benchmark::State& state) {
+  fml::ScopedTemporaryDirectory cache_dir;
+  PersistentCache::SetCacheDirectoryPath(cache_dir.path());
+  PersistentCache::ResetCacheForProcess();
+  StartupShellAndRenderFirstFrame(state, false);
+
+  PersistentCache::gPrefetchByteBudget = state.range(0);
+  while (state.KeepRunning()) {
+    {
+      benchmarking::ScopedPauseTiming pause(state);
+      PersistentCache::ResetCacheForProcess();
+    }
+    StartupShellAndRenderFirstFrame(state, true);
+  }
+  PersistentCache::gPrefetchByteBudget = 0;
+
+  const auto stats = PersistentCache::GetCacheForProcess()->GetStats();
+  std::stringstream label;
+  label << "hits=" << stats.hit_count << " misses=" << stats.miss_count
+        << " hit_bytes=" << stats.hit_bytes
+        << " prefetched_bytes=" << stats.prefetched_bytes;
+  state.SetLabel(label.str());
+
+  PersistentCache::SetCacheDirectoryPath("");
+  PersistentCache::ResetCacheForProcess();
+}
+
+BENCHMARK(BM_ShellInitializationWithPersistentCachePrefetch)
+    ->Arg(0)
+    ->Arg(8 << 20);
+
 }  // namespace flutter
@@ -5,6 +5,7 @@
 #include "flutter/shell/common/shell_io_manager.h"
 
 #include "flutter/fml/message_loop.h"
+#include "flutter/lib/ui/painting/image_decoder_cache.h"
 #include "flutter/shell/common/persistent_cache.h"
 #include "third_party/skia/include/gpu/gl/GrGLInterface.h"
 
@@ -64,6 +65,9 @@ ShellIOManager::ShellIOManager(
 }
 
 ShellIOManager::~ShellIOManager() {
+  // The cached images are released through the queue, which is about to stop
+  // accepting objects.
+  ImageDecoderCache::GetInstance().Purge(unref_queue_.get());
   // Last chance to drain the IO queue as the platform side reference to the
   // underlying OpenGL context may be going away.
   unref_queue_->Drain(true);
@@ -80,6 +84,9 @@ void ShellIOManager::NotifyResourceContextAvailable(
 }
 
 void ShellIOManager::UpdateResourceContext(sk_sp<GrContext> resource_context) {
+  // The cached images were uploaded to the previous context and would keep it
+  // alive.
+  ImageDecoderCache::GetInstance().Purge(unref_queue_.get());
   resource_context_ = std::move(resource_context);
   resource_context_weak_factory_ =
       resource_context_ ? std::make_unique<fml::WeakPtrFactory<GrContext>>(
@@ -87,6 +94,10 @@ void ShellIOManager::UpdateResourceContext(sk_sp<GrContext> resource_context) {
                         : nullptr;
 }
 
+void ShellIOManager::NotifyLowMemoryWarning() {
+  ImageDecoderCache::GetInstance().Purge(unref_queue_.get());
+}
+
 fml::WeakPtr<ShellIOManager> ShellIOManager::GetWeakPtr() {
   return weak_factory_.GetWeakPtr();
 }
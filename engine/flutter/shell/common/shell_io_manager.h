@@ -40,6 +40,10 @@ class ShellIOManager final : public IOManager {
   // resource context, but may be called if the Dart VM is restarted.
   void UpdateResourceContext(sk_sp<GrContext> resource_context);
 
+  // Releases the images decoded for this IO manager that the image decoder
+  // cache keeps.
+  void NotifyLowMemoryWarning();
+
   fml::WeakPtr<ShellIOManager> GetWeakPtr();
 
   // |IOManager|
@@ -17,6 +17,56 @@
 namespace flutter {
 namespace testing {
 
+ShellTestVsyncClock::ShellTestVsyncClock(fml::TimeDelta frame_interval)
+    : frame_interval_(frame_interval) {}
+
+ShellTestVsyncClock::~ShellTestVsyncClock() = default;
+
+fml::TimePoint ShellTestVsyncClock::SimulateVSync() {
+  std::function<void(fml::TimePoint)> fire;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    vsync_awaited_.wait(lock, [this]() { return !!pending_vsync_; });
+    fire = std::move(pending_vsync_);
+    pending_vsync_ = nullptr;
+  }
+  fml::TimePoint frame_start_time = fml::TimePoint::Now();
+  fire(frame_start_time);
+  return frame_start_time;
+}
+
+void ShellTestVsyncClock::AwaitVSync(std::function<void(fml::TimePoint)> fire) {
+  {
+    std::scoped_lock lock(mutex_);
+    pending_vsync_ = std::move(fire);
+  }
+  vsync_awaited_.notify_all();
+}
+
+ShellTestVsyncWaiter::ShellTestVsyncWaiter(
+    TaskRunners task_runners,
+    std::shared_ptr<ShellTestVsyncClock> clock)
+    : VsyncWaiter(std::move(task_runners)), clock_(std::move(clock)) {}
+
+ShellTestVsyncWaiter::~ShellTestVsyncWaiter() = default;
+
+// |VsyncWaiter|
+float ShellTestVsyncWaiter::GetDisplayRefreshRate() const {
+  return 1.0 / clock_->frame_interval().ToSecondsF();
+}
+
+// |VsyncWaiter|
+void ShellTestVsyncWaiter::AwaitVSync() {
+  std::weak_ptr<VsyncWaiter> weak_waiter = shared_from_this();
+  clock_->AwaitVSync([weak_waiter, frame_interval = clock_->frame_interval()](
+                         fml::TimePoint frame_start_time) {
+    if (auto waiter = weak_waiter.lock()) {
+      static_cast<ShellTestVsyncWaiter*>(waiter.get())
+          ->FireCallback(frame_start_time, frame_start_time + frame_interval);
+    }
+  });
+}
+
 ShellTest::ShellTest()
     : native_resolver_(std::make_shared<TestDartNativeResolver>()) {}
 
@@ -101,15 +151,18 @@ void ShellTest::RunEngine(Shell* shell, RunConfiguration configuration) {
   latch.Wait();
 }
 
-void ShellTest::PumpOneFrame(Shell* shell) {
+void ShellTest::PumpOneFrame(Shell* shell,
+                             double width,
+                             double height,
+                             LayerTreeBuilder builder) {
   // Set viewport to nonempty, and call Animator::BeginFrame to make the layer
   // tree pipeline nonempty. Without either of this, the layer tree below
   // won't be rasterized.
   fml::AutoResetWaitableEvent latch;
   shell->GetTaskRunners().GetUITaskRunner()->PostTask(
-      [&latch, engine = shell->weak_engine_]() {
+      [&latch, engine = shell->weak_engine_, width, height]() {
         engine->SetViewportMetrics(
-            {1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+            {1, width, height, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
         engine->animator_->BeginFrame(fml::TimePoint::Now(),
                                       fml::TimePoint::Now());
         latch.Signal();
@@ -120,11 +173,14 @@ void ShellTest::PumpOneFrame(Shell* shell) {
   // Call |Render| to rasterize a layer tree and trigger |OnFrameRasterized|
   fml::WeakPtr<RuntimeDelegate> runtime_delegate = shell->weak_engine_;
   shell->GetTaskRunners().GetUITaskRunner()->PostTask(
-      [&latch, runtime_delegate]() {
+      [&latch, runtime_delegate, &builder]() {
         auto layer_tree = std::make_unique<LayerTree>();
         SkMatrix identity;
         identity.setIdentity();
         auto root_layer = std::make_shared<TransformLayer>(identity);
+        if (builder) {
+          builder(root_layer);
+        }
         layer_tree->set_root_layer(root_layer);
         runtime_delegate->Render(std::move(layer_tree));
         latch.Signal();
@@ -132,6 +188,16 @@ void ShellTest::PumpOneFrame(Shell* shell) {
   latch.Wait();
 }
 
+void ShellTest::RequestFrame(Shell* shell) {
+  fml::AutoResetWaitableEvent latch;
+  shell->GetTaskRunners().GetUITaskRunner()->PostTask(
+      [&latch, engine = shell->weak_engine_]() {
+        engine->animator_->RequestFrame();
+        latch.Signal();
+      });
+  latch.Wait();
+}
+
 int ShellTest::UnreportedTimingsCount(Shell* shell) {
   return shell->unreported_timings_.size();
 }
@@ -176,11 +242,18 @@ std::unique_ptr<Shell> ShellTest::CreateShell(Settings settings) {
 
 std::unique_ptr<Shell> ShellTest::CreateShell(Settings settings,
                                               TaskRunners task_runners) {
+  return CreateShell(std::move(settings), std::move(task_runners), nullptr);
+}
+
+std::unique_ptr<Shell> ShellTest::CreateShell(
+    Settings settings,
+    TaskRunners task_runners,
+    std::shared_ptr<ShellTestVsyncClock> vsync_clock) {
   return Shell::Create(
       task_runners, settings,
-      [](Shell& shell) {
-        return std::make_unique<ShellTestPlatformView>(shell,
-                                                       shell.GetTaskRunners());
+      [vsync_clock](Shell& shell) {
+        return std::make_unique<ShellTestPlatformView>(
+            shell, shell.GetTaskRunners(), vsync_clock);
       },
       [](Shell& shell) {
         return std::make_unique<Rasterizer>(shell, shell.GetTaskRunners());
@@ -210,12 +283,24 @@ void ShellTest::AddNativeCallback(std::string name,
   native_resolver_->AddNativeCallback(std::move(name), callback);
 }
 
-ShellTestPlatformView::ShellTestPlatformView(PlatformView::Delegate& delegate,
-                                             TaskRunners task_runners)
-    : PlatformView(delegate, std::move(task_runners)) {}
+ShellTestPlatformView::ShellTestPlatformView(
+    PlatformView::Delegate& delegate,
+    TaskRunners task_runners,
+    std::shared_ptr<ShellTestVsyncClock> vsync_clock)
+    : PlatformView(delegate, std::move(task_runners)),
+      vsync_clock_(std::move(vsync_clock)) {}
 
 ShellTestPlatformView::~ShellTestPlatformView() = default;
 
+// |PlatformView|
+std::unique_ptr<VsyncWaiter> ShellTestPlatformView::CreateVSyncWaiter(
+    int32_t platform) {
+  if (!vsync_clock_) {
+    return PlatformView::CreateVSyncWaiter(platform);
+  }
+  return std::make_unique<ShellTestVsyncWaiter>(task_runners_, vsync_clock_);
+}
+
 // |PlatformView|
 std::unique_ptr<Surface> ShellTestPlatformView::CreateRenderingSurface() {
   return std::make_unique<GPUSurfaceGL>(this, true);
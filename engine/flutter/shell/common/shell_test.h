@@ -5,14 +5,19 @@
 #ifndef FLUTTER_SHELL_COMMON_SHELL_TEST_H_
 #define FLUTTER_SHELL_COMMON_SHELL_TEST_H_
 
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 
 #include "flutter/common/settings.h"
+#include "flutter/flow/layers/container_layer.h"
 #include "flutter/fml/macros.h"
 #include "flutter/lib/ui/window/platform_message.h"
 #include "flutter/shell/common/run_configuration.h"
 #include "flutter/shell/common/shell.h"
 #include "flutter/shell/common/thread_host.h"
+#include "flutter/shell/common/vsync_waiter.h"
 #include "flutter/shell/gpu/gpu_surface_gl_delegate.h"
 #include "flutter/testing/test_dart_native_resolver.h"
 #include "flutter/testing/test_gl_surface.h"
@@ -21,6 +26,53 @@
 namespace flutter {
 namespace testing {
 
+// A vsync source fired by the tests instead of a timer, so that the scheduling
+// of frames can be tested and measured deterministically. Every simulated
+// vsync targets a frame displayed one frame interval later.
+class ShellTestVsyncClock {
+ public:
+  explicit ShellTestVsyncClock(fml::TimeDelta frame_interval);
+
+  ~ShellTestVsyncClock();
+
+  fml::TimeDelta frame_interval() const { return frame_interval_; }
+
+  // Waits for the animator to wait for a vsync, then fires the vsync now.
+  // Returns the start time of the frame.
+  fml::TimePoint SimulateVSync();
+
+ private:
+  friend class ShellTestVsyncWaiter;
+
+  const fml::TimeDelta frame_interval_;
+  std::mutex mutex_;
+  std::condition_variable vsync_awaited_;
+  std::function<void(fml::TimePoint)> pending_vsync_;
+
+  void AwaitVSync(std::function<void(fml::TimePoint)> fire);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ShellTestVsyncClock);
+};
+
+class ShellTestVsyncWaiter : public VsyncWaiter {
+ public:
+  ShellTestVsyncWaiter(TaskRunners task_runners,
+                       std::shared_ptr<ShellTestVsyncClock> clock);
+
+  ~ShellTestVsyncWaiter() override;
+
+  // |VsyncWaiter|
+  float GetDisplayRefreshRate() const override;
+
+ private:
+  std::shared_ptr<ShellTestVsyncClock> clock_;
+
+  // |VsyncWaiter|
+  void AwaitVSync() override;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ShellTestVsyncWaiter);
+};
+
 class ShellTest : public ThreadTest {
  public:
   ShellTest();
@@ -31,6 +83,11 @@ class ShellTest : public ThreadTest {
   std::unique_ptr<Shell> CreateShell(Settings settings);
   std::unique_ptr<Shell> CreateShell(Settings settings,
                                      TaskRunners task_runners);
+  // Creates a shell whose vsyncs are simulated by |vsync_clock|.
+  std::unique_ptr<Shell> CreateShell(
+      Settings settings,
+      TaskRunners task_runners,
+      std::shared_ptr<ShellTestVsyncClock> vsync_clock);
   TaskRunners GetTaskRunnersForFixture();
 
   void SendEnginePlatformMessage(Shell* shell,
@@ -42,7 +99,19 @@ class ShellTest : public ThreadTest {
       Shell* shell);  // This creates the surface
   static void RunEngine(Shell* shell, RunConfiguration configuration);
 
-  static void PumpOneFrame(Shell* shell);
+  // Adds the layers of a frame to its |root|.
+  using LayerTreeBuilder =
+      std::function<void(std::shared_ptr<ContainerLayer> root)>;
+
+  // Renders a frame of |width| by |height| physical pixels, with the layers
+  // added by |builder| or nothing.
+  static void PumpOneFrame(Shell* shell,
+                           double width = 1,
+                           double height = 1,
+                           LayerTreeBuilder builder = {});
+
+  // Asks the animator for a new frame at the next vsync.
+  static void RequestFrame(Shell* shell);
 
   // Declare |UnreportedTimingsCount|, |GetNeedsReportTimings| and
   // |SetNeedsReportTimings| inside |ShellTest| mainly for easier friend class
@@ -73,13 +142,19 @@ class ShellTest : public ThreadTest {
 
 class ShellTestPlatformView : public PlatformView, public GPUSurfaceGLDelegate {
  public:
-  ShellTestPlatformView(PlatformView::Delegate& delegate,
-                        TaskRunners task_runners);
+  ShellTestPlatformView(
+      PlatformView::Delegate& delegate,
+      TaskRunners task_runners,
+      std::shared_ptr<ShellTestVsyncClock> vsync_clock = nullptr);
 
   ~ShellTestPlatformView() override;
 
  private:
   TestGLSurface gl_surface_;
+  std::shared_ptr<ShellTestVsyncClock> vsync_clock_;
+
+  // |PlatformView|
+  std::unique_ptr<VsyncWaiter> CreateVSyncWaiter(int32_t platform) override;
 
   // |PlatformView|
   std::unique_ptr<Surface> CreateRenderingSurface() override;
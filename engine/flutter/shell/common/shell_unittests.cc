@@ -16,6 +16,7 @@
 #include "flutter/fml/synchronization/count_down_latch.h"
 #include "flutter/fml/synchronization/waitable_event.h"
 #include "flutter/runtime/dart_vm.h"
+#include "flutter/shell/common/frame_deadline_predictor.h"
 #include "flutter/shell/common/platform_view.h"
 #include "flutter/shell/common/rasterizer.h"
 #include "flutter/shell/common/shell_test.h"
@@ -410,10 +411,67 @@ TEST_F(ShellTest, FrameRasterizedCallbackIsCalled) {
   std::vector<FrameTiming> timings = {timing};
   CheckFrameTimings(timings, start, finish);
 
-  // Check that onBeginFrame has the same timestamp as FrameTiming's build start
+  // Check that onBeginFrame has the same timestamp as FrameTiming's vsync
+  // start, and that the build starts when the frame is begun, which is at or
+  // after it.
+  int64_t vsync_start = timing.vsync_start().ToEpochDelta().ToMicroseconds();
+  ASSERT_EQ(vsync_start, begin_frame);
   int64_t build_start =
       timing.Get(FrameTiming::kBuildStart).ToEpochDelta().ToMicroseconds();
-  ASSERT_EQ(build_start, begin_frame);
+  ASSERT_GE(build_start, begin_frame);
+}
+
+TEST_F(ShellTest, BeginFrameIsDelayedUntilJustBeforeItsDeadline) {
+  auto settings = CreateSettingsForFixture();
+  fml::AutoResetWaitableEvent rasterized_latch;
+  settings.frame_rasterized_callback =
+      [&rasterized_latch](const FrameTiming& timing) {
+        rasterized_latch.Signal();
+      };
+  // A frame interval much longer than the test frames take.
+  auto vsync_clock = std::make_shared<ShellTestVsyncClock>(
+      fml::TimeDelta::FromMilliseconds(100));
+  std::unique_ptr<Shell> shell =
+      CreateShell(settings, GetTaskRunnersForFixture(), vsync_clock);
+
+  // Create the surface needed by rasterizer
+  PlatformViewNotifyCreated(shell.get());
+
+  auto configuration = RunConfiguration::InferFromSettings(settings);
+  configuration.SetEntrypoint("onBeginFrameMain");
+
+  fml::AutoResetWaitableEvent begin_frame_latch;
+  int64_t begin_frame = 0;
+  fml::TimePoint begin_frame_time;
+  auto nativeOnBeginFrame = [&begin_frame_latch, &begin_frame,
+                             &begin_frame_time](Dart_NativeArguments args) {
+    Dart_Handle exception = nullptr;
+    begin_frame =
+        tonic::DartConverter<int64_t>::FromArguments(args, 0, exception);
+    begin_frame_time = fml::TimePoint::Now();
+    begin_frame_latch.Signal();
+  };
+  AddNativeCallback("NativeOnBeginFrame",
+                    CREATE_NATIVE_ENTRY(nativeOnBeginFrame));
+
+  RunEngine(shell.get(), std::move(configuration));
+
+  // Time enough frames for the animator to predict how long they take.
+  for (size_t i = 0; i < FrameDeadlinePredictor::kMinFrameCount; i++) {
+    PumpOneFrame(shell.get());
+    rasterized_latch.Wait();
+  }
+  begin_frame_latch.Reset();
+
+  RequestFrame(shell.get());
+  fml::TimePoint frame_start_time = vsync_clock->SimulateVSync();
+  begin_frame_latch.Wait();
+
+  // The frame keeps the time of its vsync, but is only begun once the time
+  // left before the next vsync is about what the frames take.
+  ASSERT_EQ(begin_frame, frame_start_time.ToEpochDelta().ToMicroseconds());
+  ASSERT_GE(begin_frame_time - frame_start_time,
+            fml::TimeDelta::FromMilliseconds(50));
 }
 
 TEST(SettingsTest, FrameTimingSetsAndGetsProperly) {
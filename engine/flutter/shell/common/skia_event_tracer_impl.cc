@@ -5,9 +5,12 @@
 #include "flutter/shell/common/skia_event_tracer_impl.h"
 
 #define TRACE_EVENT_HIDE_MACROS
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 #include "flutter/fml/logging.h"
+#include "flutter/fml/trace_buffer.h"
 #include "flutter/fml/trace_event.h"
 #include "third_party/skia/include/utils/SkEventTracer.h"
 #include "third_party/skia/include/utils/SkTraceEventPhase.h"
@@ -20,7 +23,14 @@ class FlutterEventTracer : public SkEventTracer {
   static constexpr uint8_t kYes = 1;
   static constexpr uint8_t kNo = 0;
 
-  FlutterEventTracer(bool enabled) : enabled_(enabled ? kYes : kNo){};
+  FlutterEventTracer(bool enabled) : enabled_(enabled) {
+    fml::tracing::TraceBuffer::GetInstance().SetEnabledCallback(
+        [this](bool trace_buffer_enabled) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          trace_buffer_enabled_ = trace_buffer_enabled;
+          UpdateCategoryFlag();
+        });
+  }
 
   SkEventTracer::Handle addTraceEvent(char phase,
                                       const uint8_t* category_enabled_flag,
@@ -31,6 +41,9 @@ class FlutterEventTracer : public SkEventTracer {
                                       const uint8_t* p_arg_types,
                                       const uint64_t* p_arg_values,
                                       uint8_t flags) override {
+    if (!IsTracing()) {
+      return 0;
+    }
 #if defined(OS_FUCHSIA)
     // In a manner analogous to "fml/trace_event.h", use Fuchsia's system
     // tracing macros when running on Fuchsia.
@@ -84,6 +97,9 @@ class FlutterEventTracer : public SkEventTracer {
                                 SkEventTracer::Handle handle) override {
     // This is only ever called from a scoped trace event so we will just end
     // the section.
+    if (!IsTracing()) {
+      return;
+    }
 #if defined(OS_FUCHSIA)
     TRACE_DURATION_END(kSkiaTag, name);
 #else
@@ -92,7 +108,9 @@ class FlutterEventTracer : public SkEventTracer {
   }
 
   const uint8_t* getCategoryGroupEnabled(const char* name) override {
-    return &enabled_;
+    // Skia caches the pointer and reads the flag before every event, like
+    // Chromium reads its atomic category flags.
+    return reinterpret_cast<const uint8_t*>(&category_flag_);
   }
 
   const char* getCategoryGroupName(
@@ -100,10 +118,32 @@ class FlutterEventTracer : public SkEventTracer {
     return kSkiaTag;
   }
 
-  void enable() { enabled_ = kYes; }
+  void enable() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = true;
+    UpdateCategoryFlag();
+  }
 
  private:
-  uint8_t enabled_;
+  static_assert(sizeof(std::atomic<uint8_t>) == sizeof(uint8_t),
+                "Skia reads the category flag as a byte.");
+
+  std::mutex mutex_;
+  // Whether Skia is traced to the timeline.
+  bool enabled_;
+  bool trace_buffer_enabled_ = false;
+  std::atomic<uint8_t> category_flag_ = kNo;
+
+  bool IsTracing() const {
+    return category_flag_.load(std::memory_order_relaxed) == kYes;
+  }
+
+  // Called with |mutex_| held.
+  void UpdateCategoryFlag() {
+    category_flag_.store(enabled_ || trace_buffer_enabled_ ? kYes : kNo,
+                         std::memory_order_relaxed);
+  }
+
   FML_DISALLOW_COPY_AND_ASSIGN(FlutterEventTracer);
 };
 
@@ -10,8 +10,12 @@
 namespace flutter {
 
 SurfaceFrame::SurfaceFrame(sk_sp<SkSurface> surface,
-                           SubmitCallback submit_callback)
-    : submitted_(false), surface_(surface), submit_callback_(submit_callback) {
+                           SubmitCallback submit_callback,
+                           bool retains_contents)
+    : submitted_(false),
+      surface_(surface),
+      submit_callback_(submit_callback),
+      retains_contents_(retains_contents) {
   FML_DCHECK(submit_callback_);
 }
 
@@ -64,4 +68,8 @@ bool Surface::MakeRenderContextCurrent() {
   return true;
 }
 
+bool Surface::SupportsPartialRepaint() const {
+  return false;
+}
+
 }  // namespace flutter
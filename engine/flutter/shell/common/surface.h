@@ -6,6 +6,7 @@
 #define FLUTTER_SHELL_COMMON_SURFACE_H_
 
 #include <memory>
+#include <optional>
 
 #include "flutter/flow/compositor_context.h"
 #include "flutter/flow/embedded_views.h"
@@ -21,7 +22,11 @@ class SurfaceFrame {
   using SubmitCallback =
       std::function<bool(const SurfaceFrame& surface_frame, SkCanvas* canvas)>;
 
-  SurfaceFrame(sk_sp<SkSurface> surface, SubmitCallback submit_callback);
+  // |retains_contents| must only be set if |surface| still holds the pixels
+  // of the last frame submitted to the same |Surface|.
+  SurfaceFrame(sk_sp<SkSurface> surface,
+               SubmitCallback submit_callback,
+               bool retains_contents = false);
 
   ~SurfaceFrame();
 
@@ -31,10 +36,20 @@ class SurfaceFrame {
 
   sk_sp<SkSurface> SkiaSurface() const;
 
+  bool retains_contents() const { return retains_contents_; }
+
+  // The area of the surface repainted for this frame, or std::nullopt if the
+  // whole surface was repainted.
+  const std::optional<SkIRect>& damage() const { return damage_; }
+
+  void set_damage(const std::optional<SkIRect>& damage) { damage_ = damage; }
+
  private:
   bool submitted_;
   sk_sp<SkSurface> surface_;
   SubmitCallback submit_callback_;
+  const bool retains_contents_;
+  std::optional<SkIRect> damage_;
 
   bool PerformSubmit();
 
@@ -60,6 +75,10 @@ class Surface {
 
   virtual bool MakeRenderContextCurrent();
 
+  // Whether the surface can present frames of which only the damaged area has
+  // been repainted, see |SurfaceFrame::damage|.
+  virtual bool SupportsPartialRepaint() const;
+
  private:
   FML_DISALLOW_COPY_AND_ASSIGN(Surface);
 };
@@ -202,9 +202,21 @@ Settings SettingsFromCommandLine(const fml::CommandLine& command_line) {
   settings.enable_software_rendering =
       command_line.HasOption(FlagForSwitch(Switch::EnableSoftwareRendering));
 
+  settings.raster_cache_on_worker_threads =
+      command_line.HasOption(FlagForSwitch(Switch::RasterCacheOnWorkerThreads));
+
   settings.skia_deterministic_rendering_on_cpu =
       command_line.HasOption(FlagForSwitch(Switch::SkiaDeterministicRendering));
 
+  settings.enable_trace_buffer =
+      command_line.HasOption(FlagForSwitch(Switch::EnableTraceBuffer));
+
+  command_line.GetOptionValue(FlagForSwitch(Switch::JankTracePath),
+                              &settings.jank_trace_path);
+
+  GetSwitchValue(command_line, Switch::PersistentCachePrefetchByteBudget,
+                 &settings.persistent_cache_prefetch_byte_budget);
+
   settings.verbose_logging =
       command_line.HasOption(FlagForSwitch(Switch::VerboseLogging));
 
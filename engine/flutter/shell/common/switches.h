@@ -98,6 +98,10 @@ DEF_SWITCH(EnableSoftwareRendering,
            "Enable rendering using the Skia software backend. This is useful"
            "when testing Flutter on emulators. By default, Flutter will"
            "attempt to either use OpenGL or Vulkan.")
+DEF_SWITCH(RasterCacheOnWorkerThreads,
+           "raster-cache-on-worker-threads",
+           "Rasterize the raster cache entries of software surfaces on the VM "
+           "worker threads instead of the GPU thread.")
 DEF_SWITCH(SkiaDeterministicRendering,
            "skia-deterministic-rendering",
            "Skips the call to SkGraphics::Init(), thus avoiding swapping out"
@@ -125,6 +129,23 @@ DEF_SWITCH(TraceSkia,
            "Trace Skia calls. This is useful when debugging the GPU threed."
            "By default, Skia tracing is not enabled to reduce the number of "
            "traced events")
+DEF_SWITCH(EnableTraceBuffer,
+           "enable-trace-buffer",
+           "Record the most recent trace events of each thread in memory. "
+           "This is cheap enough to be left on in production. Also records "
+           "the Skia events.")
+DEF_SWITCH(JankTracePath,
+           "jank-trace-path",
+           "Path where the events recorded with --enable-trace-buffer are "
+           "written after a frame that missed its budget, in the Chrome "
+           "trace event format. At most one trace is written every 10 "
+           "seconds.")
+DEF_SWITCH(PersistentCachePrefetchByteBudget,
+           "persistent-cache-prefetch-byte-budget",
+           "The number of bytes of the persistent cache read into memory "
+           "ahead of the first frames, so that their shaders are loaded "
+           "without waiting on the disk. By default, the cache is not "
+           "prefetched.")
 DEF_SWITCH(DumpSkpOnShaderCompilation,
            "dump-skp-on-shader-compilation",
            "Automatically dump the skp that triggers new shader compilations. "
@@ -22,26 +22,36 @@ static fml::TimePoint SnapToNextTick(fml::TimePoint value,
 
 }  // namespace
 
-VsyncWaiterFallback::VsyncWaiterFallback(TaskRunners task_runners)
-    : VsyncWaiter(std::move(task_runners)), phase_(fml::TimePoint::Now()) {}
-
-VsyncWaiterFallback::~VsyncWaiterFallback() = default;
-
-// |VsyncWaiter|
-void VsyncWaiterFallback::AwaitVSync() {
 // ACE PC preview
 #if defined(WINDOWS_PLATFORM) || defined(MAC_PLATFORM)
-  constexpr fml::TimeDelta kSingleFrameInterval =
-      fml::TimeDelta::FromSecondsF(1.0 / 30.0);
+const fml::TimeDelta VsyncWaiterFallback::kDefaultFrameInterval =
+    fml::TimeDelta::FromSecondsF(1.0 / 30.0);
 #else
-  constexpr fml::TimeDelta kSingleFrameInterval =
-      fml::TimeDelta::FromSecondsF(1.0 / 60.0);
+const fml::TimeDelta VsyncWaiterFallback::kDefaultFrameInterval =
+    fml::TimeDelta::FromSecondsF(1.0 / 60.0);
 #endif
 
-  auto next =
-      SnapToNextTick(fml::TimePoint::Now(), phase_, kSingleFrameInterval);
+VsyncWaiterFallback::VsyncWaiterFallback(TaskRunners task_runners,
+                                         fml::TimeDelta frame_interval)
+    : VsyncWaiter(std::move(task_runners)),
+      frame_interval_(frame_interval),
+      phase_(fml::TimePoint::Now()) {
+  FML_DCHECK(frame_interval_ > fml::TimeDelta::Zero());
+}
+
+VsyncWaiterFallback::~VsyncWaiterFallback() = default;
+
+// |VsyncWaiter|
+float VsyncWaiterFallback::GetDisplayRefreshRate() const {
+  // Frames are produced at this rate, whatever the display does.
+  return 1.0 / frame_interval_.ToSecondsF();
+}
+
+// |VsyncWaiter|
+void VsyncWaiterFallback::AwaitVSync() {
+  auto next = SnapToNextTick(fml::TimePoint::Now(), phase_, frame_interval_);
 
-  FireCallback(next, next + kSingleFrameInterval);
+  FireCallback(next, next + frame_interval_);
 }
 
 }  // namespace flutter
@@ -12,14 +12,22 @@
 
 namespace flutter {
 
-/// A |VsyncWaiter| that will fire at 60 fps irrespective of the vsync.
+/// A |VsyncWaiter| that will fire at a fixed rate irrespective of the vsync,
+/// 60 fps unless told otherwise.
 class VsyncWaiterFallback final : public VsyncWaiter {
  public:
-  VsyncWaiterFallback(TaskRunners task_runners);
+  static const fml::TimeDelta kDefaultFrameInterval;
+
+  VsyncWaiterFallback(TaskRunners task_runners,
+                      fml::TimeDelta frame_interval = kDefaultFrameInterval);
 
   ~VsyncWaiterFallback() override;
 
+  // |VsyncWaiter|
+  float GetDisplayRefreshRate() const override;
+
  private:
+  const fml::TimeDelta frame_interval_;
   fml::TimePoint phase_;
 
   // |VsyncWaiter|
@@ -28,6 +28,15 @@ std::unique_ptr<SurfaceFrame> GPUSurfaceSoftware::AcquireFrame(
 
   const auto size = SkISize::Make(logical_size.width(), logical_size.height());
 
+  // A backing store of another size cannot hold the pixels of this frame. Let
+  // go of it before the delegate provides the new one, which may reuse its
+  // memory.
+  if (last_presented_backing_store_ != nullptr &&
+      size != SkISize::Make(last_presented_backing_store_->width(),
+                            last_presented_backing_store_->height())) {
+    last_presented_backing_store_ = nullptr;
+  }
+
   sk_sp<SkSurface> backing_store = delegate_->AcquireBackingStore(size);
 
   if (backing_store == nullptr) {
@@ -54,10 +63,19 @@ std::unique_ptr<SurfaceFrame> GPUSurfaceSoftware::AcquireFrame(
 
     canvas->flush();
 
+    self->last_presented_backing_store_ = surface_frame.SkiaSurface();
+    if (surface_frame.damage()) {
+      return self->delegate_->PresentBackingStoreWithDamage(
+          surface_frame.SkiaSurface(), *surface_frame.damage());
+    }
     return self->delegate_->PresentBackingStore(surface_frame.SkiaSurface());
   };
 
-  return std::make_unique<SurfaceFrame>(backing_store, on_submit);
+  const bool retains_contents =
+      backing_store == last_presented_backing_store_ ||
+      delegate_->BackingStoreHoldsLastPresentedFrame(backing_store);
+  return std::make_unique<SurfaceFrame>(backing_store, on_submit,
+                                        retains_contents);
 }
 
 // |Surface|
@@ -80,4 +98,9 @@ flutter::ExternalViewEmbedder* GPUSurfaceSoftware::GetExternalViewEmbedder() {
   return delegate_->GetExternalViewEmbedder();
 }
 
+// |Surface|
+bool GPUSurfaceSoftware::SupportsPartialRepaint() const {
+  return true;
+}
+
 }  // namespace flutter
@@ -33,8 +33,14 @@ class GPUSurfaceSoftware : public Surface {
   // |Surface|
   flutter::ExternalViewEmbedder* GetExternalViewEmbedder() override;
 
+  // |Surface|
+  bool SupportsPartialRepaint() const override;
+
  private:
   GPUSurfaceSoftwareDelegate* delegate_;
+  // The backing store of the last presented frame, a frame acquired with the
+  // same backing store still holds its pixels.
+  sk_sp<SkSurface> last_presented_backing_store_;
   fml::WeakPtrFactory<GPUSurfaceSoftware> weak_factory_;
 
   FML_DISALLOW_COPY_AND_ASSIGN(GPUSurfaceSoftware);
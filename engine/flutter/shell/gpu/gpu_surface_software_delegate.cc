@@ -6,6 +6,17 @@
 
 namespace flutter {
 
+bool GPUSurfaceSoftwareDelegate::PresentBackingStoreWithDamage(
+    sk_sp<SkSurface> backing_store,
+    const SkIRect& damage) {
+  return PresentBackingStore(std::move(backing_store));
+}
+
+bool GPUSurfaceSoftwareDelegate::BackingStoreHoldsLastPresentedFrame(
+    const sk_sp<SkSurface>& backing_store) const {
+  return false;
+}
+
 ExternalViewEmbedder* GPUSurfaceSoftwareDelegate::GetExternalViewEmbedder() {
   return nullptr;
 }
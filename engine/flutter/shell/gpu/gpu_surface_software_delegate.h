@@ -47,6 +47,39 @@ class GPUSurfaceSoftwareDelegate {
   ///
   virtual bool PresentBackingStore(sk_sp<SkSurface> backing_store) = 0;
 
+  //----------------------------------------------------------------------------
+  /// @brief      Called instead of |PresentBackingStore| when only part of the
+  ///             backing store has been repainted since the last frame. The
+  ///             pixels outside of the damage are those of the last presented
+  ///             frame. Platforms that copy the backing store to the screen
+  ///             may only copy the damaged area.
+  ///
+  /// @param[in]  backing_store  The software backing store to present.
+  /// @param[in]  damage         The repainted area, in pixels. May be empty
+  ///                            if nothing changed.
+  ///
+  /// @return     Returns if the platform could present the backing store onto
+  ///             the screen.
+  ///
+  virtual bool PresentBackingStoreWithDamage(sk_sp<SkSurface> backing_store,
+                                             const SkIRect& damage);
+
+  //----------------------------------------------------------------------------
+  /// @brief      Whether a backing store returned by |AcquireBackingStore|
+  ///             holds the pixels of the last presented frame even though it
+  ///             is not the backing store that was presented. Platforms that
+  ///             render into several backing stores in turn may copy the
+  ///             damaged area of the last frame into the next one, so that
+  ///             only the area that changed is repainted.
+  ///
+  /// @param[in]  backing_store  The software backing store about to be
+  ///                            rendered into.
+  ///
+  /// @return     Returns if |backing_store| holds the last presented frame.
+  ///
+  virtual bool BackingStoreHoldsLastPresentedFrame(
+      const sk_sp<SkSurface>& backing_store) const;
+
   //----------------------------------------------------------------------------
   /// @brief      Gets the view embedder that controls how the Flutter layer
   ///             hierarchy split into multiple chunks should be composited back
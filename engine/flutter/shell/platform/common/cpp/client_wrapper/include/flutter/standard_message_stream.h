@@ -0,0 +1,244 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_COMMON_CPP_CLIENT_WRAPPER_INCLUDE_FLUTTER_STANDARD_MESSAGE_STREAM_H_
+#define FLUTTER_SHELL_PLATFORM_COMMON_CPP_CLIENT_WRAPPER_INCLUDE_FLUTTER_STANDARD_MESSAGE_STREAM_H_
+
+// Streaming access to messages in the standard codec binary representation,
+// for channels where building an EncodableValue for every message is too
+// costly. Messages are read in place and written straight to a byte buffer,
+// producing the same encoding as StandardMessageCodec.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace flutter {
+
+// A fixed-type list of a message, referring to its elements in the message
+// buffer without copying them.
+template <typename T>
+class StandardTypedListView {
+ public:
+  StandardTypedListView() = default;
+
+  // Creates a view of |size| elements starting at |bytes|.
+  StandardTypedListView(const uint8_t* bytes, size_t size)
+      : bytes_(bytes), size_(size) {}
+
+  // Returns the number of elements in the list.
+  size_t size() const { return size_; }
+
+  // Returns true if the list has no elements.
+  bool empty() const { return size_ == 0; }
+
+  // Returns the element at |index|, which must be less than size().
+  T operator[](size_t index) const {
+    T value;
+    std::memcpy(&value, bytes_ + index * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  // Returns the elements as an array, or nullptr if they are not aligned for
+  // T. Lists are aligned relative to the start of the message, so this only
+  // returns nullptr if the message buffer itself is misaligned.
+  const T* data() const {
+    return reinterpret_cast<uintptr_t>(bytes_) % alignof(T) == 0
+               ? reinterpret_cast<const T*>(bytes_)
+               : nullptr;
+  }
+
+  // Returns the encoded elements, which take size() * sizeof(T) bytes.
+  const uint8_t* bytes() const { return bytes_; }
+
+ private:
+  const uint8_t* bytes_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Receives the values read by a StandardMessageReader, in the order they
+// appear in the message. The default implementations ignore the values, so
+// subclasses only need to override what they are interested in.
+//
+// Strings and lists passed to the visitor point into the message buffer, and
+// are only valid as long as it is.
+class StandardMessageVisitor {
+ public:
+  virtual ~StandardMessageVisitor() = default;
+
+  virtual void VisitNull() {}
+
+  virtual void VisitBool(bool value) {}
+
+  virtual void VisitInt(int32_t value) {}
+
+  virtual void VisitLong(int64_t value) {}
+
+  virtual void VisitDouble(double value) {}
+
+  // Called with the UTF-8 bytes of a string, which are not null-terminated.
+  virtual void VisitString(const char* data, size_t size) {}
+
+  virtual void VisitByteList(StandardTypedListView<uint8_t> list) {}
+
+  virtual void VisitIntList(StandardTypedListView<int32_t> list) {}
+
+  virtual void VisitLongList(StandardTypedListView<int64_t> list) {}
+
+  virtual void VisitDoubleList(StandardTypedListView<double> list) {}
+
+  // Called before the |length| elements of a list are visited.
+  virtual void BeginList(size_t length) {}
+
+  // Called after the last element of a list was visited.
+  virtual void EndList() {}
+
+  // Called before the |length| entries of a map are visited, each key being
+  // followed by its value.
+  virtual void BeginMap(size_t length) {}
+
+  // Called after the value of the last entry of a map was visited.
+  virtual void EndMap() {}
+};
+
+// Reads the values of a message encoded by the standard codec without
+// allocating, passing them to a visitor.
+class StandardMessageReader {
+ public:
+  // Creates a reader reading from |bytes|, which must have a length of |size|.
+  // |bytes| must remain valid for the lifetime of this object, and for as long
+  // as the strings and lists passed to visitors are used.
+  explicit StandardMessageReader(const uint8_t* bytes, size_t size);
+
+  ~StandardMessageReader();
+
+  // Prevent copying.
+  StandardMessageReader(StandardMessageReader const&) = delete;
+  StandardMessageReader& operator=(StandardMessageReader const&) = delete;
+
+  // Reads the next value, including the elements of collections, and passes
+  // it to |visitor|. Returns false if the message is malformed, in which case
+  // the visitor may have received part of the value and the reader is left at
+  // the end of the message.
+  bool ReadValue(StandardMessageVisitor* visitor);
+
+  // Skips over the next value. Returns false if the message is malformed.
+  bool SkipValue();
+
+  // Returns true if all of the message has been read.
+  bool AtEnd() const { return location_ >= size_; }
+
+ private:
+  // Reads the variable-length size at the current position into |size|.
+  bool ReadSize(size_t* size);
+
+  // Advances past the next |length| bytes, pointing |bytes| at them.
+  bool ReadBytes(size_t length, const uint8_t** bytes);
+
+  // Advances to the next multiple of |alignment| relative to the start of the
+  // message, unless the read position is already aligned.
+  bool ReadAlignment(size_t alignment);
+
+  // Reads a fixed-type list whose elements are of type T into |list|.
+  template <typename T>
+  bool ReadList(StandardTypedListView<T>* list);
+
+  // Marks the rest of the message as read and reports it as malformed.
+  bool Fail();
+
+  // The message to read from.
+  const uint8_t* bytes_;
+  // The total size of the message.
+  size_t size_;
+  // The current read location.
+  size_t location_ = 0;
+};
+
+// Writes values in the standard codec binary representation directly to a
+// byte buffer. Collections are written by starting them with their length
+// and then writing their elements.
+//
+// For example, the EncodableValue
+//   EncodableValue(EncodableMap{
+//       {EncodableValue("x"), EncodableValue(1.0)},
+//       {EncodableValue("values"), EncodableValue(EncodableList{
+//                                      EncodableValue(1),
+//                                  })},
+//   })
+// is written as
+//   writer.BeginMap(2);
+//   writer.WriteString("x");
+//   writer.WriteDouble(1.0);
+//   writer.WriteString("values");
+//   writer.BeginList(1);
+//   writer.WriteInt(1);
+class StandardMessageWriter {
+ public:
+  // Creates a writer appending to |buffer|, which must remain valid for the
+  // lifetime of this object. Clearing and reusing a buffer for each message
+  // avoids allocating once it has grown to the size of the messages.
+  explicit StandardMessageWriter(std::vector<uint8_t>* buffer);
+
+  ~StandardMessageWriter();
+
+  // Prevent copying.
+  StandardMessageWriter(StandardMessageWriter const&) = delete;
+  StandardMessageWriter& operator=(StandardMessageWriter const&) = delete;
+
+  void WriteNull();
+
+  void WriteBool(bool value);
+
+  void WriteInt(int32_t value);
+
+  void WriteLong(int64_t value);
+
+  void WriteDouble(double value);
+
+  // Writes the |size| UTF-8 bytes at |data| as a string.
+  void WriteString(const char* data, size_t size);
+
+  void WriteString(const std::string& value);
+
+  void WriteString(const char* value);
+
+  // Writes the |count| elements at |data| as a fixed-type list.
+  void WriteByteList(const uint8_t* data, size_t count);
+
+  void WriteIntList(const int32_t* data, size_t count);
+
+  void WriteLongList(const int64_t* data, size_t count);
+
+  void WriteDoubleList(const double* data, size_t count);
+
+  // Starts a list, whose |length| elements must be written next.
+  void BeginList(size_t length);
+
+  // Starts a map, whose |length| entries must be written next, each key
+  // followed by its value.
+  void BeginMap(size_t length);
+
+ private:
+  // Writes the variable-length size encoding of |size|.
+  void WriteSize(size_t size);
+
+  // Writes the |length| bytes at |bytes|.
+  void WriteBytes(const void* bytes, size_t length);
+
+  // Writes 0s until the next multiple of |alignment| relative to the start of
+  // the buffer, unless the write position is already aligned.
+  void WriteAlignment(size_t alignment);
+
+  // Writes the |count| elements at |data| as a fixed-type list of |type|.
+  template <typename T>
+  void WriteList(uint8_t type, const T* data, size_t count);
+
+  // The buffer to write to.
+  std::vector<uint8_t>* buffer_;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_COMMON_CPP_CLIENT_WRAPPER_INCLUDE_FLUTTER_STANDARD_MESSAGE_STREAM_H_
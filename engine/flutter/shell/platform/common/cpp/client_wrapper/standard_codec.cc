@@ -3,11 +3,13 @@
 // found in the LICENSE file.
 
 // This file contains what would normally be standard_codec_serializer.cc,
-// standard_message_codec.cc, and standard_method_codec.cc. They are grouped
-// together to simplify use of the client wrapper, since the common case is
-// that any client that needs one of these files needs all three.
+// standard_message_stream.cc, standard_message_codec.cc, and
+// standard_method_codec.cc. They are grouped together to simplify use of the
+// client wrapper, since the common case is that any client that needs one of
+// these files needs all of them.
 
 #include "include/flutter/standard_message_codec.h"
+#include "include/flutter/standard_message_stream.h"
 #include "include/flutter/standard_method_codec.h"
 #include "standard_codec_serializer.h"
 
@@ -267,6 +269,325 @@ void StandardCodecSerializer::WriteVector(
                      count * type_size);
 }
 
+// ===== standard_message_stream.h =====
+
+namespace {
+
+// A visitor ignoring all values, for skipping them.
+class SkippingVisitor : public StandardMessageVisitor {};
+
+}  // namespace
+
+StandardMessageReader::StandardMessageReader(const uint8_t* bytes, size_t size)
+    : bytes_(bytes), size_(size) {}
+
+StandardMessageReader::~StandardMessageReader() = default;
+
+bool StandardMessageReader::ReadValue(StandardMessageVisitor* visitor) {
+  const uint8_t* type_byte;
+  if (!ReadBytes(1, &type_byte)) {
+    return false;
+  }
+  EncodedType type = static_cast<EncodedType>(*type_byte);
+  switch (type) {
+    case EncodedType::kNull:
+      visitor->VisitNull();
+      return true;
+    case EncodedType::kTrue:
+      visitor->VisitBool(true);
+      return true;
+    case EncodedType::kFalse:
+      visitor->VisitBool(false);
+      return true;
+    case EncodedType::kInt32: {
+      const uint8_t* bytes;
+      if (!ReadBytes(4, &bytes)) {
+        return false;
+      }
+      int32_t int_value;
+      std::memcpy(&int_value, bytes, 4);
+      visitor->VisitInt(int_value);
+      return true;
+    }
+    case EncodedType::kInt64: {
+      const uint8_t* bytes;
+      if (!ReadBytes(8, &bytes)) {
+        return false;
+      }
+      int64_t long_value;
+      std::memcpy(&long_value, bytes, 8);
+      visitor->VisitLong(long_value);
+      return true;
+    }
+    case EncodedType::kFloat64: {
+      const uint8_t* bytes;
+      if (!ReadAlignment(8) || !ReadBytes(8, &bytes)) {
+        return false;
+      }
+      double double_value;
+      std::memcpy(&double_value, bytes, 8);
+      visitor->VisitDouble(double_value);
+      return true;
+    }
+    case EncodedType::kLargeInt:
+    case EncodedType::kString: {
+      size_t size;
+      const uint8_t* bytes;
+      if (!ReadSize(&size) || !ReadBytes(size, &bytes)) {
+        return false;
+      }
+      visitor->VisitString(reinterpret_cast<const char*>(bytes), size);
+      return true;
+    }
+    case EncodedType::kUInt8List: {
+      StandardTypedListView<uint8_t> list;
+      if (!ReadList(&list)) {
+        return false;
+      }
+      visitor->VisitByteList(list);
+      return true;
+    }
+    case EncodedType::kInt32List: {
+      StandardTypedListView<int32_t> list;
+      if (!ReadList(&list)) {
+        return false;
+      }
+      visitor->VisitIntList(list);
+      return true;
+    }
+    case EncodedType::kInt64List: {
+      StandardTypedListView<int64_t> list;
+      if (!ReadList(&list)) {
+        return false;
+      }
+      visitor->VisitLongList(list);
+      return true;
+    }
+    case EncodedType::kFloat64List: {
+      StandardTypedListView<double> list;
+      if (!ReadList(&list)) {
+        return false;
+      }
+      visitor->VisitDoubleList(list);
+      return true;
+    }
+    case EncodedType::kList: {
+      size_t length;
+      if (!ReadSize(&length)) {
+        return false;
+      }
+      visitor->BeginList(length);
+      for (size_t i = 0; i < length; ++i) {
+        if (!ReadValue(visitor)) {
+          return false;
+        }
+      }
+      visitor->EndList();
+      return true;
+    }
+    case EncodedType::kMap: {
+      size_t length;
+      if (!ReadSize(&length)) {
+        return false;
+      }
+      visitor->BeginMap(length);
+      for (size_t i = 0; i < length; ++i) {
+        if (!ReadValue(visitor) || !ReadValue(visitor)) {
+          return false;
+        }
+      }
+      visitor->EndMap();
+      return true;
+    }
+  }
+  std::cerr << "Unknown type in StandardMessageReader::ReadValue: "
+            << static_cast<int>(type) << std::endl;
+  return Fail();
+}
+
+bool StandardMessageReader::SkipValue() {
+  SkippingVisitor visitor;
+  return ReadValue(&visitor);
+}
+
+bool StandardMessageReader::ReadSize(size_t* size) {
+  const uint8_t* bytes;
+  if (!ReadBytes(1, &bytes)) {
+    return false;
+  }
+  if (*bytes < 254) {
+    *size = *bytes;
+  } else if (*bytes == 254) {
+    uint16_t value;
+    if (!ReadBytes(2, &bytes)) {
+      return false;
+    }
+    std::memcpy(&value, bytes, 2);
+    *size = value;
+  } else {
+    uint32_t value;
+    if (!ReadBytes(4, &bytes)) {
+      return false;
+    }
+    std::memcpy(&value, bytes, 4);
+    *size = value;
+  }
+  return true;
+}
+
+bool StandardMessageReader::ReadBytes(size_t length, const uint8_t** bytes) {
+  if (location_ > size_ || length > size_ - location_) {
+    std::cerr << "Invalid read in StandardMessageReader" << std::endl;
+    return Fail();
+  }
+  *bytes = bytes_ + location_;
+  location_ += length;
+  return true;
+}
+
+bool StandardMessageReader::ReadAlignment(size_t alignment) {
+  size_t mod = location_ % alignment;
+  if (mod) {
+    const uint8_t* padding;
+    return ReadBytes(alignment - mod, &padding);
+  }
+  return true;
+}
+
+template <typename T>
+bool StandardMessageReader::ReadList(StandardTypedListView<T>* list) {
+  size_t count;
+  if (!ReadSize(&count)) {
+    return false;
+  }
+  if (sizeof(T) > 1 && !ReadAlignment(sizeof(T))) {
+    return false;
+  }
+  if (count > (size_ - location_) / sizeof(T)) {
+    std::cerr << "Invalid read in StandardMessageReader" << std::endl;
+    return Fail();
+  }
+  const uint8_t* bytes;
+  ReadBytes(count * sizeof(T), &bytes);
+  *list = StandardTypedListView<T>(bytes, count);
+  return true;
+}
+
+bool StandardMessageReader::Fail() {
+  location_ = size_;
+  return false;
+}
+
+StandardMessageWriter::StandardMessageWriter(std::vector<uint8_t>* buffer)
+    : buffer_(buffer) {
+  assert(buffer);
+}
+
+StandardMessageWriter::~StandardMessageWriter() = default;
+
+void StandardMessageWriter::WriteNull() {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kNull));
+}
+
+void StandardMessageWriter::WriteBool(bool value) {
+  buffer_->push_back(
+      static_cast<uint8_t>(value ? EncodedType::kTrue : EncodedType::kFalse));
+}
+
+void StandardMessageWriter::WriteInt(int32_t value) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kInt32));
+  WriteBytes(&value, 4);
+}
+
+void StandardMessageWriter::WriteLong(int64_t value) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kInt64));
+  WriteBytes(&value, 8);
+}
+
+void StandardMessageWriter::WriteDouble(double value) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kFloat64));
+  WriteAlignment(8);
+  WriteBytes(&value, 8);
+}
+
+void StandardMessageWriter::WriteString(const char* data, size_t size) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kString));
+  WriteSize(size);
+  WriteBytes(data, size);
+}
+
+void StandardMessageWriter::WriteString(const std::string& value) {
+  WriteString(value.data(), value.size());
+}
+
+void StandardMessageWriter::WriteString(const char* value) {
+  WriteString(value, std::strlen(value));
+}
+
+void StandardMessageWriter::WriteByteList(const uint8_t* data, size_t count) {
+  WriteList(static_cast<uint8_t>(EncodedType::kUInt8List), data, count);
+}
+
+void StandardMessageWriter::WriteIntList(const int32_t* data, size_t count) {
+  WriteList(static_cast<uint8_t>(EncodedType::kInt32List), data, count);
+}
+
+void StandardMessageWriter::WriteLongList(const int64_t* data, size_t count) {
+  WriteList(static_cast<uint8_t>(EncodedType::kInt64List), data, count);
+}
+
+void StandardMessageWriter::WriteDoubleList(const double* data, size_t count) {
+  WriteList(static_cast<uint8_t>(EncodedType::kFloat64List), data, count);
+}
+
+void StandardMessageWriter::BeginList(size_t length) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kList));
+  WriteSize(length);
+}
+
+void StandardMessageWriter::BeginMap(size_t length) {
+  buffer_->push_back(static_cast<uint8_t>(EncodedType::kMap));
+  WriteSize(length);
+}
+
+void StandardMessageWriter::WriteSize(size_t size) {
+  if (size < 254) {
+    buffer_->push_back(static_cast<uint8_t>(size));
+  } else if (size <= 0xffff) {
+    buffer_->push_back(254);
+    uint16_t value = static_cast<uint16_t>(size);
+    WriteBytes(&value, 2);
+  } else {
+    buffer_->push_back(255);
+    uint32_t value = static_cast<uint32_t>(size);
+    WriteBytes(&value, 4);
+  }
+}
+
+void StandardMessageWriter::WriteBytes(const void* bytes, size_t length) {
+  const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+  buffer_->insert(buffer_->end(), begin, begin + length);
+}
+
+void StandardMessageWriter::WriteAlignment(size_t alignment) {
+  size_t mod = buffer_->size() % alignment;
+  if (mod) {
+    buffer_->resize(buffer_->size() + alignment - mod, 0);
+  }
+}
+
+template <typename T>
+void StandardMessageWriter::WriteList(uint8_t type,
+                                      const T* data,
+                                      size_t count) {
+  buffer_->push_back(type);
+  WriteSize(count);
+  if (sizeof(T) > 1) {
+    WriteAlignment(sizeof(T));
+  }
+  WriteBytes(data, count * sizeof(T));
+}
+
 // ===== standard_message_codec.h =====
 
 // static
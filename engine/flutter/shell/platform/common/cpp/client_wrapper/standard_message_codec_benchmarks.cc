@@ -0,0 +1,174 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/shell/platform/common/cpp/client_wrapper/include/flutter/standard_message_codec.h"
+#include "flutter/shell/platform/common/cpp/client_wrapper/include/flutter/standard_message_stream.h"
+
+namespace flutter {
+
+namespace {
+
+// The nested list of StandardMessageCodec.CanEncodeAndDecodeList.
+const std::vector<uint8_t> kListMessage = {
+    0x0c, 0x05, 0x00, 0x07, 0x05, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x06,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x85, 0xeb, 0x51, 0xb8, 0x1e,
+    0x09, 0x40, 0x03, 0x2f, 0x00, 0x00, 0x00, 0x0c, 0x02, 0x03, 0x2a,
+    0x00, 0x00, 0x00, 0x07, 0x06, 0x6e, 0x65, 0x73, 0x74, 0x65, 0x64,
+};
+
+// Accumulates the scalars and sizes of a message, so that reading it can't be
+// optimized away.
+class SummingVisitor : public StandardMessageVisitor {
+ public:
+  double sum = 0;
+
+  void VisitInt(int32_t value) override { sum += value; }
+
+  void VisitLong(int64_t value) override { sum += value; }
+
+  void VisitDouble(double value) override { sum += value; }
+
+  void VisitString(const char* data, size_t size) override { sum += size; }
+
+  void VisitDoubleList(StandardTypedListView<double> list) override {
+    for (size_t i = 0; i < list.size(); ++i) {
+      sum += list[i];
+    }
+  }
+};
+
+// A sample of a sensor channel, like the accelerometer events of the sensors
+// plugin: {'timestamp': <microseconds>, 'values': Float64List[x, y, z]}.
+EncodableValue MakeSensorSample(int64_t timestamp) {
+  return EncodableValue(EncodableMap{
+      {EncodableValue("timestamp"), EncodableValue(timestamp)},
+      {EncodableValue("values"),
+       EncodableValue(std::vector<double>{0.5, -9.81, 0.25})},
+  });
+}
+
+}  // namespace
+
+static void BM_StandardMessageCodecDecodeList(benchmark::State& state) {
+  const StandardMessageCodec& codec = StandardMessageCodec::GetInstance();
+  while (state.KeepRunning()) {
+    auto decoded = codec.DecodeMessage(kListMessage);
+    benchmark::DoNotOptimize(decoded);
+  }
+}
+
+static void BM_StandardMessageReaderDecodeList(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    StandardMessageReader reader(kListMessage.data(), kListMessage.size());
+    SummingVisitor visitor;
+    reader.ReadValue(&visitor);
+    benchmark::DoNotOptimize(visitor.sum);
+  }
+}
+
+static void BM_StandardMessageCodecEncodeList(benchmark::State& state) {
+  const StandardMessageCodec& codec = StandardMessageCodec::GetInstance();
+  while (state.KeepRunning()) {
+    EncodableValue value(EncodableList{
+        EncodableValue(),
+        EncodableValue("hello"),
+        EncodableValue(3.14),
+        EncodableValue(47),
+        EncodableValue(EncodableList{
+            EncodableValue(42),
+            EncodableValue("nested"),
+        }),
+    });
+    auto encoded = codec.EncodeMessage(value);
+    benchmark::DoNotOptimize(encoded);
+  }
+}
+
+static void BM_StandardMessageWriterEncodeList(benchmark::State& state) {
+  std::vector<uint8_t> buffer;
+  while (state.KeepRunning()) {
+    buffer.clear();
+    StandardMessageWriter writer(&buffer);
+    writer.BeginList(5);
+    writer.WriteNull();
+    writer.WriteString("hello");
+    writer.WriteDouble(3.14);
+    writer.WriteInt(47);
+    writer.BeginList(2);
+    writer.WriteInt(42);
+    writer.WriteString("nested");
+    benchmark::DoNotOptimize(buffer.data());
+  }
+}
+
+// Decodes a sample and reads its values, as a channel handler would.
+static void BM_StandardMessageCodecDecodeSensorSample(benchmark::State& state) {
+  const StandardMessageCodec& codec = StandardMessageCodec::GetInstance();
+  auto message = codec.EncodeMessage(MakeSensorSample(1234567));
+  const EncodableValue timestamp_key("timestamp");
+  const EncodableValue values_key("values");
+  while (state.KeepRunning()) {
+    auto decoded = codec.DecodeMessage(*message);
+    const EncodableMap& sample = decoded->MapValue();
+    double sum = sample.at(timestamp_key).LongValue();
+    for (double value : sample.at(values_key).DoubleListValue()) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void BM_StandardMessageReaderDecodeSensorSample(
+    benchmark::State& state) {
+  auto message = StandardMessageCodec::GetInstance().EncodeMessage(
+      MakeSensorSample(1234567));
+  while (state.KeepRunning()) {
+    StandardMessageReader reader(message->data(), message->size());
+    SummingVisitor visitor;
+    reader.ReadValue(&visitor);
+    benchmark::DoNotOptimize(visitor.sum);
+  }
+}
+
+static void BM_StandardMessageCodecEncodeSensorSample(
+    benchmark::State& state) {
+  const StandardMessageCodec& codec = StandardMessageCodec::GetInstance();
+  int64_t timestamp = 0;
+  while (state.KeepRunning()) {
+    auto encoded = codec.EncodeMessage(MakeSensorSample(timestamp++));
+    benchmark::DoNotOptimize(encoded);
+  }
+}
+
+static void BM_StandardMessageWriterEncodeSensorSample(
+    benchmark::State& state) {
+  std::vector<uint8_t> buffer;
+  const double values[] = {0.5, -9.81, 0.25};
+  int64_t timestamp = 0;
+  while (state.KeepRunning()) {
+    buffer.clear();
+    StandardMessageWriter writer(&buffer);
+    writer.BeginMap(2);
+    writer.WriteString("timestamp");
+    writer.WriteLong(timestamp++);
+    writer.WriteString("values");
+    writer.WriteDoubleList(values, 3);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+}
+
+BENCHMARK(BM_StandardMessageCodecDecodeList);
+BENCHMARK(BM_StandardMessageReaderDecodeList);
+BENCHMARK(BM_StandardMessageCodecEncodeList);
+BENCHMARK(BM_StandardMessageWriterEncodeList);
+BENCHMARK(BM_StandardMessageCodecDecodeSensorSample);
+BENCHMARK(BM_StandardMessageReaderDecodeSensorSample);
+BENCHMARK(BM_StandardMessageCodecEncodeSensorSample);
+BENCHMARK(BM_StandardMessageWriterEncodeSensorSample);
+
+}  // namespace flutter
@@ -0,0 +1,229 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/common/cpp/client_wrapper/include/flutter/standard_message_stream.h"
+
+#include <string>
+#include <vector>
+
+#include "flutter/shell/platform/common/cpp/client_wrapper/include/flutter/standard_message_codec.h"
+#include "flutter/shell/platform/common/cpp/client_wrapper/testing/encodable_value_utils.h"
+#include "gtest/gtest.h"
+
+namespace flutter {
+
+namespace {
+
+// Rebuilds the EncodableValues visited by a reader, to compare them with the
+// values decoded by StandardMessageCodec.
+class BuildingVisitor : public StandardMessageVisitor {
+ public:
+  BuildingVisitor() { stack_.push_back({EncodableValue(EncodableList{}), 1}); }
+
+  // Returns the value built from the visited value.
+  EncodableValue GetValue() const {
+    return stack_.front().value.ListValue().front();
+  }
+
+  void VisitNull() override { Add(EncodableValue()); }
+
+  void VisitBool(bool value) override { Add(EncodableValue(value)); }
+
+  void VisitInt(int32_t value) override { Add(EncodableValue(value)); }
+
+  void VisitLong(int64_t value) override { Add(EncodableValue(value)); }
+
+  void VisitDouble(double value) override { Add(EncodableValue(value)); }
+
+  void VisitString(const char* data, size_t size) override {
+    Add(EncodableValue(std::string(data, size)));
+  }
+
+  void VisitByteList(StandardTypedListView<uint8_t> list) override {
+    AddList(list);
+  }
+
+  void VisitIntList(StandardTypedListView<int32_t> list) override {
+    AddList(list);
+  }
+
+  void VisitLongList(StandardTypedListView<int64_t> list) override {
+    AddList(list);
+  }
+
+  void VisitDoubleList(StandardTypedListView<double> list) override {
+    AddList(list);
+  }
+
+  void BeginList(size_t length) override {
+    stack_.push_back({EncodableValue(EncodableList{}), length});
+    EndCollectionIfFull();
+  }
+
+  void EndList() override {}
+
+  void BeginMap(size_t length) override {
+    stack_.push_back({EncodableValue(EncodableList{}), length * 2});
+    stack_.back().is_map = true;
+    EndCollectionIfFull();
+  }
+
+  void EndMap() override {}
+
+ private:
+  struct Collection {
+    // The elements of a list, or the keys and values of a map in turn.
+    EncodableValue value;
+    size_t remaining;
+    bool is_map = false;
+  };
+
+  template <typename T>
+  void AddList(StandardTypedListView<T> list) {
+    std::vector<T> elements;
+    for (size_t i = 0; i < list.size(); ++i) {
+      elements.push_back(list[i]);
+    }
+    Add(EncodableValue(elements));
+  }
+
+  void Add(EncodableValue value) {
+    stack_.back().value.ListValue().push_back(std::move(value));
+    stack_.back().remaining--;
+    EndCollectionIfFull();
+  }
+
+  void EndCollectionIfFull() {
+    if (stack_.size() == 1 || stack_.back().remaining > 0) {
+      return;
+    }
+    Collection collection = std::move(stack_.back());
+    stack_.pop_back();
+    if (!collection.is_map) {
+      Add(std::move(collection.value));
+      return;
+    }
+    EncodableMap map;
+    const EncodableList& entries = collection.value.ListValue();
+    for (size_t i = 0; i < entries.size(); i += 2) {
+      map.emplace(entries[i], entries[i + 1]);
+    }
+    Add(EncodableValue(std::move(map)));
+  }
+
+  std::vector<Collection> stack_;
+};
+
+// Checks that a reader visits the values decoded by StandardMessageCodec from
+// |bytes|.
+void CheckReadMatchesCodec(const std::vector<uint8_t>& bytes) {
+  StandardMessageReader reader(bytes.data(), bytes.size());
+  BuildingVisitor visitor;
+  ASSERT_TRUE(reader.ReadValue(&visitor));
+  EXPECT_TRUE(reader.AtEnd());
+
+  auto decoded = StandardMessageCodec::GetInstance().DecodeMessage(bytes);
+  EXPECT_TRUE(testing::EncodableValuesAreEqual(visitor.GetValue(), *decoded));
+}
+
+}  // namespace
+
+TEST(StandardMessageStream, WritesTheEncodingOfTheCodec) {
+  std::vector<uint8_t> bytes;
+  StandardMessageWriter writer(&bytes);
+  writer.BeginList(5);
+  writer.WriteNull();
+  writer.WriteString("hello");
+  writer.WriteDouble(3.14);
+  writer.WriteInt(47);
+  writer.BeginList(2);
+  writer.WriteInt(42);
+  writer.WriteString("nested");
+
+  EncodableValue value(EncodableList{
+      EncodableValue(),
+      EncodableValue("hello"),
+      EncodableValue(3.14),
+      EncodableValue(47),
+      EncodableValue(EncodableList{
+          EncodableValue(42),
+          EncodableValue("nested"),
+      }),
+  });
+  EXPECT_EQ(bytes, *StandardMessageCodec::GetInstance().EncodeMessage(value));
+}
+
+TEST(StandardMessageStream, WritesTypedListsAligned) {
+  std::vector<uint8_t> bytes;
+  StandardMessageWriter writer(&bytes);
+  const std::vector<double> values = {3.14159265358979311599796346854, 1000.0};
+  writer.WriteDoubleList(values.data(), values.size());
+
+  std::vector<uint8_t> expected = {
+      0x0b, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x2d, 0x44, 0x54,
+      0xfb, 0x21, 0x09, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x8f, 0x40};
+  EXPECT_EQ(bytes, expected);
+}
+
+TEST(StandardMessageStream, ReadsTheValuesOfTheCodec) {
+  std::vector<uint8_t> list_bytes = {
+      0x0c, 0x05, 0x00, 0x07, 0x05, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x06,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x85, 0xeb, 0x51, 0xb8, 0x1e,
+      0x09, 0x40, 0x03, 0x2f, 0x00, 0x00, 0x00, 0x0c, 0x02, 0x03, 0x2a,
+      0x00, 0x00, 0x00, 0x07, 0x06, 0x6e, 0x65, 0x73, 0x74, 0x65, 0x64,
+  };
+  CheckReadMatchesCodec(list_bytes);
+
+  EncodableValue map(EncodableMap{
+      {EncodableValue("a"), EncodableValue(3.14)},
+      {EncodableValue("b"), EncodableValue(INT64_C(0x1234567890abcdef))},
+      {EncodableValue(), EncodableValue(true)},
+      {EncodableValue(3.14), EncodableValue(EncodableList{
+                                 EncodableValue(std::vector<uint8_t>{0xba}),
+                                 EncodableValue(std::vector<int32_t>{-1}),
+                                 EncodableValue(std::vector<int64_t>{-1}),
+                             })},
+  });
+  CheckReadMatchesCodec(
+      *StandardMessageCodec::GetInstance().EncodeMessage(map));
+}
+
+TEST(StandardMessageStream, TypedListsReferToTheMessage) {
+  std::vector<uint8_t> bytes = {0x09, 0x03, 0x00, 0x00, 0x78, 0x56, 0x34, 0x12,
+                                0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00};
+
+  class IntListVisitor : public StandardMessageVisitor {
+   public:
+    void VisitIntList(StandardTypedListView<int32_t> list) override {
+      list_ = list;
+    }
+    StandardTypedListView<int32_t> list_;
+  } visitor;
+  StandardMessageReader reader(bytes.data(), bytes.size());
+  ASSERT_TRUE(reader.ReadValue(&visitor));
+
+  ASSERT_EQ(visitor.list_.size(), 3u);
+  EXPECT_EQ(visitor.list_.bytes(), bytes.data() + 4);
+  EXPECT_EQ(visitor.list_[0], 0x12345678);
+  EXPECT_EQ(visitor.list_[1], -1);
+  EXPECT_EQ(visitor.list_[2], 0);
+  // Vector storage is aligned, so the elements can be used in place.
+  ASSERT_NE(visitor.list_.data(), nullptr);
+  EXPECT_EQ(visitor.list_.data()[0], 0x12345678);
+}
+
+TEST(StandardMessageStream, RejectsTruncatedMessages) {
+  std::vector<uint8_t> bytes = {0x0c, 0x02, 0x03, 0x2a, 0x00, 0x00, 0x00,
+                                0x0b, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                0x00, 0x00, 0x18, 0x2d, 0x44, 0x54};
+  StandardMessageReader reader(bytes.data(), bytes.size());
+  EXPECT_FALSE(reader.SkipValue());
+  EXPECT_TRUE(reader.AtEnd());
+
+  std::vector<uint8_t> empty;
+  StandardMessageReader empty_reader(empty.data(), empty.size());
+  EXPECT_FALSE(empty_reader.SkipValue());
+}
+
+}  // namespace flutter
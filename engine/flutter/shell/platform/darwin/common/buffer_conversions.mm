@@ -16,11 +16,23 @@ NSData* GetNSDataFromVector(const std::vector<uint8_t>& buffer) {
 }
 
 std::unique_ptr<fml::Mapping> GetMappingFromNSData(NSData* data) {
-  return std::make_unique<fml::DataMapping>(GetVectorFromNSData(data));
+  // Copying immutable data only retains it. The mapping releases it once it is
+  // collected.
+  NSData* immutable_data = [data copy];
+  return std::make_unique<fml::NonOwnedMapping>(
+      static_cast<const uint8_t*>(immutable_data.bytes), immutable_data.length,
+      [immutable_data](const uint8_t* bytes, size_t size) { [immutable_data release]; });
 }
 
 NSData* GetNSDataFromMapping(std::unique_ptr<fml::Mapping> mapping) {
-  return [NSData dataWithBytes:mapping->GetMapping() length:mapping->GetSize()];
+  // The data refers to the bytes of the mapping, which it collects once it is
+  // deallocated.
+  fml::Mapping* raw_mapping = mapping.release();
+  return [[[NSData alloc] initWithBytesNoCopy:const_cast<uint8_t*>(raw_mapping->GetMapping())
+                                       length:raw_mapping->GetSize()
+                                  deallocator:^(void* bytes, NSUInteger length) {
+                                    delete raw_mapping;
+                                  }] autorelease];
 }
 
 }  // namespace flutter
@@ -22,7 +22,14 @@ void PlatformMessageRouter::HandlePlatformMessage(
     FlutterBinaryMessageHandler handler = it->second;
     NSData* data = nil;
     if (message->hasData()) {
-      data = GetNSDataFromVector(message->data());
+      // Refers to the payload of the message, which the data keeps alive.
+      const fml::Mapping& payload = message->data();
+      data = [[[NSData alloc] initWithBytesNoCopy:const_cast<uint8_t*>(payload.GetMapping())
+                                           length:payload.GetSize()
+                                      deallocator:^(void* bytes, NSUInteger length) {
+                                        // Released along with the block.
+                                        (void)message;
+                                      }] autorelease];
     }
     handler(data, ^(NSData* reply) {
       if (completer) {
@@ -84,7 +84,9 @@ static bool IsSoftwareRendererConfigValid(const FlutterRendererConfig* config) {
   const FlutterSoftwareRendererConfig* software_config = &config->software;
 
   if (SAFE_ACCESS(software_config, surface_present_callback, nullptr) ==
-      nullptr) {
+          nullptr &&
+      SAFE_ACCESS(software_config, surface_present_with_info_callback,
+                  nullptr) == nullptr) {
     return false;
   }
 
@@ -213,6 +215,51 @@ InferOpenGLPlatformViewCreationCallback(
       });
 }
 
+static sk_sp<SkSurface> MakeSkSurfaceFromBackingStore(
+    GrContext* context,
+    const FlutterBackingStoreConfig& config,
+    const FlutterSoftwareBackingStore* software) {
+  const auto image_info =
+      SkImageInfo::MakeN32Premul(config.size.width, config.size.height);
+
+  if (software->allocation == nullptr ||
+      software->row_bytes < image_info.minRowBytes() ||
+      software->height < static_cast<size_t>(image_info.height())) {
+    FML_LOG(ERROR) << "Embedder supplied software render buffer was invalid.";
+    software->destruction_callback(software->user_data);
+    return nullptr;
+  }
+
+  struct Captures {
+    VoidCallback destruction_callback;
+    void* user_data;
+  };
+  auto captures = std::make_unique<Captures>();
+  captures->destruction_callback = software->destruction_callback;
+  captures->user_data = software->user_data;
+  auto release_proc = [](void* pixels, void* context) {
+    std::unique_ptr<Captures> captures(reinterpret_cast<Captures*>(context));
+    captures->destruction_callback(captures->user_data);
+  };
+
+  auto surface = SkSurface::MakeRasterDirectReleaseProc(
+      image_info,                               // image info
+      const_cast<void*>(software->allocation),  // pixels
+      software->row_bytes,                      // row bytes
+      release_proc,                             // release proc
+      captures.get()                            // release context
+  );
+
+  if (!surface) {
+    FML_LOG(ERROR)
+        << "Could not wrap embedder supplied software render buffer.";
+    software->destruction_callback(software->user_data);
+    return nullptr;
+  }
+  captures.release();
+  return surface;
+}
+
 static flutter::Shell::CreateCallback<flutter::PlatformView>
 InferSoftwarePlatformViewCreationCallback(
     const FlutterRendererConfig* config,
@@ -225,15 +272,73 @@ InferSoftwarePlatformViewCreationCallback(
     return nullptr;
   }
 
+  const FlutterSoftwareRendererConfig* software_config = &config->software;
+
   auto software_present_backing_store =
-      [ptr = config->software.surface_present_callback, user_data](
-          const void* allocation, size_t row_bytes, size_t height) -> bool {
-    return ptr(user_data, allocation, row_bytes, height);
+      [ptr = software_config->surface_present_callback,
+       present_with_info_ptr = SAFE_ACCESS(
+           software_config, surface_present_with_info_callback, nullptr),
+       user_data](const void* allocation, size_t row_bytes, size_t height,
+                  const std::vector<SkIRect>& damage,
+                  size_t buffer_index) -> bool {
+    if (present_with_info_ptr == nullptr) {
+      return ptr(user_data, allocation, row_bytes, height);
+    }
+
+    std::vector<FlutterRect> damage_rects;
+    damage_rects.reserve(damage.size());
+    for (const auto& rect : damage) {
+      damage_rects.push_back({
+          static_cast<double>(rect.left()),    // left
+          static_cast<double>(rect.top()),     // top
+          static_cast<double>(rect.right()),   // right
+          static_cast<double>(rect.bottom()),  // bottom
+      });
+    }
+
+    FlutterSoftwarePresentInfo present_info = {};
+    present_info.struct_size = sizeof(present_info);
+    present_info.allocation = allocation;
+    present_info.row_bytes = row_bytes;
+    present_info.height = height;
+    present_info.damage = damage_rects.data();
+    present_info.damage_count = damage_rects.size();
+    present_info.buffer_index = buffer_index;
+    return present_with_info_ptr(user_data, &present_info);
   };
 
+  std::function<sk_sp<SkSurface>(const SkISize&, size_t)>
+      software_create_buffer = nullptr;
+  if (auto create_buffer_ptr = SAFE_ACCESS(
+          software_config, surface_create_buffer_callback, nullptr)) {
+    software_create_buffer = [create_buffer_ptr, user_data](
+                                 const SkISize& size,
+                                 size_t index) -> sk_sp<SkSurface> {
+      FlutterSoftwareBufferConfig buffer_config = {};
+      buffer_config.struct_size = sizeof(buffer_config);
+      buffer_config.width = size.width();
+      buffer_config.height = size.height();
+      buffer_config.index = index;
+
+      FlutterSoftwareBackingStore buffer = {};
+      if (!create_buffer_ptr(user_data, &buffer_config, &buffer)) {
+        FML_LOG(ERROR) << "Could not create the software render buffer.";
+        return nullptr;
+      }
+
+      FlutterBackingStoreConfig backing_store_config = {};
+      backing_store_config.struct_size = sizeof(backing_store_config);
+      backing_store_config.size.width = size.width();
+      backing_store_config.size.height = size.height();
+      return MakeSkSurfaceFromBackingStore(nullptr, backing_store_config,
+                                           &buffer);
+    };
+  }
+
   flutter::EmbedderSurfaceSoftware::SoftwareDispatchTable
       software_dispatch_table = {
           software_present_backing_store,  // required
+          software_create_buffer,          // optional
       };
 
   return fml::MakeCopyable(
@@ -356,42 +461,6 @@ static sk_sp<SkSurface> MakeSkSurfaceFromBackingStore(
   return surface;
 }
 
-static sk_sp<SkSurface> MakeSkSurfaceFromBackingStore(
-    GrContext* context,
-    const FlutterBackingStoreConfig& config,
-    const FlutterSoftwareBackingStore* software) {
-  const auto image_info =
-      SkImageInfo::MakeN32Premul(config.size.width, config.size.height);
-
-  struct Captures {
-    VoidCallback destruction_callback;
-    void* user_data;
-  };
-  auto captures = std::make_unique<Captures>();
-  captures->destruction_callback = software->destruction_callback;
-  captures->user_data = software->user_data;
-  auto release_proc = [](void* pixels, void* context) {
-    auto captures = reinterpret_cast<Captures*>(context);
-    captures->destruction_callback(captures->user_data);
-  };
-
-  auto surface = SkSurface::MakeRasterDirectReleaseProc(
-      image_info,                               // image info
-      const_cast<void*>(software->allocation),  // pixels
-      software->row_bytes,                      // row bytes
-      release_proc,                             // release proc
-      captures.release()                        // release context
-  );
-
-  if (!surface) {
-    FML_LOG(ERROR)
-        << "Could not wrap embedder supplied software render buffer.";
-    software->destruction_callback(software->user_data);
-    return nullptr;
-  }
-  return surface;
-}
-
 static std::unique_ptr<flutter::EmbedderRenderTarget>
 CreateEmbedderRenderTarget(const FlutterCompositor* compositor,
                            const FlutterBackingStoreConfig& config,
@@ -612,6 +681,10 @@ FlutterEngineResult FlutterEngineRun(size_t version,
   settings.icu_data_path = icu_data_path;
   settings.assets_path = args->assets_path;
   settings.leak_vm = !SAFE_ACCESS(args, shutdown_dart_vm_when_done, false);
+  if (SAFE_ACCESS(args, persistent_cache_prefetch_byte_budget, 0) > 0) {
+    settings.persistent_cache_prefetch_byte_budget =
+        SAFE_ACCESS(args, persistent_cache_prefetch_byte_budget, 0);
+  }
 
   if (!flutter::DartVM::IsRunningPrecompiledCode()) {
     // Verify the assets path contains Dart 2 kernel assets.
@@ -734,8 +807,8 @@ FlutterEngineResult FlutterEngineRun(size_t version,
           const FlutterPlatformMessage incoming_message = {
               sizeof(FlutterPlatformMessage),  // struct_size
               message->channel().c_str(),      // channel
-              message->data().data(),          // message
-              message->data().size(),          // message_size
+              message->data().GetMapping(),    // message
+              message->data().GetSize(),       // message_size
               handle,                          // response_handle
           };
           handle->message = std::move(message);
@@ -1050,16 +1123,36 @@ FlutterEngineResult FlutterEngineSendPointerEvent(
 FlutterEngineResult FlutterEngineSendPlatformMessage(
     FLUTTER_API_SYMBOL(FlutterEngine) engine,
     const FlutterPlatformMessage* flutter_message) {
-  if (engine == nullptr || flutter_message == nullptr) {
+  if (flutter_message == nullptr) {
     return LOG_EMBEDDER_ERROR(kInvalidArguments);
   }
 
-  if (SAFE_ACCESS(flutter_message, channel, nullptr) == nullptr) {
+  size_t message_size = SAFE_ACCESS(flutter_message, message_size, 0);
+  const uint8_t* message_data = SAFE_ACCESS(flutter_message, message, nullptr);
+
+  // A message the embedder releases itself is referred to instead of copied.
+  // The mapping is created first so that it is released on every path below.
+  std::unique_ptr<fml::Mapping> message_mapping;
+  FlutterDataCallback release_callback =
+      SAFE_ACCESS(flutter_message, message_release_callback, nullptr);
+  if (release_callback != nullptr) {
+    void* release_user_data =
+        SAFE_ACCESS(flutter_message, message_release_user_data, nullptr);
+    message_mapping = std::make_unique<fml::NonOwnedMapping>(
+        message_data, message_size,
+        [release_callback, release_user_data](const uint8_t* data,
+                                              size_t size) {
+          release_callback(data, size, release_user_data);
+        });
+  }
+
+  if (engine == nullptr) {
     return LOG_EMBEDDER_ERROR(kInvalidArguments);
   }
 
-  size_t message_size = SAFE_ACCESS(flutter_message, message_size, 0);
-  const uint8_t* message_data = SAFE_ACCESS(flutter_message, message, nullptr);
+  if (SAFE_ACCESS(flutter_message, channel, nullptr) == nullptr) {
+    return LOG_EMBEDDER_ERROR(kInvalidArguments);
+  }
 
   if (message_size != 0 && message_data == nullptr) {
     return LOG_EMBEDDER_ERROR(kInvalidArguments);
@@ -1078,10 +1171,12 @@ FlutterEngineResult FlutterEngineSendPlatformMessage(
     message = fml::MakeRefCounted<flutter::PlatformMessage>(
         flutter_message->channel, response);
   } else {
+    if (!message_mapping) {
+      message_mapping = std::make_unique<fml::DataMapping>(
+          std::vector<uint8_t>(message_data, message_data + message_size));
+    }
     message = fml::MakeRefCounted<flutter::PlatformMessage>(
-        flutter_message->channel,
-        std::vector<uint8_t>(message_data, message_data + message_size),
-        response);
+        flutter_message->channel, std::move(message_mapping), response);
   }
 
   return reinterpret_cast<flutter::EmbedderEngine*>(engine)
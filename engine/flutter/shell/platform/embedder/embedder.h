@@ -135,6 +135,73 @@ typedef bool (*SoftwareSurfacePresentCallback)(void* /* user data */,
                                                const void* /* allocation */,
                                                size_t /* row bytes */,
                                                size_t /* height */);
+
+typedef struct {
+  double left;
+  double top;
+  double right;
+  double bottom;
+} FlutterRect;
+
+typedef struct {
+  // The size of this struct. Must be sizeof(FlutterSoftwarePresentInfo).
+  size_t struct_size;
+  // A pointer to the raw bytes of the presented frame.
+  const void* allocation;
+  // The number of bytes in a single row of the allocation.
+  size_t row_bytes;
+  // The number of rows in the allocation.
+  size_t height;
+  // The areas of the frame that changed since the last present, in pixels.
+  // Outside of them, the frame is the same as the last presented one. Covers
+  // the whole frame when everything may have changed, and is empty when
+  // nothing did.
+  const FlutterRect* damage;
+  // The number of rectangles in |damage|.
+  size_t damage_count;
+  // The index of the embedder buffer that holds the frame, see
+  // |FlutterSoftwareRendererConfig.surface_create_buffer_callback|. Zero when
+  // the engine owns the allocation.
+  size_t buffer_index;
+} FlutterSoftwarePresentInfo;
+
+typedef bool (*SoftwareSurfacePresentWithInfoCallback)(
+    void* /* user data */,
+    const FlutterSoftwarePresentInfo* /* present info */);
+
+typedef struct {
+  // The size of this struct. Must be sizeof(FlutterSoftwareBufferConfig).
+  size_t struct_size;
+  // The width of the buffer in pixels.
+  size_t width;
+  // The number of rows of the buffer.
+  size_t height;
+  // The index of the buffer, 0 or 1.
+  size_t index;
+} FlutterSoftwareBufferConfig;
+
+typedef struct {
+  // A pointer to the raw bytes of the allocation described by this software
+  // backing store.
+  const void* allocation;
+  // The number of bytes in a single row of the allocation.
+  size_t row_bytes;
+  // The number of rows in the allocation.
+  size_t height;
+  // A baton that is not interpreted by the engine in any way. It will be given
+  // back to the embedder in the destruction callback below. Embedder resources
+  // may be associated with this baton.
+  void* user_data;
+  // The callback invoked by the engine when it no longer needs this backing
+  // store.
+  VoidCallback destruction_callback;
+} FlutterSoftwareBackingStore;
+
+typedef bool (*SoftwareSurfaceCreateBufferCallback)(
+    void* /* user data */,
+    const FlutterSoftwareBufferConfig* /* config */,
+    FlutterSoftwareBackingStore* /* buffer out */);
+
 typedef void* (*ProcResolver)(void* /* user data */, const char* /* name */);
 typedef bool (*TextureFrameCallback)(void* /* user data */,
                                      int64_t /* texture identifier */,
@@ -180,8 +247,29 @@ typedef struct {
   // The callback presented to the embedder to present a fully populated buffer
   // to the user. The pixel format of the buffer is the native 32-bit RGBA
   // format. The buffer is owned by the Flutter engine and must be copied in
-  // this callback if needed.
+  // this callback if needed. May be null if
+  // |surface_present_with_info_callback| is specified.
   SoftwareSurfacePresentCallback surface_present_callback;
+  // An optional callback used instead of |surface_present_callback| when
+  // specified. Along with the buffer, it receives the areas that changed since
+  // the last present, so that the embedder may only update those on the
+  // screen.
+  SoftwareSurfacePresentWithInfoCallback surface_present_with_info_callback;
+  // An optional callback that provides the memory the engine renders into,
+  // which then does not allocate buffers nor needs them copied. The engine asks
+  // for two buffers, with the indices 0 and 1, whenever the size of the frame
+  // changes, and renders into them in turn. The allocation of each buffer is
+  // written to by the engine, and must hold |row_bytes| times |height| bytes
+  // for at least the size in the config. A buffer the engine cannot render
+  // into is handed back through its destruction callback right away.
+  //
+  // The engine starts rendering into a buffer as soon as the present callback
+  // of the other one returns. The present callback must therefore not return
+  // until the buffer presented before has left the screen, for instance once
+  // the flip to the newly presented buffer completed. The engine keeps the
+  // pixels of the last frame up to date in both buffers, outside of the damage
+  // of the next present.
+  SoftwareSurfaceCreateBufferCallback surface_create_buffer_callback;
 } FlutterSoftwareRendererConfig;
 
 typedef struct {
@@ -290,6 +378,10 @@ struct _FlutterPlatformMessageResponseHandle;
 typedef struct _FlutterPlatformMessageResponseHandle
     FlutterPlatformMessageResponseHandle;
 
+typedef void (*FlutterDataCallback)(const uint8_t* /* data */,
+                                    size_t /* size */,
+                                    void* /* user data */);
+
 typedef struct {
   // The size of this struct. Must be sizeof(FlutterPlatformMessage).
   size_t struct_size;
@@ -303,23 +395,20 @@ typedef struct {
   // |FlutterEngineSendPlatformMessageResponse| will cause a memory leak. It is
   // not safe to send multiple responses on a single response object.
   const FlutterPlatformMessageResponseHandle* response_handle;
+  // Optional. If set on a message sent to the engine, the engine refers to
+  // |message| instead of copying it, and calls this callback with |message|,
+  // |message_size| and |message_release_user_data| once it no longer needs
+  // it. The callback is called exactly once, on any thread, even if sending
+  // the message fails. Until then the embedder must neither modify nor free
+  // the message. Unset on the messages received from the engine.
+  FlutterDataCallback message_release_callback;
+  void* message_release_user_data;
 } FlutterPlatformMessage;
 
 typedef void (*FlutterPlatformMessageCallback)(
     const FlutterPlatformMessage* /* message*/,
     void* /* user data */);
 
-typedef void (*FlutterDataCallback)(const uint8_t* /* data */,
-                                    size_t /* size */,
-                                    void* /* user data */);
-
-typedef struct {
-  double left;
-  double top;
-  double right;
-  double bottom;
-} FlutterRect;
-
 typedef struct _FlutterTaskRunner* FlutterTaskRunner;
 
 typedef struct {
@@ -379,23 +468,6 @@ typedef struct {
   };
 } FlutterOpenGLBackingStore;
 
-typedef struct {
-  // A pointer to the raw bytes of the allocation described by this software
-  // backing store.
-  const void* allocation;
-  // The number of bytes in a single row of the allocation.
-  size_t row_bytes;
-  // The number of rows in the allocation.
-  size_t height;
-  // A baton that is not interpreted by the engine in any way. It will be given
-  // back to the embedder in the destruction callback below. Embedder resources
-  // may be associated with this baton.
-  void* user_data;
-  // The callback invoked by the engine when it no longer needs this backing
-  // store.
-  VoidCallback destruction_callback;
-} FlutterSoftwareBackingStore;
-
 // The identifier of the platform view. This identifier is specified by the
 // application when a platform view is added to the scene via the
 // `SceneBuilder.addPlatformView` call.
@@ -555,6 +627,12 @@ typedef struct {
   // absence, platforms views in the scene are ignored and Flutter renders to
   // the root surface as normal.
   const FlutterCompositor* compositor;
+
+  // The number of bytes of the persistent cache read into memory when the
+  // engine starts, so that the shaders of the first frames are loaded without
+  // waiting on the disk. Only caches stored in a single pack file are
+  // prefetched. Zero, the default, to not prefetch the cache.
+  size_t persistent_cache_prefetch_byte_budget;
 } FlutterProjectArgs;
 
 FLUTTER_EXPORT
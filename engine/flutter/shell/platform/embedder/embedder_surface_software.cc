@@ -57,6 +57,10 @@ sk_sp<SkSurface> EmbedderSurfaceSoftware::AcquireBackingStore(
     return nullptr;
   }
 
+  if (software_dispatch_table_.software_create_buffer) {
+    return AcquireEmbedderBuffer(size);
+  }
+
   if (sk_surface_ != nullptr &&
       SkISize::Make(sk_surface_->width(), sk_surface_->height()) == size) {
     // The old and new surface sizes are the same. Nothing to do here.
@@ -78,6 +82,96 @@ sk_sp<SkSurface> EmbedderSurfaceSoftware::AcquireBackingStore(
 // |GPUSurfaceSoftwareDelegate|
 bool EmbedderSurfaceSoftware::PresentBackingStore(
     sk_sp<SkSurface> backing_store) {
+  return Present(backing_store, SkIRect::MakeWH(backing_store->width(),
+                                                backing_store->height()));
+}
+
+// |GPUSurfaceSoftwareDelegate|
+bool EmbedderSurfaceSoftware::PresentBackingStoreWithDamage(
+    sk_sp<SkSurface> backing_store,
+    const SkIRect& damage) {
+  return Present(backing_store, damage);
+}
+
+// |GPUSurfaceSoftwareDelegate|
+bool EmbedderSurfaceSoftware::BackingStoreHoldsLastPresentedFrame(
+    const sk_sp<SkSurface>& backing_store) const {
+  return back_buffer_holds_last_frame_ && backing_store != nullptr &&
+         backing_store == buffers_[back_index_];
+}
+
+// |GPUSurfaceSoftwareDelegate|
+ExternalViewEmbedder* EmbedderSurfaceSoftware::GetExternalViewEmbedder() {
+  return external_view_embedder_.get();
+}
+
+sk_sp<SkSurface> EmbedderSurfaceSoftware::AcquireEmbedderBuffer(
+    const SkISize& size) {
+  if (buffers_[0] == nullptr ||
+      SkISize::Make(buffers_[0]->width(), buffers_[0]->height()) != size) {
+    // Let go of the old buffers before the embedder is asked for new ones, so
+    // that it may reuse their memory. The GPU surface let go of the last
+    // presented one when the size changed, so their destruction callbacks run
+    // here.
+    for (size_t i = 0; i < kBufferCount; i++) {
+      buffers_[i] = nullptr;
+      buffer_presents_[i] = 0;
+    }
+    present_count_ = 0;
+    for (size_t i = 0; i < kBufferCount; i++) {
+      buffers_[i] = software_dispatch_table_.software_create_buffer(size, i);
+      if (buffers_[i] == nullptr) {
+        FML_LOG(ERROR) << "Could not create the embedder supplied software "
+                          "render buffer.";
+        for (size_t j = 0; j < kBufferCount; j++) {
+          buffers_[j] = nullptr;
+        }
+        return nullptr;
+      }
+    }
+  }
+
+  // Render into the buffer that is not on screen.
+  back_index_ =
+      present_count_ == 0 ? 0 : (presented_index_ + 1) % kBufferCount;
+  back_buffer_holds_last_frame_ = CopyLastFrameToBackBuffer();
+  // The back buffer no longer holds a presented frame once rendered into,
+  // even if the frame ends up not being presented.
+  buffer_presents_[back_index_] = 0;
+  return buffers_[back_index_];
+}
+
+bool EmbedderSurfaceSoftware::CopyLastFrameToBackBuffer() {
+  TRACE_EVENT0("flutter", "EmbedderSurfaceSoftware::CopyLastFrameToBackBuffer");
+  if (present_count_ == 0) {
+    return false;
+  }
+
+  SkPixmap front_pixels;
+  if (!buffers_[presented_index_]->peekPixels(&front_pixels)) {
+    return false;
+  }
+
+  const sk_sp<SkSurface>& back_buffer = buffers_[back_index_];
+
+  // A buffer that showed the frame before the last one only lacks the damage
+  // of the last present.
+  const size_t back_buffer_present = buffer_presents_[back_index_];
+  if (back_buffer_present != 0 && back_buffer_present + 1 == present_count_) {
+    SkPixmap damaged_pixels;
+    if (front_pixels.extractSubset(&damaged_pixels, last_present_damage_)) {
+      back_buffer->writePixels(damaged_pixels, last_present_damage_.x(),
+                               last_present_damage_.y());
+    }
+    return true;
+  }
+
+  back_buffer->writePixels(front_pixels, 0, 0);
+  return true;
+}
+
+bool EmbedderSurfaceSoftware::Present(const sk_sp<SkSurface>& backing_store,
+                                      SkIRect damage) {
   if (!IsValid()) {
     FML_LOG(ERROR) << "Tried to present an invalid software surface.";
     return false;
@@ -89,26 +183,40 @@ bool EmbedderSurfaceSoftware::PresentBackingStore(
     return false;
   }
 
-  // Some basic sanity checking.
-  uint64_t expected_pixmap_data_size = pixmap.width() * pixmap.height() * 4;
-
-  const size_t pixmap_size = pixmap.computeByteSize();
-
-  if (expected_pixmap_data_size != pixmap_size) {
+  // Some basic sanity checking. Embedder buffers may pad their rows.
+  if (pixmap.info().bytesPerPixel() != 4 ||
+      pixmap.rowBytes() < pixmap.info().minRowBytes()) {
     FML_LOG(ERROR) << "Software backing store had unexpected size.";
     return false;
   }
 
+  if (!damage.intersect(SkIRect::MakeWH(pixmap.width(), pixmap.height()))) {
+    damage.setEmpty();
+  }
+
+  size_t buffer_index = 0;
+  for (size_t i = 0; i < kBufferCount; i++) {
+    if (buffers_[i] != nullptr && buffers_[i] == backing_store) {
+      buffer_index = i;
+      buffer_presents_[i] = ++present_count_;
+      presented_index_ = i;
+      last_present_damage_ = damage;
+      back_buffer_holds_last_frame_ = false;
+    }
+  }
+
+  std::vector<SkIRect> damage_rects;
+  if (!damage.isEmpty()) {
+    damage_rects.push_back(damage);
+  }
+
   return software_dispatch_table_.software_present_backing_store(
       pixmap.addr(),      //
       pixmap.rowBytes(),  //
-      pixmap.height()     //
+      pixmap.height(),    //
+      damage_rects,       //
+      buffer_index        //
   );
 }
 
-// |GPUSurfaceSoftwareDelegate|
-ExternalViewEmbedder* EmbedderSurfaceSoftware::GetExternalViewEmbedder() {
-  return external_view_embedder_.get();
-}
-
 }  // namespace flutter
@@ -5,6 +5,8 @@
 #ifndef FLUTTER_SHELL_PLATFORM_EMBEDDER_EMBEDDER_SURFACE_SOFTWARE_H_
 #define FLUTTER_SHELL_PLATFORM_EMBEDDER_EMBEDDER_SURFACE_SOFTWARE_H_
 
+#include <vector>
+
 #include "flutter/fml/macros.h"
 #include "flutter/shell/gpu/gpu_surface_software.h"
 #include "flutter/shell/platform/embedder/embedder_external_view_embedder.h"
@@ -15,9 +17,18 @@ namespace flutter {
 class EmbedderSurfaceSoftware final : public EmbedderSurface,
                                       public GPUSurfaceSoftwareDelegate {
  public:
+  // The number of embedder buffers rendered into in turn.
+  static constexpr size_t kBufferCount = 2;
+
   struct SoftwareDispatchTable {
-    std::function<bool(const void* allocation, size_t row_bytes, size_t height)>
+    std::function<bool(const void* allocation,
+                       size_t row_bytes,
+                       size_t height,
+                       const std::vector<SkIRect>& damage,
+                       size_t buffer_index)>
         software_present_backing_store;  // required
+    std::function<sk_sp<SkSurface>(const SkISize& size, size_t index)>
+        software_create_buffer;  // optional
   };
 
   EmbedderSurfaceSoftware(
@@ -31,6 +42,16 @@ class EmbedderSurfaceSoftware final : public EmbedderSurface,
   SoftwareDispatchTable software_dispatch_table_;
   sk_sp<SkSurface> sk_surface_;
   std::unique_ptr<EmbedderExternalViewEmbedder> external_view_embedder_;
+  // The embedder buffers, when it provides them.
+  sk_sp<SkSurface> buffers_[kBufferCount];
+  // The number of the present that last showed each buffer, zero if the
+  // buffer was rendered into since.
+  size_t buffer_presents_[kBufferCount] = {};
+  size_t present_count_ = 0;
+  size_t presented_index_ = 0;
+  size_t back_index_ = 0;
+  SkIRect last_present_damage_ = SkIRect::MakeEmpty();
+  bool back_buffer_holds_last_frame_ = false;
 
   // |EmbedderSurface|
   bool IsValid() const override;
@@ -47,9 +68,25 @@ class EmbedderSurfaceSoftware final : public EmbedderSurface,
   // |GPUSurfaceSoftwareDelegate|
   bool PresentBackingStore(sk_sp<SkSurface> backing_store) override;
 
+  // |GPUSurfaceSoftwareDelegate|
+  bool PresentBackingStoreWithDamage(sk_sp<SkSurface> backing_store,
+                                     const SkIRect& damage) override;
+
+  // |GPUSurfaceSoftwareDelegate|
+  bool BackingStoreHoldsLastPresentedFrame(
+      const sk_sp<SkSurface>& backing_store) const override;
+
   // |GPUSurfaceSoftwareDelegate|
   ExternalViewEmbedder* GetExternalViewEmbedder() override;
 
+  sk_sp<SkSurface> AcquireEmbedderBuffer(const SkISize& size);
+
+  // Copies the last presented frame into the back buffer where it differs
+  // from it. Returns if the back buffer holds the last frame.
+  bool CopyLastFrameToBackBuffer();
+
+  bool Present(const sk_sp<SkSurface>& backing_store, SkIRect damage);
+
   FML_DISALLOW_COPY_AND_ASSIGN(EmbedderSurfaceSoftware);
 };
 
@@ -254,3 +254,13 @@ void can_composite_platform_views_with_known_scene() {
   window.scheduleFrame();
 }
 
+@pragma('vm:entry-point')
+void render_red_box() {
+  window.onBeginFrame = (Duration duration) {
+    SceneBuilder builder = SceneBuilder();
+    builder.addPicture(Offset(0.0, 0.0),
+        CreateColoredBox(Color.fromARGB(255, 255, 0, 0), Size(800.0, 600.0)));
+    window.render(builder.build());
+  };
+  window.scheduleFrame();
+}
@@ -70,6 +70,30 @@ void EmbedderConfigBuilder::SetSoftwareRendererConfig() {
   renderer_config_.software = software_renderer_config_;
 }
 
+void EmbedderConfigBuilder::SetSoftwarePresentWithInfoCallback() {
+  software_renderer_config_.surface_present_callback = nullptr;
+  software_renderer_config_.surface_present_with_info_callback =
+      [](void* context, const FlutterSoftwarePresentInfo* present_info) {
+        return reinterpret_cast<EmbedderTestContext*>(context)
+            ->SoftwarePresent(present_info);
+      };
+  SetSoftwareRendererConfig();
+}
+
+void EmbedderConfigBuilder::SetSoftwareCreateBufferCallback() {
+  software_renderer_config_.surface_create_buffer_callback =
+      [](void* context, const FlutterSoftwareBufferConfig* config,
+         FlutterSoftwareBackingStore* buffer_out) {
+        return reinterpret_cast<EmbedderTestContext*>(context)
+            ->SoftwareCreateBuffer(config, buffer_out);
+      };
+  SetSoftwareRendererConfig();
+}
+
+FlutterRendererConfig& EmbedderConfigBuilder::GetRendererConfig() {
+  return renderer_config_;
+}
+
 void EmbedderConfigBuilder::SetOpenGLRendererConfig() {
   renderer_config_.type = FlutterRendererType::kOpenGL;
   renderer_config_.open_gl = opengl_renderer_config_;
@@ -45,6 +45,15 @@ class EmbedderConfigBuilder {
 
   void SetSoftwareRendererConfig();
 
+  // Presents software frames with their damage to the callback of the context
+  // instead of |surface_present_callback|.
+  void SetSoftwarePresentWithInfoCallback();
+
+  // Renders software frames into the buffers of the callback of the context.
+  void SetSoftwareCreateBufferCallback();
+
+  FlutterRendererConfig& GetRendererConfig();
+
   void SetOpenGLRendererConfig();
 
   void SetAssetsPath();
@@ -200,5 +200,31 @@ void EmbedderTestContext::SetNextSceneCallback(
   next_scene_callback_ = next_scene_callback;
 }
 
+void EmbedderTestContext::SetSoftwarePresentCallback(
+    SoftwarePresentCallback callback) {
+  software_present_callback_ = callback;
+}
+
+void EmbedderTestContext::SetSoftwareCreateBufferCallback(
+    SoftwareCreateBufferCallback callback) {
+  software_create_buffer_callback_ = callback;
+}
+
+bool EmbedderTestContext::SoftwarePresent(
+    const FlutterSoftwarePresentInfo* present_info) {
+  if (software_present_callback_) {
+    return software_present_callback_(present_info);
+  }
+  return true;
+}
+
+bool EmbedderTestContext::SoftwareCreateBuffer(
+    const FlutterSoftwareBufferConfig* config,
+    FlutterSoftwareBackingStore* buffer_out) {
+  FML_CHECK(software_create_buffer_callback_)
+      << "The software create buffer callback must be set.";
+  return software_create_buffer_callback_(config, buffer_out);
+}
+
 }  // namespace testing
 }  // namespace flutter
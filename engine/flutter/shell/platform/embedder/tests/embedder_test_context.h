@@ -61,6 +61,15 @@ class EmbedderTestContext {
   using NextSceneCallback = std::function<void(sk_sp<SkImage> image)>;
   void SetNextSceneCallback(NextSceneCallback next_scene_callback);
 
+  using SoftwarePresentCallback =
+      std::function<bool(const FlutterSoftwarePresentInfo* present_info)>;
+  void SetSoftwarePresentCallback(SoftwarePresentCallback callback);
+
+  using SoftwareCreateBufferCallback =
+      std::function<bool(const FlutterSoftwareBufferConfig* config,
+                         FlutterSoftwareBackingStore* buffer_out)>;
+  void SetSoftwareCreateBufferCallback(SoftwareCreateBufferCallback callback);
+
  private:
   // This allows the builder to access the hooks.
   friend class EmbedderConfigBuilder;
@@ -78,6 +87,8 @@ class EmbedderTestContext {
   std::unique_ptr<TestGLSurface> gl_surface_;
   std::unique_ptr<EmbedderTestCompositor> compositor_;
   NextSceneCallback next_scene_callback_;
+  SoftwarePresentCallback software_present_callback_;
+  SoftwareCreateBufferCallback software_create_buffer_callback_;
 
   static VoidCallback GetIsolateCreateCallbackHook();
 
@@ -107,6 +118,11 @@ class EmbedderTestContext {
 
   void PlatformMessageCallback(const FlutterPlatformMessage* message);
 
+  bool SoftwarePresent(const FlutterSoftwarePresentInfo* present_info);
+
+  bool SoftwareCreateBuffer(const FlutterSoftwareBufferConfig* config,
+                            FlutterSoftwareBackingStore* buffer_out);
+
   FML_DISALLOW_COPY_AND_ASSIGN(EmbedderTestContext);
 };
 
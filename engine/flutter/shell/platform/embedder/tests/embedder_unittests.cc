@@ -4,6 +4,7 @@
 
 #define FML_USED_ON_EMBEDDER
 
+#include <cstddef>
 #include <string>
 
 #include "embedder.h"
@@ -15,6 +16,7 @@
 #include "flutter/fml/synchronization/waitable_event.h"
 #include "flutter/fml/thread.h"
 #include "flutter/runtime/dart_vm.h"
+#include "flutter/shell/platform/embedder/embedder_surface_software.h"
 #include "flutter/shell/platform/embedder/tests/embedder_assertions.h"
 #include "flutter/shell/platform/embedder/tests/embedder_config_builder.h"
 #include "flutter/shell/platform/embedder/tests/embedder_test.h"
@@ -469,6 +471,77 @@ TEST_F(EmbedderTest, InvalidPlatformMessages) {
   ASSERT_EQ(result, kInvalidArguments);
 }
 
+//------------------------------------------------------------------------------
+/// Tests that a platform message with a release callback is delivered without
+/// being copied, and that the embedder gets it back once.
+///
+TEST_F(EmbedderTest, PlatformMessagesCanBeSentWithoutCopies) {
+  auto& context = GetEmbedderContext();
+  EmbedderConfigBuilder builder(context);
+
+  builder.SetDartEntrypoint("platform_messages_no_response");
+
+  const std::string message_data = "Hello but don't copy me.";
+
+  fml::AutoResetWaitableEvent ready, message;
+  context.AddNativeCallback(
+      "SignalNativeTest",
+      CREATE_NATIVE_ENTRY(
+          [&ready](Dart_NativeArguments args) { ready.Signal(); }));
+  context.AddNativeCallback(
+      "SignalNativeMessage",
+      CREATE_NATIVE_ENTRY(
+          ([&message, &message_data](Dart_NativeArguments args) {
+            auto received_message = tonic::DartConverter<std::string>::FromDart(
+                Dart_GetNativeArgument(args, 0));
+            ASSERT_EQ(received_message, message_data);
+            message.Signal();
+          })));
+
+  auto engine = builder.LaunchEngine();
+
+  ASSERT_TRUE(engine.is_valid());
+  ready.Wait();
+
+  struct Release {
+    const uint8_t* data = nullptr;
+    size_t count = 0;
+    fml::CountDownLatch latch{1};
+  } release;
+
+  FlutterPlatformMessage platform_message = {};
+  platform_message.struct_size = sizeof(FlutterPlatformMessage);
+  platform_message.channel = "test_channel";
+  platform_message.message =
+      reinterpret_cast<const uint8_t*>(message_data.data());
+  platform_message.message_size = message_data.size();
+  platform_message.response_handle = nullptr;  // No response needed.
+  platform_message.message_release_callback = [](const uint8_t* data,
+                                                 size_t size, void* user_data) {
+    auto release = reinterpret_cast<Release*>(user_data);
+    release->data = data;
+    release->count++;
+    release->latch.CountDown();
+  };
+  platform_message.message_release_user_data = &release;
+
+  auto result =
+      FlutterEngineSendPlatformMessage(engine.get(), &platform_message);
+  ASSERT_EQ(result, kSuccess);
+  message.Wait();
+  release.latch.Wait();
+  ASSERT_EQ(release.count, 1u);
+  ASSERT_EQ(release.data, platform_message.message);
+
+  // Invalid messages are handed back as well.
+  release.count = 0;
+  platform_message.message = nullptr;
+  platform_message.message_size = 1;
+  ASSERT_EQ(FlutterEngineSendPlatformMessage(engine.get(), &platform_message),
+            kInvalidArguments);
+  ASSERT_EQ(release.count, 1u);
+}
+
 //------------------------------------------------------------------------------
 /// Asserts behavior of FlutterProjectArgs::shutdown_dart_vm_when_done (which is
 /// set to true by default in these unit-tests).
@@ -1069,5 +1142,223 @@ TEST_F(EmbedderTest, CompositorMustBeAbleToRenderKnownScene) {
   ASSERT_TRUE(images_are_same);
 }
 
+static void SendWindowMetrics(FlutterEngine engine) {
+  FlutterWindowMetricsEvent event = {};
+  event.struct_size = sizeof(event);
+  event.width = 800;
+  event.height = 600;
+  ASSERT_EQ(FlutterEngineSendWindowMetricsEvent(engine, &event), kSuccess);
+}
+
+TEST_F(EmbedderTest, SoftwareFramesCanBePresentedWithTheirDamage) {
+  auto& context = GetEmbedderContext();
+  fml::AutoResetWaitableEvent latch;
+  size_t present_count = 0;
+  context.SetSoftwarePresentCallback(
+      [&](const FlutterSoftwarePresentInfo* present_info) {
+        if (present_count++ > 0) {
+          return true;
+        }
+        // The first frame is presented in full, from the engine buffer.
+        EXPECT_EQ(present_info->struct_size,
+                  sizeof(FlutterSoftwarePresentInfo));
+        EXPECT_NE(present_info->allocation, nullptr);
+        EXPECT_GE(present_info->row_bytes, 800u * 4u);
+        EXPECT_EQ(present_info->height, 600u);
+        EXPECT_EQ(present_info->buffer_index, 0u);
+        EXPECT_EQ(present_info->damage_count, 1u);
+        if (present_info->damage_count == 1u) {
+          EXPECT_EQ(present_info->damage[0].left, 0.0);
+          EXPECT_EQ(present_info->damage[0].top, 0.0);
+          EXPECT_EQ(present_info->damage[0].right, 800.0);
+          EXPECT_EQ(present_info->damage[0].bottom, 600.0);
+        }
+        latch.Signal();
+        return true;
+      });
+
+  EmbedderConfigBuilder builder(context);
+  builder.SetSoftwarePresentWithInfoCallback();
+  builder.SetDartEntrypoint("render_red_box");
+  auto engine = builder.LaunchEngine();
+  ASSERT_TRUE(engine.is_valid());
+  SendWindowMetrics(engine.get());
+  latch.Wait();
+}
+
+TEST_F(EmbedderTest, SoftwareConfigsIgnoreTheCallbacksPastTheirSize) {
+  auto& context = GetEmbedderContext();
+  context.SetSoftwareCreateBufferCallback(
+      [](const FlutterSoftwareBufferConfig* config,
+         FlutterSoftwareBackingStore* buffer_out) {
+        ADD_FAILURE() << "The buffer callback is past the size of the config.";
+        return false;
+      });
+
+  EmbedderConfigBuilder builder(context);
+  builder.SetSoftwarePresentWithInfoCallback();
+  builder.SetSoftwareCreateBufferCallback();
+  builder.SetDartEntrypoint("render_red_box");
+
+  // Without the present with info callback, the config has no present
+  // callback at all.
+  builder.GetRendererConfig().software.struct_size =
+      offsetof(FlutterSoftwareRendererConfig,
+               surface_present_with_info_callback);
+  ASSERT_FALSE(builder.LaunchEngine().is_valid());
+
+  // Frames are rendered into engine buffers.
+  fml::AutoResetWaitableEvent latch;
+  context.SetSoftwarePresentCallback(
+      [&latch](const FlutterSoftwarePresentInfo* present_info) {
+        latch.Signal();
+        return true;
+      });
+  builder.GetRendererConfig().software.struct_size =
+      offsetof(FlutterSoftwareRendererConfig, surface_create_buffer_callback);
+  auto engine = builder.LaunchEngine();
+  ASSERT_TRUE(engine.is_valid());
+  SendWindowMetrics(engine.get());
+  latch.Wait();
+}
+
+TEST_F(EmbedderTest, SoftwareFramesCanBeRenderedIntoEmbedderBuffers) {
+  auto& context = GetEmbedderContext();
+  std::vector<uint32_t> buffers[EmbedderSurfaceSoftware::kBufferCount];
+  context.SetSoftwareCreateBufferCallback(
+      [&buffers](const FlutterSoftwareBufferConfig* config,
+                 FlutterSoftwareBackingStore* buffer_out) {
+        EXPECT_EQ(config->struct_size, sizeof(FlutterSoftwareBufferConfig));
+        EXPECT_LT(config->index, EmbedderSurfaceSoftware::kBufferCount);
+        auto& pixels = buffers[config->index];
+        pixels.resize(config->width * config->height);
+        buffer_out->allocation = pixels.data();
+        buffer_out->row_bytes = config->width * sizeof(uint32_t);
+        buffer_out->height = config->height;
+        buffer_out->destruction_callback = [](void* user_data) {};
+        return true;
+      });
+  fml::AutoResetWaitableEvent latch;
+  size_t present_count = 0;
+  context.SetSoftwarePresentCallback(
+      [&](const FlutterSoftwarePresentInfo* present_info) {
+        if (present_count++ > 0) {
+          return true;
+        }
+        EXPECT_EQ(present_info->buffer_index, 0u);
+        EXPECT_EQ(present_info->allocation, buffers[0].data());
+        EXPECT_EQ(buffers[0][0], SkPreMultiplyColor(SK_ColorRED));
+        latch.Signal();
+        return true;
+      });
+
+  EmbedderConfigBuilder builder(context);
+  builder.SetSoftwarePresentWithInfoCallback();
+  builder.SetSoftwareCreateBufferCallback();
+  builder.SetDartEntrypoint("render_red_box");
+  auto engine = builder.LaunchEngine();
+  ASSERT_TRUE(engine.is_valid());
+  SendWindowMetrics(engine.get());
+  latch.Wait();
+}
+
+TEST_F(EmbedderTest, InvalidEmbedderBuffersAreHandedBack) {
+  auto& context = GetEmbedderContext();
+  std::vector<uint32_t> pixels;
+  fml::AutoResetWaitableEvent latch;
+  context.SetSoftwareCreateBufferCallback(
+      [&](const FlutterSoftwareBufferConfig* config,
+          FlutterSoftwareBackingStore* buffer_out) {
+        pixels.resize(config->width * config->height);
+        buffer_out->allocation = pixels.data();
+        // The rows are too short for the width of the frame.
+        buffer_out->row_bytes = config->width;
+        buffer_out->height = config->height;
+        buffer_out->user_data = &latch;
+        buffer_out->destruction_callback = [](void* user_data) {
+          reinterpret_cast<fml::AutoResetWaitableEvent*>(user_data)->Signal();
+        };
+        return true;
+      });
+  context.SetSoftwarePresentCallback(
+      [](const FlutterSoftwarePresentInfo* present_info) {
+        ADD_FAILURE() << "Frames cannot be rendered into invalid buffers.";
+        return false;
+      });
+
+  EmbedderConfigBuilder builder(context);
+  builder.SetSoftwarePresentWithInfoCallback();
+  builder.SetSoftwareCreateBufferCallback();
+  builder.SetDartEntrypoint("render_red_box");
+  auto engine = builder.LaunchEngine();
+  ASSERT_TRUE(engine.is_valid());
+  SendWindowMetrics(engine.get());
+  latch.Wait();
+}
+
+TEST(EmbedderSurfaceSoftwareTest, RendersIntoEmbedderBuffersInTurn) {
+  std::vector<sk_sp<SkSurface>> buffers;
+  std::vector<size_t> presented_indices;
+  std::vector<std::vector<SkIRect>> presented_damage;
+  EmbedderSurfaceSoftware::SoftwareDispatchTable dispatch_table = {
+      [&](const void* allocation, size_t row_bytes, size_t height,
+          const std::vector<SkIRect>& damage, size_t buffer_index) -> bool {
+        presented_indices.push_back(buffer_index);
+        presented_damage.push_back(damage);
+        return true;
+      },
+      [&](const SkISize& size, size_t index) -> sk_sp<SkSurface> {
+        buffers.push_back(
+            SkSurface::MakeRasterN32Premul(size.width(), size.height()));
+        return buffers.back();
+      },
+  };
+  EmbedderSurfaceSoftware software_surface(dispatch_table, nullptr);
+  auto surface = static_cast<EmbedderSurface&>(software_surface)
+                     .CreateGPUSurface();
+  ASSERT_TRUE(surface);
+  const SkISize size = SkISize::Make(8, 8);
+
+  // The first frame is rendered in full.
+  auto frame = surface->AcquireFrame(size);
+  ASSERT_TRUE(frame);
+  ASSERT_FALSE(frame->retains_contents());
+  frame->SkiaCanvas()->clear(SK_ColorRED);
+  ASSERT_TRUE(frame->Submit());
+  ASSERT_EQ(buffers.size(), 2u);
+
+  // The second frame goes to the other buffer, which already holds the first
+  // frame, so only its damage is repainted.
+  frame = surface->AcquireFrame(size);
+  ASSERT_TRUE(frame);
+  ASSERT_TRUE(frame->retains_contents());
+  ASSERT_EQ(frame->SkiaSurface(), buffers[1]);
+  const SkIRect damage = SkIRect::MakeXYWH(2, 2, 2, 2);
+  SkPaint paint;
+  paint.setColor(SK_ColorBLUE);
+  frame->SkiaCanvas()->drawIRect(damage, paint);
+  frame->set_damage(damage);
+  ASSERT_TRUE(frame->Submit());
+
+  // The damage of the second frame is brought over to the first buffer.
+  frame = surface->AcquireFrame(size);
+  ASSERT_TRUE(frame);
+  ASSERT_TRUE(frame->retains_contents());
+  ASSERT_EQ(frame->SkiaSurface(), buffers[0]);
+  SkPixmap pixels;
+  ASSERT_TRUE(buffers[0]->peekPixels(&pixels));
+  ASSERT_EQ(pixels.getColor(0, 0), SK_ColorRED);
+  ASSERT_EQ(pixels.getColor(2, 2), SK_ColorBLUE);
+  frame->set_damage(SkIRect::MakeEmpty());
+  ASSERT_TRUE(frame->Submit());
+
+  ASSERT_EQ(buffers.size(), 2u);
+  ASSERT_EQ(presented_indices, std::vector<size_t>({0, 1, 0}));
+  ASSERT_EQ(presented_damage.size(), 3u);
+  ASSERT_EQ(presented_damage[0], std::vector<SkIRect>({SkIRect::MakeWH(8, 8)}));
+  ASSERT_EQ(presented_damage[1], std::vector<SkIRect>({damage}));
+  ASSERT_TRUE(presented_damage[2].empty());
+}
+
 }  // namespace testing
 }  // namespace flutter
@@ -112,6 +112,8 @@ def RunEngineBenchmarks(build_dir, filter):
 
   RunEngineExecutable(build_dir, 'fml_benchmarks', filter)
 
+  RunEngineExecutable(build_dir, 'client_wrapper_benchmarks', filter)
+
   if IsLinux():
     RunEngineExecutable(build_dir, 'txt_benchmarks', filter, [ fonts_dir_flag ])
 
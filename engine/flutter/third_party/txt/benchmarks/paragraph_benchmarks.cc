@@ -31,6 +31,7 @@
 #include "txt/font_weight.h"
 #include "txt/paragraph.h"
 #include "txt/paragraph_builder_txt.h"
+#include "txt/paragraph_cache.h"
 
 namespace txt {
 
@@ -100,6 +101,48 @@ static void BM_ParagraphLongLayout(benchmark::State& state) {
 }
 BENCHMARK(BM_ParagraphLongLayout);
 
+// Lays paragraphs out on several threads at once, as several isolates or
+// background threads would. Every thread uses its own font size so that the
+// threads don't share cached word layouts.
+static void BM_ParagraphLongLayoutMultiThreaded(benchmark::State& state) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line. Sometimes, short sentence. Longer "
+      "sentences are okay too because they are necessary. Very short. "
+      "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+      "tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+      "veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+      "commodo consequat. Duis aute irure dolor in reprehenderit in voluptate "
+      "velit esse cillum dolore eu fugiat nulla pariatur. Excepteur sint "
+      "occaecat cupidatat non proident, sunt in culpa qui officia deserunt "
+      "mollit anim id est laborum.";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  txt::ParagraphStyle paragraph_style;
+
+  txt::TextStyle text_style;
+  text_style.font_families = std::vector<std::string>(1, "Roboto");
+  text_style.font_size = 10 + state.thread_index;
+  text_style.color = SK_ColorBLACK;
+
+  txt::ParagraphBuilderTxt builder(paragraph_style, GetTestFontCollection());
+
+  builder.PushStyle(text_style);
+  builder.AddText(u16_text);
+  builder.Pop();
+  auto paragraph = BuildParagraph(builder);
+  while (state.KeepRunning()) {
+    paragraph->SetDirty();
+    paragraph->Layout(300);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParagraphLongLayoutMultiThreaded)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
 static void BM_ParagraphJustifyLayout(benchmark::State& state) {
   const char* text =
       "This is a very long sentence to test if the text will properly wrap "
@@ -167,6 +210,111 @@ static void BM_ParagraphManyStylesLayout(benchmark::State& state) {
 }
 BENCHMARK(BM_ParagraphManyStylesLayout);
 
+// Builds and lays out a new paragraph every iteration, as the framework does
+// when it rebuilds a list. The width is either always the same, so that every
+// layout but the first is restored from the ParagraphCache, or cycles through
+// more widths than the cache holds, so that every layout misses.
+static void ParagraphCachedLayout(benchmark::State& state, bool hit) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line. Sometimes, short sentence. Longer "
+      "sentences are okay too because they are necessary. Very short. "
+      "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+      "tempor incididunt ut labore et dolore magna aliqua.";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  txt::ParagraphStyle paragraph_style;
+
+  txt::TextStyle text_style;
+  text_style.font_families = std::vector<std::string>(1, "Roboto");
+  text_style.color = SK_ColorBLACK;
+
+  auto font_collection = GetTestFontCollection();
+  ParagraphCache& cache = ParagraphCache::GetInstance();
+  cache.Clear();
+  ParagraphCache::Stats initial_stats = cache.GetStats();
+  size_t width_index = 0;
+  while (state.KeepRunning()) {
+    txt::ParagraphBuilderTxt builder(paragraph_style, font_collection);
+    builder.PushStyle(text_style);
+    builder.AddText(u16_text);
+    builder.Pop();
+    auto paragraph = BuildParagraph(builder);
+    paragraph->Layout(
+        hit ? 300
+            : 300 + width_index++ % (ParagraphCache::kDefaultMaxEntries * 2));
+  }
+  ParagraphCache::Stats stats = cache.GetStats();
+  size_t hits = stats.hit_count - initial_stats.hit_count;
+  size_t misses = stats.miss_count - initial_stats.miss_count;
+  state.SetLabel("hits: " + std::to_string(hits) +
+                 " misses: " + std::to_string(misses));
+}
+
+static void BM_ParagraphCachedLayoutHit(benchmark::State& state) {
+  ParagraphCachedLayout(state, true);
+}
+BENCHMARK(BM_ParagraphCachedLayoutHit);
+
+static void BM_ParagraphCachedLayoutMiss(benchmark::State& state) {
+  ParagraphCachedLayout(state, false);
+}
+BENCHMARK(BM_ParagraphCachedLayoutMiss);
+
+// Lays a 10k character paragraph out at a new width every iteration, as when
+// a window is resized. Unless |remeasure| is set, the paragraph reuses the
+// widths it measured for the first layout and only breaks the lines again.
+static void ParagraphResizeLayout(benchmark::State& state, bool remeasure) {
+  const char* sentence =
+      "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+      "tempor incididunt ut labore et dolore magna aliqua. ";
+  std::string text;
+  while (text.size() < 10000) {
+    text += sentence;
+  }
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  txt::ParagraphStyle paragraph_style;
+
+  txt::TextStyle text_style;
+  text_style.font_families = std::vector<std::string>(1, "Roboto");
+  text_style.color = SK_ColorBLACK;
+
+  txt::ParagraphBuilderTxt builder(paragraph_style, GetTestFontCollection());
+
+  builder.PushStyle(text_style);
+  builder.AddText(u16_text);
+  builder.Pop();
+  auto paragraph = BuildParagraph(builder);
+  paragraph->Layout(300);
+
+  // Keep the layouts of earlier widths from being restored.
+  ParagraphCache& cache = ParagraphCache::GetInstance();
+  cache.SetMaxEntries(0);
+  size_t width_index = 0;
+  while (state.KeepRunning()) {
+    if (remeasure) {
+      paragraph->SetDirty();
+    }
+    paragraph->Layout(300 + width_index++ % 200);
+  }
+  cache.SetMaxEntries(ParagraphCache::kDefaultMaxEntries);
+}
+
+static void BM_ParagraphResizeLayout(benchmark::State& state) {
+  ParagraphResizeLayout(state, false);
+}
+BENCHMARK(BM_ParagraphResizeLayout);
+
+static void BM_ParagraphResizeLayoutRemeasure(benchmark::State& state) {
+  ParagraphResizeLayout(state, true);
+}
+BENCHMARK(BM_ParagraphResizeLayoutRemeasure);
+
 static void BM_ParagraphTextBigO(benchmark::State& state) {
   std::vector<uint16_t> text;
   for (uint16_t i = 0; i < state.range(0); ++i) {
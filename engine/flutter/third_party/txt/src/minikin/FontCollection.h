@@ -17,6 +17,7 @@
 #ifndef MINIKIN_FONT_COLLECTION_H
 #define MINIKIN_FONT_COLLECTION_H
 
+#include <atomic>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -125,7 +126,7 @@ class FontCollection {
                                            const FontFamily& fontFamily);
 
   // static for allocating unique id's
-  static uint32_t sNextId;
+  static std::atomic<uint32_t> sNextId;
 
   // unique id for this font collection (suitable for cache key)
   uint32_t mId;
@@ -17,6 +17,8 @@
 #ifndef MINIKIN_FONT_LANGUAGE_LIST_CACHE_H
 #define MINIKIN_FONT_LANGUAGE_LIST_CACHE_H
 
+#include <deque>
+#include <mutex>
 #include <unordered_map>
 
 #include <minikin/FontFamily.h>
@@ -32,20 +34,23 @@ class FontLanguageListCache {
   const static uint32_t kEmptyListId = 0;
 
   // Returns language list ID for the given string representation of
-  // FontLanguages. Caller should acquire a lock before calling the method.
+  // FontLanguages.
   static uint32_t getId(const std::string& languages);
 
-  // Caller should acquire a lock before calling the method.
+  // The returned reference stays valid as language lists are never removed.
   static const FontLanguages& getById(uint32_t id);
 
  private:
   FontLanguageListCache() {}  // Singleton
   ~FontLanguageListCache() {}
 
-  // Caller should acquire a lock before calling the method.
   static FontLanguageListCache* getInstance();
 
-  std::vector<FontLanguages> mLanguageLists;
+  std::mutex mMutex;
+
+  // A deque so that references returned by getById are not invalidated by
+  // insertions.
+  std::deque<FontLanguages> mLanguageLists;
 
   // A map from string representation of the font language list to the ID.
   std::unordered_map<std::string, uint32_t> mLanguageListLookupTable;
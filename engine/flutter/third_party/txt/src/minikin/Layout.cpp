@@ -22,6 +22,8 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>  // for debugging
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -33,6 +35,9 @@
 #include <hb-icu.h>
 #include <hb-ot.h>
 
+#include "flutter/fml/thread_local.h"
+#include "flutter/fml/trace_event.h"
+
 #include <minikin/Emoji.h>
 #include <minikin/Layout.h>
 #include "FontLanguage.h"
@@ -99,6 +104,15 @@ class LayoutCacheKey {
     mChars = NULL;
   }
 
+  // Returns the memory held by a cache entry of this key and |layout|. Cached
+  // layouts are never modified, so this doesn't change while they are cached.
+  size_t getEntryBytes(const Layout& layout) const {
+    return sizeof(LayoutCacheKey) + mNchars * sizeof(uint16_t) +
+           sizeof(Layout) + layout.mGlyphs.capacity() * sizeof(LayoutGlyph) +
+           layout.mAdvances.capacity() * sizeof(float) +
+           layout.mFaces.capacity() * sizeof(FakedFont);
+  }
+
   void doLayout(Layout* layout,
                 LayoutContext* ctx,
                 const std::shared_ptr<FontCollection>& collection) const {
@@ -129,53 +143,128 @@ class LayoutCacheKey {
   android::hash_t computeHash() const;
 };
 
-class LayoutCache : private android::OnEntryRemoved<LayoutCacheKey, Layout*> {
+// Shared by all the threads laying text out. The lock is only held to look
+// layouts up and to insert them, words are shaped without holding it. Layouts
+// are shared with the callers so that they stay valid if they are evicted by
+// another thread while in use.
+//
+// The cache is limited by the memory its entries hold rather than by their
+// number, since the layouts of long words or of scripts without spaces can be
+// many times larger than those of short Latin words.
+class LayoutCache
+    : private android::OnEntryRemoved<LayoutCacheKey,
+                                      std::shared_ptr<Layout>> {
  public:
-  LayoutCache() : mCache(kMaxEntries) {
+  LayoutCache()
+      : mCache(android::LruCache<LayoutCacheKey, std::shared_ptr<Layout>>::
+                   kUnlimitedCapacity) {
     mCache.setOnEntryRemovedListener(this);
   }
 
-  void clear() { mCache.clear(); }
-
-  Layout* get(LayoutCacheKey& key,
-              LayoutContext* ctx,
-              const std::shared_ptr<FontCollection>& collection) {
-    Layout* layout = mCache.get(key);
-    if (layout == NULL) {
-      key.copyText();
-      layout = new Layout();
-      key.doLayout(layout, ctx, collection);
-      mCache.put(key, layout);
+  void clear() {
+    std::scoped_lock lock(mMutex);
+    mCache.clear();
+  }
+
+  void setMaxBytes(size_t maxBytes) {
+    std::scoped_lock lock(mMutex);
+    mMaxBytes = maxBytes;
+    evictToMaxBytesLocked();
+  }
+
+  Layout::CacheStats getStats() {
+    std::scoped_lock lock(mMutex);
+    return getStatsLocked();
+  }
+
+  std::shared_ptr<Layout> get(
+      LayoutCacheKey& key,
+      LayoutContext* ctx,
+      const std::shared_ptr<FontCollection>& collection) {
+    {
+      std::scoped_lock lock(mMutex);
+      std::shared_ptr<Layout> layout = mCache.get(key);
+      if (layout) {
+        mHitCount++;
+        traceCountersLocked();
+        return layout;
+      }
+      mMissCount++;
     }
+
+    auto layout = std::make_shared<Layout>();
+    key.doLayout(layout.get(), ctx, collection);
+
+    key.copyText();
+    std::scoped_lock lock(mMutex);
+    if (mCache.put(key, layout)) {
+      mByteCount += key.getEntryBytes(*layout);
+      evictToMaxBytesLocked();
+    } else {
+      // Another thread laid the same word out meanwhile.
+      key.freeText();
+    }
+    traceCountersLocked();
     return layout;
   }
 
  private:
   // callback for OnEntryRemoved
-  void operator()(LayoutCacheKey& key, Layout*& value) {
+  void operator()(LayoutCacheKey& key, std::shared_ptr<Layout>& value) {
+    mByteCount -= key.getEntryBytes(*value);
     key.freeText();
-    delete value;
+    value.reset();
+  }
+
+  void evictToMaxBytesLocked() {
+    while (mByteCount > mMaxBytes && mCache.removeOldest()) {
+      mEvictionCount++;
+    }
   }
 
-  android::LruCache<LayoutCacheKey, Layout*> mCache;
+  Layout::CacheStats getStatsLocked() const {
+    return {mHitCount,    mMissCount, mEvictionCount,
+            mCache.size(), mByteCount, mMaxBytes};
+  }
 
-  // static const size_t kMaxEntries = LruCache<LayoutCacheKey,
-  // Layout*>::kUnlimitedCapacity;
+  // Reports the statistics to the timeline every kTraceInterval lookups, as
+  // reporting every word would be too costly.
+  void traceCountersLocked() {
+    size_t lookupCount = mHitCount + mMissCount;
+    if (lookupCount % kTraceInterval != 0) {
+      return;
+    }
+    FML_TRACE_COUNTER("flutter", "MinikinLayoutCache",
+                      reinterpret_cast<int64_t>(this),             //
+                      "HitRate", mHitCount * 100.0 / lookupCount,  //
+                      "EntryCount", mCache.size(),                 //
+                      "MBytes", mByteCount * 1e-6,                 //
+                      "EvictionCount", mEvictionCount,             //
+                      "BudgetMBytes", mMaxBytes * 1e-6             //
+    );
+  }
 
-  // TODO: eviction based on memory footprint; for now, we just use a constant
-  // number of strings
-  static const size_t kMaxEntries = 5000;
+  std::mutex mMutex;
+  android::LruCache<LayoutCacheKey, std::shared_ptr<Layout>> mCache;
+  size_t mMaxBytes = kDefaultMaxBytes;
+  size_t mByteCount = 0;
+  size_t mHitCount = 0;
+  size_t mMissCount = 0;
+  size_t mEvictionCount = 0;
+
+  // About the memory used by the 5000 entries the cache used to be limited
+  // to, for words of Latin text.
+  static const size_t kDefaultMaxBytes = 2 * 1024 * 1024;
+  static const size_t kTraceInterval = 1000;
 };
 
 class LayoutEngine {
  public:
   LayoutEngine() {
     unicodeFunctions = hb_unicode_funcs_create(hb_icu_get_unicode_funcs());
-    hbBuffer = hb_buffer_create();
-    hb_buffer_set_unicode_funcs(hbBuffer, unicodeFunctions);
+    hb_unicode_funcs_make_immutable(unicodeFunctions);
   }
 
-  hb_buffer_t* hbBuffer;
   hb_unicode_funcs_t* unicodeFunctions;
   LayoutCache layoutCache;
 
@@ -183,8 +272,40 @@ class LayoutEngine {
     static LayoutEngine* instance = new LayoutEngine();
     return *instance;
   }
+
+  // HarfBuzz buffers can't be shared between threads, every thread shapes
+  // into its own.
+  static hb_buffer_t* getThreadBuffer();
 };
 
+namespace {
+
+class ThreadBuffer {
+ public:
+  ThreadBuffer() : mBuffer(hb_buffer_create()) {
+    hb_buffer_set_unicode_funcs(mBuffer,
+                                LayoutEngine::getInstance().unicodeFunctions);
+  }
+
+  ~ThreadBuffer() { hb_buffer_destroy(mBuffer); }
+
+  hb_buffer_t* get() const { return mBuffer; }
+
+ private:
+  hb_buffer_t* mBuffer;
+};
+
+FML_THREAD_LOCAL fml::ThreadLocalUniquePtr<ThreadBuffer> tThreadBuffer;
+
+}  // namespace
+
+hb_buffer_t* LayoutEngine::getThreadBuffer() {
+  if (tThreadBuffer.get() == nullptr) {
+    tThreadBuffer.reset(new ThreadBuffer());
+  }
+  return tThreadBuffer.get()->get();
+}
+
 bool LayoutCacheKey::operator==(const LayoutCacheKey& other) const {
   return mId == other.mId && mStart == other.mStart && mCount == other.mCount &&
          mStyle == other.mStyle && mSize == other.mSize &&
@@ -254,34 +375,31 @@ static hb_bool_t harfbuzzGetGlyphHorizontalOrigin(hb_font_t* /* hbFont */,
   return true;
 }
 
-hb_font_funcs_t* getHbFontFuncs(bool forColorBitmapFont) {
-  assertMinikinLocked();
-
-  static hb_font_funcs_t* hbFuncs = nullptr;
-  static hb_font_funcs_t* hbFuncsForColorBitmap = nullptr;
-
-  hb_font_funcs_t** funcs =
-      forColorBitmapFont ? &hbFuncs : &hbFuncsForColorBitmap;
-  if (*funcs == nullptr) {
-    *funcs = hb_font_funcs_create();
-    if (forColorBitmapFont) {
-      // Don't override the h_advance function since we use HarfBuzz's
-      // implementation for emoji for performance reasons. Note that it is
-      // technically possible for a TrueType font to have outline and embedded
-      // bitmap at the same time. We ignore modified advances of hinted outline
-      // glyphs in that case.
-    } else {
-      // Override the h_advance function since we can't use HarfBuzz's
-      // implemenation. It may return the wrong value if the font uses hinting
-      // aggressively.
-      hb_font_funcs_set_glyph_h_advance_func(
-          *funcs, harfbuzzGetGlyphHorizontalAdvance, 0, 0);
-    }
-    hb_font_funcs_set_glyph_h_origin_func(
-        *funcs, harfbuzzGetGlyphHorizontalOrigin, 0, 0);
-    hb_font_funcs_make_immutable(*funcs);
+static hb_font_funcs_t* createHbFontFuncs(bool forColorBitmapFont) {
+  hb_font_funcs_t* funcs = hb_font_funcs_create();
+  if (forColorBitmapFont) {
+    // Don't override the h_advance function since we use HarfBuzz's
+    // implementation for emoji for performance reasons. Note that it is
+    // technically possible for a TrueType font to have outline and embedded
+    // bitmap at the same time. We ignore modified advances of hinted outline
+    // glyphs in that case.
+  } else {
+    // Override the h_advance function since we can't use HarfBuzz's
+    // implemenation. It may return the wrong value if the font uses hinting
+    // aggressively.
+    hb_font_funcs_set_glyph_h_advance_func(
+        funcs, harfbuzzGetGlyphHorizontalAdvance, 0, 0);
   }
-  return *funcs;
+  hb_font_funcs_set_glyph_h_origin_func(
+      funcs, harfbuzzGetGlyphHorizontalOrigin, 0, 0);
+  hb_font_funcs_make_immutable(funcs);
+  return funcs;
+}
+
+hb_font_funcs_t* getHbFontFuncs(bool forColorBitmapFont) {
+  static hb_font_funcs_t* colorBitmapFuncs = createHbFontFuncs(true);
+  static hb_font_funcs_t* funcs = createHbFontFuncs(false);
+  return forColorBitmapFont ? colorBitmapFuncs : funcs;
 }
 
 static bool isColorBitmapFont(hb_font_t* font) {
@@ -333,7 +451,7 @@ int Layout::findFace(const FakedFont& face, LayoutContext* ctx) {
   // Note: ctx == NULL means we're copying from the cache, no need to create
   // corresponding hb_font object.
   if (ctx != NULL) {
-    hb_font_t* font = getHbFontLocked(face.font);
+    hb_font_t* font = getHbFont(face.font);
     // Temporarily removed to fix advance integer rounding.
     // This is likely due to very old versions of harfbuzz and ICU.
     // hb_font_set_funcs(font, getHbFontFuncs(isColorBitmapFont(font)),
@@ -344,10 +462,7 @@ int Layout::findFace(const FakedFont& face, LayoutContext* ctx) {
 }
 
 static hb_script_t codePointToScript(hb_codepoint_t codepoint) {
-  static hb_unicode_funcs_t* u = 0;
-  if (!u) {
-    u = LayoutEngine::getInstance().unicodeFunctions;
-  }
+  static hb_unicode_funcs_t* u = LayoutEngine::getInstance().unicodeFunctions;
   return hb_unicode_script(u, codepoint);
 }
 
@@ -607,8 +722,6 @@ void Layout::doLayout(const uint16_t* buf,
                       const FontStyle& style,
                       const MinikinPaint& paint,
                       const std::shared_ptr<FontCollection>& collection) {
-  std::scoped_lock _l(gMinikinLock);
-
   LayoutContext ctx;
   ctx.style = style;
   ctx.paint = paint;
@@ -631,8 +744,6 @@ float Layout::measureText(const uint16_t* buf,
                           const MinikinPaint& paint,
                           const std::shared_ptr<FontCollection>& collection,
                           float* advances) {
-  std::scoped_lock _l(gMinikinLock);
-
   LayoutContext ctx;
   ctx.style = style;
   ctx.paint = paint;
@@ -739,9 +850,9 @@ float Layout::doLayoutWord(const uint16_t* buf,
     }
     advance = layoutForWord.getAdvance();
   } else {
-    Layout* layoutForWord = cache.get(key, ctx, collection);
+    std::shared_ptr<Layout> layoutForWord = cache.get(key, ctx, collection);
     if (layout) {
-      layout->appendLayout(layoutForWord, bufStart, wordSpacing);
+      layout->appendLayout(layoutForWord.get(), bufStart, wordSpacing);
     }
     if (advances) {
       layoutForWord->getAdvances(advances);
@@ -938,7 +1049,7 @@ void Layout::doLayoutRun(const uint16_t* buf,
                          bool isRtl,
                          LayoutContext* ctx,
                          const std::shared_ptr<FontCollection>& collection) {
-  hb_buffer_t* buffer = LayoutEngine::getInstance().hbBuffer;
+  hb_buffer_t* buffer = LayoutEngine::getThreadBuffer();
   std::vector<FontCollection::Run> items;
   collection->itemize(buf + start, count, ctx->style, &items);
 
@@ -1213,10 +1324,17 @@ void Layout::getBounds(MinikinRect* bounds) const {
 }
 
 void Layout::purgeCaches() {
-  std::scoped_lock _l(gMinikinLock);
   LayoutCache& layoutCache = LayoutEngine::getInstance().layoutCache;
   layoutCache.clear();
-  purgeHbFontCacheLocked();
+  purgeHbFontCache();
+}
+
+Layout::CacheStats Layout::getCacheStats() {
+  return LayoutEngine::getInstance().layoutCache.getStats();
+}
+
+void Layout::setCacheMaxBytes(size_t maxBytes) {
+  LayoutEngine::getInstance().layoutCache.setMaxBytes(maxBytes);
 }
 
 }  // namespace minikin
@@ -117,6 +117,23 @@ class Layout {
   // Purge all caches, useful in low memory conditions
   static void purgeCaches();
 
+  // libtxt: Statistics of the cache of word layouts shared by all threads.
+  struct CacheStats {
+    size_t hitCount;
+    size_t missCount;
+    size_t evictionCount;
+    size_t entryCount;
+    // The memory held by the cached layouts and their keys.
+    size_t byteCount;
+    size_t maxBytes;
+  };
+
+  static CacheStats getCacheStats();
+
+  // libtxt: Sets the memory budget of the word layout cache. The least
+  // recently used layouts are evicted until the cache fits in it.
+  static void setCacheMaxBytes(size_t maxBytes);
+
  private:
   friend class LayoutCacheKey;
 
@@ -111,24 +111,48 @@ bool isLineEndSpace(uint16_t c) {
          c == 0x3000;
 }
 
-// Ordinarily, this method measures the text in the range given. However, when
-// paint is nullptr, it assumes the widths have already been calculated and
-// stored in the width buffer. This method finds the candidate word breaks
-// (using the ICU break iterator) and sends them to addCandidate.
 float LineBreaker::addStyleRun(MinikinPaint* paint,
                                const std::shared_ptr<FontCollection>& typeface,
                                FontStyle style,
                                size_t start,
                                size_t end,
                                bool isRtl) {
+  return addStyleRunInternal(paint, typeface, style, start, end, isRtl, true);
+}
+
+void LineBreaker::addMeasuredStyleRun(
+    MinikinPaint* paint,
+    const std::shared_ptr<FontCollection>& typeface,
+    FontStyle style,
+    size_t start,
+    size_t end,
+    bool isRtl) {
+  addStyleRunInternal(paint, typeface, style, start, end, isRtl, false);
+}
+
+// Ordinarily, this method measures the text in the range given. However, when
+// paint is nullptr or measure is false, it assumes the widths have already
+// been calculated and stored in the width buffer. This method finds the
+// candidate word breaks (using the ICU break iterator) and sends them to
+// addCandidate.
+float LineBreaker::addStyleRunInternal(
+    MinikinPaint* paint,
+    const std::shared_ptr<FontCollection>& typeface,
+    FontStyle style,
+    size_t start,
+    size_t end,
+    bool isRtl,
+    bool measure) {
   float width = 0.0f;
   int bidiFlags = isRtl ? kBidi_Force_RTL : kBidi_Force_LTR;
 
   float hyphenPenalty = 0.0;
   if (paint != nullptr) {
-    width = Layout::measureText(mTextBuf.data(), start, end - start,
-                                mTextBuf.size(), bidiFlags, style, *paint,
-                                typeface, mCharWidths.data() + start);
+    if (measure) {
+      width = Layout::measureText(mTextBuf.data(), start, end - start,
+                                  mTextBuf.size(), bidiFlags, style, *paint,
+                                  typeface, mCharWidths.data() + start);
+    }
 
     // a heuristic that seems to perform well
     hyphenPenalty =
@@ -155,6 +155,18 @@ class LineBreaker {
                     size_t end,
                     bool isRtl);
 
+  // libtxt: Like addStyleRun, but takes the widths of the run from the width
+  // buffer (see charWidths()) instead of measuring the text. The buffer must
+  // hold the widths measured by an earlier addStyleRun of the same text and
+  // style, which allows breaking it again at another line width without
+  // shaping it.
+  void addMeasuredStyleRun(MinikinPaint* paint,
+                           const std::shared_ptr<FontCollection>& typeface,
+                           FontStyle style,
+                           size_t start,
+                           size_t end,
+                           bool isRtl);
+
   void addReplacement(size_t start, size_t end, float width);
 
   size_t computeBreaks();
@@ -200,6 +212,14 @@ class LineBreaker {
 
   float currentLineWidth() const;
 
+  float addStyleRunInternal(MinikinPaint* paint,
+                            const std::shared_ptr<FontCollection>& typeface,
+                            FontStyle style,
+                            size_t start,
+                            size_t end,
+                            bool isRtl,
+                            bool measure);
+
   // Determine whether to split a character string.
   bool IsSplittingCharacters(ParaWidth postBreak);
 
@@ -21,8 +21,7 @@
 namespace minikin {
 
 MinikinFont::~MinikinFont() {
-  std::scoped_lock _l(gMinikinLock);
-  purgeHbFontLocked(this);
+  purgeHbFont(this);
 }
 
 }  // namespace minikin
@@ -19,8 +19,6 @@
 #ifndef MINIKIN_INTERNAL_H
 #define MINIKIN_INTERNAL_H
 
-#include <mutex>
-
 #include <hb.h>
 
 #include <minikin/MinikinFont.h>
@@ -28,13 +26,9 @@
 namespace minikin {
 
 // All external Minikin interfaces are designed to be thread-safe.
-// Presently, that's implemented by through a global lock, and having
-// all external interfaces take that lock.
-
-extern std::recursive_mutex gMinikinLock;
-
-// Aborts if gMinikinLock is not acquired. Do nothing on the release build.
-void assertMinikinLocked();
+// Caches shared between threads are guarded by their own locks, which are
+// never held while shaping text, so that independent layouts can run in
+// parallel.
 
 hb_blob_t* getFontTable(const MinikinFont* minikinFont, uint32_t tag);
 
@@ -107,23 +107,28 @@ size_t FontCollection::GetFontManagersCount() const {
 void FontCollection::SetupDefaultFontManager() {
   std::lock_guard<std::mutex> lock(fontManagerMutex_);
   default_font_manager_ = GetDefaultFontManager();
+  generation_++;
 }
 
 void FontCollection::SetDefaultFontManager(sk_sp<SkFontMgr> font_manager) {
   std::lock_guard<std::mutex> lock(fontManagerMutex_);
   default_font_manager_ = font_manager;
+  generation_++;
 }
 
 void FontCollection::SetAssetFontManager(sk_sp<SkFontMgr> font_manager) {
   asset_font_manager_ = font_manager;
+  generation_++;
 }
 
 void FontCollection::SetDynamicFontManager(sk_sp<SkFontMgr> font_manager) {
   dynamic_font_manager_ = font_manager;
+  generation_++;
 }
 
 void FontCollection::SetTestFontManager(sk_sp<SkFontMgr> font_manager) {
   test_font_manager_ = font_manager;
+  generation_++;
 }
 
 sk_sp<SkFontMgr> FontCollection::GetDefaultFontManagerSafely() const {
@@ -148,6 +153,7 @@ std::vector<sk_sp<SkFontMgr>> FontCollection::GetFontManagerOrder() const {
 
 void FontCollection::DisableFontFallback() {
   enable_font_fallback_ = false;
+  generation_++;
 }
 
 std::shared_ptr<minikin::FontCollection>
@@ -365,6 +371,7 @@ void FontCollection::ClearFontFamilyCache() {
   decltype(font_collections_cache_) font_collections_cache;
   std::lock_guard<std::mutex> lock(mutex_);
   std::swap(font_collections_cache_, font_collections_cache);
+  generation_++;
 }
 
 void FontCollection::VaryFontCollectionWithFontWeightScale(float font_weight_scale) {
@@ -376,6 +383,7 @@ void FontCollection::VaryFontCollectionWithFontWeightScale(float font_weight_sca
     fallback_fonts = std::move(fallback_fonts_);
     fallback_match_cache_.clear();
     fallback_fonts_for_locale_.clear();
+    generation_++;
   }
 }
 
@@ -403,6 +411,10 @@ void FontCollection::SetIsZawgyiMyanmar(bool is_zawgyi_myanmar) {
   LoadSystemFont();
 }
 
+uint64_t FontCollection::GetGeneration() const {
+  return generation_;
+}
+
 #if defined(OHOS_PLATFORM) && !defined(OHOS_STANDARD_SYSTEM)
 // Return the available font managers in the order they should be queried with
 // type.
@@ -17,6 +17,7 @@
 #ifndef LIB_TXT_SRC_FONT_COLLECTION_H_
 #define LIB_TXT_SRC_FONT_COLLECTION_H_
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -75,6 +76,10 @@ class FontCollection : public std::enable_shared_from_this<FontCollection> {
 
   void SetIsZawgyiMyanmar(bool is_zawgyi_myanmar);
 
+  // Returns a number that changes whenever the fonts matched by the collection
+  // may have changed, which makes layouts done with older fonts stale.
+  uint64_t GetGeneration() const;
+
 #if FLUTTER_ENABLE_SKSHAPER
 
   // Construct a Skia text layout FontCollection based on this collection.
@@ -123,6 +128,7 @@ class FontCollection : public std::enable_shared_from_this<FontCollection> {
   bool is_zawgyi_myanmar_ = false; // whether encoding of Burmese is zawgyi, not unicode.
   float font_weight_scale_ = 1.0f;
   std::vector<FamilyKey> varied_fonts_;
+  std::atomic<uint64_t> generation_{0};
 
   std::mutex mutex_;
   mutable std::mutex fontManagerMutex_;
@@ -40,4 +40,12 @@ std::string FontFeatures::GetFeatureSettings() const {
   return stream.str();
 }
 
+bool FontFeatures::operator==(const FontFeatures& other) const {
+  return feature_map_ == other.feature_map_;
+}
+
+bool FontFeatures::operator!=(const FontFeatures& other) const {
+  return !(*this == other);
+}
+
 }  // namespace txt
@@ -31,6 +31,10 @@ class FontFeatures {
 
   std::string GetFeatureSettings() const;
 
+  bool operator==(const FontFeatures& other) const;
+
+  bool operator!=(const FontFeatures& other) const;
+
  private:
   std::map<std::string, int> feature_map_;
 };
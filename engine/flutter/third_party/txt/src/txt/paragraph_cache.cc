@@ -0,0 +1,146 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "paragraph_cache.h"
+
+#include <functional>
+
+namespace txt {
+namespace {
+
+size_t HashCombine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+ParagraphCache::Key::Key(const std::vector<uint16_t>& text,
+                         const StyledRuns& runs,
+                         const ParagraphStyle& paragraph_style,
+                         const std::vector<float>& indents,
+                         double width,
+                         const std::shared_ptr<FontCollection>& font_collection)
+    : text_(text),
+      paragraph_style_(paragraph_style),
+      indents_(indents),
+      width_(width),
+      font_collection_(font_collection),
+      font_collection_address_(font_collection.get()),
+      font_generation_(font_collection ? font_collection->GetGeneration() : 0) {
+  runs_.reserve(runs.size());
+  for (size_t i = 0; i < runs.size(); ++i) {
+    StyledRuns::Run run = runs.GetRun(i);
+    runs_.push_back({run.style, run.start, run.end});
+  }
+
+  for (uint16_t code_unit : text_) {
+    hash_ = HashCombine(hash_, code_unit);
+  }
+  for (const Run& run : runs_) {
+    hash_ = HashCombine(hash_, run.start);
+    hash_ = HashCombine(hash_, run.end);
+    hash_ = HashCombine(hash_, std::hash<double>()(run.style.font_size));
+  }
+  hash_ = HashCombine(hash_, std::hash<double>()(width_));
+  hash_ =
+      HashCombine(hash_, std::hash<const void*>()(font_collection_address_));
+  hash_ = HashCombine(hash_, font_generation_);
+}
+
+bool ParagraphCache::Key::operator==(const Key& other) const {
+  if (hash_ != other.hash_ || width_ != other.width_ ||
+      font_collection_address_ != other.font_collection_address_ ||
+      font_generation_ != other.font_generation_ || text_ != other.text_ ||
+      indents_ != other.indents_ || runs_.size() != other.runs_.size() ||
+      !paragraph_style_.equals(other.paragraph_style_)) {
+    return false;
+  }
+  for (size_t i = 0; i < runs_.size(); ++i) {
+    const Run& run = runs_[i];
+    const Run& other_run = other.runs_[i];
+    if (run.start != other_run.start || run.end != other_run.end ||
+        !run.style.equals(other_run.style)) {
+      return false;
+    }
+  }
+  // Only one of the keys can refer to a live collection at this address.
+  return !font_collection_.owner_before(other.font_collection_) &&
+         !other.font_collection_.owner_before(font_collection_);
+}
+
+ParagraphCache& ParagraphCache::GetInstance() {
+  static ParagraphCache* instance = new ParagraphCache();
+  return *instance;
+}
+
+ParagraphCache::ParagraphCache(size_t max_entries)
+    : max_entries_(max_entries) {}
+
+ParagraphCache::~ParagraphCache() = default;
+
+void ParagraphCache::SetMaxEntries(size_t max_entries) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_entries_ = max_entries;
+  EvictToMaxEntriesLocked();
+}
+
+void ParagraphCache::Clear() {
+  std::list<Entry> entries;
+  std::lock_guard<std::mutex> lock(mutex_);
+  index_.clear();
+  std::swap(entries, entries_);
+  stats_.entry_count = 0;
+}
+
+ParagraphCache::Stats ParagraphCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+ParagraphCache::Layout ParagraphCache::Find(const Key& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(&key);
+  if (found == index_.end()) {
+    stats_.miss_count++;
+    return nullptr;
+  }
+  // Make it the most recently used entry.
+  entries_.splice(entries_.begin(), entries_, found->second);
+  stats_.hit_count++;
+  return found->second->layout;
+}
+
+void ParagraphCache::Insert(Key key, Layout layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (max_entries_ == 0 || index_.find(&key) != index_.end()) {
+    return;
+  }
+  entries_.push_front({std::move(key), std::move(layout)});
+  index_.emplace(&entries_.front().key, entries_.begin());
+  stats_.entry_count++;
+  EvictToMaxEntriesLocked();
+}
+
+void ParagraphCache::EvictToMaxEntriesLocked() {
+  while (entries_.size() > max_entries_) {
+    index_.erase(&entries_.back().key);
+    entries_.pop_back();
+    stats_.entry_count--;
+    stats_.eviction_count++;
+  }
+}
+
+}  // namespace txt
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIB_TXT_SRC_PARAGRAPH_CACHE_H_
+#define LIB_TXT_SRC_PARAGRAPH_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "font_collection.h"
+#include "paragraph_style.h"
+#include "paragraph_txt.h"
+#include "styled_runs.h"
+#include "text_style.h"
+
+namespace txt {
+
+// Keeps the results of ParagraphTxt::Layout() so that a paragraph with the
+// same text, styles and width as one laid out earlier, typically rebuilt by
+// the framework for the next frame, can restore its line breaks, glyph
+// positions and text blobs instead of shaping the text again.
+//
+// The least recently used layouts are evicted beyond a maximum number of
+// entries. Paragraphs with inline placeholders are not cached.
+//
+// Thread-safe.
+class ParagraphCache {
+ public:
+  static constexpr size_t kDefaultMaxEntries = 128;
+
+  // Identifies the layout of a paragraph by everything that affects it.
+  class Key {
+   public:
+    Key(const std::vector<uint16_t>& text,
+        const StyledRuns& runs,
+        const ParagraphStyle& paragraph_style,
+        const std::vector<float>& indents,
+        double width,
+        const std::shared_ptr<FontCollection>& font_collection);
+
+    size_t GetHash() const { return hash_; }
+
+    bool operator==(const Key& other) const;
+
+   private:
+    struct Run {
+      TextStyle style;
+      size_t start;
+      size_t end;
+    };
+
+    std::vector<uint16_t> text_;
+    std::vector<Run> runs_;
+    ParagraphStyle paragraph_style_;
+    std::vector<float> indents_;
+    double width_;
+    // Layouts done by a collection that was destroyed since must not be found
+    // by a new collection allocated at the same address.
+    std::weak_ptr<FontCollection> font_collection_;
+    const FontCollection* font_collection_address_;
+    uint64_t font_generation_;
+    size_t hash_ = 0;
+  };
+
+  struct Stats {
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+    size_t eviction_count = 0;
+    size_t entry_count = 0;
+  };
+
+  // The cache used by all the paragraphs of the process.
+  static ParagraphCache& GetInstance();
+
+  explicit ParagraphCache(size_t max_entries = kDefaultMaxEntries);
+
+  ~ParagraphCache();
+
+  // Evicts entries until at most |max_entries| are left. Nothing is cached
+  // while it is 0.
+  void SetMaxEntries(size_t max_entries);
+
+  // Removes all the entries.
+  void Clear();
+
+  Stats GetStats() const;
+
+ private:
+  friend class ParagraphTxt;
+
+  using Layout = std::shared_ptr<const ParagraphTxt::CachedLayout>;
+
+  struct Entry {
+    Key key;
+    Layout layout;
+  };
+
+  // The index refers to the keys of the entries rather than copying them.
+  struct KeyPointerHash {
+    size_t operator()(const Key* key) const { return key->GetHash(); }
+  };
+
+  struct KeyPointerEqual {
+    bool operator()(const Key* a, const Key* b) const { return *a == *b; }
+  };
+
+  mutable std::mutex mutex_;
+  size_t max_entries_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<const Key*,
+                     std::list<Entry>::iterator,
+                     KeyPointerHash,
+                     KeyPointerEqual>
+      index_;
+  Stats stats_;
+
+  // Returns the layout stored for |key|, or null.
+  Layout Find(const Key& key);
+
+  // Stores |layout| for |key|, evicting the least recently used entries if
+  // the cache is full.
+  void Insert(Key key, Layout layout);
+
+  void EvictToMaxEntriesLocked();
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ParagraphCache);
+};
+
+}  // namespace txt
+
+#endif  // LIB_TXT_SRC_PARAGRAPH_CACHE_H_
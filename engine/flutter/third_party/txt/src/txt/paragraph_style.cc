@@ -34,6 +34,55 @@ TextStyle ParagraphStyle::GetTextStyle() const {
   return result;
 }
 
+bool ParagraphStyle::equals(const ParagraphStyle& other) const {
+  if (font_weight != other.font_weight)
+    return false;
+  if (font_style != other.font_style)
+    return false;
+  if (font_family != other.font_family)
+    return false;
+  if (font_size != other.font_size)
+    return false;
+  if (height != other.height)
+    return false;
+  if (has_height_override != other.has_height_override)
+    return false;
+  if (strut_enabled != other.strut_enabled)
+    return false;
+  if (strut_font_weight != other.strut_font_weight)
+    return false;
+  if (strut_font_style != other.strut_font_style)
+    return false;
+  if (strut_font_families != other.strut_font_families)
+    return false;
+  if (strut_font_size != other.strut_font_size)
+    return false;
+  if (strut_height != other.strut_height)
+    return false;
+  if (strut_has_height_override != other.strut_has_height_override)
+    return false;
+  if (strut_leading != other.strut_leading)
+    return false;
+  if (force_strut_height != other.force_strut_height)
+    return false;
+  if (text_align != other.text_align)
+    return false;
+  if (text_direction != other.text_direction)
+    return false;
+  if (max_lines != other.max_lines)
+    return false;
+  if (ellipsis != other.ellipsis)
+    return false;
+  if (locale != other.locale)
+    return false;
+  if (break_strategy != other.break_strategy)
+    return false;
+  if (word_break_type != other.word_break_type)
+    return false;
+
+  return true;
+}
+
 bool ParagraphStyle::unlimited_lines() const {
   return max_lines == std::numeric_limits<size_t>::max();
 };
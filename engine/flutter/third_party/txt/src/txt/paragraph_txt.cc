@@ -35,6 +35,7 @@
 #include "minikin/LayoutUtils.h"
 #include "minikin/LineBreaker.h"
 #include "minikin/MinikinFont.h"
+#include "paragraph_cache.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkFont.h"
 #include "third_party/skia/include/core/SkFontMetrics.h"
@@ -101,6 +102,13 @@ std::vector<Paragraph::Range<size_t>> GetLayoutTypefaceRuns(
   return result;
 }
 
+PaintRecord CopyPaintRecord(const PaintRecord& record) {
+  return PaintRecord(record.style(), record.offset(), sk_ref_sp(record.text()),
+                     record.metrics(), record.line(), record.x_start(),
+                     record.x_end(), record.isGhost(),
+                     record.GetPlaceholderRun());
+}
+
 int GetWeight(const FontWeight weight) {
   switch (weight) {
     case FontWeight::w100:
@@ -235,6 +243,7 @@ ParagraphTxt::~ParagraphTxt() = default;
 
 void ParagraphTxt::SetText(std::vector<uint16_t> text, StyledRuns runs) {
   needs_layout_ = true;
+  is_measured_ = false;
   if (text.size() == 0)
     return;
   text_ = std::move(text);
@@ -245,34 +254,46 @@ void ParagraphTxt::SetInlinePlaceholders(
     std::vector<PlaceholderRun> inline_placeholders,
     std::unordered_set<size_t> obj_replacement_char_indexes) {
   needs_layout_ = true;
+  is_measured_ = false;
   inline_placeholders_ = std::move(inline_placeholders);
   obj_replacement_char_indexes_ = std::move(obj_replacement_char_indexes);
 }
 
-bool ParagraphTxt::ComputeLineBreaks() {
+bool ParagraphTxt::ComputeLineBreaks(bool measured) {
   line_ranges_.clear();
   line_widths_.clear();
   max_intrinsic_width_ = 0;
 
-  std::vector<size_t> newline_positions;
-  // Discover and add all hard breaks.
-  for (size_t i = 0; i < text_.size(); ++i) {
-    ULineBreak ulb = static_cast<ULineBreak>(
-        u_getIntPropertyValue(text_[i], UCHAR_LINE_BREAK));
-    if (ulb == U_LB_LINE_FEED || ulb == U_LB_MANDATORY_BREAK)
-      newline_positions.push_back(i);
+  if (!measured) {
+    std::vector<size_t> newline_positions;
+    // Discover and add all hard breaks.
+    for (size_t i = 0; i < text_.size(); ++i) {
+      ULineBreak ulb = static_cast<ULineBreak>(
+          u_getIntPropertyValue(text_[i], UCHAR_LINE_BREAK));
+      if (ulb == U_LB_LINE_FEED || ulb == U_LB_MANDATORY_BREAK)
+        newline_positions.push_back(i);
+    }
+    // Break at the end of the paragraph.
+    newline_positions.push_back(text_.size());
+
+    measured_blocks_.clear();
+    measured_blocks_.reserve(newline_positions.size());
+    for (size_t newline_index = 0; newline_index < newline_positions.size();
+         ++newline_index) {
+      MeasuredBlock block;
+      block.start =
+          (newline_index > 0) ? newline_positions[newline_index - 1] + 1 : 0;
+      block.end = newline_positions[newline_index];
+      measured_blocks_.push_back(std::move(block));
+    }
   }
-  // Break at the end of the paragraph.
-  newline_positions.push_back(text_.size());
 
   // Calculate and add any breaks due to a line being too long.
   size_t run_index = 0;
   size_t inline_placeholder_index = 0;
-  for (size_t newline_index = 0; newline_index < newline_positions.size();
-       ++newline_index) {
-    size_t block_start =
-        (newline_index > 0) ? newline_positions[newline_index - 1] + 1 : 0;
-    size_t block_end = newline_positions[newline_index];
+  for (MeasuredBlock& block : measured_blocks_) {
+    size_t block_start = block.start;
+    size_t block_end = block.end;
     size_t block_size = block_end - block_start;
 
     if (block_size == 0) {
@@ -294,6 +315,10 @@ bool ParagraphTxt::ComputeLineBreaks() {
            block_size * sizeof(text_[0]));
     breaker_.setText();
     breaker_.setIndents(indents_);
+    if (measured) {
+      memcpy(breaker_.charWidths(), block.char_widths.data(),
+             block_size * sizeof(float));
+    }
 
     // Add the runs that include this line to the LineBreaker.
     double block_total_width = 0;
@@ -343,6 +368,10 @@ bool ParagraphTxt::ComputeLineBreaks() {
         breaker_.addStyleRun(nullptr, collection, font, run_start, run_end,
                              isRtl);
         inline_placeholder_index++;
+      } else if (measured) {
+        // Is a regular text run measured by an earlier layout.
+        breaker_.addMeasuredStyleRun(&paint, collection, font, run_start,
+                                     run_end, isRtl);
       } else {
         // Is a regular text run.
         double run_width = breaker_.addStyleRun(&paint, collection, font,
@@ -354,7 +383,12 @@ bool ParagraphTxt::ComputeLineBreaks() {
         break;
       run_index++;
     }
-    max_intrinsic_width_ = std::max(max_intrinsic_width_, block_total_width);
+    if (!measured) {
+      block.char_widths.assign(breaker_.charWidths(),
+                               breaker_.charWidths() + block_size);
+      block.total_width = block_total_width;
+    }
+    max_intrinsic_width_ = std::max(max_intrinsic_width_, block.total_width);
 
     size_t breaks_count = breaker_.computeBreaks();
     const int* breaks = breaker_.getBreaks();
@@ -629,6 +663,85 @@ void ParagraphTxt::ComputePlaceholder(PlaceholderRun* placeholder_run,
   }
 }
 
+struct ParagraphTxt::CachedLayout {
+  std::vector<LineRange> line_ranges;
+  std::vector<double> line_widths;
+  std::vector<PaintRecord> records;
+  std::vector<double> line_heights;
+  std::vector<double> line_baselines;
+  bool did_exceed_max_lines;
+  StrutMetrics strut;
+  std::vector<SkScalar> line_max_spacings;
+  std::vector<SkScalar> line_max_descent;
+  std::vector<SkScalar> line_max_ascent;
+  double max_right;
+  double min_left;
+  std::vector<GlyphLine> glyph_lines;
+  std::vector<CodeUnitRun> code_unit_runs;
+  double longest_line;
+  double max_intrinsic_width;
+  double min_intrinsic_width;
+  double alphabetic_baseline;
+  double ideographic_baseline;
+};
+
+std::shared_ptr<const ParagraphTxt::CachedLayout> ParagraphTxt::SaveLayout()
+    const {
+  auto layout = std::make_shared<CachedLayout>();
+  layout->line_ranges = line_ranges_;
+  layout->line_widths = line_widths_;
+  layout->records.reserve(records_.size());
+  for (const PaintRecord& record : records_) {
+    layout->records.push_back(CopyPaintRecord(record));
+  }
+  layout->line_heights = line_heights_;
+  layout->line_baselines = line_baselines_;
+  layout->did_exceed_max_lines = did_exceed_max_lines_;
+  layout->strut = strut_;
+  layout->line_max_spacings = line_max_spacings_;
+  layout->line_max_descent = line_max_descent_;
+  layout->line_max_ascent = line_max_ascent_;
+  layout->max_right = max_right_;
+  layout->min_left = min_left_;
+  // Glyph lines can't be assigned, only copied.
+  layout->glyph_lines = std::vector<GlyphLine>(glyph_lines_);
+  layout->code_unit_runs = code_unit_runs_;
+  layout->longest_line = longest_line_;
+  layout->max_intrinsic_width = max_intrinsic_width_;
+  layout->min_intrinsic_width = min_intrinsic_width_;
+  layout->alphabetic_baseline = alphabetic_baseline_;
+  layout->ideographic_baseline = ideographic_baseline_;
+  return layout;
+}
+
+void ParagraphTxt::RestoreLayout(const CachedLayout& layout) {
+  line_ranges_ = layout.line_ranges;
+  line_widths_ = layout.line_widths;
+  records_.clear();
+  records_.reserve(layout.records.size());
+  for (const PaintRecord& record : layout.records) {
+    records_.push_back(CopyPaintRecord(record));
+  }
+  line_heights_ = layout.line_heights;
+  line_baselines_ = layout.line_baselines;
+  did_exceed_max_lines_ = layout.did_exceed_max_lines;
+  strut_ = layout.strut;
+  line_max_spacings_ = layout.line_max_spacings;
+  line_max_descent_ = layout.line_max_descent;
+  line_max_ascent_ = layout.line_max_ascent;
+  max_right_ = layout.max_right;
+  min_left_ = layout.min_left;
+  // Glyph lines can't be assigned, only copied.
+  glyph_lines_ = std::vector<GlyphLine>(layout.glyph_lines);
+  code_unit_runs_ = layout.code_unit_runs;
+  inline_placeholder_code_unit_runs_.clear();
+  longest_line_ = layout.longest_line;
+  max_intrinsic_width_ = layout.max_intrinsic_width;
+  min_intrinsic_width_ = layout.min_intrinsic_width;
+  alphabetic_baseline_ = layout.alphabetic_baseline;
+  ideographic_baseline_ = layout.ideographic_baseline;
+}
+
 // Implementation outline:
 //
 // -For each line:
@@ -656,13 +769,40 @@ void ParagraphTxt::Layout(double width) {
 
   needs_layout_ = false;
 
-  if (!ComputeLineBreaks())
-    return;
+  // The layout of inline placeholders refers to the placeholders of this
+  // paragraph, so it can't be shared.
+  std::unique_ptr<ParagraphCache::Key> cache_key;
+  if (!skip_layout_cache_ && inline_placeholders_.empty()) {
+    cache_key = std::make_unique<ParagraphCache::Key>(
+        text_, runs_, paragraph_style_, indents_, width_, font_collection_);
+    std::shared_ptr<const CachedLayout> cached_layout =
+        ParagraphCache::GetInstance().Find(*cache_key);
+    if (cached_layout) {
+      RestoreLayout(*cached_layout);
+      return;
+    }
+  }
+  skip_layout_cache_ = false;
 
-  std::vector<BidiRun> bidi_runs;
-  if (!ComputeBidiRuns(&bidi_runs))
+  // Only the line breaking and positioning depend on the width, so a
+  // paragraph laid out before at another width reuses its measurements.
+  uint64_t font_generation =
+      font_collection_ ? font_collection_->GetGeneration() : 0;
+  bool measured = is_measured_ && measured_font_generation_ == font_generation;
+  is_measured_ = false;
+
+  if (!ComputeLineBreaks(measured))
     return;
 
+  if (!measured) {
+    bidi_runs_.clear();
+    if (!ComputeBidiRuns(&bidi_runs_))
+      return;
+  }
+  is_measured_ = true;
+  measured_font_generation_ = font_generation;
+  const std::vector<BidiRun>& bidi_runs = bidi_runs_;
+
   SkFont font;
   font.setEdging(SkFont::Edging::kAntiAlias);
   font.setSubpixel(true);
@@ -1174,6 +1314,10 @@ void ParagraphTxt::Layout(double width) {
             });
 
   longest_line_ = max_right_ - min_left_;
+
+  if (cache_key) {
+    ParagraphCache::GetInstance().Insert(std::move(*cache_key), SaveLayout());
+  }
 }
 
 double ParagraphTxt::GetLineXOffset(double line_total_advance,
@@ -1244,12 +1388,14 @@ double ParagraphTxt::GetLongestLine() {
 
 void ParagraphTxt::SetParagraphStyle(const ParagraphStyle& style) {
   needs_layout_ = true;
+  is_measured_ = false;
   paragraph_style_ = style;
 }
 
 void ParagraphTxt::SetFontCollection(
     std::shared_ptr<FontCollection> font_collection) {
   font_collection_ = std::move(font_collection);
+  is_measured_ = false;
 }
 
 std::shared_ptr<minikin::FontCollection>
@@ -1993,6 +2139,10 @@ bool ParagraphTxt::DidExceedMaxLines() {
 
 void ParagraphTxt::SetDirty(bool dirty) {
   needs_layout_ = dirty;
+  skip_layout_cache_ = dirty;
+  if (dirty) {
+    is_measured_ = false;
+  }
 }
 
 }  // namespace txt
@@ -67,6 +67,10 @@ class ParagraphTxt : public Paragraph {
   // number of characters. However, this is not significant for reasonably sized
   // paragraphs. It is currently recommended to break up very long paragraphs
   // (10k+ characters) to ensure speedy layout.
+  //
+  // The widths measured by the LineBreaker and the bidi runs are kept until
+  // the text, styles or fonts change, so laying out the paragraph again at
+  // another width only breaks and positions its lines.
   virtual void Layout(double width) override;
 
   virtual void Paint(SkCanvas* canvas, double x, double y) override;
@@ -117,12 +121,14 @@ class ParagraphTxt : public Paragraph {
   bool DidExceedMaxLines() override;
 
   // Sets the needs_layout_ to dirty. When Layout() is called, a new Layout will
-  // be performed when this is set to true. Can also be used to prevent a new
+  // be performed when this is set to true, measuring the text again without
+  // looking it up in the ParagraphCache. Can also be used to prevent a new
   // Layout from being calculated by setting to false.
   void SetDirty(bool dirty = true);
 
  private:
   friend class ParagraphBuilderTxt;
+  friend class ParagraphCache;
   FRIEND_TEST(ParagraphTest, SimpleParagraph);
   FRIEND_TEST(ParagraphTest, SimpleRedParagraph);
   FRIEND_TEST(ParagraphTest, RainbowParagraph);
@@ -330,6 +336,27 @@ class ParagraphTxt : public Paragraph {
   double ideographic_baseline_ = FLT_MAX;
 
   bool needs_layout_ = true;
+  // Set by SetDirty() to bypass the ParagraphCache in the next Layout().
+  bool skip_layout_cache_ = false;
+
+  // The results of Layout() stored in the ParagraphCache.
+  struct CachedLayout;
+
+  // A range of text between hard line breaks, as measured for line breaking.
+  struct MeasuredBlock {
+    size_t start;
+    size_t end;
+    // The advance of each code unit of the block.
+    std::vector<float> char_widths;
+    double total_width = 0;
+  };
+
+  // The parts of Layout() that don't depend on the width, reused by the next
+  // Layout() as long as is_measured_ is set and the fonts have not changed.
+  std::vector<MeasuredBlock> measured_blocks_;
+  std::vector<BidiRun> bidi_runs_;
+  bool is_measured_ = false;
+  uint64_t measured_font_generation_ = 0;
 
   struct WaveCoordinates {
     double x_start;
@@ -353,8 +380,15 @@ class ParagraphTxt : public Paragraph {
       std::vector<PlaceholderRun> inline_placeholders,
       std::unordered_set<size_t> obj_replacement_char_indexes);
 
-  // Break the text into lines.
-  bool ComputeLineBreaks();
+  // Copies the results of the last Layout() to be stored in the cache.
+  std::shared_ptr<const CachedLayout> SaveLayout() const;
+
+  // Restores the results of an earlier Layout() of an identical paragraph.
+  void RestoreLayout(const CachedLayout& layout);
+
+  // Break the text into lines. If |measured| is true, the widths stored in
+  // measured_blocks_ are used instead of measuring the text.
+  bool ComputeLineBreaks(bool measured);
 
   // Break the text into runs based on LTR/RTL text direction.
   bool ComputeBidiRuns(std::vector<BidiRun>* result);
@@ -41,6 +41,10 @@ bool TextStyle::equals(const TextStyle& other) const {
     return false;
   if (font_style != other.font_style)
     return false;
+  if (text_baseline != other.text_baseline)
+    return false;
+  if (font_size != other.font_size)
+    return false;
   if (letter_spacing != other.letter_spacing)
     return false;
   if (word_spacing != other.word_spacing)
@@ -51,8 +55,18 @@ bool TextStyle::equals(const TextStyle& other) const {
     return false;
   if (locale != other.locale)
     return false;
+  if (has_background != other.has_background)
+    return false;
+  if (background != other.background)
+    return false;
+  if (has_foreground != other.has_foreground)
+    return false;
   if (foreground != other.foreground)
     return false;
+  if (font_features != other.font_features)
+    return false;
+  if (font_families.size() != other.font_families.size())
+    return false;
   if (text_shadows.size() != other.text_shadows.size())
     return false;
   for (size_t font_index = 0; font_index < font_families.size(); ++font_index) {
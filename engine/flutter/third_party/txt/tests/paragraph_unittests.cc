@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include "flutter/fml/logging.h"
+#include "minikin/Layout.h"
 #include "render_test.h"
 #include "third_party/icu/source/common/unicode/unistr.h"
 #include "third_party/skia/include/core/SkColor.h"
@@ -24,6 +27,7 @@
 #include "txt/font_style.h"
 #include "txt/font_weight.h"
 #include "txt/paragraph_builder_txt.h"
+#include "txt/paragraph_cache.h"
 #include "txt/paragraph_txt.h"
 #include "txt/placeholder_run.h"
 #include "txt_test_utils.h"
@@ -5271,4 +5275,249 @@ TEST_F(ParagraphTest, FontFeaturesParagraph) {
   ASSERT_TRUE(Snapshot());
 }
 
+TEST_F(ParagraphTest, ConcurrentLayoutsMatchSerialLayout) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line. Sometimes, short sentence. Longer "
+      "sentences are okay too because they are necessary. Very short. ";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  auto font_collection = GetTestFontCollection();
+  auto build_paragraph = [&](double font_size) {
+    txt::ParagraphStyle paragraph_style;
+    txt::ParagraphBuilderTxt builder(paragraph_style, font_collection);
+    txt::TextStyle text_style;
+    text_style.font_families = std::vector<std::string>(1, "Roboto");
+    text_style.font_size = font_size;
+    text_style.color = SK_ColorBLACK;
+    builder.PushStyle(text_style);
+    builder.AddText(u16_text);
+    builder.Pop();
+    return BuildParagraph(builder);
+  };
+
+  const size_t kThreadCount = 4;
+  const size_t kIterations = 20;
+  std::vector<double> expected_heights;
+  std::vector<double> expected_longest_lines;
+  for (size_t i = 0; i < kThreadCount; i++) {
+    auto paragraph = build_paragraph(10 + i);
+    paragraph->Layout(GetTestCanvasWidth());
+    expected_heights.push_back(paragraph->GetHeight());
+    expected_longest_lines.push_back(paragraph->GetLongestLine());
+  }
+
+  // Every thread lays out text of its own size, so that the threads shape
+  // the same words concurrently without sharing cached layouts. The paragraphs
+  // are marked dirty to be laid out rather than restored from the paragraph
+  // cache.
+  minikin::Layout::purgeCaches();
+  std::vector<std::thread> threads;
+  std::atomic_size_t mismatches = 0;
+  for (size_t i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0; j < kIterations; j++) {
+        auto paragraph = build_paragraph(10 + i);
+        paragraph->SetDirty();
+        paragraph->Layout(GetTestCanvasWidth());
+        if (paragraph->GetHeight() != expected_heights[i] ||
+            paragraph->GetLongestLine() != expected_longest_lines[i]) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(mismatches, 0u);
+}
+
+TEST_F(ParagraphTest, WordLayoutCacheStaysWithinByteBudget) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line. Sometimes, short sentence. Longer "
+      "sentences are okay too because they are necessary. Very short. ";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  txt::ParagraphStyle paragraph_style;
+  txt::ParagraphBuilderTxt builder(paragraph_style, GetTestFontCollection());
+  txt::TextStyle text_style;
+  text_style.font_families = std::vector<std::string>(1, "Roboto");
+  text_style.color = SK_ColorBLACK;
+  builder.PushStyle(text_style);
+  builder.AddText(u16_text);
+  builder.Pop();
+  auto paragraph = BuildParagraph(builder);
+
+  minikin::Layout::purgeCaches();
+  minikin::Layout::CacheStats initial_stats = minikin::Layout::getCacheStats();
+  ASSERT_EQ(initial_stats.entryCount, 0ull);
+  ASSERT_EQ(initial_stats.byteCount, 0ull);
+
+  paragraph->SetDirty();
+  paragraph->Layout(GetTestCanvasWidth());
+  minikin::Layout::CacheStats stats = minikin::Layout::getCacheStats();
+  ASSERT_GT(stats.missCount, initial_stats.missCount);
+  ASSERT_GT(stats.entryCount, 0ull);
+  ASSERT_GT(stats.byteCount, stats.entryCount * sizeof(minikin::Layout));
+
+  // Laying the same words out again only hits.
+  paragraph->SetDirty();
+  paragraph->Layout(GetTestCanvasWidth());
+  minikin::Layout::CacheStats relayout_stats = minikin::Layout::getCacheStats();
+  ASSERT_GT(relayout_stats.hitCount, stats.hitCount);
+  ASSERT_EQ(relayout_stats.missCount, stats.missCount);
+  ASSERT_EQ(relayout_stats.byteCount, stats.byteCount);
+
+  // A smaller budget evicts the least recently used words.
+  const size_t kMaxBytes = stats.byteCount / 2;
+  minikin::Layout::setCacheMaxBytes(kMaxBytes);
+  minikin::Layout::CacheStats evicted_stats = minikin::Layout::getCacheStats();
+  ASSERT_LE(evicted_stats.byteCount, kMaxBytes);
+  ASSERT_LT(evicted_stats.entryCount, stats.entryCount);
+  ASSERT_GT(evicted_stats.evictionCount, stats.evictionCount);
+
+  paragraph->SetDirty();
+  paragraph->Layout(GetTestCanvasWidth());
+  ASSERT_LE(minikin::Layout::getCacheStats().byteCount, kMaxBytes);
+
+  minikin::Layout::setCacheMaxBytes(initial_stats.maxBytes);
+  minikin::Layout::purgeCaches();
+  ASSERT_EQ(minikin::Layout::getCacheStats().byteCount, 0ull);
+}
+
+TEST_F(ParagraphTest, IdenticalParagraphsShareCachedLayout) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line. Sometimes, short sentence.";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  auto font_collection = GetTestFontCollection();
+  auto build_paragraph = [&](SkColor color) {
+    txt::ParagraphStyle paragraph_style;
+    txt::ParagraphBuilderTxt builder(paragraph_style, font_collection);
+    txt::TextStyle text_style;
+    text_style.font_families = std::vector<std::string>(1, "Roboto");
+    text_style.font_size = 26;
+    text_style.color = color;
+    builder.PushStyle(text_style);
+    builder.AddText(u16_text);
+    builder.Pop();
+    return BuildParagraph(builder);
+  };
+
+  ParagraphCache& cache = ParagraphCache::GetInstance();
+  cache.Clear();
+  ParagraphCache::Stats stats = cache.GetStats();
+
+  auto paragraph = build_paragraph(SK_ColorBLACK);
+  paragraph->Layout(300);
+  ASSERT_EQ(cache.GetStats().miss_count, stats.miss_count + 1);
+  ASSERT_EQ(cache.GetStats().entry_count, 1ull);
+
+  auto cached_paragraph = build_paragraph(SK_ColorBLACK);
+  cached_paragraph->Layout(300);
+  ASSERT_EQ(cache.GetStats().hit_count, stats.hit_count + 1);
+
+  cached_paragraph->Paint(GetCanvas(), 0, 0);
+  ASSERT_TRUE(Snapshot());
+  ASSERT_EQ(cached_paragraph->GetLineCount(), paragraph->GetLineCount());
+  ASSERT_EQ(cached_paragraph->GetHeight(), paragraph->GetHeight());
+  ASSERT_EQ(cached_paragraph->GetLongestLine(), paragraph->GetLongestLine());
+  ASSERT_EQ(cached_paragraph->GetMinIntrinsicWidth(),
+            paragraph->GetMinIntrinsicWidth());
+  ASSERT_EQ(cached_paragraph->GetMaxIntrinsicWidth(),
+            paragraph->GetMaxIntrinsicWidth());
+  ASSERT_EQ(cached_paragraph->GetAlphabeticBaseline(),
+            paragraph->GetAlphabeticBaseline());
+  std::vector<txt::Paragraph::TextBox> boxes = paragraph->GetRectsForRange(
+      0, u16_text.length(), Paragraph::RectHeightStyle::kMax,
+      Paragraph::RectWidthStyle::kTight);
+  std::vector<txt::Paragraph::TextBox> cached_boxes =
+      cached_paragraph->GetRectsForRange(0, u16_text.length(),
+                                         Paragraph::RectHeightStyle::kMax,
+                                         Paragraph::RectWidthStyle::kTight);
+  ASSERT_EQ(cached_boxes.size(), boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    ASSERT_EQ(cached_boxes[i].rect, boxes[i].rect);
+  }
+  ASSERT_EQ(cached_paragraph->GetGlyphPositionAtCoordinate(100, 40).position,
+            paragraph->GetGlyphPositionAtCoordinate(100, 40).position);
+
+  // Any difference in style or width is laid out separately.
+  auto red_paragraph = build_paragraph(SK_ColorRED);
+  red_paragraph->Layout(300);
+  cached_paragraph->Layout(200);
+  ASSERT_EQ(cache.GetStats().miss_count, stats.miss_count + 3);
+  ASSERT_EQ(cache.GetStats().entry_count, 3ull);
+
+  // Layouts done before the fonts changed are not reused.
+  font_collection->ClearFontFamilyCache();
+  auto reloaded_paragraph = build_paragraph(SK_ColorBLACK);
+  reloaded_paragraph->Layout(300);
+  ASSERT_EQ(cache.GetStats().miss_count, stats.miss_count + 4);
+}
+
+TEST_F(ParagraphTest, RelayoutAtNewWidthMatchesFreshLayout) {
+  const char* text =
+      "This is a very long sentence to test if the text will properly wrap "
+      "around and go to the next line.\nSometimes, short sentence. Longer "
+      "sentences are okay too because they are necessary. Very short.";
+  auto icu_text = icu::UnicodeString::fromUTF8(text);
+  std::u16string u16_text(icu_text.getBuffer(),
+                          icu_text.getBuffer() + icu_text.length());
+
+  auto build_paragraph = [&]() {
+    txt::ParagraphStyle paragraph_style;
+    paragraph_style.text_align = TextAlign::justify;
+    txt::ParagraphBuilderTxt builder(paragraph_style, GetTestFontCollection());
+    txt::TextStyle text_style;
+    text_style.font_families = std::vector<std::string>(1, "Roboto");
+    text_style.font_size = 26;
+    text_style.color = SK_ColorBLACK;
+    builder.PushStyle(text_style);
+    builder.AddText(u16_text);
+    builder.Pop();
+    return BuildParagraph(builder);
+  };
+
+  // Only the line breaks and positions are computed again at a new width.
+  auto paragraph = build_paragraph();
+  paragraph->Layout(500);
+  paragraph->Layout(250);
+
+  auto fresh_paragraph = build_paragraph();
+  fresh_paragraph->SetDirty();
+  fresh_paragraph->Layout(250);
+
+  paragraph->Paint(GetCanvas(), 0, 0);
+  ASSERT_TRUE(Snapshot());
+  ASSERT_GT(paragraph->GetLineCount(), 2ull);
+  ASSERT_EQ(paragraph->GetLineCount(), fresh_paragraph->GetLineCount());
+  ASSERT_EQ(paragraph->GetHeight(), fresh_paragraph->GetHeight());
+  ASSERT_EQ(paragraph->GetLongestLine(), fresh_paragraph->GetLongestLine());
+  ASSERT_EQ(paragraph->GetMinIntrinsicWidth(),
+            fresh_paragraph->GetMinIntrinsicWidth());
+  ASSERT_EQ(paragraph->GetMaxIntrinsicWidth(),
+            fresh_paragraph->GetMaxIntrinsicWidth());
+  std::vector<txt::Paragraph::TextBox> boxes = paragraph->GetRectsForRange(
+      0, u16_text.length(), Paragraph::RectHeightStyle::kMax,
+      Paragraph::RectWidthStyle::kTight);
+  std::vector<txt::Paragraph::TextBox> fresh_boxes =
+      fresh_paragraph->GetRectsForRange(0, u16_text.length(),
+                                        Paragraph::RectHeightStyle::kMax,
+                                        Paragraph::RectWidthStyle::kTight);
+  ASSERT_EQ(boxes.size(), fresh_boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    ASSERT_EQ(boxes[i].rect, fresh_boxes[i].rect);
+  }
+}
+
 }  // namespace txt